@@ -410,6 +410,10 @@ menu-2-1-exec = menu-open-0
 
 [settings]
 screenchange-reload = true
+;throttle-output-for = 10
+; Redraw at most this many times per second, 0 disables the cap.
+; Defaults to 1000 / throttle-output-for, replaces throttle-output
+;max-fps = 100
 ;compositing-background = xor
 ;compositing-background = screen
 ;compositing-foreground = source
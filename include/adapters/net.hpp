@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdlib>
+#include <mutex>
 
 #include <arpa/inet.h>
 #include <ifaddrs.h>
@@ -10,12 +11,14 @@
 #include "settings.hpp"
 #include "errors.hpp"
 #include "components/logger.hpp"
+#include "components/sampler.hpp"
 #include "utils/math.hpp"
 
 #if WITH_LIBNL
 #include <net/if.h>
 
 struct nl_msg;
+struct nl_sock;
 struct nlattr;
 #else
 #include <iwlib.h>
@@ -30,6 +33,8 @@ struct nlattr;
 #endif
 #endif
 
+struct nlmsghdr;
+
 POLYBAR_NS
 
 class file_descriptor;
@@ -68,6 +73,53 @@ namespace net {
     link_activity current{};
   };
 
+  // }}}
+  // class : link_monitor {{{
+
+  /**
+   * Subscriber for the rtnetlink link and address notifications
+   * of a single interface
+   *
+   * Keeps the operational state and addresses of the interface up
+   * to date as the kernel reports changes, so they don't have to be
+   * queried on every interval. If notifications were dropped because
+   * the socket buffer overran, the whole state is loaded again
+   */
+  class link_monitor {
+   public:
+    explicit link_monitor(const string& interface);
+    ~link_monitor();
+
+    int get_file_descriptor() const;
+    bool process();
+
+    bool up(bool unknown_up) const;
+    string ip() const;
+    string ip6() const;
+
+   protected:
+    bool resync();
+    void request(int type, int flags);
+    bool receive(bool block, bool& changed);
+    bool handle_link(const struct nlmsghdr* hdr);
+    bool handle_addr(const struct nlmsghdr* hdr);
+
+   private:
+    mutable std::mutex m_lock;
+    int m_fd{-1};
+    unsigned int m_ifindex{0};
+    unsigned int m_seq{0};
+    unsigned char m_operstate{0};
+    vector<string> m_ip;
+    vector<string> m_ip6;
+
+    // Addresses collected by a running resync
+    bool m_dumping{false};
+    bool m_overrun{false};
+    vector<string> m_dump_ip;
+    vector<string> m_dump_ip6;
+  };
+
   // }}}
   // class : network {{{
 
@@ -80,25 +132,36 @@ namespace net {
     virtual bool connected() const = 0;
     virtual bool ping() const;
 
+    virtual vector<int> event_fds() const;
+    virtual bool process_events();
+
     string ip() const;
     string ip6() const;
     string downspeed(int minwidth = 3) const;
     string upspeed(int minwidth = 3) const;
     void set_unknown_up(bool unknown = true);
+    void set_probe(bool in_process = true);
 
    protected:
     void check_tuntap_or_bridge();
     bool test_interface() const;
     string format_speedrate(float bytes_diff, int minwidth) const;
     void query_ip6();
+    bool query_counters();
+    bool probe() const;
 
     const logger& m_log;
     unique_ptr<file_descriptor> m_socketfd;
+    unique_ptr<link_monitor> m_monitor;
+    sampler::handle m_rxbytes;
+    sampler::handle m_txbytes;
     link_status m_status{};
     string m_interface;
     bool m_tuntap{false};
     bool m_bridge{false};
     bool m_unknown_up{false};
+    // Cleared if the in-process probe turns out to be unavailable
+    mutable bool m_probe{false};
   };
 
   // }}}
@@ -123,7 +186,8 @@ namespace net {
 
   class wireless_network : public network {
    public:
-    wireless_network(string interface) : network(interface), m_ifid(if_nametoindex(interface.c_str())){};
+    explicit wireless_network(string interface);
+    ~wireless_network() override;
 
     bool query(bool accumulate = false) override;
     bool connected() const override;
@@ -131,8 +195,15 @@ namespace net {
     int signal() const;
     int quality() const;
 
+    vector<int> event_fds() const override;
+    bool process_events() override;
+
    protected:
     static int scan_cb(struct nl_msg* msg, void* instance);
+    static int event_cb(struct nl_msg* msg, void* instance);
+
+    bool query_bss();
+    void subscribe();
 
     bool associated_or_joined(struct nlattr** bss);
     void parse_essid(struct nlattr** bss);
@@ -142,6 +213,12 @@ namespace net {
 
    private:
     unsigned int m_ifid{};
+    // Reused between queries, reset if a request fails
+    struct nl_sock* m_sock{nullptr};
+    int m_driver_id{-1};
+    // Receives the nl80211 "mlme" multicast group
+    struct nl_sock* m_events{nullptr};
+    bool m_mlme_changed{false};
     string m_essid{};
     int m_frequency{};
     quality_range m_signalstrength{};
@@ -142,96 +142,48 @@ namespace cairo {
     }
 
     context& operator<<(const textblock& t) {
+      if (!m_fonts) {
+        return *this;
+      }
+
       double x, y;
       position(&x, &y);
 
-      // Prioritize the preferred font
-      vector<shared_ptr<font>> fns(m_fonts.begin(), m_fonts.end());
-
-      if (t.font > 0 && t.font <= std::distance(fns.begin(), fns.end())) {
-        std::iter_swap(fns.begin(), fns.begin() + t.font - 1);
-      }
-
-      string utf8 = string(t.contents);
-      utils::unicode_charlist chars;
-      utils::utf8_to_ucs4((const unsigned char*)utf8.c_str(), chars);
-
-      while (!chars.empty()) {
-        auto remaining = chars.size();
-        for (auto&& f : fns) {
-          unsigned int matches = 0;
-
-          // Match as many glyphs as possible if the default/preferred font
-          // is being tested. Otherwise test one glyph at a time against
-          // the remaining fonts. Roll back to the top of the font list
-          // when a glyph has been found.
-          if (f == fns.front() && (matches = f->match(chars)) == 0) {
-            continue;
-          } else if (f != fns.front() && (matches = f->match(chars.front())) == 0) {
-            continue;
-          }
-
-          string subset;
-          auto end = chars.begin();
-          while (matches-- && end != chars.end()) {
-            subset += utf8.substr(end->offset, end->length);
-            end++;
-          }
-
-          // Use the font
-          f->use();
-
-          // Get subset extents
-          cairo_text_extents_t extents;
-          f->textwidth(subset, &extents);
-
-          // Draw the background
-          if (t.bg_rect.h != 0.0) {
-            save();
-            cairo_set_operator(m_c, t.bg_operator);
-            *this << t.bg;
-            cairo_rectangle(m_c, t.bg_rect.x + *t.x_advance, t.bg_rect.y + *t.y_advance,
-                t.bg_rect.w + extents.x_advance, t.bg_rect.h);
-            cairo_fill(m_c);
-            restore();
-          }
-
-          // Render subset
-          auto fontextents = f->extents();
-          f->render(subset, x, y - (fontextents.descent / 2 - fontextents.height / 4) + f->offset());
-
-          // Get updated position
-          position(&x, nullptr);
-
-          // Increase position
-          *t.x_advance += extents.x_advance;
-          *t.y_advance += extents.y_advance;
-
-          chars.erase(chars.begin(), end);
-          break;
+      auto runs = m_fonts->shape(t.font, t.contents);
+
+      for (auto&& run : *runs) {
+        // Use the font
+        run.face->use(m_c);
+
+        // Draw the background
+        if (t.bg_rect.h != 0.0) {
+          save();
+          cairo_set_operator(m_c, t.bg_operator);
+          *this << t.bg;
+          cairo_rectangle(m_c, t.bg_rect.x + *t.x_advance, t.bg_rect.y + *t.y_advance,
+              t.bg_rect.w + run.extents.x_advance, t.bg_rect.h);
+          cairo_fill(m_c);
+          restore();
         }
 
-        if (chars.empty()) {
-          break;
-        } else if (remaining != chars.size()) {
-          continue;
-        }
+        // Render subset
+        auto fontextents = run.face->extents();
+        run.face->render(
+            m_c, run.glyphs, x, y - (fontextents.descent / 2 - fontextents.height / 4) + run.face->offset());
 
-        char unicode[6]{'\0'};
-        utils::ucs4_to_utf8(unicode, chars.begin()->codepoint);
-        m_log.warn("Dropping unmatched character %s (U+%04x) in '%s'", unicode, chars.begin()->codepoint, t.contents);
-        utf8.erase(chars.begin()->offset, chars.begin()->length);
-        for (auto&& c : chars) {
-          c.offset -= chars.begin()->length;
-        }
-        chars.erase(chars.begin(), ++chars.begin());
+        // Get updated position
+        position(&x, nullptr);
+
+        // Increase position
+        *t.x_advance += run.extents.x_advance;
+        *t.y_advance += run.extents.y_advance;
       }
 
       return *this;
     }
 
-    context& operator<<(shared_ptr<font>&& f) {
-      m_fonts.emplace_back(forward<decltype(f)>(f));
+    context& operator<<(shared_ptr<font_set> fonts) {
+      m_fonts = move(fonts);
       return *this;
     }
 
@@ -350,7 +302,7 @@ namespace cairo {
    protected:
     cairo_t* m_c;
     const logger& m_log;
-    vector<shared_ptr<font>> m_fonts;
+    shared_ptr<font_set> m_fonts;
     std::deque<pair<double, double>> m_points;
     int m_activegroups{0};
   };
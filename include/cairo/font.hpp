@@ -2,11 +2,15 @@
 
 #include <cairo/cairo-ft.h>
 
+#include <mutex>
+
 #include "cairo/types.hpp"
 #include "cairo/utils.hpp"
 #include "common.hpp"
+#include "components/logger.hpp"
 #include "errors.hpp"
 #include "settings.hpp"
+#include "utils/cache.hpp"
 #include "utils/math.hpp"
 #include "utils/scope.hpp"
 #include "utils/string.hpp"
@@ -21,10 +25,13 @@ namespace cairo {
 
   /**
    * \brief Abstract font face
+   *
+   * Fonts aren't bound to a cairo context, so that bars with
+   * the same fonts and dpi can share them
    */
   class font {
    public:
-    explicit font(cairo_t* cairo, double offset) : m_cairo(cairo), m_offset(offset) {}
+    explicit font(double offset) : m_offset(offset) {}
     virtual ~font(){};
 
     virtual string name() const = 0;
@@ -34,17 +41,17 @@ namespace cairo {
 
     virtual cairo_font_extents_t extents() = 0;
 
-    virtual void use() {
-      cairo_set_font_face(m_cairo, cairo_font_face_reference(m_font_face));
+    virtual void use(cairo_t* cairo) {
+      cairo_set_font_face(cairo, cairo_font_face_reference(m_font_face));
     }
 
     virtual size_t match(utils::unicode_character& character) = 0;
     virtual size_t match(utils::unicode_charlist& charlist) = 0;
-    virtual size_t render(const string& text, double x = 0.0, double y = 0.0) = 0;
+    virtual size_t shape(const string& text, glyph_run* run) = 0;
+    virtual void render(cairo_t* cairo, const glyph_run& run, double x = 0.0, double y = 0.0) = 0;
     virtual void textwidth(const string& text, cairo_text_extents_t* extents) = 0;
 
    protected:
-    cairo_t* m_cairo;
     cairo_font_face_t* m_font_face{nullptr};
     cairo_font_extents_t m_extents{};
     double m_offset{0.0};
@@ -55,11 +62,11 @@ namespace cairo {
    */
   class font_fc : public font {
    public:
-    explicit font_fc(cairo_t* cairo, FcPattern* pattern, double offset, double dpi_x, double dpi_y) : font(cairo, offset), m_pattern(pattern) {
+    explicit font_fc(FcPattern* pattern, double offset, double dpi_x, double dpi_y) : font(offset), m_pattern(pattern) {
       cairo_matrix_t fm;
       cairo_matrix_t ctm;
       cairo_matrix_init_scale(&fm, size(dpi_x), size(dpi_y));
-      cairo_get_matrix(m_cairo, &ctm);
+      cairo_matrix_init_identity(&ctm);
 
       auto fontface = cairo_ft_font_face_create_for_pattern(m_pattern);
       auto opts = cairo_font_options_create();
@@ -183,8 +190,8 @@ namespace cairo {
       }
     }
 
-    void use() override {
-      cairo_set_scaled_font(m_cairo, m_scaled);
+    void use(cairo_t* cairo) override {
+      cairo_set_scaled_font(cairo, m_scaled);
     }
 
     size_t match(utils::unicode_character& character) override {
@@ -208,15 +215,18 @@ namespace cairo {
       return available_chars;
     }
 
-    size_t render(const string& text, double x = 0.0, double y = 0.0) override {
+    /**
+     * Convert the leading part of the text that can be rendered
+     * using this font to glyphs. Returns the number of bytes covered
+     */
+    size_t shape(const string& text, glyph_run* run) override {
       cairo_glyph_t* glyphs{nullptr};
       cairo_text_cluster_t* clusters{nullptr};
       cairo_text_cluster_flags_t cf{};
       int nglyphs = 0, nclusters = 0;
 
-      string utf8 = string(text);
       auto status = cairo_scaled_font_text_to_glyphs(
-          m_scaled, x, y, utf8.c_str(), utf8.size(), &glyphs, &nglyphs, &clusters, &nclusters, &cf);
+          m_scaled, 0.0, 0.0, text.c_str(), text.size(), &glyphs, &nglyphs, &clusters, &nclusters, &cf);
 
       if (status != CAIRO_STATUS_SUCCESS) {
         throw application_error(sstream() << "cairo_scaled_font_text_to_glyphs()" << cairo_status_to_string(status));
@@ -231,30 +241,31 @@ namespace cairo {
         }
       }
 
+      run->text = text.substr(0, bytes);
+
       if (bytes && bytes < text.size()) {
         cairo_glyph_free(glyphs);
         cairo_text_cluster_free(clusters);
+        glyphs = nullptr;
+        clusters = nullptr;
 
-        utf8 = text.substr(0, bytes);
-        auto status = cairo_scaled_font_text_to_glyphs(
-            m_scaled, x, y, utf8.c_str(), utf8.size(), &glyphs, &nglyphs, &clusters, &nclusters, &cf);
+        status = cairo_scaled_font_text_to_glyphs(m_scaled, 0.0, 0.0, run->text.c_str(), run->text.size(), &glyphs,
+            &nglyphs, &clusters, &nclusters, &cf);
 
         if (status != CAIRO_STATUS_SUCCESS) {
           throw application_error(sstream() << "cairo_scaled_font_text_to_glyphs()" << cairo_status_to_string(status));
         }
       }
 
+      run->glyphs.clear();
+      run->clusters.clear();
+      run->flags = cf;
+      run->extents = cairo_text_extents_t{};
+
       if (bytes) {
-        // auto lock = make_unique<utils::device_lock>(cairo_surface_get_device(cairo_get_target(m_cairo)));
-        // if (lock.get()) {
-        //   cairo_glyph_path(m_cairo, glyphs, nglyphs);
-        // }
-
-        cairo_text_extents_t extents{};
-        cairo_scaled_font_glyph_extents(m_scaled, glyphs, nglyphs, &extents);
-        cairo_show_text_glyphs(m_cairo, utf8.c_str(), utf8.size(), glyphs, nglyphs, clusters, nclusters, cf);
-        cairo_fill(m_cairo);
-        cairo_move_to(m_cairo, x + extents.x_advance, 0.0);
+        run->glyphs.assign(glyphs, glyphs + nglyphs);
+        run->clusters.assign(clusters, clusters + nclusters);
+        cairo_scaled_font_glyph_extents(m_scaled, glyphs, nglyphs, &run->extents);
       }
 
       cairo_glyph_free(glyphs);
@@ -263,6 +274,20 @@ namespace cairo {
       return bytes;
     }
 
+    void render(cairo_t* cairo, const glyph_run& run, double x = 0.0, double y = 0.0) override {
+      if (run.glyphs.empty()) {
+        return;
+      }
+
+      cairo_save(cairo);
+      cairo_translate(cairo, x, y);
+      cairo_show_text_glyphs(cairo, run.text.c_str(), run.text.size(), run.glyphs.data(), run.glyphs.size(),
+          run.clusters.data(), run.clusters.size(), run.flags);
+      cairo_restore(cairo);
+      cairo_new_path(cairo);
+      cairo_move_to(cairo, x + run.extents.x_advance, 0.0);
+    }
+
     void textwidth(const string& text, cairo_text_extents_t* extents) override {
       cairo_scaled_font_text_extents(m_scaled, text.c_str(), extents);
     }
@@ -299,11 +324,13 @@ namespace cairo {
   /**
    * Match and create font from given fontconfig pattern
    */
-  inline decltype(auto) make_font(cairo_t* cairo, string&& fontname, double offset, double dpi_x, double dpi_y) {
+  inline decltype(auto) make_font(string&& fontname, double offset, double dpi_x, double dpi_y) {
+    // Both libraries are shared by the fonts of all bars in the process
     static bool fc_init{false};
+    static bool ft_init{false};
     if (!fc_init && !(fc_init = FcInit())) {
       throw application_error("Could not load fontconfig");
-    } else if (FT_Init_FreeType(&g_ftlib) != FT_Err_Ok) {
+    } else if (!ft_init && !(ft_init = FT_Init_FreeType(&g_ftlib) == FT_Err_Ok)) {
       throw application_error("Could not load FreeType");
     }
 
@@ -334,7 +361,166 @@ namespace cairo {
     FcPatternPrint(match);
 #endif
 
-    return make_shared<font_fc>(cairo, match, offset, dpi_x, dpi_y);
+    return make_shared<font_fc>(match, offset, dpi_x, dpi_y);
+  }
+
+  /**
+   * \brief Fonts of a bar and the text shaped with them
+   *
+   * Shared by all bars with the same fonts and dpi, see make_font_set()
+   */
+  class font_set {
+   public:
+    /**
+     * \brief Part of a text block rendered using a single font
+     */
+    struct text_run {
+      shared_ptr<font> face;
+      glyph_run glyphs;
+      cairo_text_extents_t extents;
+    };
+
+    using text_runs = shared_ptr<const vector<text_run>>;
+
+    /**
+     * Load the fonts given as "pattern;offset"
+     */
+    explicit font_set(const logger& log, const vector<string>& fonts, double dpi_x, double dpi_y) : m_log(log) {
+      for (const auto& f : fonts) {
+        int offset{0};
+        string pattern{f};
+        size_t pos = pattern.rfind(';');
+        if (pos != string::npos) {
+          offset = std::strtol(pattern.substr(pos + 1).c_str(), nullptr, 10);
+          pattern.erase(pos);
+        }
+        auto font = make_font(string{pattern}, offset, dpi_x, dpi_y);
+        m_log.notice("Loaded font \"%s\" (name=%s, offset=%i, file=%s)", pattern, font->name(), offset, font->file());
+        m_fonts.emplace_back(move(font));
+      }
+    }
+
+    /**
+     * Get the runs of the text, shaping it unless it was
+     * shaped before for this or another bar sharing the set
+     */
+    text_runs shape(int index, const string& text) {
+      std::lock_guard<std::mutex> guard(m_lock);
+
+      auto key = make_pair(index, text);
+      auto runs = m_runs.find(key);
+
+      if (runs == nullptr) {
+        runs = &m_runs.insert(key, make_shared<const vector<text_run>>(split(index, text)));
+        m_log.trace("cairo: Shaped text (cache hits=%lu, misses=%lu, size=%lu)", m_runs.hits(), m_runs.misses(),
+            m_runs.size());
+      }
+
+      return *runs;
+    }
+
+   protected:
+    struct text_key_hash {
+      size_t operator()(const pair<int, string>& key) const {
+        return std::hash<string>{}(key.second) ^ std::hash<int>{}(key.first);
+      }
+    };
+
+    /**
+     * Split the text into runs of glyphs using the first font
+     * that can render them, falling back to the remaining fonts
+     * one character at a time
+     */
+    vector<text_run> split(int index, const string& text) {
+      vector<text_run> runs;
+
+      // Prioritize the preferred font
+      vector<shared_ptr<font>> fns(m_fonts.begin(), m_fonts.end());
+
+      if (index > 0 && index <= std::distance(fns.begin(), fns.end())) {
+        std::iter_swap(fns.begin(), fns.begin() + index - 1);
+      }
+
+      string utf8 = string(text);
+      utils::unicode_charlist chars;
+      utils::utf8_to_ucs4((const unsigned char*)utf8.c_str(), chars);
+
+      while (!chars.empty()) {
+        auto remaining = chars.size();
+        for (auto&& f : fns) {
+          unsigned int matches = 0;
+
+          // Match as many glyphs as possible if the default/preferred font
+          // is being tested. Otherwise test one glyph at a time against
+          // the remaining fonts. Roll back to the top of the font list
+          // when a glyph has been found.
+          if (f == fns.front() && (matches = f->match(chars)) == 0) {
+            continue;
+          } else if (f != fns.front() && (matches = f->match(chars.front())) == 0) {
+            continue;
+          }
+
+          string subset;
+          auto end = chars.begin();
+          while (matches-- && end != chars.end()) {
+            subset += utf8.substr(end->offset, end->length);
+            end++;
+          }
+
+          text_run run{f, glyph_run{}, cairo_text_extents_t{}};
+
+          // Get subset extents
+          f->textwidth(subset, &run.extents);
+          f->shape(subset, &run.glyphs);
+
+          runs.emplace_back(move(run));
+
+          chars.erase(chars.begin(), end);
+          break;
+        }
+
+        if (chars.empty()) {
+          break;
+        } else if (remaining != chars.size()) {
+          continue;
+        }
+
+        char unicode[6]{'\0'};
+        utils::ucs4_to_utf8(unicode, chars.begin()->codepoint);
+        m_log.warn("Dropping unmatched character %s (U+%04x) in '%s'", unicode, chars.begin()->codepoint, text);
+        utf8.erase(chars.begin()->offset, chars.begin()->length);
+        for (auto&& c : chars) {
+          c.offset -= chars.begin()->length;
+        }
+        chars.erase(chars.begin(), ++chars.begin());
+      }
+
+      return runs;
+    }
+
+   private:
+    const logger& m_log;
+    vector<shared_ptr<font>> m_fonts;
+
+    // Text shaped in previous frames, keyed by (font index, contents),
+    // guarded by m_lock since the bars sharing the set all use it
+    std::mutex m_lock;
+    lru_cache<text_runs, pair<int, string>, text_key_hash> m_runs{256};
+  };
+
+  /**
+   * Get the font set for the given fonts and dpi, loading it
+   * unless a bar that is still alive loaded the same one
+   */
+  inline shared_ptr<font_set> make_font_set(const logger& log, const vector<string>& fonts, double dpi_x, double dpi_y) {
+    static cache<font_set, string> sets;
+
+    string key{to_string(dpi_x) + "x" + to_string(dpi_y)};
+    for (const auto& f : fonts) {
+      key += "\n" + f;
+    }
+
+    return sets.object(key, log, fonts, dpi_x, dpi_y);
   }
 }
 
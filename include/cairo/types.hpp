@@ -64,6 +64,17 @@ namespace cairo {
     double *x_advance;
     double *y_advance;
   };
+  /**
+   * \brief Glyphs of a text run, positioned relative to the
+   * origin so that they can be rendered at any offset
+   */
+  struct glyph_run {
+    string text;
+    vector<cairo_glyph_t> glyphs;
+    vector<cairo_text_cluster_t> clusters;
+    cairo_text_cluster_flags_t flags;
+    cairo_text_extents_t extents;
+  };
 }
 
 POLYBAR_NS_END
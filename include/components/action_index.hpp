@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.hpp"
+#include "components/types.hpp"
+
+POLYBAR_NS
+
+/**
+ * Immutable index of the clickable regions of a rendered frame
+ *
+ * The bar is cut into segments at every region boundary and each
+ * segment lists the regions covering it, innermost first. A hit test
+ * is a binary search for the segment followed by a scan over the few
+ * regions nested at that point.
+ *
+ * The renderer publishes one index per frame as a shared snapshot, so
+ * the event handlers neither copy the commands nor wait for a redraw
+ */
+class action_index {
+ public:
+  struct region {
+    mousebtn button;
+    int start;
+    int end;
+    // Number of regions this one is nested in
+    size_t depth;
+    string command;
+  };
+
+  action_index() = default;
+  explicit action_index(const vector<action_block>& blocks);
+
+  const region* find(int x, mousebtn button) const;
+  bool has_click(int x) const;
+  bool has_scroll(int x) const;
+  bool has_double_click() const;
+
+  const vector<region>& regions() const;
+
+ protected:
+  struct segment {
+    int start;
+    int end;
+    // Range of m_covering listing the regions of this segment
+    size_t first;
+    size_t count;
+    bool click;
+    bool scroll;
+  };
+
+  const segment* locate(int x) const;
+
+ private:
+  vector<region> m_regions;
+  vector<segment> m_segments;
+  vector<size_t> m_covering;
+  bool m_double_click{false};
+};
+
+POLYBAR_NS_END
@@ -20,7 +20,6 @@ POLYBAR_NS
 class config;
 class connection;
 class logger;
-class parser;
 class renderer;
 class screen;
 class taskqueue;
@@ -50,23 +49,18 @@ inline double geom_format_to_pixels(std::string str, double max) {
 
 class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::property_notify, evt::enter_notify,
                 evt::leave_notify, evt::motion_notify, evt::destroy_notify, evt::client_message, evt::configure_notify>,
-            public signal_receiver<SIGN_PRIORITY_BAR, signals::eventqueue::start, signals::ui::tick,
-                signals::ui::shade_window, signals::ui::unshade_window, signals::ui::dim_window
-#if WITH_XCURSOR
-                , signals::ui::cursor_change
-#endif
-		> {
+            public signal_receiver<SIGN_PRIORITY_BAR, signals::eventqueue::start> {
  public:
   using make_type = unique_ptr<bar>;
-  static make_type make(bool only_initialize_values = false);
+  static make_type make(string section = "", bool only_initialize_values = false);
 
   explicit bar(connection&, signal_emitter&, const config&, const logger&, unique_ptr<screen>&&,
-      unique_ptr<tray_manager>&&, unique_ptr<parser>&&, unique_ptr<taskqueue>&&, bool only_initialize_values);
+      unique_ptr<tray_manager>&&, unique_ptr<taskqueue>&&, string section, bool only_initialize_values);
   ~bar();
 
-  const bar_settings settings() const;
+  bar_settings_t settings() const;
 
-  void parse(string&& data, bool force = false);
+  void parse(string&& data, render_list&& ops, bool force = false);
 
   void hide();
   void show();
@@ -80,6 +74,16 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   void reconfigure_struts();
   void reconfigure_wm_hints();
   void broadcast_visibility();
+  void publish_settings();
+  bool hosts_tray() const;
+
+  void shade();
+  void unshade();
+  void shade_step();
+  void dim(double value);
+#if WITH_XCURSOR
+  void change_cursor(const string& cursor);
+#endif
 
   void handle(const evt::client_message& evt);
   void handle(const evt::destroy_notify& evt);
@@ -92,13 +96,6 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   void handle(const evt::configure_notify& evt);
 
   bool on(const signals::eventqueue::start&);
-  bool on(const signals::ui::unshade_window&);
-  bool on(const signals::ui::shade_window&);
-  bool on(const signals::ui::tick&);
-  bool on(const signals::ui::dim_window&);
-#if WITH_XCURSOR
-  bool on(const signals::ui::cursor_change&);
-#endif
 
  private:
   connection& m_connection;
@@ -108,12 +105,14 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   unique_ptr<screen> m_screen;
   unique_ptr<tray_manager> m_tray;
   unique_ptr<renderer> m_renderer;
-  unique_ptr<parser> m_parser;
   unique_ptr<taskqueue> m_taskqueue;
 
   bar_settings m_opts{};
+  // Published with atomic loads and stores
+  bar_settings_t m_snapshot{};
 
   string m_lastinput{};
+  render_list m_lastops{};
   std::mutex m_mutex{};
   std::atomic<bool> m_dblclicks{false};
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mutex>
+#include <shared_mutex>
+#include <typeindex>
 #include <unordered_map>
 
 #include "common.hpp"
@@ -48,27 +51,16 @@ class config {
    * Returns true if a given parameter exists
    */
   bool has(const string& section, const string& key) const {
-    auto it = m_sections.find(section);
-    return it != m_sections.end() && it->second.find(key) != it->second.end();
+    return find(section, key) != npos;
   }
 
-  /**
-   * Set parameter value
-   */
-  void set(const string& section, const string& key, string&& value) {
-    auto it = m_sections.find(section);
-    if (it == m_sections.end()) {
-      valuemap_t values;
-      values[key] = value;
-      m_sections[section] = move(values);
-    }
-    auto it2 = it->second.find(key);
-    if ((it2 = it->second.find(key)) == it->second.end()) {
-      it2 = it->second.emplace_hint(it2, key, value);
-    } else {
-      it2->second = value;
-    }
-  }
+  void set(const string& section, const string& key, string&& value);
+
+  void resolve_all() const;
+
+  bool has_section(const string& section) const;
+  valuemap_t get_section(const string& section) const;
+  vector<string> root_references(const string& section) const;
 
   /**
    * Get parameter for the current bar by name
@@ -80,14 +72,32 @@ class config {
 
   /**
    * Get value of a variable by section and parameter name
+   *
+   * The dereferenced value and the converted values are cached, so
+   * repeated lookups only cost the index lookup
    */
   template <typename T = string>
   T get(const string& section, const string& key) const {
-    auto it = m_sections.find(section);
-    if (it == m_sections.end() || it->second.find(key) == it->second.end()) {
+    std::shared_lock<std::shared_timed_mutex> guard(m_sectionlock);
+
+    size_t id{find(section, key)};
+    if (id == npos) {
       throw key_error("Missing parameter \"" + section + "." + key + "\"");
     }
-    return dereference<T>(section, key, it->second.at(key), convert<T>(string{it->second.at(key)}));
+
+    auto cached = lookup<T>(id);
+    if (cached) {
+      return cached->value;
+    }
+
+    size_t generation{0};
+    bool cacheable{true};
+    T result{convert<T>(resolve(id, cacheable, generation))};
+
+    if (cacheable) {
+      store<T>(id, generation, result);
+    }
+    return result;
   }
 
   /**
@@ -97,9 +107,7 @@ class config {
   template <typename T = string>
   T get(const string& section, const string& key, const T& default_value) const {
     try {
-      string string_value{get<string>(section, key)};
-      T result{convert<T>(string{string_value})};
-      return dereference<T>(move(section), move(key), move(string_value), move(result));
+      return get<T>(section, key);
     } catch (const key_error& err) {
       return default_value;
     }
@@ -118,22 +126,7 @@ class config {
    */
   template <typename T = string>
   vector<T> get_list(const string& section, const string& key) const {
-    vector<T> results;
-
-    while (true) {
-      try {
-        string string_value{get<string>(section, key + "-" + to_string(results.size()))};
-        T value{convert<T>(string{string_value})};
-
-        if (!string_value.empty()) {
-          results.emplace_back(dereference<T>(section, key, move(string_value), move(value)));
-        } else {
-          results.emplace_back(move(value));
-        }
-      } catch (const key_error& err) {
-        break;
-      }
-    }
+    vector<T> results{get_list<T>(section, key, vector<T>{})};
 
     if (results.empty()) {
       throw key_error("Missing parameter \"" + section + "." + key + "-0\"");
@@ -152,14 +145,7 @@ class config {
 
     while (true) {
       try {
-        string string_value{get<string>(section, key + "-" + to_string(results.size()))};
-        T value{convert<T>(string{string_value})};
-
-        if (!string_value.empty()) {
-          results.emplace_back(dereference<T>(section, key, move(string_value), move(value)));
-        } else {
-          results.emplace_back(move(value));
-        }
+        results.emplace_back(get<T>(section, key + "-" + to_string(results.size())));
       } catch (const key_error& err) {
         break;
       }
@@ -167,7 +153,6 @@ class config {
 
     if (!results.empty()) {
       return results;
-      ;
     }
 
     return default_value;
@@ -204,172 +189,83 @@ class config {
   }
 
  protected:
-  void copy_inherited();
+  static constexpr size_t npos{static_cast<size_t>(-1)};
 
-  template <typename T>
-  T convert(string&& value) const;
+  struct cached_value {
+    virtual ~cached_value() {}
+  };
 
-  /**
-   * Dereference value reference
-   */
   template <typename T>
-  T dereference(const string& section, const string& key, const string& var, const T& fallback) const {
-    if (var.substr(0, 2) != "${" || var.substr(var.length() - 1) != "}") {
-      return fallback;
-    }
-
-    auto path = var.substr(2, var.length() - 3);
-    size_t pos;
-
-    if (path.compare(0, 4, "env:") == 0) {
-      return dereference_env<T>(path.substr(4));
-    } else if (path.compare(0, 5, "xrdb:") == 0) {
-      return dereference_xrdb<T>(path.substr(5));
-    } else if (path.compare(0, 5, "file:") == 0) {
-      return dereference_file<T>(path.substr(5));
-    } else if ((pos = path.find(".")) != string::npos) {
-      return dereference_local<T>(path.substr(0, pos), path.substr(pos + 1), section);
-    } else {
-      throw value_error("Invalid reference defined at \"" + section + "." + key + "\"");
-    }
-  }
+  struct typed_value : public cached_value {
+    explicit typed_value(T v) : value(move(v)) {}
+    const T value;
+  };
 
   /**
-   * Dereference local value reference defined using:
-   *  ${root.key}
-   *  ${root.key:fallback}
-   *  ${self.key}
-   *  ${self.key:fallback}
-   *  ${section.key}
-   *  ${section.key:fallback}
+   * Indexed parameter, holding the raw value along with the
+   * dereferenced and converted values once they are known
    */
-  template <typename T>
-  T dereference_local(string section, const string& key, const string& current_section) const {
-    if (section == "BAR") {
-      m_log.warn("${BAR.key} is deprecated. Use ${root.key} instead");
-    }
+  struct entry {
+    size_t section;
+    size_t key;
+    string raw;
+    bool resolved{false};
+    string value;
+    // Bumped whenever the cached values are dropped
+    size_t generation{0};
+    vector<pair<std::type_index, shared_ptr<const cached_value>>> values;
+    // Entries with references to this one
+    vector<size_t> dependents;
+  };
 
-    section = string_util::replace(section, "BAR", this->section(), 0, 3);
-    section = string_util::replace(section, "root", this->section(), 0, 4);
-    section = string_util::replace(section, "self", current_section, 0, 4);
+  void copy_inherited();
+  void build_index();
+  size_t find(const string& section, const string& key) const;
+  void invalidate(size_t id);
 
-    try {
-      string string_value{get<string>(section, key)};
-      T result{convert<T>(string{string_value})};
-      return dereference<T>(string(section), move(key), move(string_value), move(result));
-    } catch (const key_error& err) {
-      size_t pos;
-      if ((pos = key.find(':')) != string::npos) {
-        string fallback = key.substr(pos + 1);
-        m_log.info("The reference ${%s.%s} does not exist, using defined fallback value \"%s\"", section,
-            key.substr(0, pos), fallback);
-        return convert<T>(move(fallback));
-      }
-      throw value_error("The reference ${" + section + "." + key + "} does not exist (no fallback set)");
-    }
-  }
+  string resolve(size_t id, bool& cacheable, size_t& generation) const;
+  bool reads_file(size_t id) const;
 
   /**
-   * Dereference environment variable reference defined using:
-   *  ${env:key}
-   *  ${env:key:fallback value}
+   * Get the cached converted value of the entry
    */
   template <typename T>
-  T dereference_env(string var) const {
-    size_t pos;
-    string env_default;
-    /*
-     * This is needed because with only the string we cannot distinguish
-     * between an empty string as default and not default
-     */
-    bool has_default = false;
-
-    if ((pos = var.find(':')) != string::npos) {
-      env_default = var.substr(pos + 1);
-      has_default = true;
-      var.erase(pos);
-    }
-
-    if (env_util::has(var)) {
-      string env_value{env_util::get(var)};
-      m_log.info("Environment var reference ${%s} found (value=%s)", var, env_value);
-      return convert<T>(move(env_value));
-    } else if (has_default) {
-      m_log.info("Environment var ${%s} is undefined, using defined fallback value \"%s\"", var, env_default);
-      return convert<T>(move(env_default));
-    } else {
-      throw value_error(sstream() << "Environment var ${" << var << "} does not exist (no fallback set)");
+  shared_ptr<const typed_value<T>> lookup(size_t id) const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    for (auto&& v : m_entries[id].values) {
+      if (v.first == std::type_index(typeid(T))) {
+        return std::static_pointer_cast<const typed_value<T>>(v.second);
+      }
     }
+    return nullptr;
   }
 
   /**
-   * Dereference X resource db value defined using:
-   *  ${xrdb:key}
-   *  ${xrdb:key:fallback value}
+   * Cache the converted value, unless the entry changed in the meantime
    */
   template <typename T>
-  T dereference_xrdb(string var) const {
-    size_t pos;
-#if not WITH_XRM
-    m_log.warn("No built-in support to dereference ${xrdb:%s} references (requires `xcb-util-xrm`)", var);
-    if ((pos = var.find(':')) != string::npos) {
-      return convert<T>(var.substr(pos + 1));
-    }
-    return convert<T>("");
-#else
-    if (!m_xrm) {
-      throw application_error("xrm is not initialized");
-    }
-
-    string fallback;
-    bool has_fallback = false;
-    if ((pos = var.find(':')) != string::npos) {
-      fallback = var.substr(pos + 1);
-      has_fallback = true;
-      var.erase(pos);
+  void store(size_t id, size_t generation, const T& value) const {
+    // Converted pointers would refer to a temporary
+    if (std::is_pointer<T>::value) {
+      return;
     }
-
-    try {
-      auto value = m_xrm->require<string>(var.c_str());
-      m_log.info("Found matching X resource \"%s\" (value=%s)", var, value);
-      return convert<T>(move(value));
-    } catch (const xresource_error& err) {
-      if (has_fallback) {
-        m_log.info("%s, using defined fallback value \"%s\"", err.what(), fallback);
-        return convert<T>(move(fallback));
-      }
-      throw value_error(sstream() << err.what() << " (no fallback set)");
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto& e = m_entries[id];
+    if (e.generation == generation) {
+      e.values.emplace_back(std::type_index(typeid(T)), make_shared<const typed_value<T>>(value));
     }
-#endif
   }
 
-  /**
-   * Dereference file reference by reading its contents
-   *  ${file:/absolute/file/path}
-   *  ${file:/absolute/file/path:fallback value}
-   */
   template <typename T>
-  T dereference_file(string var) const {
-    size_t pos;
-    string fallback;
-    bool has_fallback = false;
-    if ((pos = var.find(':')) != string::npos) {
-      fallback = var.substr(pos + 1);
-      has_fallback = true;
-      var.erase(pos);
-    }
-    var = file_util::expand(var);
-
-    if (file_util::exists(var)) {
-      m_log.info("File reference \"%s\" found", var);
-      return convert<T>(string_util::trim(file_util::contents(var), '\n'));
-    } else if (has_fallback) {
-      m_log.info("File reference \"%s\" not found, using defined fallback value \"%s\"", var, fallback);
-      return convert<T>(move(fallback));
-    } else {
-      throw value_error(sstream() << "The file \"" << var << "\" does not exist (no fallback set)");
-    }
-  }
+  T convert(string&& value) const;
+
+  string dereference(const string& section, const string& key, const string& var, bool& cacheable, size_t id) const;
+  string local_section(string section, const string& current_section) const;
+  string dereference_local(string section, const string& key, const string& current_section, bool& cacheable,
+      size_t dependent) const;
+  string dereference_env(string var) const;
+  string dereference_xrdb(string var) const;
+  string dereference_file(string var) const;
 
  private:
   const logger& m_log;
@@ -382,9 +278,41 @@ class config {
    * config (Path of the main config file also included)
    */
   file_list m_included;
+
+  // Interned section and key names, which together identify an entry
+  std::unordered_map<string, size_t> m_section_ids;
+  std::unordered_map<string, size_t> m_key_ids;
+  vector<string> m_section_names;
+  vector<string> m_key_names;
+  std::unordered_map<uint64_t, size_t> m_slots;
+
+  mutable std::mutex m_lock;
+  mutable vector<entry> m_entries;
+
+  // Held exclusively while the sections are replaced, so that lookups
+  // from other threads never see a partially built index
+  mutable std::shared_timed_mutex m_sectionlock;
 #if WITH_XRM
   unique_ptr<xresource_manager> m_xrm;
 #endif
 };
 
+/**
+ * Resolved values of the sections a running bar depends on, taken
+ * before and after a reload to find out what has to be rebuilt
+ */
+class config_snapshot {
+ public:
+  explicit config_snapshot(const config& conf, const vector<string>& bars, const vector<string>& modules);
+
+  bool bars_equal(const config_snapshot& other) const;
+  bool module_equal(const config_snapshot& other, const string& name) const;
+
+ private:
+  // Without the module lists, which only decide the blocks
+  vector<valuemap_t> m_bars;
+  valuemap_t m_settings;
+  std::map<string, valuemap_t> m_modules;
+};
+
 POLYBAR_NS_END
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <set>
 
 #include "common.hpp"
@@ -7,6 +8,7 @@
 #include "components/logger.hpp"
 #include "errors.hpp"
 #include "utils/file.hpp"
+#include "utils/mixins.hpp"
 #include "utils/string.hpp"
 
 POLYBAR_NS
@@ -90,6 +92,7 @@ struct line_t {
 class config_parser {
  public:
   config_parser(const logger& logger, string&& file, string&& bar);
+  ~config_parser();
 
   /**
    * \brief Performs the parsing of the main config file m_file
@@ -102,6 +105,41 @@ class config_parser {
   config::make_type parse();
 
  protected:
+  /**
+   * \brief A header or key-value line, pointing into the contents of its file
+   *
+   * For headers, `key` holds the section name
+   */
+  struct token {
+    int file_index;
+    int line_no;
+    bool is_header;
+    const char* key;
+    size_t key_len;
+    const char* value;
+    size_t value_len;
+  };
+
+  /**
+   * \brief Contents of a config file and the tokens found in it
+   *
+   * The file is read into a buffer of its own rather than mapped, so that
+   * it being truncated meanwhile can't fault the parser. The tokens point
+   * into those contents, so a source has to outlive the sectionmap creation
+   */
+  class source : non_copyable_mixin<source> {
+   public:
+    explicit source(const string& file);
+
+    const char* data() const;
+    size_t size() const;
+
+    vector<token> tokens;
+
+   private:
+    string m_buffer;
+  };
+
   /**
    * \brief Converts the `lines` vector to a proper sectionmap
    */
@@ -118,6 +156,15 @@ class config_parser {
    */
   void parse_file(const string& file, file_list path);
 
+  /**
+   * \brief Splits the contents of the given file into tokens
+   *
+   * This is the allocation free equivalent of calling parse_line on every
+   * line. Lines that are not well formed are passed to parse_line to
+   * produce the same syntax_error
+   */
+  void tokenize(source& src, int file_index);
+
   /**
    * \brief Parses the given line string to create a line_t struct
    *
@@ -202,6 +249,13 @@ class config_parser {
    *        in config_parser::m_forbidden_chars
    */
   bool is_valid_name(const string& name);
+  bool is_valid_name(const char* name, size_t len) const;
+  bool is_reserved_name(const char* name, size_t len) const;
+
+  /**
+   * \brief Throws the syntax_error parse_line produces for the given line
+   */
+  [[noreturn]] void invalid_line(int file_index, int line_no, const char* begin, const char* end);
 
   /**
    * \brief Whether or not an xresource manager should be used
@@ -222,19 +276,31 @@ class config_parser {
    */
   string m_barname;
 
+  /**
+   * \brief Contents of every file in m_files, at the same index
+   *
+   * A file that is included more than once is only read and tokenized once
+   */
+  vector<unique_ptr<source>> m_sources;
+
   /**
    * \brief List of all the lines in the config (with included files)
    *
    * The order here matters, as we have not yet associated key-value pairs
    * with sections
    */
-  vector<line_t> m_lines;
+  vector<const token*> m_lines;
 
   /**
    * \brief None of these characters can be used in the key and section names
    */
   const string m_forbidden_chars{"\"'=;#[](){}:.$\\%"};
 
+  /**
+   * \brief Lookup table of the characters allowed in names
+   */
+  std::array<bool, 256> m_name_chars{};
+
   /**
    * \brief List of names that cannot be used as section names
    *
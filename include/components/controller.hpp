@@ -2,9 +2,11 @@
 
 #include <moodycamel/blockingconcurrentqueue.h>
 
+#include <mutex>
 #include <thread>
 
 #include "common.hpp"
+#include "components/types.hpp"
 #include "events/signal_fwd.hpp"
 #include "events/signal_receiver.hpp"
 #include "events/types.hpp"
@@ -21,9 +23,12 @@ class bar;
 class command;
 class config;
 class connection;
+class eventloop;
+class frame_scheduler;
 class inotify_watch;
 class ipc;
 class logger;
+class parser;
 class signal_emitter;
 namespace modules {
   struct module_interface;
@@ -41,10 +46,11 @@ class controller
           signals::ui::ready, signals::ui::button_press, signals::ui::update_background> {
  public:
   using make_type = unique_ptr<controller>;
-  static make_type make(unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch);
+  static make_type make(
+      const vector<string>& bars, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch);
 
-  explicit controller(connection&, signal_emitter&, const logger&, const config&, unique_ptr<bar>&&, unique_ptr<ipc>&&,
-      unique_ptr<inotify_watch>&&);
+  explicit controller(connection&, signal_emitter&, eventloop&, const logger&, const config&, vector<unique_ptr<bar>>&&,
+      unique_ptr<parser>&&, unique_ptr<ipc>&&, unique_ptr<inotify_watch>&&);
   ~controller();
 
   bool run(bool writeback, string snapshot_dst);
@@ -57,6 +63,7 @@ class controller
   void process_eventqueue();
   void process_inputdata();
   bool process_update(bool force);
+  void reload();
 
   bool on(const signals::eventqueue::notify_change& evt);
   bool on(const signals::eventqueue::notify_forcechange& evt);
@@ -71,13 +78,79 @@ class controller
   bool on(const signals::ui::update_background& evt);
 
  private:
-  size_t setup_modules(alignment align);
+  /**
+   * \brief Cached output of a single module
+   */
+  struct segment {
+    string contents{};
+    render_list ops{};
+    bool valid{false};
+  };
+
+  /**
+   * \brief Separators, margins and padding placed between the segments
+   *
+   * Built for one snapshot of the bar settings
+   */
+  struct glue {
+    bar_settings_t settings{};
+    string separator{};
+    string margin_left{};
+    string margin_right{};
+    string padding_left{};
+    string padding_right{};
+    render_list separator_ops{};
+    render_list margin_left_ops{};
+    render_list margin_right_ops{};
+    render_list padding_left_ops{};
+    render_list padding_right_ops{};
+  };
+
+  /**
+   * \brief A bar window and the output assembled for it
+   */
+  struct bar_state {
+    unique_ptr<bar> instance{};
+
+    /**
+     * \brief Modules of the bar grouped by block
+     */
+    modulemap_t blocks{};
+
+    /**
+     * \brief Compacted module output, per block and module
+     */
+    std::map<alignment, vector<segment>> segments{};
+
+    /**
+     * \brief Assembled block contents, rebuilt when one of its segments changes
+     */
+    std::map<alignment, string> block_contents{};
+
+    /**
+     * \brief Render ops of the assembled block contents
+     */
+    std::map<alignment, render_list> block_ops{};
+
+    /**
+     * \brief Glue between the segments, rebuilt when the bar settings change
+     */
+    glue parts{};
+  };
+
+  size_t setup_modules(bar_state& state, alignment align, std::map<string, module_t>& reusable);
+  bool start_module(const module_t& module);
+  void assemble(bar_state& state, std::map<const modules::module_interface*, string>& outputs, string& contents,
+      render_list& ops, size_t& copied, size_t& rebuilt);
+  void build_glue(bar_state& state, bar_settings_t settings);
+  void parse(const bar_settings& bar, const string& data, render_list& ops, const string& context);
 
   connection& m_connection;
   signal_emitter& m_sig;
+  eventloop& m_loop;
   const logger& m_log;
   const config& m_conf;
-  unique_ptr<bar> m_bar;
+  unique_ptr<parser> m_parser;
   unique_ptr<ipc> m_ipc;
   unique_ptr<inotify_watch> m_confwatch;
   unique_ptr<command> m_command;
@@ -105,14 +178,29 @@ class controller
   moodycamel::BlockingConcurrentQueue<event> m_queue;
 
   /**
-   * \brief Loaded modules
+   * \brief Bars drawn by this process, the first one is the bar the config was loaded for
+   */
+  vector<bar_state> m_bars;
+
+  /**
+   * \brief Number of bars that have mapped their window
+   */
+  size_t m_ready_bars{0};
+
+  /**
+   * \brief Loaded modules, each instance only once
    */
   vector<module_t> m_modules;
 
   /**
-   * \brief Loaded modules grouped by block
+   * \brief Loaded modules by the key they are shared between bars under
+   */
+  std::map<string, module_t> m_instances;
+
+  /**
+   * \brief Number of bytes copied while assembling the bar contents
    */
-  modulemap_t m_blocks;
+  size_t m_bytes_copied{0};
 
   /**
    * \brief Module input handlers
@@ -120,15 +208,20 @@ class controller
   vector<modules::input_handler*> m_inputhandlers;
 
   /**
-   * \brief Maximum number of subsequent events to swallow
+   * \brief Guards the module lists, which are replaced when the config is reloaded
    */
-  size_t m_swallow_limit{5U};
+  std::mutex m_modulelock;
 
   /**
-   * \brief Time to wait for subsequent events
+   * \brief Minimum time between two frames
    */
   std::chrono::milliseconds m_swallow_update{10};
 
+  /**
+   * \brief Coalesces module updates into frames
+   */
+  unique_ptr<frame_scheduler> m_frames;
+
   /**
    * \brief Time to throttle input events
    */
@@ -149,6 +242,12 @@ class controller
    */
   std::thread m_event_thread;
 
+  /**
+   * \brief Thread dispatching the module event loop in reactor mode
+   */
+  std::thread m_reactor_thread;
+  std::atomic<bool> m_reactor_running{false};
+
   /**
    * \brief Misc threads
    */
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <map>
+
+#include "common.hpp"
+#include "components/types.hpp"
+
+POLYBAR_NS
+
+/**
+ * Computes the parts of the bar that changed between two frames
+ *
+ * The renderer reports the geometry of every alignment block and the
+ * ranges drawn by its text nodes. Blocks that were moved or resized
+ * are damaged as a whole, otherwise only the range between the first
+ * and the last changed text node is. The damaged ranges are clipped
+ * to the drawable area and overlapping ranges are merged
+ */
+class damage_tracker {
+ public:
+  /**
+   * Horizontal range drawn by a single text node, relative to its block,
+   * and a hash of everything that affects its pixels
+   */
+  struct span {
+    double x0;
+    double x1;
+    size_t hash;
+
+    bool operator==(const span& other) const {
+      return hash == other.hash && x0 == other.x0 && x1 == other.x1;
+    }
+  };
+
+  /**
+   * Geometry and contents of an alignment block
+   */
+  struct block {
+    double x{0.0};
+    double w{0.0};
+    bool fits{true};
+    vector<span> spans{};
+  };
+
+  void invalidate();
+  bool full() const;
+
+  vector<xcb_rectangle_t> update(const xcb_rectangle_t& rect, std::map<alignment, block> blocks);
+
+  static vector<xcb_rectangle_t> merge(vector<xcb_rectangle_t> regions);
+
+ private:
+  std::map<alignment, block> m_prev;
+  xcb_rectangle_t m_rect{0, 0, 0U, 0U};
+  bool m_full{true};
+  bool m_pending{true};
+};
+
+POLYBAR_NS_END
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+using namespace std::chrono_literals;
+
+/**
+ * Registry used to multiplex file descriptors and timers
+ * on a single epoll set.
+ *
+ * The controller registers the X connection, the ipc channel
+ * and the config watch here and runs `dispatch()` as its main
+ * loop. Any other component can plug in an fd (signalfd,
+ * timerfd, sockets, ...) using `add()` without touching the loop.
+ *
+ * In reactor mode the modules register their timers, event
+ * sockets and inotify watches with a second instance instead of
+ * spawning a thread each. That loop runs on a thread of its own, so
+ * that module updates don't hold up the X events.
+ */
+class eventloop : non_copyable_mixin<eventloop> {
+ public:
+  using make_type = eventloop&;
+  static make_type make();
+  static make_type make_reactor();
+
+  using callback = function<void()>;
+  using duration = chrono::duration<double>;
+
+  explicit eventloop();
+  ~eventloop();
+
+  void enable(bool state);
+  bool enabled() const;
+
+  void add(int fd, callback cb, uint32_t events = EPOLLIN);
+  int add_timer(callback cb, duration initial = duration{0});
+  void arm(int timer_fd, duration timeout);
+  void remove(int fd);
+
+  size_t dispatch(int timeout_ms = -1);
+  int get_file_descriptor() const;
+
+ protected:
+  struct handler {
+    callback func;
+    uint32_t generation;
+    bool timer;
+  };
+
+ private:
+  int m_fd{-1};
+  std::atomic<bool> m_enabled{false};
+
+  std::mutex m_lock;
+  std::unordered_map<int, shared_ptr<handler>> m_handlers;
+  uint32_t m_generation{0};
+
+  // Fd whose callback is running and the thread running it
+  int m_current{-1};
+  std::thread::id m_dispatcher{};
+  std::condition_variable m_idle;
+};
+
+POLYBAR_NS_END
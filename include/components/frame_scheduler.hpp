@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+/**
+ * Decides when the bar gets redrawn
+ *
+ * Update requests are coalesced into a single pending frame, which
+ * becomes due once the minimum interval since the previous frame has
+ * passed. An idle bar reacts right away while a busy one is capped
+ * at `max_fps`.
+ *
+ * Requests may come from any thread, frames are rendered by the
+ * controller's event queue thread. The pending frame is taken with
+ * begin_frame() before the module output is read, so that requests
+ * made while the frame is built open the next one
+ */
+class frame_scheduler {
+ public:
+  using clock = chrono::steady_clock;
+
+  /**
+   * Upper bounds (in ms) of the latency histogram buckets,
+   * the last bucket holds everything above
+   */
+  static constexpr array<unsigned int, 8> latency_buckets{{1, 2, 5, 10, 20, 50, 100, 250}};
+
+  struct metrics {
+    size_t rendered{0};
+    size_t coalesced{0};
+    size_t dropped{0};
+    array<size_t, latency_buckets.size() + 1> latency{};
+  };
+
+  explicit frame_scheduler(double max_fps = 0.0);
+
+  bool request(clock::time_point now = clock::now());
+  bool pending() const;
+  bool due(clock::time_point now = clock::now()) const;
+  clock::duration until_due(clock::time_point now = clock::now()) const;
+  void begin_frame();
+  void rendered(clock::time_point now = clock::now());
+
+  metrics stats() const;
+  string report() const;
+
+ protected:
+  clock::time_point deadline() const;
+  void take_pending();
+
+ private:
+  mutable std::mutex m_lock;
+  clock::duration m_interval{};
+  clock::time_point m_lastframe{};
+  clock::time_point m_requested{};
+  bool m_pending{false};
+
+  // Frame taken by begin_frame() and not rendered yet
+  bool m_building{false};
+  bool m_frame_has_request{false};
+  clock::time_point m_frame_deadline{};
+  clock::time_point m_frame_requested_at{};
+
+  metrics m_metrics{};
+};
+
+POLYBAR_NS_END
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <deque>
+#include <map>
+
 #include "common.hpp"
 #include "settings.hpp"
 #include "utils/concurrency.hpp"
 
 POLYBAR_NS
 
+class eventloop;
 class file_descriptor;
 class logger;
 class signal_emitter;
@@ -17,30 +21,61 @@ static constexpr const char* ipc_command_prefix{"cmd:"};
 static constexpr const char* ipc_hook_prefix{"hook:"};
 static constexpr const char* ipc_action_prefix{"action:"};
 
+/**
+ * Replies sent back over the ipc socket
+ */
+static constexpr const char* ipc_reply_ok{"ok"};
+static constexpr const char* ipc_reply_error{"error: "};
+
 /**
  * Component used for inter-process communication.
  *
  * A unique messaging channel will be setup for each
  * running process which will allow messages and
  * events to be sent to the process externally.
+ *
+ * Messages are accepted on a unix socket of type SOCK_SEQPACKET, where
+ * every packet is one message and gets a reply packet, and on a fifo
+ * where every line is one message. Both are served from the event loop.
+ * Replies that don't fit into the socket are queued until the client
+ * reads them, and no further messages are read from it meanwhile
  */
 class ipc {
  public:
   using make_type = unique_ptr<ipc>;
   static make_type make();
 
-  explicit ipc(signal_emitter& emitter, const logger& logger);
+  explicit ipc(signal_emitter& emitter, eventloop& loop, const logger& logger);
   ~ipc();
 
+  void start();
+  void stop();
+
   void receive_message();
   int get_file_descriptor() const;
+  const string& get_socket_path() const;
+
+ protected:
+  void accept_clients();
+  void receive_packets(int fd);
+  bool send_replies(int fd);
+  void close_client(int fd);
+  vector<string> process(const vector<string>& messages);
 
  private:
   signal_emitter& m_sig;
+  eventloop& m_loop;
   const logger& m_log;
 
   string m_path{};
   unique_ptr<file_descriptor> m_fd;
+
+  string m_socket_path{};
+  unique_ptr<file_descriptor> m_socket;
+  // Connected clients and the replies they haven't taken yet
+  std::map<int, std::deque<string>> m_clients;
+
+  bool m_started{false};
 };
 
 POLYBAR_NS_END
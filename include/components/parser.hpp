@@ -5,11 +5,11 @@
 
 POLYBAR_NS
 
-class signal_emitter;
 enum class attribute;
 enum class controltag;
 enum class mousebtn;
 struct bar_settings;
+struct render_list;
 
 DEFINE_ERROR(parser_error);
 DEFINE_CHILD_ERROR(unrecognized_token, parser_error);
@@ -22,24 +22,26 @@ class parser {
   static make_type make();
 
  public:
-  explicit parser(signal_emitter& emitter);
-  void parse(const bar_settings& bar, string data);
+  explicit parser() = default;
+  void parse(const bar_settings& bar, const string& data, render_list& ops);
 
  protected:
-  void codeblock(string&& data, const bar_settings& bar);
-  size_t text(string&& data);
+  void codeblock(const string& data, size_t begin, size_t end, const bar_settings& bar, render_list& ops);
+  void text(const string& data, size_t begin, size_t end, render_list& ops);
 
   static unsigned int parse_color(const string& s, unsigned int fallback = 0);
   static int parse_fontindex(const string& s);
   static attribute parse_attr(const char attr);
-  mousebtn parse_action_btn(const string& data);
+  mousebtn parse_action_btn(char btn);
   static string parse_action_cmd(string&& data);
+  static size_t parse_action_cmd(const string& data, size_t begin, size_t end);
   static controltag parse_control(const string& data);
 
  private:
-  signal_emitter& m_sig;
   vector<int> m_actions;
-  unique_ptr<parser> m_parser;
+
+  // Scratch buffer reused between calls to avoid allocating per token
+  string m_value;
 };
 
 POLYBAR_NS_END
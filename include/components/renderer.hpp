@@ -6,6 +6,8 @@
 
 #include "cairo/fwd.hpp"
 #include "common.hpp"
+#include "components/action_index.hpp"
+#include "components/damage_tracker.hpp"
 #include "components/types.hpp"
 #include "events/signal_fwd.hpp"
 #include "events/signal_receiver.hpp"
@@ -30,13 +32,7 @@ struct alignment_block {
   double y;
 };
 
-class renderer
-    : public signal_receiver<SIGN_PRIORITY_RENDERER, signals::ui::request_snapshot, signals::parser::change_background,
-          signals::parser::change_foreground, signals::parser::change_underline, signals::parser::change_overline,
-          signals::parser::change_font, signals::parser::change_alignment, signals::parser::reverse_colors,
-          signals::parser::offset_pixel, signals::parser::attribute_set, signals::parser::attribute_unset,
-          signals::parser::attribute_toggle, signals::parser::action_begin, signals::parser::action_end,
-          signals::parser::text, signals::parser::control> {
+class renderer : public signal_receiver<SIGN_PRIORITY_RENDERER, signals::ui::request_snapshot> {
  public:
   using make_type = unique_ptr<renderer>;
   static make_type make(const bar_settings& bar);
@@ -46,9 +42,10 @@ class renderer
   ~renderer();
 
   xcb_window_t window() const;
-  const vector<action_block> actions() const;
+  shared_ptr<const action_index> actions() const;
 
   void begin(xcb_rectangle_t rect);
+  void render(const render_list& list);
   void end();
   void flush();
 
@@ -68,24 +65,17 @@ class renderer
   double block_h(alignment a) const;
 
   void flush(alignment a);
+  void flush(const vector<xcb_rectangle_t>& regions);
   void highlight_clickable_areas();
 
+  vector<xcb_rectangle_t> damaged_regions();
+
+  void change_alignment(alignment align);
+  void action_begin(mousebtn btn, string&& command);
+  void action_end(mousebtn btn);
+  void control(controltag ctrl);
+
   bool on(const signals::ui::request_snapshot& evt);
-  bool on(const signals::parser::change_background& evt);
-  bool on(const signals::parser::change_foreground& evt);
-  bool on(const signals::parser::change_underline& evt);
-  bool on(const signals::parser::change_overline& evt);
-  bool on(const signals::parser::change_font& evt);
-  bool on(const signals::parser::change_alignment& evt);
-  bool on(const signals::parser::reverse_colors&);
-  bool on(const signals::parser::offset_pixel& evt);
-  bool on(const signals::parser::attribute_set& evt);
-  bool on(const signals::parser::attribute_unset& evt);
-  bool on(const signals::parser::attribute_toggle& evt);
-  bool on(const signals::parser::action_begin& evt);
-  bool on(const signals::parser::action_end& evt);
-  bool on(const signals::parser::text& evt);
-  bool on(const signals::parser::control& evt);
 
  protected:
   struct reserve_area {
@@ -133,9 +123,18 @@ class renderer
   unsigned int m_ol{0U};
   unsigned int m_ul{0U};
   vector<action_block> m_actions;
+  // Published with atomic loads and stores, readers keep the snapshot they got
+  shared_ptr<const action_index> m_action_index{make_shared<action_index>()};
+
+  map<alignment, vector<damage_tracker::span>> m_spans;
+  damage_tracker m_damage;
+  size_t m_pixels_touched{0};
 
   bool m_fixedcenter;
   string m_snapshot_dst;
+
+  // Scratch buffer for the text runs of a render list
+  string m_text;
 };
 
 POLYBAR_NS_END
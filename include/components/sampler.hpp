@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+/**
+ * Shared reader for procfs and sysfs files
+ *
+ * Each file is opened once for the whole process and re-read with
+ * `pread` into a buffer that is reused between samples. Subscribers
+ * of the same file share its samples: a read is only issued if the
+ * last sample is older than the age the caller accepts, so two cpu
+ * modules polling every second cost one read of /proc/stat.
+ *
+ * The sampler only keeps weak references, a file is closed once the
+ * last subscriber drops its handle
+ */
+class sampler : non_copyable_mixin<sampler> {
+ public:
+  using make_type = sampler&;
+  static make_type make();
+
+  using clock = chrono::steady_clock;
+
+  class source {
+   public:
+    explicit source(string path);
+    ~source();
+
+    const string& path() const;
+    size_t reads() const;
+
+   protected:
+    friend class sampler;
+
+    void refresh(clock::time_point now, clock::duration max_age);
+    bool reopen();
+
+    std::mutex m_lock;
+    const string m_path;
+    int m_fd{-1};
+    string m_buffer;
+    size_t m_length{0};
+    size_t m_reads{0};
+    clock::time_point m_sampled{};
+  };
+
+  using handle = shared_ptr<source>;
+
+  explicit sampler() = default;
+
+  handle subscribe(const string& path);
+
+  /**
+   * Call `fn(const char* data, size_t len)` with a sample of the
+   * file that is at most `max_age` old
+   */
+  template <typename Fn>
+  auto read(const handle& src, clock::duration max_age, Fn&& fn) -> decltype(fn(nullptr, 0)) {
+    std::lock_guard<std::mutex> guard(src->m_lock);
+    src->refresh(clock::now(), max_age);
+    return fn(src->m_buffer.data(), src->m_length);
+  }
+
+ private:
+  std::mutex m_lock;
+  std::unordered_map<string, std::weak_ptr<source>> m_sources;
+};
+
+POLYBAR_NS_END
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+class eventloop;
+class logger;
+
+/**
+ * Runs the shell commands of the script modules
+ *
+ * Commands are started with `posix_spawn` and their output is read
+ * from non-blocking pipes. Completion is detected using a pidfd, or
+ * by polling `waitpid` with `WNOHANG` on kernels without pidfds, so
+ * no thread has to block in it. Everything happens on one
+ * epoll set, which is dispatched from the shared event loop in reactor
+ * mode and from a single thread of its own otherwise.
+ *
+ * Identical commands submitted while one is already queued or
+ * running share that invocation, and at most `limit` commands run
+ * at the same time
+ */
+class script_executor : non_copyable_mixin<script_executor> {
+ public:
+  using make_type = script_executor&;
+  static make_type make();
+
+  using clock = chrono::steady_clock;
+
+  struct result {
+    // Exit status, -1 if the command could not be run or was killed
+    int status{-1};
+    string output;
+  };
+
+  using callback = function<void(const result&)>;
+
+  struct stats {
+    size_t runs{0};
+    // Submissions that were served by an invocation already in flight
+    size_t shared{0};
+    clock::duration queued{};
+    clock::duration spawn{};
+    chrono::microseconds user{};
+    chrono::microseconds system{};
+  };
+
+  explicit script_executor(eventloop& loop, const logger& logger);
+  ~script_executor();
+
+  void set_limit(size_t limit);
+
+  size_t submit(const string& cmd, callback cb, const string& key = "");
+  void cancel(size_t ticket);
+  result run(const string& cmd);
+
+  stats get_stats(const string& key) const;
+  string report(const string& key) const;
+
+  size_t dispatch(int timeout_ms = -1);
+  int get_file_descriptor() const;
+
+ protected:
+  struct job {
+    string cmd;
+    // Statistics are accumulated under this key
+    string key;
+    vector<pair<size_t, callback>> callbacks;
+    pid_t pid{-1};
+    int out{-1};
+    int pidfd{-1};
+    bool exited{false};
+    bool eof{false};
+    result res{};
+    clock::time_point submitted{};
+  };
+
+  void start();
+  void spawn(const shared_ptr<job>& j);
+  void drain(job& j);
+  void reap(job& j, bool block);
+  bool complete(const shared_ptr<job>& j);
+  void watch(int fd, const shared_ptr<job>& j);
+  void unwatch(int& fd);
+  void poll(bool enable);
+
+  // Disabled by the tests to exercise the fallback
+  bool m_use_pidfd{true};
+
+ private:
+  eventloop& m_loop;
+  const logger& m_log;
+
+  int m_epoll{-1};
+  int m_wakeup{-1};
+  int m_reaper{-1};
+
+  std::thread m_thread;
+  std::atomic_bool m_active{true};
+  bool m_started{false};
+
+  mutable std::mutex m_lock;
+  std::mutex m_calllock;
+  std::atomic<std::thread::id> m_caller{};
+
+  size_t m_limit{8};
+  size_t m_running{0};
+  size_t m_ticket{0};
+
+  // Queued or running invocation of each command
+  std::unordered_map<string, shared_ptr<job>> m_jobs;
+  std::deque<shared_ptr<job>> m_queue;
+  std::unordered_map<int, shared_ptr<job>> m_fds;
+  std::unordered_map<size_t, std::weak_ptr<job>> m_tickets;
+  vector<shared_ptr<job>> m_done;
+  // Running commands without a pidfd, polled by the reaper timer
+  vector<shared_ptr<job>> m_polled;
+  std::unordered_map<string, stats> m_stats;
+};
+
+POLYBAR_NS_END
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "common.hpp"
+#include "utils/command.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+class logger;
+
+/**
+ * Persistent worker of a script module
+ *
+ * The command is started once and asked for new output by writing a
+ * request line to its stdin or by sending it a signal. It has to reply
+ * with a single line on stdout. Workers that exit, stop accepting
+ * requests or don't reply in time are restarted on the next query
+ */
+class script_worker : non_copyable_mixin<script_worker> {
+ public:
+  explicit script_worker(const logger& logger, string name, string request, int request_signal,
+      chrono::duration<double> timeout);
+
+  bool query(const string& exec, int counter, string& reply, const std::atomic<bool>& stopping);
+  void stop();
+
+  bool running();
+  pid_t get_pid();
+
+ protected:
+  void start(const string& exec);
+  bool request(int counter);
+  bool fill(int fd);
+  bool next_line(string& line);
+
+ private:
+  const logger& m_log;
+  const string m_name;
+
+  const string m_request;
+  const int m_request_signal;
+  const chrono::duration<double> m_timeout;
+
+  unique_ptr<command> m_command;
+
+  // Output read from the worker that doesn't form a complete line yet
+  string m_buffer;
+};
+
+POLYBAR_NS_END
@@ -5,6 +5,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "utils/mixins.hpp"
@@ -14,20 +15,32 @@ POLYBAR_NS
 namespace chrono = std::chrono;
 using namespace std::chrono_literals;
 
+class eventloop;
+
+/**
+ * Runs deferred (and optionally repeated) callbacks
+ *
+ * Pending tasks are kept in a min-heap ordered by deadline. Purged
+ * or rescheduled tasks leave their heap entries behind, which are
+ * skipped once they reach the top.
+ *
+ * In reactor mode the queue is driven by a timer on the shared event
+ * loop, otherwise it runs in a thread of its own
+ */
 class taskqueue : non_copyable_mixin<taskqueue> {
  public:
   struct deferred {
-    using clock = chrono::high_resolution_clock;
+    using clock = chrono::steady_clock;
     using duration = chrono::milliseconds;
     using timepoint = chrono::time_point<clock, duration>;
     using callback = function<void(size_t remaining)>;
 
-    explicit deferred(string id, timepoint now, duration wait, callback fn, size_t count)
-        : id(move(id)), func(move(fn)), now(move(now)), wait(move(wait)), count(move(count)) {}
+    explicit deferred(string id, timepoint deadline, duration wait, callback fn, size_t count)
+        : id(move(id)), func(move(fn)), deadline(move(deadline)), wait(move(wait)), count(move(count)) {}
 
     const string id;
     const callback func;
-    timepoint now;
+    timepoint deadline;
     duration wait;
     size_t count;
   };
@@ -36,7 +49,7 @@ class taskqueue : non_copyable_mixin<taskqueue> {
   using make_type = unique_ptr<taskqueue>;
   static make_type make();
 
-  explicit taskqueue();
+  explicit taskqueue(eventloop& loop);
   ~taskqueue();
 
   void defer(
@@ -48,15 +61,36 @@ class taskqueue : non_copyable_mixin<taskqueue> {
   bool purge(const string& id);
 
  protected:
+  struct entry {
+    deferred::timepoint deadline;
+    size_t handle;
+
+    bool operator>(const entry& other) const {
+      return deadline > other.deadline;
+    }
+  };
+
+  void start();
+  void schedule(string&& id, deferred::duration ms, deferred::callback&& fn, deferred::duration offset, size_t count);
+  void push(deferred::timepoint deadline, size_t handle);
+  size_t erase(const string& id);
+  void rearm();
   void tick();
 
  private:
+  eventloop& m_loop;
+
   std::thread m_thread;
   std::mutex m_lock{};
   std::condition_variable m_hold;
   std::atomic_bool m_active{true};
+  bool m_started{false};
+  int m_timer{-1};
 
-  vector<unique_ptr<deferred>> m_deferred;
+  vector<entry> m_heap;
+  std::unordered_map<size_t, unique_ptr<deferred>> m_tasks;
+  std::unordered_multimap<string, size_t> m_ids;
+  size_t m_handle{0};
 };
 
 POLYBAR_NS_END
@@ -120,6 +120,92 @@ struct action {
   string command{};
 };
 
+enum class render_op_type {
+  NONE = 0,
+  BACKGROUND,
+  FOREGROUND,
+  UNDERLINE,
+  OVERLINE,
+  FONT,
+  ALIGNMENT,
+  REVERSE,
+  OFFSET,
+  ATTRIBUTE_SET,
+  ATTRIBUTE_UNSET,
+  ATTRIBUTE_TOGGLE,
+  ACTION_BEGIN,
+  ACTION_END,
+  TEXT,
+  CONTROL,
+};
+
+/**
+ * Single drawing instruction produced by the parser
+ *
+ * Text runs and action commands are stored in the owning
+ * render_list and referenced by offset and length
+ */
+struct render_op {
+  explicit render_op(render_op_type type) : type(type), value(0) {}
+  explicit render_op(render_op_type type, unsigned int color) : type(type), color(color) {}
+  explicit render_op(render_op_type type, int value) : type(type), value(value) {}
+  explicit render_op(render_op_type type, alignment align) : type(type), align(align) {}
+  explicit render_op(render_op_type type, attribute attr) : type(type), attr(attr) {}
+  explicit render_op(render_op_type type, mousebtn btn) : type(type), btn(btn) {}
+  explicit render_op(render_op_type type, controltag ctrl) : type(type), ctrl(ctrl) {}
+
+  render_op_type type;
+  union {
+    unsigned int color;
+    int value;
+    alignment align;
+    attribute attr;
+    mousebtn btn;
+    controltag ctrl;
+  };
+  size_t offset{0};
+  size_t length{0};
+};
+
+/**
+ * Flat list of drawing instructions consumed by the renderer
+ */
+struct render_list {
+  vector<render_op> ops;
+  string strings;
+
+  template <typename... Args>
+  void add(Args&&... args) {
+    ops.emplace_back(forward<Args>(args)...);
+  }
+
+  /**
+   * Add op referencing a copy of src[pos, pos + len)
+   */
+  template <typename... Args>
+  void add_string(const string& src, size_t pos, size_t len, Args&&... args) {
+    ops.emplace_back(forward<Args>(args)...);
+    ops.back().offset = strings.size();
+    ops.back().length = len;
+    strings.append(src, pos, len);
+  }
+
+  void append(const render_list& other) {
+    size_t base{strings.size()};
+    ops.reserve(ops.size() + other.ops.size());
+    for (auto&& op : other.ops) {
+      ops.emplace_back(op);
+      ops.back().offset += base;
+    }
+    strings += other.strings;
+  }
+
+  void clear() {
+    ops.clear();
+    strings.clear();
+  }
+};
+
 struct action_block : public action {
   alignment align{alignment::NONE};
   double start_x{0.0};
@@ -139,6 +225,8 @@ struct bar_settings {
   explicit bar_settings() = default;
   bar_settings(const bar_settings& other) = default;
 
+  // Config section the bar was loaded from
+  string section{};
   xcb_window_t window{XCB_NONE};
   monitor_t monitor{};
   bool monitor_strict{false};
@@ -221,6 +309,14 @@ struct bar_settings {
   }
 };
 
+/**
+ * Immutable snapshot of the bar settings
+ *
+ * The bar publishes a new snapshot whenever its settings change, so
+ * holders of a snapshot can tell it apart from a newer one by identity
+ */
+using bar_settings_t = shared_ptr<const bar_settings>;
+
 struct event_timer {
   xcb_timestamp_t event{0L};
   xcb_timestamp_t offset{1L};
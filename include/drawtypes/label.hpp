@@ -40,7 +40,9 @@ namespace drawtypes {
     alignment m_alignment{alignment::LEFT};
     bool m_ellipsis{true};
 
-    explicit label(string text, int font) : m_font(font), m_text(text), m_tokenized(m_text) {}
+    explicit label(string text, int font) : m_font(font), m_text(text) {
+      compile(m_text);
+    }
     explicit label(string text, string foreground = ""s, string background = ""s, string underline = ""s,
         string overline = ""s, int font = 0, struct side_values padding = {0U, 0U},
         struct side_values margin = {0U, 0U}, int minlen = 0, size_t maxlen = 0_z,
@@ -57,9 +59,9 @@ namespace drawtypes {
         , m_alignment(label_alignment)
         , m_ellipsis(ellipsis)
         , m_text(text)
-        , m_tokenized(m_text)
         , m_tokens(forward<vector<token>>(tokens)) {
       assert(!m_ellipsis || (m_maxlen == 0 || m_maxlen >= 3));
+      compile(m_text);
     }
 
     string get() const;
@@ -74,9 +76,37 @@ namespace drawtypes {
     void copy_undefined(const label_t& label);
 
    private:
+    /**
+     * Occurrence of a token in the text, bound to a value by replace_token
+     */
+    struct slot {
+      // Index of the token definition in m_tokens
+      size_t token;
+      string value;
+      bool bound;
+    };
+
+    void compile(const string& text);
+    const string& tokenized() const;
+
     string m_text{};
-    string m_tokenized{};
     const vector<token> m_tokens{};
+
+    /**
+     * Text between the slots, there is one more literal than there are slots
+     */
+    vector<string> m_literals{};
+    vector<slot> m_slots{};
+
+    // The template was compiled from a text given to reset_tokens
+    bool m_custom{false};
+    bool m_cleared{false};
+
+    /**
+     * Text with the bound values filled in, assembled on demand into the same buffer
+     */
+    mutable string m_tokenized{};
+    mutable bool m_dirty{true};
   };
 
   label_t load_label(const config& conf, const string& section, string name, bool required = true, string def = ""s);
@@ -1,36 +1,71 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <mutex>
+
 #include "common.hpp"
 #include "components/logger.hpp"
 #include "events/signal_receiver.hpp"
 
 POLYBAR_NS
 
-/**
- * \brief Holds all signal receivers attached to the emitter
- */
-extern signal_receivers_t g_signal_receivers;
+namespace signals {
+  namespace detail {
+    size_t next_signal_id();
+  }
+
+  /**
+   * Get the dense index of the given signal type, assigned on first use
+   */
+  template <typename Signal>
+  size_t signal_id() {
+    static const size_t id{detail::next_signal_id()};
+    return id;
+  }
+}  // namespace signals
 
 /**
  * Wrapper used to delegate emitted signals
  * to attached signal receivers
+ *
+ * Receivers are kept in a flat table indexed by signal id. Attaching
+ * and detaching publishes a new immutable list for the affected ids,
+ * so emitting only loads a pointer and never waits on a writer.
+ * Replaced lists are retired and freed as soon as no emit is running.
+ *
+ * Entries are shared between the lists, detaching flags the entry so
+ * that emits still iterating an older list skip the receiver
  */
 class signal_emitter {
  public:
   using make_type = signal_emitter&;
   static make_type make();
 
-  explicit signal_emitter() = default;
+  static constexpr size_t max_signals{64};
+
+  explicit signal_emitter();
   virtual ~signal_emitter() {}
 
   template <typename Signal>
-  bool emit(const Signal& sig) {
+  bool emit(const Signal& sig) const {
+    const size_t id{signals::signal_id<Signal>()};
+
+    // Nobody ever attached to this signal
+    if (lookup(id) == nullptr) {
+      return false;
+    }
+
+    read_guard guard{*this};
+    auto receivers = lookup(id);
+
     try {
-      if (g_signal_receivers.find(id<Signal>()) != g_signal_receivers.end()) {
-        for (auto&& item : g_signal_receivers.at(id<Signal>())) {
-          if (item.second->on(sig)) {
-            return true;
-          }
+      for (auto&& item : *receivers) {
+        if (item->detached.load(std::memory_order_acquire)) {
+          continue;
+        }
+        if (static_cast<signal_receiver_impl<Signal>*>(item->sink)->on(sig)) {
+          return true;
         }
       }
     } catch (const std::exception& e) {
@@ -47,61 +82,92 @@ class signal_emitter {
 
   template <int Priority, typename Signal, typename... Signals>
   void attach(signal_receiver<Priority, Signal, Signals...>* s) {
+    std::lock_guard<std::mutex> guard(m_lock);
     attach<signal_receiver<Priority, Signal, Signals...>, Signal, Signals...>(s);
   }
 
   template <int Priority, typename Signal, typename... Signals>
   void detach(signal_receiver<Priority, Signal, Signals...>* s) {
+    std::lock_guard<std::mutex> guard(m_lock);
     detach<signal_receiver<Priority, Signal, Signals...>, Signal, Signals...>(s);
   }
 
  protected:
-  template <typename Signal>
-  std::type_index id() const {
-    return typeid(Signal);
-  }
+  /**
+   * Marks an emit as running for as long as it lives, retired lists
+   * are not freed while there is one
+   */
+  class read_guard {
+   public:
+    explicit read_guard(const signal_emitter& emitter) : m_emitter(emitter) {
+      m_emitter.m_readers.fetch_add(1);
+    }
+
+    ~read_guard() {
+      if (m_emitter.m_readers.fetch_sub(1) == 1 && m_emitter.m_retiring.load(std::memory_order_relaxed)) {
+        m_emitter.reclaim();
+      }
+    }
+
+   private:
+    const signal_emitter& m_emitter;
+  };
+
+  /**
+   * Receiver attached to a single signal. The sink points to the
+   * receiver's handler for that signal so that emitting doesn't
+   * need to cast dynamically
+   */
+  struct receiver_entry {
+    receiver_entry(signal_receiver_interface::prio priority, signal_receiver_interface* receiver, void* sink)
+        : priority(priority), receiver(receiver), sink(sink) {}
+
+    const signal_receiver_interface::prio priority;
+    signal_receiver_interface* const receiver;
+    void* const sink;
+    std::atomic<bool> detached{false};
+  };
+  using receiver_list = vector<shared_ptr<receiver_entry>>;
 
   template <typename Receiver, typename Signal>
   void attach(Receiver* s) {
-    attach(s, id<Signal>());
+    attach(s, signals::signal_id<Signal>(), static_cast<signal_receiver_impl<Signal>*>(s));
   }
 
   template <typename Receiver, typename Signal, typename Next, typename... Signals>
   void attach(Receiver* s) {
-    attach(s, id<Signal>());
+    attach<Receiver, Signal>(s);
     attach<Receiver, Next, Signals...>(s);
   }
 
-  void attach(signal_receiver_interface* s, std::type_index id) {
-    g_signal_receivers[id].emplace(s->priority(), s);
-  }
-
   template <typename Receiver, typename Signal>
   void detach(Receiver* s) {
-    detach(s, id<Signal>());
+    detach(s, signals::signal_id<Signal>());
   }
 
   template <typename Receiver, typename Signal, typename Next, typename... Signals>
   void detach(Receiver* s) {
-    detach(s, id<Signal>());
+    detach<Receiver, Signal>(s);
     detach<Receiver, Next, Signals...>(s);
   }
 
-  void detach(signal_receiver_interface* d, std::type_index id) {
-    try {
-      auto& prio_map = g_signal_receivers.at(id);
-      const auto& prio_sink_pair = prio_map.equal_range(d->priority());
-
-      for (auto it = prio_sink_pair.first; it != prio_sink_pair.second;) {
-        if (d == it->second) {
-          it = prio_map.erase(it);
-        } else {
-          ++it;
-        }
-      }
-    } catch (...) {
-    }
-  }
+  const receiver_list* lookup(size_t id) const;
+  void attach(signal_receiver_interface* s, size_t id, void* sink);
+  void detach(signal_receiver_interface* d, size_t id);
+  void publish(size_t id, receiver_list&& receivers);
+  void reclaim() const;
+  void reclaim_locked() const;
+  size_t retired() const;
+
+ private:
+  array<std::atomic<const receiver_list*>, max_signals> m_receivers;
+  array<unique_ptr<const receiver_list>, max_signals> m_current;
+
+  // Replaced lists that a running emit might still iterate
+  mutable vector<unique_ptr<const receiver_list>> m_retired;
+  mutable std::atomic<bool> m_retiring{false};
+  mutable std::atomic<size_t> m_readers{0};
+  mutable std::mutex m_lock;
 };
 
 POLYBAR_NS_END
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "components/config.hpp"
+#include "components/sampler.hpp"
 #include "modules/meta/inotify_module.hpp"
 #include "modules/meta/input_handler.hpp"
 #include "settings.hpp"
@@ -15,17 +16,16 @@ namespace modules {
       float read() const;
 
      private:
-      string m_path;
+      sampler::handle m_src;
     };
 
     string get_output();
 
    public:
-    explicit backlight_module(const bar_settings&, string);
+    explicit backlight_module(bar_settings_t, string);
 
-    void idle();
     bool on_event(inotify_event* event);
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
@@ -35,6 +35,8 @@ namespace modules {
     static constexpr auto TAG_BAR = "<bar>";
     static constexpr auto TAG_RAMP = "<ramp>";
 
+    enum tag_id { ID_LABEL, ID_BAR, ID_RAMP };
+
     static constexpr const char* EVENT_SCROLLUP{"backlight+"};
     static constexpr const char* EVENT_SCROLLDOWN{"backlight-"};
 
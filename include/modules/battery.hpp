@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.hpp"
+#include "components/sampler.hpp"
 #include "modules/meta/inotify_module.hpp"
 
 POLYBAR_NS
@@ -45,14 +46,14 @@ namespace modules {
     using consumption_reader = mutex_wrapper<value_reader<string /* watts */>>;
 
    public:
-    explicit battery_module(const bar_settings&, string);
+    explicit battery_module(bar_settings_t, string);
 
     void start();
     void teardown();
-    void idle();
+    void fallback_poll();
     bool on_event(inotify_event* event);
     string get_format() const;
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     state current_state();
@@ -62,6 +63,9 @@ namespace modules {
     string current_consumption();
     void subthread();
 
+    unsigned long read_value(const sampler::handle& src) const;
+    bool read_prefix(const sampler::handle& src, const char* prefix) const;
+
    private:
     static constexpr const char* FORMAT_CHARGING{"format-charging"};
     static constexpr const char* FORMAT_DISCHARGING{"format-discharging"};
@@ -75,6 +79,16 @@ namespace modules {
     static constexpr const char* TAG_LABEL_DISCHARGING{"<label-discharging>"};
     static constexpr const char* TAG_LABEL_FULL{"<label-full>"};
 
+    enum tag_id {
+      ID_BAR_CAPACITY,
+      ID_RAMP_CAPACITY,
+      ID_ANIMATION_CHARGING,
+      ID_LABEL_CHARGING,
+      ID_ANIMATION_DISCHARGING,
+      ID_LABEL_DISCHARGING,
+      ID_LABEL_FULL
+    };
+
     static const size_t SKIP_N_UNCHANGED{3_z};
 
     unique_ptr<state_reader> m_state_reader;
@@ -96,6 +110,12 @@ namespace modules {
     string m_frate;
     string m_fvoltage;
 
+    sampler::handle m_state_src;
+    sampler::handle m_capnow_src;
+    sampler::handle m_capfull_src;
+    sampler::handle m_rate_src;
+    sampler::handle m_voltage_src;
+
     state m_state{state::DISCHARGING};
     int m_percentage{0};
 
@@ -3,6 +3,7 @@
 #include "modules/meta/event_module.hpp"
 #include "modules/meta/input_handler.hpp"
 #include "utils/bspwm.hpp"
+#include "utils/bspwm_status.hpp"
 
 POLYBAR_NS
 
@@ -31,28 +32,41 @@ namespace modules {
       NODE_MARKED
     };
 
+    struct bspwm_workspace {
+      unsigned int mask;
+      label_t label;
+      size_t revision;
+      size_t index;
+    };
+
     struct bspwm_monitor {
-      vector<pair<unsigned int, label_t>> workspaces;
+      vector<bspwm_workspace> workspaces;
       vector<label_t> modes;
       label_t label;
       string name;
       bool focused{false};
+      size_t revision{0};
+      size_t first_index{0};
     };
 
    public:
-    explicit bspwm_module(const bar_settings&, string);
+    explicit bspwm_module(bar_settings_t, string);
 
     void stop();
     bool has_event();
+    int event_fd() const;
     bool update();
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
 
    private:
-    bool handle_status(string& data);
+    bool handle_status(const char* data, size_t len);
+    bool rebuild();
+    void add_modes(bspwm_monitor& mon, const bspwm_util::monitor_status& status) const;
+    label_t make_workspace_label(unsigned int mask, const string& name, bool focused, size_t index) const;
 
     static constexpr auto DEFAULT_ICON = "ws-icon-default";
     static constexpr auto DEFAULT_LABEL = "%icon% %name%";
@@ -62,12 +76,20 @@ namespace modules {
     static constexpr auto TAG_LABEL_STATE = "<label-state>";
     static constexpr auto TAG_LABEL_MODE = "<label-mode>";
 
+    enum tag_id { ID_LABEL_STATE, ID_LABEL_MONITOR, ID_LABEL_MODE };
+
     static constexpr const char* EVENT_PREFIX{"bspwm-desk"};
     static constexpr const char* EVENT_CLICK{"bspwm-deskfocus"};
     static constexpr const char* EVENT_SCROLL_UP{"bspwm-desknext"};
     static constexpr const char* EVENT_SCROLL_DOWN{"bspwm-deskprev"};
 
     bspwm_util::connection_t m_subscriber;
+    bspwm_util::status_parser m_status;
+
+    /**
+     * Received data that doesn't form a complete report yet
+     */
+    string m_pending;
 
     vector<unique_ptr<bspwm_monitor>> m_monitors;
 
@@ -86,7 +108,6 @@ namespace modules {
     bool m_revscroll{true};
     bool m_pinworkspaces{true};
     bool m_inlinemode{false};
-    string_util::hash_type m_hash{0U};
     bool m_fuzzy_match{false};
 
     // used while formatting output
@@ -7,14 +7,16 @@ POLYBAR_NS
 namespace modules {
   class counter_module : public timer_module<counter_module> {
    public:
-    explicit counter_module(const bar_settings&, string);
+    explicit counter_module(bar_settings_t, string);
 
     bool update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    private:
     static constexpr auto TAG_COUNTER = "<counter>";
 
+    enum tag_id { ID_COUNTER };
+
     int m_counter{0};
   };
 }
@@ -1,28 +1,21 @@
 #pragma once
 
+#include "components/sampler.hpp"
 #include "settings.hpp"
 #include "modules/meta/timer_module.hpp"
+#include "utils/procfs.hpp"
 
 POLYBAR_NS
 
 namespace modules {
-  struct cpu_time {
-    unsigned long long user;
-    unsigned long long nice;
-    unsigned long long system;
-    unsigned long long idle;
-    unsigned long long steal;
-    unsigned long long total;
-  };
-
-  using cpu_time_t = unique_ptr<cpu_time>;
+  using cpu_time = procfs_util::cpu_time;
 
   class cpu_module : public timer_module<cpu_module> {
    public:
-    explicit cpu_module(const bar_settings&, string);
+    explicit cpu_module(bar_settings_t, string);
 
     bool update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool read_values();
@@ -34,14 +27,17 @@ namespace modules {
     static constexpr auto TAG_RAMP_LOAD = "<ramp-load>";
     static constexpr auto TAG_RAMP_LOAD_PER_CORE = "<ramp-coreload>";
 
+    enum tag_id { ID_LABEL, ID_BAR_LOAD, ID_RAMP_LOAD, ID_RAMP_LOAD_PER_CORE };
+
     progressbar_t m_barload;
     ramp_t m_rampload;
     ramp_t m_rampload_core;
     label_t m_label;
     int m_ramp_padding;
 
-    vector<cpu_time_t> m_cputimes;
-    vector<cpu_time_t> m_cputimes_prev;
+    sampler::handle m_stat;
+    vector<cpu_time> m_cputimes;
+    vector<cpu_time> m_cputimes_prev;
 
     float m_total = 0;
     vector<float> m_load;
@@ -12,10 +12,10 @@ POLYBAR_NS
 namespace modules {
   class date_module : public timer_module<date_module>, public input_handler {
    public:
-    explicit date_module(const bar_settings&, string);
+    explicit date_module(bar_settings_t, string);
 
     bool update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
@@ -27,6 +27,8 @@ namespace modules {
     // \deprecated: Use <label>
     static constexpr auto TAG_DATE = "<date>";
 
+    enum tag_id { ID_LABEL, ID_DATE };
+
     label_t m_label;
 
     string m_dateformat;
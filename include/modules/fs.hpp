@@ -35,12 +35,12 @@ namespace modules {
    */
   class fs_module : public timer_module<fs_module> {
    public:
-    explicit fs_module(const bar_settings&, string);
+    explicit fs_module(bar_settings_t, string);
 
     bool update();
     string get_format() const;
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    private:
     static constexpr auto FORMAT_MOUNTED = "format-mounted";
@@ -51,6 +51,8 @@ namespace modules {
     static constexpr auto TAG_BAR_FREE = "<bar-free>";
     static constexpr auto TAG_RAMP_CAPACITY = "<ramp-capacity>";
 
+    enum tag_id { ID_LABEL_MOUNTED, ID_BAR_FREE, ID_BAR_USED, ID_RAMP_CAPACITY, ID_LABEL_UNMOUNTED };
+
     label_t m_labelmounted;
     label_t m_labelunmounted;
     progressbar_t m_barused;
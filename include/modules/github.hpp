@@ -12,10 +12,10 @@ namespace modules {
    */
   class github_module : public timer_module<github_module> {
    public:
-    explicit github_module(const bar_settings&, string);
+    explicit github_module(bar_settings_t, string);
 
     bool update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
     string get_format() const;
 
    private:
@@ -26,6 +26,8 @@ namespace modules {
     static constexpr auto TAG_LABEL_OFFLINE = "<label-offline>";
     static constexpr auto FORMAT_OFFLINE = "format-offline";
 
+    enum tag_id { ID_LABEL, ID_LABEL_OFFLINE };
+
     label_t m_label{};
     label_t m_label_offline{};
     string m_api_url;
@@ -6,6 +6,7 @@
 #include "modules/meta/event_module.hpp"
 #include "modules/meta/input_handler.hpp"
 #include "utils/i3.hpp"
+#include "utils/i3_workspaces.hpp"
 #include "utils/io.hpp"
 
 POLYBAR_NS
@@ -34,26 +35,31 @@ namespace modules {
     };
 
     struct workspace {
-      explicit workspace(string name, enum state state_, label_t&& label)
-          : name(name), state(state_), label(forward<label_t>(label)) {}
+      explicit workspace(string name, enum state state_, label_t&& label, size_t revision)
+          : name(name), state(state_), label(forward<label_t>(label)), revision(revision) {}
 
       operator bool();
 
       string name;
       enum state state;
       label_t label;
+      size_t revision;
     };
 
    public:
-    explicit i3_module(const bar_settings&, string);
+    explicit i3_module(bar_settings_t, string);
 
     void stop();
     bool has_event();
+    int event_fd() const;
     bool update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
+    void on_workspace_event(const i3ipc::workspace_event_t& evt);
+    void resync();
+    unique_ptr<workspace> make_workspace(const i3_util::workspace_state& ws) const;
 
    private:
     static string make_workspace_command(const string& workspace);
@@ -66,6 +72,8 @@ namespace modules {
     static constexpr const char* TAG_LABEL_STATE{"<label-state>"};
     static constexpr const char* TAG_LABEL_MODE{"<label-mode>"};
 
+    enum tag_id { ID_LABEL_STATE, ID_LABEL_MODE };
+
     static constexpr const char* EVENT_PREFIX{"i3wm"};
     static constexpr const char* EVENT_CLICK{"i3wm-wsfocus-"};
     static constexpr const char* EVENT_SCROLL_UP{"i3wm-wsnext"};
@@ -93,6 +101,15 @@ namespace modules {
     bool m_fuzzy_match{false};
 
     unique_ptr<i3_util::connection_t> m_ipc;
+
+    /**
+     * Guards the command socket of m_ipc, which is shared
+     * between the module thread and input handling
+     */
+    std::mutex m_cmdlock;
+
+    i3_util::workspace_model m_model;
+    bool m_resync{true};
   };
 }  // namespace modules
 
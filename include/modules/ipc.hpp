@@ -24,16 +24,19 @@ namespace modules {
     };
 
    public:
-    explicit ipc_module(const bar_settings&, string);
+    explicit ipc_module(bar_settings_t, string);
 
     void start();
     void update() {}
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
     void on_message(const string& message);
 
    private:
     static constexpr const char* TAG_OUTPUT{"<output>"};
+
+    enum tag_id { ID_OUTPUT };
+
     vector<unique_ptr<hook>> m_hooks;
     map<mousebtn, string> m_actions;
     string m_output;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "components/sampler.hpp"
 #include "modules/meta/timer_module.hpp"
 #include "settings.hpp"
+#include "utils/procfs.hpp"
 
 POLYBAR_NS
 
@@ -10,10 +12,10 @@ namespace modules {
 
   class memory_module : public timer_module<memory_module> {
    public:
-    explicit memory_module(const bar_settings&, string);
+    explicit memory_module(bar_settings_t, string);
 
     bool update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    private:
     static constexpr const char* TAG_LABEL{"<label>"};
@@ -26,6 +28,18 @@ namespace modules {
     static constexpr const char* TAG_RAMP_SWAP_USED{"<ramp-swap-used>"};
     static constexpr const char* TAG_RAMP_SWAP_FREE{"<ramp-swap-free>"};
 
+    enum tag_id {
+      ID_LABEL,
+      ID_BAR_USED,
+      ID_BAR_FREE,
+      ID_RAMP_USED,
+      ID_RAMP_FREE,
+      ID_BAR_SWAP_USED,
+      ID_BAR_SWAP_FREE,
+      ID_RAMP_SWAP_USED,
+      ID_RAMP_SWAP_FREE
+    };
+
     label_t m_label;
     progressbar_t m_bar_memused;
     progressbar_t m_bar_memfree;
@@ -39,6 +53,9 @@ namespace modules {
     int m_perc_swap_free{0};
     ramp_t m_ramp_swapused;
     ramp_t m_ramp_swapfree;
+
+    sampler::handle m_meminfo;
+    procfs_util::meminfo m_values{};
   };
 }
 
@@ -18,9 +18,9 @@ namespace modules {
     };
 
    public:
-    explicit menu_module(const bar_settings&, string);
+    explicit menu_module(bar_settings_t, string);
 
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
     void update() {}
 
    protected:
@@ -30,6 +30,8 @@ namespace modules {
     static constexpr auto TAG_LABEL_TOGGLE = "<label-toggle>";
     static constexpr auto TAG_MENU = "<menu>";
 
+    enum tag_id { ID_LABEL_TOGGLE, ID_MENU };
+
     static constexpr auto EVENT_MENU_OPEN = "menu-open-";
     static constexpr auto EVENT_MENU_CLOSE = "menu-close";
 
@@ -41,6 +41,7 @@ namespace drawtypes {
 
 class builder;
 class config;
+class eventloop;
 class logger;
 class signal_emitter;
 
@@ -56,8 +57,23 @@ namespace modules {
   // class definition : module_format {{{
 
   struct module_format {
+    /**
+     * \brief Literal text or a tag of the compiled format value
+     */
+    struct token {
+      string text{};
+      // Literal text without leading spaces, used while no tag has been built
+      string trimmed{};
+      bool tag{false};
+      // Id the formatter numbered the tag with
+      int id{-1};
+    };
+
     string value{};
     vector<string> tags{};
+    map<string, int> tag_ids{};
+    vector<token> tokens{};
+    string tail{};
     label_t prefix{};
     label_t suffix{};
     string fg{};
@@ -72,6 +88,8 @@ namespace modules {
     int offset{0};
     int font{0};
 
+    void compile();
+    bool uses(const string& tag) const;
     string decorate(builder* builder, string output);
   };
 
@@ -91,6 +109,8 @@ namespace modules {
     const config& m_conf;
     string m_modname;
     map<string, shared_ptr<module_format>> m_formats;
+    // Tags numbered in the order they were first added
+    map<string, int> m_tag_ids;
   };
 
   // }}}
@@ -107,6 +127,7 @@ namespace modules {
     virtual void start() = 0;
     virtual void stop() = 0;
     virtual void halt(string error_message) = 0;
+    virtual bool changed() const = 0;
     virtual string contents() = 0;
   };
 
@@ -116,7 +137,7 @@ namespace modules {
   template <class Impl>
   class module : public module_interface {
    public:
-    module(const bar_settings bar, string name);
+    module(bar_settings_t bar, string name);
     ~module() noexcept;
 
     string name() const;
@@ -124,6 +145,7 @@ namespace modules {
     void stop();
     void halt(string error_message);
     void teardown();
+    bool changed() const;
     string contents();
 
    protected:
@@ -133,10 +155,14 @@ namespace modules {
     void wakeup();
     string get_format() const;
     string get_output();
+    template <typename T = Impl>
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     signal_emitter& m_sig;
-    const bar_settings m_bar;
+    eventloop& m_loop;
+    const bar_settings_t m_settings;
+    const bar_settings& m_bar;
     const logger& m_log;
     const config& m_conf;
 
@@ -1,5 +1,6 @@
 #include "components/builder.hpp"
 #include "components/config.hpp"
+#include "components/eventloop.hpp"
 #include "components/logger.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
@@ -11,13 +12,15 @@ namespace modules {
   // module<Impl> public {{{
 
   template <typename Impl>
-  module<Impl>::module(const bar_settings bar, string name)
+  module<Impl>::module(bar_settings_t bar, string name)
       : m_sig(signal_emitter::make())
-      , m_bar(bar)
+      , m_loop(eventloop::make_reactor())
+      , m_settings(move(bar))
+      , m_bar(*m_settings)
       , m_log(logger::make())
       , m_conf(config::make())
       , m_name("module/" + name)
-      , m_builder(make_unique<builder>(bar))
+      , m_builder(make_unique<builder>(m_bar))
       , m_formatter(make_unique<module_formatter>(m_conf, m_name))
       , m_handle_events(m_conf.get(m_name, "handle-events", true)) {}
 
@@ -54,15 +57,18 @@ namespace modules {
     m_log.info("%s: Stopping", name());
     m_enabled = false;
 
-    std::lock(m_buildlock, m_updatelock);
-    std::lock_guard<std::mutex> guard_a(m_buildlock, std::adopt_lock);
-    std::lock_guard<std::mutex> guard_b(m_updatelock, std::adopt_lock);
     {
+      std::lock(m_buildlock, m_updatelock);
+      std::lock_guard<std::mutex> guard_a(m_buildlock, std::adopt_lock);
+      std::lock_guard<std::mutex> guard_b(m_updatelock, std::adopt_lock);
+
       CAST_MOD(Impl)->wakeup();
       CAST_MOD(Impl)->teardown();
-
-      m_sig.emit(signals::eventqueue::check_state{});
     }
+
+    // Emitted without the module locks, the controller takes them
+    // after its module lock when it builds the output
+    m_sig.emit(signals::eventqueue::check_state{});
   }
 
   template <typename Impl>
@@ -75,6 +81,11 @@ namespace modules {
   template <typename Impl>
   void module<Impl>::teardown() {}
 
+  template <typename Impl>
+  bool module<Impl>::changed() const {
+    return m_changed;
+  }
+
   template <typename Impl>
   string module<Impl>::contents() {
     if (m_changed) {
@@ -133,52 +144,49 @@ namespace modules {
     auto format_name = CONST_MOD(Impl).get_format();
     auto format = m_formatter->get(format_name);
     bool no_tag_built{true};
-    bool fake_no_tag_built{false};
-    bool tag_built{false};
     auto mingap = std::max(1_z, format->spacing);
-    size_t start, end;
-    string value{format->value};
-    while ((start = value.find('<')) != string::npos && (end = value.find('>', start)) != string::npos) {
-      if (start > 0) {
-        if (no_tag_built) {
-          // If no module tag has been built we do not want to add
-          // whitespace defined between the format tags, but we do still
-          // want to output other non-tag content
-          auto trimmed = string_util::ltrim(value.substr(0, start), ' ');
-          if (!trimmed.empty()) {
-            fake_no_tag_built = false;
-            m_builder->node(move(trimmed));
-          }
-        } else {
-          m_builder->node(value.substr(0, start));
-        }
-        value.erase(0, start);
-        end -= start;
-        start = 0;
-      }
-      string tag{value.substr(start, end + 1)};
-      if (tag.empty()) {
+
+    // The format was split into literal text and tags when it was added
+    for (auto&& token : format->tokens) {
+      if (!token.tag) {
+        // If no module tag has been built we do not want to add
+        // whitespace defined between the format tags, but we do still
+        // want to output other non-tag content
+        m_builder->node(no_tag_built ? token.trimmed : token.text);
         continue;
-      } else if (tag[0] == '<' && tag[tag.size() - 1] == '>') {
-        if (!no_tag_built)
-          m_builder->space(format->spacing);
-        else if (fake_no_tag_built)
-          no_tag_built = false;
-        if (!(tag_built = CONST_MOD(Impl).build(m_builder.get(), tag)) && !no_tag_built)
-          m_builder->remove_trailing_space(mingap);
-        if (tag_built)
-          no_tag_built = false;
       }
-      value.erase(0, tag.size());
+
+      if (!no_tag_built) {
+        m_builder->space(format->spacing);
+      }
+      if (CONST_MOD(Impl).build_tag(m_builder.get(), token.id, token.text)) {
+        no_tag_built = false;
+      } else if (!no_tag_built) {
+        m_builder->remove_trailing_space(mingap);
+      }
     }
 
-    if (!value.empty()) {
-      m_builder->append(value);
+    if (!format->tail.empty()) {
+      m_builder->append(format->tail);
     }
 
     return format->decorate(&*m_builder, m_builder->flush());
   }
 
+  /**
+   * Build a tag of the current format
+   *
+   * Modules hide this to dispatch on the id the formatter numbered the
+   * tag with, otherwise the tag is passed on to build(). This is a member
+   * template so that `template class module<X>;` doesn't instantiate a
+   * call to `X::build`, which modules that hide it don't define
+   */
+  template <typename Impl>
+  template <typename T>
+  bool module<Impl>::build_tag(builder* builder, int, const string& tag) const {
+    return static_cast<const T&>(*this).build(builder, tag);
+  }
+
   // }}}
 }  // namespace modules
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "components/eventloop.hpp"
 #include "modules/meta/base.hpp"
 
 POLYBAR_NS
@@ -11,7 +12,40 @@ namespace modules {
     using module<Impl>::module;
 
     void start() {
-      this->m_mainthread = thread(&event_module::runner, this);
+      int fd{this->m_loop.enabled() ? CAST_MOD(Impl)->event_fd() : -1};
+
+      if (fd == -1) {
+        this->m_mainthread = thread(&event_module::runner, this);
+        return;
+      }
+
+      // warm up module output before handing the fd to the event loop
+      try {
+        std::unique_lock<std::mutex> guard(this->m_updatelock);
+        CAST_MOD(Impl)->update();
+        guard.unlock();
+        CAST_MOD(Impl)->broadcast();
+        watch(fd);
+      } catch (const exception& err) {
+        CAST_MOD(Impl)->halt(err.what());
+      }
+    }
+
+    void stop() {
+      if (m_fd != -1) {
+        this->m_loop.remove(m_fd);
+        m_fd = -1;
+      }
+      module<Impl>::stop();
+    }
+
+    /**
+     * File descriptor that becomes readable when `has_event()` would
+     * return true. Modules that can't provide one keep running in
+     * their own thread, even in reactor mode
+     */
+    int event_fd() const {
+      return -1;
     }
 
    protected:
@@ -39,6 +73,40 @@ namespace modules {
         CAST_MOD(Impl)->halt(err.what());
       }
     }
+
+    void watch(int fd) {
+      m_fd = fd;
+      this->m_loop.add(fd, [this] { on_readable(); });
+    }
+
+    /**
+     * Reactor mode counterpart of `runner()`, called from the
+     * event loop when the module's fd is ready
+     */
+    void on_readable() {
+      try {
+        std::unique_lock<std::mutex> guard(this->m_updatelock);
+        bool has_event{CAST_MOD(Impl)->has_event()};
+        bool changed{has_event && CAST_MOD(Impl)->update()};
+        guard.unlock();
+
+        if (changed) {
+          CAST_MOD(Impl)->broadcast();
+        }
+
+        // The module might have reconnected, in which case the old
+        // fd is gone (and the new one might even share its number)
+        if (!has_event && this->running() && m_fd != -1) {
+          this->m_loop.remove(m_fd);
+          watch(CAST_MOD(Impl)->event_fd());
+        }
+      } catch (const exception& err) {
+        CAST_MOD(Impl)->halt(err.what());
+      }
+    }
+
+   private:
+    int m_fd{-1};
   };
 }
 
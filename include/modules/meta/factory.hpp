@@ -52,7 +52,7 @@ POLYBAR_NS
 using namespace modules;
 
 namespace {
-  module_interface* make_module(string&& name, const bar_settings& bar, string module_name, const logger& m_log) {
+  module_interface* make_module(string&& name, const bar_settings_t& bar, string module_name, const logger& m_log) {
     if (name == "internal/counter") {
       return new counter_module(bar, move(module_name));
     } else if (name == "internal/backlight") {
@@ -110,6 +110,25 @@ namespace {
       throw application_error("Unknown module: " + name);
     }
   }
+
+  /**
+   * Key under which a module instance is shared between bars
+   *
+   * Besides their own section, modules only depend on the colors, spacing
+   * and locale of the bar, and some of them on its monitor
+   */
+  string share_key(const string& module_name, const string& type, const bar_settings& bar) {
+    string key{module_name};
+    key += '\n' + to_string(bar.foreground) + '\n' + to_string(bar.background);
+    key += '\n' + to_string(bar.spacing) + '\n' + bar.locale;
+
+    if (bar.monitor &&
+        (type == "internal/i3" || type == "internal/bspwm" || type == "internal/xworkspaces" ||
+            type == "internal/xbacklight")) {
+      key += '\n' + bar.monitor->name;
+    }
+    return key;
+  }
 }
 
 POLYBAR_NS_END
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "components/builder.hpp"
+#include "components/eventloop.hpp"
 #include "modules/meta/base.hpp"
 
 POLYBAR_NS
@@ -12,7 +13,20 @@ namespace modules {
     using module<Impl>::module;
 
     void start() {
-      this->m_mainthread = thread(&inotify_module::runner, this);
+      if (this->m_loop.enabled()) {
+        m_timer = this->m_loop.add_timer([this] { on_timer(); });
+      } else {
+        this->m_mainthread = thread(&inotify_module::runner, this);
+      }
+    }
+
+    void stop() {
+      if (m_timer != -1) {
+        unwatch_all();
+        this->m_loop.remove(m_timer);
+        m_timer = -1;
+      }
+      module<Impl>::stop();
     }
 
    protected:
@@ -42,9 +56,16 @@ namespace modules {
     }
 
     void idle() {
-      this->sleep(200ms);
+      CAST_MOD(Impl)->fallback_poll();
+      this->sleep(m_idle_interval);
     }
 
+    /**
+     * Called periodically while waiting for inotify events, for
+     * modules that need to poll files which don't report changes
+     */
+    void fallback_poll() {}
+
     void poll_events() {
       vector<unique_ptr<inotify_watch>> watches;
 
@@ -85,8 +106,98 @@ namespace modules {
       }
     }
 
+    /**
+     * Reactor mode timer callback. Used to warm up the module, to
+     * re-attach the watches once the module has processed an event
+     * and to drive `fallback_poll()`
+     */
+    void on_timer() {
+      try {
+        if (!m_warm) {
+          std::unique_lock<std::mutex> guard(this->m_updatelock);
+          CAST_MOD(Impl)->on_event(nullptr);
+          guard.unlock();
+          CAST_MOD(Impl)->broadcast();
+          m_warm = true;
+        }
+
+        if (m_watches.empty()) {
+          watch_all();
+        } else {
+          std::lock_guard<std::mutex> guard(this->m_updatelock);
+          CAST_MOD(Impl)->fallback_poll();
+        }
+
+        if (this->running() && m_timer != -1) {
+          this->m_loop.arm(m_timer, m_watches.empty() ? 0.1s : 1s);
+        }
+      } catch (const std::exception& err) {
+        CAST_MOD(Impl)->halt(err.what());
+      }
+    }
+
+    /**
+     * Reactor mode callback for a ready inotify fd
+     *
+     * The watches are removed before the module handles the event
+     * since reading the tracked files would otherwise trigger new
+     * events, and they are attached again after the usual idle time
+     */
+    void on_watch_event(inotify_watch* w) {
+      try {
+        auto event = w->get_event();
+        unwatch_all();
+
+        std::unique_lock<std::mutex> guard(this->m_updatelock);
+        bool changed{CAST_MOD(Impl)->on_event(event.get())};
+        guard.unlock();
+
+        if (changed) {
+          CAST_MOD(Impl)->broadcast();
+        }
+        if (this->running() && m_timer != -1) {
+          this->m_loop.arm(m_timer, m_idle_interval);
+        }
+      } catch (const std::exception& err) {
+        CAST_MOD(Impl)->halt(err.what());
+      }
+    }
+
+    void watch_all() {
+      try {
+        for (auto&& w : m_watchlist) {
+          m_watches.emplace_back(inotify_util::make_watch(w.first));
+          m_watches.back()->attach(w.second);
+        }
+      } catch (const system_error& e) {
+        m_watches.clear();
+        this->m_log.err("%s: Error while creating inotify watch (what: %s)", this->name(), e.what());
+        return;
+      }
+
+      for (auto&& w : m_watches) {
+        auto* ptr = w.get();
+        this->m_loop.add(w->get_file_descriptor(), [this, ptr] { on_watch_event(ptr); });
+      }
+    }
+
+    void unwatch_all() {
+      for (auto&& w : m_watches) {
+        this->m_loop.remove(w->get_file_descriptor());
+      }
+      m_watches.clear();
+    }
+
+    /**
+     * Time to wait after an event before the watches are attached again
+     */
+    chrono::duration<double> m_idle_interval{200ms};
+
    private:
     map<string, int> m_watchlist;
+    vector<unique_ptr<inotify_watch>> m_watches;
+    int m_timer{-1};
+    bool m_warm{false};
   };
 }
 
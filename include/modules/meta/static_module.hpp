@@ -18,7 +18,7 @@ namespace modules {
       });
     }
 
-    bool build(builder*, string) const {
+    bool build_tag(builder*, int, const string&) const {
       return true;
     }
   };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "components/eventloop.hpp"
 #include "modules/meta/base.hpp"
 
 POLYBAR_NS
@@ -13,18 +14,30 @@ namespace modules {
     using module<Impl>::module;
 
     void start() {
-      this->m_mainthread = thread(&timer_module::runner, this);
+      if (this->m_loop.enabled()) {
+        m_timer = this->m_loop.add_timer([this] { on_timer(); });
+      } else {
+        this->m_mainthread = thread(&timer_module::runner, this);
+      }
+    }
+
+    void stop() {
+      if (m_timer != -1) {
+        this->m_loop.remove(m_timer);
+        m_timer = -1;
+      }
+      module<Impl>::stop();
     }
 
    protected:
+    bool check() {
+      std::unique_lock<std::mutex> guard(this->m_updatelock);
+      return CAST_MOD(Impl)->update();
+    }
+
     void runner() {
       this->m_log.trace("%s: Thread id = %i", this->name(), concurrency_util::thread_id(this_thread::get_id()));
 
-      const auto check = [&]() -> bool {
-        std::unique_lock<std::mutex> guard(this->m_updatelock);
-        return CAST_MOD(Impl)->update();
-      };
-
       try {
         // warm up module output before entering the loop
         check();
@@ -41,8 +54,31 @@ namespace modules {
       }
     }
 
+    /**
+     * Reactor mode counterpart of `runner()`, called from the
+     * event loop each time the module's timer expires
+     */
+    void on_timer() {
+      try {
+        // The first expiry warms up the module output
+        if (check() || !m_warm) {
+          m_warm = true;
+          CAST_MOD(Impl)->broadcast();
+        }
+        if (this->running() && m_timer != -1) {
+          this->m_loop.arm(m_timer, m_interval);
+        }
+      } catch (const exception& err) {
+        CAST_MOD(Impl)->halt(err.what());
+      }
+    }
+
    protected:
     interval_t m_interval{1.0};
+
+   private:
+    int m_timer{-1};
+    bool m_warm{false};
   };
 }
 
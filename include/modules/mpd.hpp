@@ -14,7 +14,7 @@ using namespace mpd;
 namespace modules {
   class mpd_module : public event_module<mpd_module>, public input_handler {
    public:
-    explicit mpd_module(const bar_settings&, string);
+    explicit mpd_module(bar_settings_t, string);
 
     void teardown();
     inline bool connected() const;
@@ -23,7 +23,7 @@ namespace modules {
     bool update();
     string get_format() const;
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
@@ -62,6 +62,27 @@ namespace modules {
     static constexpr const char* FORMAT_OFFLINE{"format-offline"};
     static constexpr const char* TAG_LABEL_OFFLINE{"<label-offline>"};
 
+    enum tag_id {
+      ID_BAR_PROGRESS,
+      ID_TOGGLE,
+      ID_TOGGLE_STOP,
+      ID_LABEL_SONG,
+      ID_LABEL_TIME,
+      ID_ICON_RANDOM,
+      ID_ICON_REPEAT,
+      ID_ICON_REPEAT_ONE,
+      ID_ICON_SINGLE,
+      ID_ICON_PREV,
+      ID_ICON_STOP,
+      ID_ICON_PLAY,
+      ID_ICON_PAUSE,
+      ID_ICON_NEXT,
+      ID_ICON_SEEKB,
+      ID_ICON_SEEKF,
+      ID_ICON_CONSUME,
+      ID_LABEL_OFFLINE
+    };
+
     static constexpr const char* EVENT_PLAY{"mpdplay"};
     static constexpr const char* EVENT_PAUSE{"mpdpause"};
     static constexpr const char* EVENT_STOP{"mpdstop"};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <future>
+
 #include "adapters/net.hpp"
 #include "components/config.hpp"
 #include "modules/meta/timer_module.hpp"
@@ -11,15 +13,22 @@ namespace modules {
 
   class network_module : public timer_module<network_module> {
    public:
-    explicit network_module(const bar_settings&, string);
+    explicit network_module(bar_settings_t, string);
 
+    void start();
+    void stop();
     void teardown();
     bool update();
     string get_format() const;
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
+    net::network* active() const;
+    void refresh();
+    void start_ping(net::network* network);
+    void on_event();
     void subthread_routine();
+    void event_routine(vector<int> fds);
 
    private:
     static constexpr auto FORMAT_CONNECTED = "format-connected";
@@ -32,6 +41,15 @@ namespace modules {
     static constexpr auto TAG_LABEL_PACKETLOSS = "<label-packetloss>";
     static constexpr auto TAG_ANIMATION_PACKETLOSS = "<animation-packetloss>";
 
+    enum tag_id {
+      ID_RAMP_SIGNAL,
+      ID_RAMP_QUALITY,
+      ID_LABEL_CONNECTED,
+      ID_LABEL_DISCONNECTED,
+      ID_ANIMATION_PACKETLOSS,
+      ID_LABEL_PACKETLOSS
+    };
+
     net::wired_t m_wired;
     net::wireless_t m_wireless;
 
@@ -47,11 +65,19 @@ namespace modules {
     int m_quality{0};
     int m_counter{-1};  // -1 to ignore the first run
 
+    string m_upspeed;
+    string m_downspeed;
+    vector<int> m_eventfds;
+
+    // Connectivity test running in the background
+    std::future<void> m_ping;
+
     string m_interface;
     int m_ping_nth_update{0};
     int m_udspeed_minwidth{0};
     bool m_accumulate{false};
     bool m_unknown_up{false};
+    string m_ping_method{"command"};
   };
 }
 
@@ -14,14 +14,14 @@ namespace modules {
 
   class pulseaudio_module : public event_module<pulseaudio_module>, public input_handler {
    public:
-    explicit pulseaudio_module(const bar_settings&, string);
+    explicit pulseaudio_module(bar_settings_t, string);
 
     void teardown();
     bool has_event();
     bool update();
     string get_format() const;
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
@@ -35,6 +35,8 @@ namespace modules {
     static constexpr auto TAG_LABEL_VOLUME = "<label-volume>";
     static constexpr auto TAG_LABEL_MUTED = "<label-muted>";
 
+    enum tag_id { ID_RAMP_VOLUME, ID_LABEL_VOLUME, ID_BAR_VOLUME, ID_LABEL_MUTED };
+
     static constexpr auto EVENT_PREFIX = "pa_vol";
     static constexpr auto EVENT_VOLUME_UP = "pa_volup";
     static constexpr auto EVENT_VOLUME_DOWN = "pa_voldown";
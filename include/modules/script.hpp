@@ -1,5 +1,7 @@
 #pragma once
 
+#include "components/script_executor.hpp"
+#include "components/script_worker.hpp"
 #include "modules/meta/base.hpp"
 #include "utils/command.hpp"
 #include "utils/io.hpp"
@@ -9,32 +11,48 @@ POLYBAR_NS
 namespace modules {
   class script_module : public module<script_module> {
    public:
-    explicit script_module(const bar_settings&, string);
+    explicit script_module(bar_settings_t, string);
     ~script_module() {}
 
     void start();
     void stop();
 
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     chrono::duration<double> process(const mutex_wrapper<function<chrono::duration<double>()>>& handler) const;
     bool check_condition();
+    bool execute(const string& cmd, script_executor::result& res, const string& key = "");
+    bool handle_condition(const script_executor::result& res);
+    chrono::duration<double> handle_result(const script_executor::result& res);
+    void schedule(chrono::duration<double> delay);
+    void tick();
 
    private:
     static constexpr const char* TAG_LABEL{"<label>"};
 
+    enum tag_id { ID_LABEL };
+
     mutex_wrapper<function<chrono::duration<double>()>> m_handler;
 
+    script_executor& m_executor;
     unique_ptr<command> m_command;
+    unique_ptr<script_worker> m_worker;
 
     bool m_tail;
+    bool m_persistent;
 
     string m_exec;
     string m_exec_if;
 
     chrono::duration<double> m_interval{0};
+
+    // Request sent to persistent workers, either a line or a signal
+    string m_request{"update"};
+    int m_request_signal{0};
+    chrono::duration<double> m_request_timeout{5s};
+
     map<mousebtn, string> m_actions;
 
     label_t m_label;
@@ -42,7 +60,12 @@ namespace modules {
     string m_prev;
     int m_counter{0};
 
-    bool m_stopping{false};
+    // Interval timer and pending command in reactor mode,
+    // the ticket is guarded by m_sleeplock together with m_stopping
+    int m_timer{-1};
+    size_t m_ticket{0};
+
+    atomic<bool> m_stopping{false};
   };
 }
 
@@ -15,10 +15,10 @@ namespace modules {
    */
   class systray_module : public static_module<systray_module>, public input_handler {
    public:
-    explicit systray_module(const bar_settings&, string);
+    explicit systray_module(bar_settings_t, string);
 
     void update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool input(string&& cmd);
@@ -29,6 +29,8 @@ namespace modules {
     static constexpr const char* TAG_LABEL_TOGGLE{"<label-toggle>"};
     static constexpr const char* TAG_TRAY_CLIENTS{"<tray-clients>"};
 
+    enum tag_id { ID_LABEL_TOGGLE, ID_TRAY_CLIENTS };
+
     connection& m_connection;
     label_t m_label;
 
@@ -2,6 +2,7 @@
 
 #include <istream>
 
+#include "components/sampler.hpp"
 #include "settings.hpp"
 #include "modules/meta/timer_module.hpp"
 
@@ -12,11 +13,11 @@ namespace modules {
 
   class temperature_module : public timer_module<temperature_module> {
    public:
-    explicit temperature_module(const bar_settings&, string);
+    explicit temperature_module(bar_settings_t, string);
 
     bool update();
     string get_format() const;
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    private:
     static constexpr auto TAG_LABEL = "<label>";
@@ -24,10 +25,13 @@ namespace modules {
     static constexpr auto TAG_RAMP = "<ramp>";
     static constexpr auto FORMAT_WARN = "format-warn";
 
+    enum tag_id { ID_LABEL, ID_RAMP, ID_LABEL_WARN };
+
     map<temp_state, label_t> m_label;
     ramp_t m_ramp;
 
     string m_path;
+    sampler::handle m_input;
     int m_zone = 0;
     // Base temperature used for where to start the ramp
     int m_tempbase = 0;
@@ -14,7 +14,7 @@ namespace modules {
 #define DEFINE_UNSUPPORTED_MODULE(MODULE_NAME, MODULE_TYPE)                             \
   class MODULE_NAME : public module_interface {                                         \
    public:                                                                              \
-    MODULE_NAME(const bar_settings, string) {                                           \
+    MODULE_NAME(bar_settings_t, string) {                                           \
       throw application_error("No built-in support for '" + string{MODULE_TYPE} + "'"); \
     }                                                                                   \
     string name() const {                                                               \
@@ -26,6 +26,9 @@ namespace modules {
     void start() {}                                                                     \
     void stop() {}                                                                      \
     void halt(string) {}                                                                \
+    bool changed() const {                                                              \
+      return false;                                                                     \
+    }                                                                                   \
     string contents() {                                                                 \
       return "";                                                                        \
     }                                                                                   \
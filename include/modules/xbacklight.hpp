@@ -29,11 +29,11 @@ namespace modules {
                             public event_handler<evt::randr_notify>,
                             public input_handler {
    public:
-    explicit xbacklight_module(const bar_settings& bar, string name_);
+    explicit xbacklight_module(bar_settings_t bar, string name_);
 
     void update();
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     void handle(const evt::randr_notify& evt);
@@ -44,6 +44,8 @@ namespace modules {
     static constexpr const char* TAG_BAR{"<bar>"};
     static constexpr const char* TAG_RAMP{"<ramp>"};
 
+    enum tag_id { ID_LABEL, ID_BAR, ID_RAMP };
+
     static constexpr const char* EVENT_SCROLLUP{"xbacklight+"};
     static constexpr const char* EVENT_SCROLLDOWN{"xbacklight-"};
 
@@ -22,11 +22,11 @@ namespace modules {
         public event_handler<evt::xkb_new_keyboard_notify, evt::xkb_state_notify, evt::xkb_indicator_state_notify>,
         public input_handler {
    public:
-    explicit xkeyboard_module(const bar_settings& bar, string name_);
+    explicit xkeyboard_module(bar_settings_t bar, string name_);
 
     string get_output();
     void update();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     bool query_keyboard();
@@ -47,6 +47,8 @@ namespace modules {
     
     static constexpr const char* EVENT_SWITCH{"xkeyboard/switch"};
 
+    enum tag_id { ID_LABEL_LAYOUT, ID_LABEL_INDICATOR };
+
     connection& m_connection;
     event_timer m_xkb_newkb_notify{};
     event_timer m_xkb_state_notify{};
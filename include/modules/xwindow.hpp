@@ -35,10 +35,10 @@ namespace modules {
       ACTIVE,
       EMPTY
     };
-    explicit xwindow_module(const bar_settings&, string);
+    explicit xwindow_module(bar_settings_t, string);
 
     void update(bool force = false);
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     void handle(const evt::property_notify& evt);
@@ -46,6 +46,8 @@ namespace modules {
    private:
     static constexpr const char* TAG_LABEL{"<label>"};
 
+    enum tag_id { ID_LABEL };
+
     connection& m_connection;
     unique_ptr<active_window> m_active;
     map<state, label_t> m_statelabels;
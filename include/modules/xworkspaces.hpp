@@ -55,11 +55,11 @@ namespace modules {
                              public event_handler<evt::property_notify>,
                              public input_handler {
    public:
-    explicit xworkspaces_module(const bar_settings& bar, string name_);
+    explicit xworkspaces_module(bar_settings_t bar, string name_);
 
     void update();
     string get_output();
-    bool build(builder* builder, const string& tag) const;
+    bool build_tag(builder* builder, int id, const string& tag) const;
 
    protected:
     void handle(const evt::property_notify& evt);
@@ -81,6 +81,8 @@ namespace modules {
     static constexpr const char* TAG_LABEL_MONITOR{"<label-monitor>"};
     static constexpr const char* TAG_LABEL_STATE{"<label-state>"};
 
+    enum tag_id { ID_LABEL_STATE, ID_LABEL_MONITOR };
+
     static constexpr const char* EVENT_PREFIX{"xworkspaces-"};
     static constexpr const char* EVENT_CLICK{"focus="};
     static constexpr const char* EVENT_SCROLL_UP{"next"};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace bspwm_util {
+  struct desktop_status {
+    string name;
+    /**
+     * Report flag of the desktop, one of F, O, U (focused) or f, o, u
+     */
+    char flag{'\0'};
+    size_t revision{0};
+  };
+
+  struct monitor_status {
+    string name;
+    bool focused{false};
+    vector<desktop_status> desktops;
+    string layout;
+    string state;
+    string flags;
+    /**
+     * Changes with anything on the monitor, including its desktops
+     */
+    size_t revision{0};
+  };
+
+  /**
+   * Parser for the lines of `bspc subscribe report`
+   *
+   * Each report is scanned in place and diffed against the state left
+   * by the previous one. Entries are only written, and their revision
+   * bumped, if they actually changed, so consumers can skip rebuilding
+   * everything that kept its revision
+   */
+  class status_parser {
+   public:
+    bool parse(const char* data, size_t len);
+
+    const vector<monitor_status>& monitors() const;
+
+   protected:
+    void touch(monitor_status& mon);
+    void touch(desktop_status& desktop);
+
+   private:
+    vector<monitor_status> m_monitors;
+    size_t m_revision{0};
+    size_t m_parsed{0};
+  };
+}  // namespace bspwm_util
+
+POLYBAR_NS_END
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <list>
 #include <unordered_map>
 
 #include "common.hpp"
@@ -32,4 +33,74 @@ class cache {
   safe_map_type m_cache;
 };
 
+/**
+ * Bounded map that evicts the least recently used entry
+ * once the capacity is reached
+ *
+ * Not thread-safe, the owner is expected to serialize access
+ */
+template <typename ValueType, typename KeyType, typename Hash = std::hash<KeyType>>
+class lru_cache {
+ public:
+  explicit lru_cache(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+
+  /**
+   * Get the cached value for the given key and mark it as
+   * most recently used. Returns nullptr if the key is unknown
+   */
+  ValueType* find(const KeyType& key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+      m_misses++;
+      return nullptr;
+    }
+    m_hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->second;
+  }
+
+  /**
+   * Insert or replace the value for the given key
+   */
+  ValueType& insert(const KeyType& key, ValueType&& value) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      m_entries.erase(it->second);
+      m_index.erase(it);
+    } else if (m_entries.size() >= m_capacity) {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+    m_entries.emplace_front(key, forward<ValueType>(value));
+    m_index.emplace(key, m_entries.begin());
+    return m_entries.front().second;
+  }
+
+  void clear() {
+    m_index.clear();
+    m_entries.clear();
+  }
+
+  size_t size() const {
+    return m_entries.size();
+  }
+
+  size_t hits() const {
+    return m_hits;
+  }
+
+  size_t misses() const {
+    return m_misses;
+  }
+
+ private:
+  using entry_list = std::list<pair<KeyType, ValueType>>;
+
+  size_t m_capacity;
+  entry_list m_entries;
+  std::unordered_map<KeyType, typename entry_list::iterator, Hash> m_index;
+  size_t m_hits{0};
+  size_t m_misses{0};
+};
+
 POLYBAR_NS_END
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace i3_util {
+  /**
+   * Cached state of a single i3 workspace
+   *
+   * `revision` changes whenever any of the other fields do, so
+   * consumers can tell which entries need to be redrawn
+   */
+  struct workspace_state {
+    string name;
+    string output;
+    int num{-1};
+    bool focused{false};
+    bool visible{false};
+    bool urgent{false};
+    size_t revision{0};
+  };
+
+  /**
+   * Workspace list that is kept up to date by applying the payloads
+   * of i3 workspace events instead of querying GET_WORKSPACES each time
+   *
+   * The apply functions return false if the event refers to state the
+   * model doesn't know about, in which case it has to be resynced
+   */
+  class workspace_model {
+   public:
+    void reset(vector<workspace_state>&& workspaces);
+
+    bool focus(const string& name);
+    bool urgent(const string& name, bool state);
+    bool empty(const string& name);
+    bool move(const string& name, const string& output);
+
+    const vector<workspace_state>& workspaces() const;
+    size_t revision() const;
+
+   protected:
+    workspace_state* find(const string& name);
+    void touch(workspace_state& ws);
+
+   private:
+    vector<workspace_state> m_workspaces;
+    size_t m_revision{0};
+  };
+}  // namespace i3_util
+
+POLYBAR_NS_END
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+/**
+ * Scanners for the procfs and sysfs formats read by the modules
+ *
+ * They work on the raw buffer as read from the file and never
+ * allocate, apart from growing the output vector on first use
+ */
+namespace procfs_util {
+  struct cpu_time {
+    unsigned long long user;
+    unsigned long long nice;
+    unsigned long long system;
+    unsigned long long idle;
+    unsigned long long steal;
+    unsigned long long total;
+  };
+
+  struct meminfo {
+    unsigned long long total;
+    unsigned long long free;
+    unsigned long long available;
+    unsigned long long buffers;
+    unsigned long long cached;
+    unsigned long long sreclaimable;
+    unsigned long long shmem;
+    unsigned long long swap_total;
+    unsigned long long swap_free;
+    bool has_available;
+  };
+
+  size_t parse_stat(const char* data, size_t len, vector<cpu_time>& cores);
+  bool parse_meminfo(const char* data, size_t len, meminfo& info);
+  long long parse_integer(const char* data, size_t len);
+  bool starts_with(const char* data, size_t len, const char* prefix);
+}  // namespace procfs_util
+
+POLYBAR_NS_END
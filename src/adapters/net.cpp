@@ -5,17 +5,25 @@
 #include <arpa/inet.h>
 #include <linux/ethtool.h>
 #include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <linux/sockios.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
 
 #include "common.hpp"
 #include "settings.hpp"
 #include "utils/command.hpp"
 #include "utils/file.hpp"
+#include "utils/procfs.hpp"
 #include "utils/string.hpp"
 
 POLYBAR_NS
@@ -30,6 +38,327 @@ namespace net {
 
   static const string NO_IP = string("N/A");
 
+  /**
+   * Check if the address is one that should be shown, skipping
+   * link local, site local and unique local (fc00::/7) addresses
+   */
+  static bool is_global_ip6(const in6_addr& addr) {
+    if (IN6_IS_ADDR_LINKLOCAL(&addr) || IN6_IS_ADDR_SITELOCAL(&addr)) {
+      return false;
+    }
+    return (addr.s6_addr[0] & 0xFE) != 0xFC;
+  }
+
+  /**
+   * Milliseconds left until the deadline, rounded up
+   */
+  static int remaining_ms(std::chrono::steady_clock::time_point deadline) {
+    auto left = deadline - std::chrono::steady_clock::now();
+    if (left <= std::chrono::steady_clock::duration::zero()) {
+      return 0;
+    }
+    return static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(left + std::chrono::microseconds{999}).count());
+  }
+
+  // class : link_monitor {{{
+
+  // IF_OPER_* from linux/if.h, which can't be included next to net/if.h
+  static constexpr unsigned char OPER_UNKNOWN{0};
+  static constexpr unsigned char OPER_DOWN{2};
+  static constexpr unsigned char OPER_UP{6};
+
+  /**
+   * Subscribe to the link and address groups and load the current state
+   */
+  link_monitor::link_monitor(const string& interface) {
+    if ((m_ifindex = if_nametoindex(interface.c_str())) == 0) {
+      throw network_error("Invalid network interface \"" + interface + "\"");
+    }
+
+    if ((m_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)) == -1) {
+      throw system_error("Failed to open rtnetlink socket");
+    }
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+    if (bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+      close(m_fd);
+      throw system_error("Failed to bind rtnetlink socket");
+    }
+
+    resync();
+  }
+
+  link_monitor::~link_monitor() {
+    if (m_fd != -1) {
+      close(m_fd);
+    }
+  }
+
+  /**
+   * Socket that becomes readable when the kernel reports changes
+   */
+  int link_monitor::get_file_descriptor() const {
+    return m_fd;
+  }
+
+  /**
+   * Handle all pending notifications
+   *
+   * Returns true if the state of the interface changed
+   */
+  bool link_monitor::process() {
+    bool changed{false};
+    while (receive(false, changed)) {
+    }
+    return changed;
+  }
+
+  /**
+   * Check the operational state of the interface
+   */
+  bool link_monitor::up(bool unknown_up) const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_operstate == OPER_UP || (unknown_up && m_operstate == OPER_UNKNOWN);
+  }
+
+  string link_monitor::ip() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_ip.empty() ? NO_IP : m_ip.back();
+  }
+
+  string link_monitor::ip6() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_ip6.empty() ? NO_IP : m_ip6.back();
+  }
+
+  /**
+   * Load the link state and the addresses of the interface
+   *
+   * The addresses are collected separately and swapped in at the end,
+   * so readers never see a partial list. Retried a few times if the
+   * buffer overran again while the dump was read, the previous
+   * addresses are kept if it keeps overrunning
+   *
+   * Returns true if the state changed
+   */
+  bool link_monitor::resync() {
+    bool changed{false};
+
+    for (int attempt = 0; attempt < 3; attempt++) {
+      // Queued notifications are superseded by the dump, and dropping
+      // them makes room for the replies
+      alignas(nlmsghdr) char buffer[8192];
+      ssize_t bytes{0};
+      while ((bytes = recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0 ||
+             (bytes == -1 && (errno == EINTR || errno == ENOBUFS))) {
+      }
+
+      m_overrun = false;
+      m_dumping = true;
+      m_dump_ip.clear();
+      m_dump_ip6.clear();
+
+      request(RTM_GETLINK, NLM_F_ACK);
+      while (receive(true, changed)) {
+      }
+      if (!m_overrun) {
+        request(RTM_GETADDR, NLM_F_DUMP);
+        while (receive(true, changed)) {
+        }
+      }
+
+      m_dumping = false;
+
+      // An incomplete dump would drop addresses that still exist
+      if (m_overrun) {
+        continue;
+      }
+
+      {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_dump_ip != m_ip || m_dump_ip6 != m_ip6) {
+          m_ip.swap(m_dump_ip);
+          m_ip6.swap(m_dump_ip6);
+          changed = true;
+        }
+      }
+
+      break;
+    }
+
+    return changed;
+  }
+
+  /**
+   * Send a request for the link or the addresses of the interface
+   */
+  void link_monitor::request(int type, int flags) {
+    struct {
+      nlmsghdr hdr;
+      union {
+        ifinfomsg link;
+        ifaddrmsg addr;
+      };
+    } req{};
+
+    req.hdr.nlmsg_type = type;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | flags;
+    req.hdr.nlmsg_seq = ++m_seq;
+
+    if (type == RTM_GETLINK) {
+      req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+      req.link.ifi_family = AF_UNSPEC;
+      req.link.ifi_index = m_ifindex;
+    } else {
+      req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(ifaddrmsg));
+      req.addr.ifa_family = AF_UNSPEC;
+    }
+
+    if (send(m_fd, &req, req.hdr.nlmsg_len, 0) == -1) {
+      throw system_error("Failed to send rtnetlink request");
+    }
+  }
+
+  /**
+   * Read and handle one batch of messages
+   *
+   * When blocking, returns false once the reply to the last request is
+   * complete. Otherwise returns false when there is nothing left to read
+   */
+  bool link_monitor::receive(bool block, bool& changed) {
+    alignas(nlmsghdr) char buffer[8192];
+
+    // Replies are dropped without notice while the kernel still considers
+    // the socket congested, so don't wait for them forever
+    if (block) {
+      pollfd pfd{m_fd, POLLIN, 0};
+      int ready{poll(&pfd, 1, 1000)};
+      if (ready == -1) {
+        return errno == EINTR;
+      } else if (ready == 0) {
+        m_overrun = true;
+        return false;
+      }
+    }
+
+    auto bytes = recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+    if (bytes == -1 && errno == EINTR) {
+      return true;
+    } else if (bytes == -1 && errno == ENOBUFS) {
+      // The kernel dropped messages, start over from a fresh dump. When
+      // blocking, the reply that is waited for might be lost as well
+      if (block) {
+        m_overrun = true;
+        return false;
+      }
+      changed = resync() || changed;
+      return true;
+    } else if (bytes <= 0) {
+      return false;
+    }
+
+    bool more{true};
+    int len = static_cast<int>(bytes);
+
+    for (auto hdr = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len)) {
+      switch (hdr->nlmsg_type) {
+        case NLMSG_DONE:
+        case NLMSG_ERROR:
+          if (block && hdr->nlmsg_seq == m_seq) {
+            more = false;
+          }
+          break;
+        case RTM_NEWLINK:
+        case RTM_DELLINK:
+          changed = handle_link(hdr) || changed;
+          break;
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+          changed = handle_addr(hdr) || changed;
+          break;
+      }
+    }
+
+    return more;
+  }
+
+  bool link_monitor::handle_link(const nlmsghdr* hdr) {
+    auto ifi = static_cast<const ifinfomsg*>(NLMSG_DATA(hdr));
+    if (static_cast<unsigned int>(ifi->ifi_index) != m_ifindex) {
+      return false;
+    }
+
+    unsigned char operstate{OPER_DOWN};
+
+    if (hdr->nlmsg_type == RTM_NEWLINK) {
+      int len = IFLA_PAYLOAD(hdr);
+      for (auto rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type == IFLA_OPERSTATE) {
+          operstate = *static_cast<const unsigned char*>(RTA_DATA(rta));
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_operstate == operstate) {
+      return false;
+    }
+    m_operstate = operstate;
+    return true;
+  }
+
+  bool link_monitor::handle_addr(const nlmsghdr* hdr) {
+    auto ifa = static_cast<const ifaddrmsg*>(NLMSG_DATA(hdr));
+    if (ifa->ifa_index != m_ifindex || (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)) {
+      return false;
+    }
+
+    const void* address{nullptr};
+    int len = IFA_PAYLOAD(hdr);
+    for (auto rta = IFA_RTA(ifa); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+      // IFA_LOCAL is the address of the interface on point-to-point links
+      if (rta->rta_type == IFA_LOCAL || (rta->rta_type == IFA_ADDRESS && address == nullptr)) {
+        address = RTA_DATA(rta);
+      }
+    }
+
+    if (address == nullptr) {
+      return false;
+    }
+    if (ifa->ifa_family == AF_INET6 && !is_global_ip6(*static_cast<const in6_addr*>(address))) {
+      return false;
+    }
+
+    char buffer[INET6_ADDRSTRLEN];
+    if (inet_ntop(ifa->ifa_family, address, buffer, sizeof(buffer)) == nullptr) {
+      return false;
+    }
+
+    std::unique_lock<std::mutex> guard(m_lock, std::defer_lock);
+    if (!m_dumping) {
+      guard.lock();
+    }
+
+    auto& addresses = ifa->ifa_family == AF_INET ? (m_dumping ? m_dump_ip : m_ip) : (m_dumping ? m_dump_ip6 : m_ip6);
+    auto it = std::find(addresses.begin(), addresses.end(), buffer);
+
+    // Changes made by a dump are only known once it is complete
+    if (hdr->nlmsg_type == RTM_NEWADDR && it == addresses.end()) {
+      addresses.emplace_back(buffer);
+      return !m_dumping;
+    } else if (hdr->nlmsg_type == RTM_DELADDR && it != addresses.end()) {
+      addresses.erase(it);
+      return !m_dumping;
+    }
+    return false;
+  }
+
+  // }}}
   // class : network {{{
 
   /**
@@ -46,6 +375,18 @@ namespace net {
     }
 
     check_tuntap_or_bridge();
+
+    // Link state and addresses are pushed by the kernel, only the
+    // transfer counters are still read on each interval
+    try {
+      auto& values = sampler::make();
+      m_rxbytes = values.subscribe("/sys/class/net/" + m_interface + "/statistics/rx_bytes");
+      m_txbytes = values.subscribe("/sys/class/net/" + m_interface + "/statistics/tx_bytes");
+      m_monitor = make_unique<link_monitor>(m_interface);
+    } catch (const application_error& err) {
+      m_log.warn("Failed to monitor interface \"%s\", falling back to polling (%s)", m_interface, err.what());
+      m_monitor.reset();
+    }
   }
 
   /**
@@ -56,6 +397,13 @@ namespace net {
     m_status.current.transmitted = 0;
     m_status.current.received = 0;
     m_status.current.time = std::chrono::system_clock::now();
+
+    if (m_monitor && !accumulate) {
+      m_status.ip = m_monitor->ip();
+      m_status.ip6 = m_monitor->ip6();
+      return query_counters();
+    }
+
     m_status.ip = NO_IP;
     m_status.ip6 = NO_IP;
 
@@ -87,14 +435,7 @@ namespace net {
         case AF_INET6:
           char ip6_buffer[INET6_ADDRSTRLEN];
           sa6 = reinterpret_cast<decltype(sa6)>(ifa->ifa_addr);
-          if (IN6_IS_ADDR_LINKLOCAL(&sa6->sin6_addr)) {
-              continue;
-          }
-          if (IN6_IS_ADDR_SITELOCAL(&sa6->sin6_addr)) {
-              continue;
-          }
-          if ((((unsigned char*)sa6->sin6_addr.s6_addr)[0] & 0xFE) == 0xFC) {
-              /* Skip Unique Local Addresses (fc00::/7) */
+          if (!is_global_ip6(sa6->sin6_addr)) {
               continue;
           }
           if (inet_ntop(AF_INET6, &sa6->sin6_addr, ip6_buffer, INET6_ADDRSTRLEN) == 0) {
@@ -124,9 +465,54 @@ namespace net {
   }
 
   /**
-   * Run ping command to test internet connectivity
+   * Read the transfer counters of the interface from sysfs
+   */
+  bool network::query_counters() {
+    const auto read = [](const sampler::handle& src) {
+      return sampler::make().read(src, sampler::clock::duration::zero(), procfs_util::parse_integer);
+    };
+    m_status.current.received = read(m_rxbytes);
+    m_status.current.transmitted = read(m_txbytes);
+    return true;
+  }
+
+  /**
+   * Interface state notification sockets
+   */
+  vector<int> network::event_fds() const {
+    if (m_monitor) {
+      return {m_monitor->get_file_descriptor()};
+    }
+    return {};
+  }
+
+  /**
+   * Handle pending interface state notifications
+   *
+   * Returns true if the state of the interface changed
+   */
+  bool network::process_events() {
+    if (m_monitor && m_monitor->process()) {
+      m_status.ip = m_monitor->ip();
+      m_status.ip6 = m_monitor->ip6();
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Test internet connectivity, either in-process or using the ping command
    */
   bool network::ping() const {
+    if (m_probe) {
+      try {
+        return probe();
+      } catch (const system_error& err) {
+        m_log.warn("Connectivity probe unavailable, falling back to ping (%s)", err.what());
+        m_probe = false;
+      }
+    }
+
     try {
       auto exec = "ping -c 2 -W 2 -I " + m_interface + " " + string(CONNECTION_TEST_IP);
       auto ping = command_util::make_command(exec);
@@ -136,6 +522,54 @@ namespace net {
     }
   }
 
+  /**
+   * Send ICMP echo requests from an unprivileged ICMP datagram socket,
+   * which needs the group to be part of net.ipv4.ping_group_range
+   *
+   * Mirrors `ping -c 2 -W 2`
+   */
+  bool network::probe() const {
+    file_descriptor fd{socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_ICMP)};
+    if (static_cast<int>(fd) == -1) {
+      throw system_error("Failed to open ICMP socket");
+    }
+
+    // Not permitted without CAP_NET_RAW on older kernels, the
+    // routing table decides about the interface in that case
+    setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, m_interface.c_str(), m_interface.size());
+
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    if (inet_pton(AF_INET, CONNECTION_TEST_IP, &dest.sin_addr) != 1) {
+      return false;
+    }
+
+    for (uint16_t seq = 1; seq <= 2; seq++) {
+      // The kernel fills in the identifier and the checksum
+      icmphdr request{};
+      request.type = ICMP_ECHO;
+      request.un.echo.sequence = htons(seq);
+
+      if (sendto(fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)) == -1) {
+        continue;
+      }
+
+      // Unrelated packets don't extend the wait for the reply
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+      pollfd pfd{fd, POLLIN, 0};
+      int timeout{0};
+      while ((timeout = remaining_ms(deadline)) > 0 && poll(&pfd, 1, timeout) > 0) {
+        icmphdr reply{};
+        if (recv(fd, &reply, sizeof(reply), MSG_DONTWAIT) >= static_cast<ssize_t>(sizeof(reply)) &&
+            reply.type == ICMP_ECHOREPLY) {
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
   /**
    * Get interface ipv4 address
    */
@@ -173,6 +607,13 @@ namespace net {
     m_unknown_up = unknown;
   }
 
+  /**
+   * Use the in-process connectivity probe instead of the ping command
+   */
+  void network::set_probe(bool in_process) {
+    m_probe = in_process;
+  }
+
   /**
    * Query driver info to check if the
    * interface is a TUN/TAP device or BRIDGE
@@ -216,6 +657,9 @@ namespace net {
    * Test if the network interface is in a valid state
    */
   bool network::test_interface() const {
+    if (m_monitor) {
+      return m_monitor->up(m_unknown_up);
+    }
     auto operstate = file_util::contents("/sys/class/net/" + m_interface + "/operstate");
     bool up = operstate.compare(0, 2, "up") == 0;
     return m_unknown_up ? (up || operstate.compare(0, 7, "unknown") == 0) : up;
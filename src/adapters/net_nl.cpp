@@ -11,6 +11,20 @@ POLYBAR_NS
 namespace net {
   // class : wireless_network {{{
 
+  wireless_network::wireless_network(string interface)
+      : network(interface), m_ifid(if_nametoindex(interface.c_str())) {
+    subscribe();
+  }
+
+  wireless_network::~wireless_network() {
+    if (m_events != nullptr) {
+      nl_socket_free(m_events);
+    }
+    if (m_sock != nullptr) {
+      nl_socket_free(m_sock);
+    }
+  }
+
   /**
    * Query the wireless device for information
    * about the current connection
@@ -19,49 +33,134 @@ namespace net {
     if (!network::query(accumulate)) {
       return false;
     }
+    return query_bss();
+  }
 
-    struct nl_sock* sk = nl_socket_alloc();
-    if (sk == nullptr) {
-      return false;
+  /**
+   * Dump the scan results of the interface using the
+   * persistent generic netlink socket
+   */
+  bool wireless_network::query_bss() {
+    if (m_sock == nullptr) {
+      if ((m_sock = nl_socket_alloc()) == nullptr) {
+        return false;
+      }
+
+      if (genl_connect(m_sock) < 0 || (m_driver_id = genl_ctrl_resolve(m_sock, "nl80211")) < 0 ||
+          nl_socket_modify_cb(m_sock, NL_CB_VALID, NL_CB_CUSTOM, scan_cb, this) != 0) {
+        nl_socket_free(m_sock);
+        m_sock = nullptr;
+        return false;
+      }
     }
 
-    if (genl_connect(sk) < 0) {
+    struct nl_msg* msg = nlmsg_alloc();
+    if (msg == nullptr) {
       return false;
     }
 
-    int driver_id = genl_ctrl_resolve(sk, "nl80211");
-    if (driver_id < 0) {
-      nl_socket_free(sk);
+    if ((genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, m_driver_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) == nullptr) ||
+        nla_put_u32(msg, NL80211_ATTR_IFINDEX, m_ifid) < 0) {
+      nlmsg_free(msg);
       return false;
     }
 
-    if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, scan_cb, this) != 0) {
-      nl_socket_free(sk);
+    // nl_send_sync always frees msg. A failed request might leave
+    // unread replies behind, so start over with a new socket
+    if (nl_send_sync(m_sock, msg) < 0) {
+      nl_socket_free(m_sock);
+      m_sock = nullptr;
       return false;
     }
 
-    struct nl_msg* msg = nlmsg_alloc();
-    if (msg == nullptr) {
-      nl_socket_free(sk);
-      return false;
+    return true;
+  }
+
+  /**
+   * Listen for association changes so they show up without
+   * waiting for the next interval
+   */
+  void wireless_network::subscribe() {
+    if ((m_events = nl_socket_alloc()) == nullptr) {
+      return;
     }
 
-    if ((genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, driver_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) == nullptr) ||
-        nla_put_u32(msg, NL80211_ATTR_IFINDEX, m_ifid) < 0) {
-      nlmsg_free(msg);
-      nl_socket_free(sk);
-      return false;
+    // Multicast messages aren't replies to any of our requests
+    nl_socket_disable_seq_check(m_events);
+
+    int group{-1};
+    if (genl_connect(m_events) < 0 || (group = genl_ctrl_resolve_grp(m_events, "nl80211", "mlme")) < 0 ||
+        nl_socket_add_membership(m_events, group) < 0 || nl_socket_set_nonblocking(m_events) < 0 ||
+        nl_socket_modify_cb(m_events, NL_CB_VALID, NL_CB_CUSTOM, event_cb, this) != 0) {
+      m_log.warn("Failed to subscribe to nl80211 events for \"%s\"", m_interface);
+      nl_socket_free(m_events);
+      m_events = nullptr;
     }
+  }
 
-    // nl_send_sync always frees msg
-    if (nl_send_sync(sk, msg) < 0) {
-      nl_socket_free(sk);
-      return false;
+  /**
+   * Link notifications and the nl80211 event socket
+   */
+  vector<int> wireless_network::event_fds() const {
+    auto fds = network::event_fds();
+    if (m_events != nullptr) {
+      fds.emplace_back(nl_socket_get_fd(m_events));
     }
+    return fds;
+  }
 
-    nl_socket_free(sk);
+  /**
+   * Handle pending link and association notifications, querying
+   * the scan results again if the association changed
+   */
+  bool wireless_network::process_events() {
+    bool changed{network::process_events()};
 
-    return true;
+    if (m_events != nullptr) {
+      m_mlme_changed = false;
+      // Returns -NLE_AGAIN once the socket is drained
+      while (nl_recvmsgs_default(m_events) >= 0) {
+      }
+      if (m_mlme_changed) {
+        m_essid.clear();
+        m_signalstrength = {};
+        m_linkquality = {};
+        query_bss();
+        changed = true;
+      }
+    }
+
+    return changed;
+  }
+
+  /**
+   * Callback to flag mlme events for the interface
+   */
+  int wireless_network::event_cb(struct nl_msg* msg, void* instance) {
+    auto wn = static_cast<wireless_network*>(instance);
+    auto gnlh = static_cast<genlmsghdr*>(nlmsg_data(nlmsg_hdr(msg)));
+    struct nlattr* tb[NL80211_ATTR_MAX + 1];
+
+    if (nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), nullptr) < 0) {
+      return NL_SKIP;
+    }
+
+    if (tb[NL80211_ATTR_IFINDEX] != nullptr && nla_get_u32(tb[NL80211_ATTR_IFINDEX]) == wn->m_ifid) {
+      switch (gnlh->cmd) {
+        case NL80211_CMD_CONNECT:
+        case NL80211_CMD_DISCONNECT:
+        case NL80211_CMD_ASSOCIATE:
+        case NL80211_CMD_DISASSOCIATE:
+        case NL80211_CMD_DEAUTHENTICATE:
+        case NL80211_CMD_ROAM:
+          wn->m_mlme_changed = true;
+          break;
+        default:
+          break;
+      }
+    }
+
+    return NL_SKIP;
   }
 
   /**
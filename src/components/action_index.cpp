@@ -0,0 +1,157 @@
+#include "components/action_index.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+POLYBAR_NS
+
+namespace {
+  bool is_scroll(mousebtn button) {
+    return button == mousebtn::SCROLL_UP || button == mousebtn::SCROLL_DOWN;
+  }
+}  // namespace
+
+/**
+ * Build the index from the action blocks of a frame
+ *
+ * Blocks that were never closed have no extent and are left out
+ */
+action_index::action_index(const vector<action_block>& blocks) {
+  m_regions.reserve(blocks.size());
+
+  for (auto&& block : blocks) {
+    int start{static_cast<int>(block.start_x)};
+    int end{static_cast<int>(block.end_x)};
+
+    if (block.active || end <= start) {
+      continue;
+    }
+
+    m_regions.emplace_back(region{block.button, start, end, 0, block.command});
+    m_double_click = m_double_click || static_cast<int>(block.button) >= static_cast<int>(mousebtn::DOUBLE_LEFT);
+  }
+
+  // Sorted by start, enclosing regions before the ones nested in them
+  vector<size_t> order(m_regions.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    const auto& ra = m_regions[a];
+    const auto& rb = m_regions[b];
+    return ra.start != rb.start ? ra.start < rb.start : ra.end != rb.end ? ra.end > rb.end : a < b;
+  });
+
+  vector<size_t> open;
+  for (size_t id : order) {
+    auto& r = m_regions[id];
+    open.erase(std::remove_if(open.begin(), open.end(), [&](size_t o) { return m_regions[o].end <= r.start; }),
+        open.end());
+    r.depth = std::count_if(open.begin(), open.end(), [&](size_t o) { return m_regions[o].end >= r.end; });
+    open.emplace_back(id);
+  }
+
+  vector<int> bounds;
+  bounds.reserve(m_regions.size() * 2);
+  for (auto&& r : m_regions) {
+    bounds.emplace_back(r.start);
+    bounds.emplace_back(r.end);
+  }
+  std::sort(bounds.begin(), bounds.end());
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+  // Sweep over the boundaries, keeping track of the regions covering each segment
+  vector<size_t> active;
+  size_t next{0};
+
+  for (size_t i = 0; i + 1 < bounds.size(); i++) {
+    int x{bounds[i]};
+
+    active.erase(std::remove_if(active.begin(), active.end(), [&](size_t id) { return m_regions[id].end <= x; }),
+        active.end());
+    while (next < order.size() && m_regions[order[next]].start == x) {
+      active.emplace_back(order[next++]);
+    }
+
+    if (active.empty()) {
+      continue;
+    }
+
+    segment seg{x, bounds[i + 1], m_covering.size(), active.size(), false, false};
+
+    // Regions added later are nested inside the earlier ones, so they take precedence
+    size_t first{m_covering.size()};
+    m_covering.insert(m_covering.end(), active.begin(), active.end());
+    std::sort(m_covering.begin() + first, m_covering.end(), std::greater<size_t>());
+
+    for (size_t id : active) {
+      mousebtn button{m_regions[id].button};
+      seg.scroll = seg.scroll || is_scroll(button);
+      seg.click = seg.click || (!is_scroll(button) && button != mousebtn::NONE);
+    }
+
+    m_segments.emplace_back(seg);
+  }
+}
+
+/**
+ * Find the innermost region at the given position that handles the button
+ */
+const action_index::region* action_index::find(int x, mousebtn button) const {
+  const segment* seg{locate(x)};
+
+  if (seg != nullptr) {
+    for (size_t i = seg->first; i < seg->first + seg->count; i++) {
+      if (m_regions[m_covering[i]].button == button) {
+        return &m_regions[m_covering[i]];
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * Check if there is a click region at the given position
+ */
+bool action_index::has_click(int x) const {
+  const segment* seg{locate(x)};
+  return seg != nullptr && seg->click;
+}
+
+/**
+ * Check if there is a scroll region at the given position
+ */
+bool action_index::has_scroll(int x) const {
+  const segment* seg{locate(x)};
+  return seg != nullptr && seg->scroll;
+}
+
+/**
+ * Check if any region handles double clicks
+ */
+bool action_index::has_double_click() const {
+  return m_double_click;
+}
+
+/**
+ * Get all regions in the order their blocks were opened
+ */
+const vector<action_index::region>& action_index::regions() const {
+  return m_regions;
+}
+
+/**
+ * Find the segment containing the given position
+ */
+const action_index::segment* action_index::locate(int x) const {
+  auto it = std::upper_bound(
+      m_segments.begin(), m_segments.end(), x, [](int pos, const segment& seg) { return pos < seg.start; });
+
+  if (it == m_segments.begin()) {
+    return nullptr;
+  }
+
+  --it;
+  return x < it->end ? &*it : nullptr;
+}
+
+POLYBAR_NS_END
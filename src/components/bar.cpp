@@ -3,7 +3,6 @@
 #include <algorithm>
 
 #include "components/config.hpp"
-#include "components/parser.hpp"
 #include "components/renderer.hpp"
 #include "components/screen.hpp"
 #include "components/taskqueue.hpp"
@@ -38,7 +37,7 @@ using namespace signals::ui;
 /**
  * Create instance
  */
-bar::make_type bar::make(bool only_initialize_values) {
+bar::make_type bar::make(string section, bool only_initialize_values) {
   // clang-format off
   return factory_util::unique<bar>(
         connection::make(),
@@ -47,8 +46,8 @@ bar::make_type bar::make(bool only_initialize_values) {
         logger::make(),
         screen::make(),
         tray_manager::make(),
-        parser::make(),
         taskqueue::make(),
+        move(section),
         only_initialize_values);
   // clang-format on
 }
@@ -56,20 +55,23 @@ bar::make_type bar::make(bool only_initialize_values) {
 /**
  * Construct bar instance
  *
+ * The bar is loaded from the given section, or from the one
+ * of the bar passed on the command line if it's empty
+ *
  * TODO: Break out all tray handling
  */
 bar::bar(connection& conn, signal_emitter& emitter, const config& config, const logger& logger,
-    unique_ptr<screen>&& screen, unique_ptr<tray_manager>&& tray_manager, unique_ptr<parser>&& parser,
-    unique_ptr<taskqueue>&& taskqueue, bool only_initialize_values)
+    unique_ptr<screen>&& screen, unique_ptr<tray_manager>&& tray_manager, unique_ptr<taskqueue>&& taskqueue,
+    string section, bool only_initialize_values)
     : m_connection(conn)
     , m_sig(emitter)
     , m_conf(config)
     , m_log(logger)
     , m_screen(forward<decltype(screen)>(screen))
     , m_tray(forward<decltype(tray_manager)>(tray_manager))
-    , m_parser(forward<decltype(parser)>(parser))
     , m_taskqueue(forward<decltype(taskqueue)>(taskqueue)) {
-  string bs{m_conf.section()};
+  m_opts.section = section.empty() ? m_conf.section() : move(section);
+  string bs{m_opts.section};
 
   // Get available RandR outputs
   auto monitor_name = m_conf.get(bs, "monitor", ""s);
@@ -173,6 +175,7 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
   m_opts.module_margin.right = m_conf.get(bs, "module-margin-right", margin);
 
   if (only_initialize_values) {
+    publish_settings();
     return;
   }
 
@@ -254,10 +257,10 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
   m_opts.borders[edge::RIGHT].color = parse_or_throw("border-right-color", border_color);
 
   // Load geometry values
-  auto w = m_conf.get(m_conf.section(), "width", "100%"s);
-  auto h = m_conf.get(m_conf.section(), "height", "24"s);
-  auto offsetx = m_conf.get(m_conf.section(), "offset-x", ""s);
-  auto offsety = m_conf.get(m_conf.section(), "offset-y", ""s);
+  auto w = m_conf.get(bs, "width", "100%"s);
+  auto h = m_conf.get(bs, "height", "24"s);
+  auto offsetx = m_conf.get(bs, "offset-x", ""s);
+  auto offsety = m_conf.get(bs, "offset-y", ""s);
 
   m_opts.size.w = geom_format_to_pixels(w, m_opts.monitor->w);
   m_opts.size.h = geom_format_to_pixels(h, m_opts.monitor->h);
@@ -284,6 +287,8 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
       m_opts.pos.y, m_opts.borders[edge::TOP].size, m_opts.borders[edge::RIGHT].size, m_opts.borders[edge::BOTTOM].size,
       m_opts.borders[edge::LEFT].size);
 
+  publish_settings();
+
   m_log.trace("bar: Attach X event sink");
   m_connection.attach_sink(this, SINK_PRIORITY_BAR);
 
@@ -301,19 +306,20 @@ bar::~bar() {
 }
 
 /**
- * Get the bar settings container
+ * Get the current snapshot of the bar settings
  */
-const bar_settings bar::settings() const {
-  return m_opts;
+bar_settings_t bar::settings() const {
+  return std::atomic_load(&m_snapshot);
 }
 
 /**
- * Parse input string and redraw the bar window
+ * Redraw the bar window using the render ops parsed from the input string
  *
  * \param data Input string
- * \param force Unless true, do not parse unchanged data
+ * \param ops Render ops produced from data
+ * \param force Unless true, do not redraw unchanged data
  */
-void bar::parse(string&& data, bool force) {
+void bar::parse(string&& data, render_list&& ops, bool force) {
   if (!m_mutex.try_lock()) {
     return;
   }
@@ -323,6 +329,7 @@ void bar::parse(string&& data, bool force) {
   bool unchanged = data == m_lastinput;
 
   m_lastinput = data;
+  m_lastops = forward<render_list>(ops);
 
   if (force) {
     m_log.trace("bar: Force update");
@@ -349,20 +356,12 @@ void bar::parse(string&& data, bool force) {
 
   m_log.info("Redrawing bar window");
   m_renderer->begin(rect);
-
-  try {
-    m_parser->parse(settings(), data);
-  } catch (const parser_error& err) {
-    m_log.err("Failed to parse contents (reason: %s)", err.what());
-  }
-
+  m_renderer->render(m_lastops);
   m_renderer->end();
 
   const auto check_dblclicks = [&]() -> bool {
-    for (auto&& action : m_renderer->actions()) {
-      if (static_cast<int>(action.button) >= static_cast<int>(mousebtn::DOUBLE_LEFT)) {
-        return true;
-      }
+    if (m_renderer->actions()->has_double_click()) {
+      return true;
     }
     for (auto&& action : m_opts.actions) {
       if (static_cast<int>(action.button) >= static_cast<int>(mousebtn::DOUBLE_LEFT)) {
@@ -384,7 +383,9 @@ void bar::hide() {
 
   try {
     m_log.info("Hiding bar window");
-    m_sig.emit(visibility_change{false});
+    if (hosts_tray()) {
+      m_sig.emit(visibility_change{false});
+    }
     m_connection.unmap_window_checked(m_opts.window);
     m_connection.flush();
     m_visible = false;
@@ -404,7 +405,9 @@ void bar::show() {
 
   try {
     m_log.info("Showing bar window");
-    m_sig.emit(visibility_change{true});
+    if (hosts_tray()) {
+      m_sig.emit(visibility_change{true});
+    }
     /**
      * First reconfigures the window so that WMs that discard some information
      * when unmapping have the correct window properties (geometry etc).
@@ -413,7 +416,7 @@ void bar::show() {
     m_connection.map_window_checked(m_opts.window);
     m_connection.flush();
     m_visible = true;
-    parse(string{m_lastinput}, true);
+    parse(string{m_lastinput}, render_list{m_lastops}, true);
   } catch (const exception& err) {
     m_log.err("Failed to map bar window (err=%s", err.what());
   }
@@ -438,7 +441,7 @@ void bar::restack_window() {
   string wm_restack;
 
   try {
-    wm_restack = m_conf.get(m_conf.section(), "wm-restack");
+    wm_restack = m_conf.get(m_opts.section, "wm-restack");
   } catch (const key_error& err) {
     return;
   }
@@ -540,6 +543,10 @@ void bar::reconfigure_wm_hints() {
  * Broadcast current map state
  */
 void bar::broadcast_visibility() {
+  if (!hosts_tray()) {
+    return;
+  }
+
   auto attr = m_connection.get_window_attributes(m_opts.window);
 
   if (attr->map_state == XCB_MAP_STATE_UNVIEWABLE) {
@@ -551,6 +558,26 @@ void bar::broadcast_visibility() {
   }
 }
 
+/**
+ * Replace the settings snapshot with a copy of the current settings
+ *
+ * Readers that still hold the previous snapshot keep using it until
+ * they ask for the settings again
+ */
+void bar::publish_settings() {
+  std::atomic_store(&m_snapshot, bar_settings_t{make_shared<const bar_settings>(m_opts)});
+}
+
+/**
+ * Check if the tray is docked to this bar
+ *
+ * The tray follows the visibility and opacity of its bar, which it
+ * learns through signals that are only emitted by that bar
+ */
+bool bar::hosts_tray() const {
+  return m_tray->settings().align != alignment::NONE;
+}
+
 /**
  * Event handler for XCB_DESTROY_NOTIFY events
  */
@@ -576,20 +603,20 @@ void bar::handle(const evt::destroy_notify& evt) {
  * Used to brighten the window by setting the
  * _NET_WM_WINDOW_OPACITY atom value
  */
-void bar::handle(const evt::enter_notify&) {
+void bar::handle(const evt::enter_notify& evt) {
+  if (evt->event != m_opts.window) {
+    return;
+  }
 #if 0
 #ifdef DEBUG_SHADED
   if (m_opts.origin == edge::TOP) {
-    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { m_sig.emit(signals::ui::unshade_window{}); });
+    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { unshade(); });
     return;
   }
 #endif
 #endif
   if (m_opts.dimmed) {
-    m_taskqueue->defer_unique("window-dim", 25ms, [&](size_t) {
-      m_opts.dimmed = false;
-      m_sig.emit(dim_window{1.0});
-    });
+    m_taskqueue->defer_unique("window-dim", 25ms, [&](size_t) { dim(1.0); });
   } else if (m_taskqueue->exist("window-dim")) {
     m_taskqueue->purge("window-dim");
   }
@@ -601,20 +628,20 @@ void bar::handle(const evt::enter_notify&) {
  * Used to dim the window by setting the
  * _NET_WM_WINDOW_OPACITY atom value
  */
-void bar::handle(const evt::leave_notify&) {
+void bar::handle(const evt::leave_notify& evt) {
+  if (evt->event != m_opts.window) {
+    return;
+  }
 #if 0
 #ifdef DEBUG_SHADED
   if (m_opts.origin == edge::TOP) {
-    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { m_sig.emit(signals::ui::shade_window{}); });
+    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { shade(); });
     return;
   }
 #endif
 #endif
   if (!m_opts.dimmed) {
-    m_taskqueue->defer_unique("window-dim", 3s, [&](size_t) {
-      m_opts.dimmed = true;
-      m_sig.emit(dim_window{double(m_opts.dimvalue)});
-    });
+    m_taskqueue->defer_unique("window-dim", 3s, [&](size_t) { dim(m_opts.dimvalue); });
   }
 }
 
@@ -624,69 +651,52 @@ void bar::handle(const evt::leave_notify&) {
  * Used to change the cursor depending on the module
  */
 void bar::handle(const evt::motion_notify& evt) {
-  if (!m_mutex.try_lock()) {
+  if (evt->event != m_opts.window) {
     return;
   }
 
-  std::lock_guard<std::mutex> guard(m_mutex, std::adopt_lock);
-
   m_log.trace("bar: Detected motion: %i at pos(%i, %i)", evt->detail, evt->event_x, evt->event_y);
 #if WITH_XCURSOR
   m_motion_pos = evt->event_x;
-  // scroll cursor is less important than click cursor, so we shouldn't return until we are sure there is no click
-  // action
-  bool found_scroll = false;
-  const auto find_click_area = [&](const action& action) {
-    if (!m_opts.cursor_click.empty() &&
-        !(action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN ||
-            action.button == mousebtn::NONE)) {
-      if (!string_util::compare(m_opts.cursor, m_opts.cursor_click)) {
-        m_opts.cursor = m_opts.cursor_click;
-        m_sig.emit(cursor_change{string{m_opts.cursor}});
-      }
-      return true;
-    } else if (!m_opts.cursor_scroll.empty() &&
-               (action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN)) {
-      if (!found_scroll) {
-        found_scroll = true;
-      }
+
+  // The snapshot of the last frame is only read, so redraws don't hold up the hit test
+  auto index = m_renderer->actions();
+
+  const auto set_cursor = [&](const string& cursor) {
+    if (!string_util::compare(m_opts.cursor, cursor)) {
+      m_opts.cursor = cursor;
+      change_cursor(m_opts.cursor);
     }
-    return false;
   };
 
-  for (auto&& action : m_renderer->actions()) {
-    if (action.test(m_motion_pos)) {
-      m_log.trace("Found matching input area");
-      if (find_click_area(action))
-        return;
-    }
-  }
-  if (found_scroll) {
-    if (!string_util::compare(m_opts.cursor, m_opts.cursor_scroll)) {
-      m_opts.cursor = m_opts.cursor_scroll;
-      m_sig.emit(cursor_change{string{m_opts.cursor}});
-    }
-    return;
+  // scroll cursor is less important than click cursor, so we shouldn't return until we are sure there is no click
+  // action
+  if (!m_opts.cursor_click.empty() && index->has_click(m_motion_pos)) {
+    m_log.trace("Found matching input area");
+    return set_cursor(m_opts.cursor_click);
+  } else if (!m_opts.cursor_scroll.empty() && index->has_scroll(m_motion_pos)) {
+    m_log.trace("Found matching input area");
+    return set_cursor(m_opts.cursor_scroll);
   }
+
+  bool found_scroll = false;
   for (auto&& action : m_opts.actions) {
-    if (!action.command.empty()) {
-      m_log.trace("Found matching fallback handler");
-      if (find_click_area(action))
-        return;
+    if (action.command.empty()) {
+      continue;
     }
-  }
-  if (found_scroll) {
-    if (!string_util::compare(m_opts.cursor, m_opts.cursor_scroll)) {
-      m_opts.cursor = m_opts.cursor_scroll;
-      m_sig.emit(cursor_change{string{m_opts.cursor}});
+    m_log.trace("Found matching fallback handler");
+    if (action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN) {
+      found_scroll = true;
+    } else if (!m_opts.cursor_click.empty() && action.button != mousebtn::NONE) {
+      return set_cursor(m_opts.cursor_click);
     }
-    return;
+  }
+  if (found_scroll && !m_opts.cursor_scroll.empty()) {
+    return set_cursor(m_opts.cursor_scroll);
   }
   if (!string_util::compare(m_opts.cursor, "default")) {
     m_log.trace("No matching cursor area found");
-    m_opts.cursor = "default";
-    m_sig.emit(cursor_change{string{m_opts.cursor}});
-    return;
+    set_cursor("default");
   }
 #endif
 }
@@ -697,12 +707,10 @@ void bar::handle(const evt::motion_notify& evt) {
  * Used to map mouse clicks to bar actions
  */
 void bar::handle(const evt::button_press& evt) {
-  if (!m_mutex.try_lock()) {
+  if (evt->event != m_opts.window) {
     return;
   }
 
-  std::lock_guard<std::mutex> guard(m_mutex, std::adopt_lock);
-
   if (m_buttonpress.deny(evt->time)) {
     return m_log.trace_x("bar: Ignoring button press (throttled)...");
   }
@@ -713,18 +721,13 @@ void bar::handle(const evt::button_press& evt) {
   m_buttonpress_pos = evt->event_x;
 
   const auto deferred_fn = [&](size_t) {
-    /*
-     * Iterate over all defined actions in reverse order until matching action is found
-     * To properly handle nested actions we iterate in reverse because nested actions are added later than their
-     * surrounding action block
-     */
-    auto actions = m_renderer->actions();
-    for (auto action = actions.rbegin(); action != actions.rend(); action++) {
-      if (action->button == m_buttonpress_btn && !action->active && action->test(m_buttonpress_pos)) {
-        m_log.trace("Found matching input area");
-        m_sig.emit(button_press{string{action->command}});
-        return;
-      }
+    // The index returns the innermost matching action, nested actions take precedence
+    auto index = m_renderer->actions();
+    auto region = index->find(m_buttonpress_pos, m_buttonpress_btn);
+    if (region != nullptr) {
+      m_log.trace("Found matching input area");
+      m_sig.emit(button_press{string{region->command}});
+      return;
     }
 
     for (auto&& action : m_opts.actions) {
@@ -799,7 +802,11 @@ void bar::handle(const evt::property_notify& evt) {
   }
 }
 
-void bar::handle(const evt::configure_notify&) {
+void bar::handle(const evt::configure_notify& evt) {
+  if (evt->window != m_opts.window) {
+    return;
+  }
+
   // The absolute position of the window in the root may be different after configuration is done
   // (for example, because the parent is not positioned at 0/0 in the root window).
   // Notify components that the geometry may have changed (used by the background manager for example).
@@ -810,6 +817,7 @@ bool bar::on(const signals::eventqueue::start&) {
   m_log.trace("bar: Create renderer");
   m_renderer = renderer::make(m_opts);
   m_opts.window = m_renderer->window();
+  publish_settings();
 
   // Subscribe to window enter and leave events
   // if we should dim the window
@@ -841,20 +849,30 @@ bool bar::on(const signals::eventqueue::start&) {
   m_sig.emit(signals::ui::ready{});
 
   // TODO: tray manager could run this internally on ready event
-  m_log.trace("bar: Setup tray manager");
-  m_tray->setup(static_cast<const bar_settings&>(m_opts));
+  // Only one tray can be docked per process, it goes to the bar passed first on the command line
+  if (m_opts.section == m_conf.section()) {
+    m_log.trace("bar: Setup tray manager");
+    m_tray->setup(static_cast<const bar_settings&>(m_opts));
+  } else if (m_conf.has(m_opts.section, "tray-position")) {
+    m_log.warn("Ignoring tray of %s, only the first bar of a process can host the tray", m_opts.section);
+  }
 
   broadcast_visibility();
 
-  return true;
+  // let the other bars of the process start as well
+  return false;
 }
 
-bool bar::on(const signals::ui::unshade_window&) {
+/**
+ * Roll the window out to its full height
+ */
+void bar::unshade() {
   m_opts.shaded = false;
   m_opts.shade_size.w = m_opts.size.w;
   m_opts.shade_size.h = m_opts.size.h;
   m_opts.shade_pos.x = m_opts.pos.x;
   m_opts.shade_pos.y = m_opts.pos.y;
+  publish_settings();
 
   double distance{static_cast<double>(m_opts.shade_size.h - m_connection.get_geometry(m_opts.window)->height)};
   double steptime{25.0 / 2.0};
@@ -864,22 +882,22 @@ bool bar::on(const signals::ui::unshade_window&) {
       "window-shade", 25ms,
       [&](size_t remaining) {
         if (!m_opts.shaded) {
-          m_sig.emit(signals::ui::tick{});
+          shade_step();
         }
         if (!remaining) {
           m_renderer->flush();
         }
         if (m_opts.dimmed) {
-          m_opts.dimmed = false;
-          m_sig.emit(dim_window{1.0});
+          dim(1.0);
         }
       },
       taskqueue::deferred::duration{25ms}, 10U);
-
-  return true;
 }
 
-bool bar::on(const signals::ui::shade_window&) {
+/**
+ * Roll the window up to a thin strip
+ */
+void bar::shade() {
   taskqueue::deferred::duration offset{2000ms};
 
   if (!m_opts.shaded && m_opts.shade_size.h != m_opts.size.h) {
@@ -895,6 +913,7 @@ bool bar::on(const signals::ui::shade_window&) {
   if (m_opts.origin == edge::BOTTOM) {
     m_opts.shade_pos.y = m_opts.pos.y + m_opts.size.h - m_opts.shade_size.h;
   }
+  publish_settings();
 
   double distance{static_cast<double>(m_connection.get_geometry(m_opts.window)->height - m_opts.shade_size.h)};
   double steptime{25.0 / 2.0};
@@ -904,25 +923,25 @@ bool bar::on(const signals::ui::shade_window&) {
       "window-shade", 25ms,
       [&](size_t remaining) {
         if (m_opts.shaded) {
-          m_sig.emit(signals::ui::tick{});
+          shade_step();
         }
         if (!remaining) {
           m_renderer->flush();
         }
         if (!m_opts.dimmed) {
-          m_opts.dimmed = true;
-          m_sig.emit(dim_window{double{m_opts.dimvalue}});
+          dim(m_opts.dimvalue);
         }
       },
       move(offset), 10U);
-
-  return true;
 }
 
-bool bar::on(const signals::ui::tick&) {
+/**
+ * Move the window one step closer to its shaded or unshaded geometry
+ */
+void bar::shade_step() {
   auto geom = m_connection.get_geometry(m_opts.window);
   if (geom->y == m_opts.shade_pos.y && geom->height == m_opts.shade_size.h) {
-    return false;
+    return;
   }
 
   unsigned int mask{0};
@@ -949,23 +968,29 @@ bool bar::on(const signals::ui::tick&) {
 
   m_connection.configure_window(m_opts.window, mask, values);
   m_connection.flush();
-
-  return false;
 }
 
-bool bar::on(const signals::ui::dim_window& sig) {
-  m_opts.dimmed = sig.cast() != 1.0;
-  ewmh_util::set_wm_window_opacity(m_opts.window, sig.cast() * 0xFFFFFFFF);
-  return false;
+/**
+ * Set the opacity of the window and of the tray docked to it
+ */
+void bar::dim(double value) {
+  m_opts.dimmed = value != 1.0;
+  ewmh_util::set_wm_window_opacity(m_opts.window, value * 0xFFFFFFFF);
+
+  if (hosts_tray()) {
+    m_sig.emit(dim_window{double{value}});
+  }
 }
 
 #if WITH_XCURSOR
-bool bar::on(const signals::ui::cursor_change& sig) {
-  if (!cursor_util::set_cursor(m_connection, m_connection.screen(), m_opts.window, sig.cast())) {
+/**
+ * Set the cursor shown above the window
+ */
+void bar::change_cursor(const string& cursor) {
+  if (!cursor_util::set_cursor(m_connection, m_connection.screen(), m_opts.window, cursor)) {
     m_log.warn("Failed to create cursor context");
   }
   m_connection.flush();
-  return false;
 }
 #endif
 
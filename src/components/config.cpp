@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <climits>
 #include <fstream>
+#include <set>
 
 #include "cairo/utils.hpp"
 #include "components/config.hpp"
@@ -33,6 +35,8 @@ string config::section() const {
 
 void config::use_xrm() {
 #if WITH_XRM
+  std::unique_lock<std::shared_timed_mutex> guard(m_sectionlock);
+
   /*
    * Initialize the xresource manager if there are any xrdb refs
    * present in the configuration
@@ -44,12 +48,115 @@ void config::use_xrm() {
 #endif
 }
 
+/**
+ * Replace all sections
+ *
+ * Inherited parameters are copied into the new sections before they
+ * are swapped in, so that sections which fail to validate leave the
+ * current ones untouched
+ */
 void config::set_sections(sectionmap_t sections) {
-  m_sections = move(sections);
-  copy_inherited();
+  config staged{m_log, string{m_file}, string{m_barname}};
+  staged.m_sections = move(sections);
+  // References in inherit values are looked up through the index
+  staged.build_index();
+  staged.copy_inherited();
+
+  std::unique_lock<std::shared_timed_mutex> guard(m_sectionlock);
+  m_sections = move(staged.m_sections);
+  build_index();
+}
+
+/**
+ * Set parameter value
+ */
+void config::set(const string& section, const string& key, string&& value) {
+  std::unique_lock<std::shared_timed_mutex> guard(m_sectionlock);
+
+  m_sections[section][key] = value;
+
+  size_t id{find(section, key)};
+  if (id != npos) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_entries[id].raw = move(value);
+    invalidate(id);
+    return;
+  }
+
+  // A new parameter might satisfy references that used their fallback
+  // value so far, which aren't tracked as dependencies
+  build_index();
+}
+
+/**
+ * Dereference all parameters up front
+ *
+ * Each value is resolved once, references to values that are already
+ * resolved are taken from the cache. Invalid references are left for
+ * `get()` to report once the parameter is actually used, and values
+ * read from files are only read once they are asked for
+ */
+void config::resolve_all() const {
+  std::shared_lock<std::shared_timed_mutex> guard(m_sectionlock);
+
+  size_t count{0};
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    count = m_entries.size();
+  }
+
+  for (size_t id = 0; id < count; id++) {
+    if (reads_file(id)) {
+      continue;
+    }
+
+    try {
+      size_t generation{0};
+      bool cacheable{true};
+      resolve(id, cacheable, generation);
+    } catch (const application_error& err) {
+      m_log.trace("config: Deferring reference error (%s)", err.what());
+    }
+  }
+}
+
+/**
+ * Check if the section is defined
+ */
+bool config::has_section(const string& section) const {
+  std::shared_lock<std::shared_timed_mutex> guard(m_sectionlock);
+  return m_sections.find(section) != m_sections.end();
+}
+
+/**
+ * Get the dereferenced values of all parameters in the section
+ *
+ * Values with invalid references are returned as they are written
+ */
+valuemap_t config::get_section(const string& section) const {
+  std::shared_lock<std::shared_timed_mutex> guard(m_sectionlock);
+
+  valuemap_t values;
+  auto it = m_sections.find(section);
+  if (it == m_sections.end()) {
+    return values;
+  }
+
+  for (auto&& param : it->second) {
+    try {
+      size_t generation{0};
+      bool cacheable{true};
+      values.emplace(param.first, resolve(find(section, param.first), cacheable, generation));
+    } catch (const application_error& err) {
+      values.emplace(param.first, param.second);
+    }
+  }
+
+  return values;
 }
 
 void config::set_included(file_list included) {
+  std::unique_lock<std::shared_timed_mutex> guard(m_sectionlock);
   m_included = move(included);
 }
 
@@ -78,7 +185,8 @@ void config::copy_inherited() {
       if (param.first == "inherit") {
         // Get name of base section
         auto inherit = param.second;
-        if ((inherit = dereference<string>(section.first, param.first, inherit, inherit)).empty()) {
+        bool cacheable{true};
+        if ((inherit = dereference(section.first, param.first, inherit, cacheable, npos)).empty()) {
           throw value_error("Invalid section \"\" defined for \"" + section.first + ".inherit\"");
         }
 
@@ -102,6 +210,416 @@ void config::copy_inherited() {
   }
 }
 
+/**
+ * Intern all section and parameter names and (re)create the entries
+ */
+void config::build_index() {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  m_slots.clear();
+  m_entries.clear();
+
+  for (auto&& section : m_sections) {
+    auto sid = m_section_ids.emplace(section.first, m_section_names.size());
+    if (sid.second) {
+      m_section_names.emplace_back(section.first);
+    }
+
+    for (auto&& param : section.second) {
+      auto kid = m_key_ids.emplace(param.first, m_key_names.size());
+      if (kid.second) {
+        m_key_names.emplace_back(param.first);
+      }
+
+      entry e{};
+      e.section = sid.first->second;
+      e.key = kid.first->second;
+      e.raw = param.second;
+
+      m_slots.emplace(static_cast<uint64_t>(e.section) << 32 | e.key, m_entries.size());
+      m_entries.emplace_back(move(e));
+    }
+  }
+}
+
+/**
+ * Get the entry of the given parameter, or npos if it isn't defined
+ */
+size_t config::find(const string& section, const string& key) const {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  auto sid = m_section_ids.find(section);
+  auto kid = m_key_ids.find(key);
+  if (sid == m_section_ids.end() || kid == m_key_ids.end()) {
+    return npos;
+  }
+
+  auto slot = m_slots.find(static_cast<uint64_t>(sid->second) << 32 | kid->second);
+  return slot != m_slots.end() ? slot->second : npos;
+}
+
+/**
+ * Drop the cached values of the entry and of all entries that
+ * reference it, expects the lock to be held
+ */
+void config::invalidate(size_t id) {
+  auto& e = m_entries[id];
+  auto dependents = move(e.dependents);
+
+  e.resolved = false;
+  e.value.clear();
+  e.values.clear();
+  e.dependents.clear();
+  e.generation++;
+
+  for (auto&& dependent : dependents) {
+    invalidate(dependent);
+  }
+}
+
+/**
+ * Get the dereferenced value of the entry
+ *
+ * `cacheable` is cleared if the value depends on the contents of a
+ * file, which are read again on every lookup
+ */
+string config::resolve(size_t id, bool& cacheable, size_t& generation) const {
+  string section;
+  string key;
+  string raw;
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    const auto& e = m_entries[id];
+    generation = e.generation;
+    if (e.resolved) {
+      return e.value;
+    }
+    section = m_section_names[e.section];
+    key = m_key_names[e.key];
+    raw = e.raw;
+  }
+
+  bool constant{true};
+  string value{dereference(section, key, raw, constant, id)};
+
+  if (constant) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto& e = m_entries[id];
+    if (e.generation == generation) {
+      e.resolved = true;
+      e.value = value;
+    }
+  }
+
+  cacheable = cacheable && constant;
+  return value;
+}
+
+/**
+ * Check if the value of the entry comes from a file, either directly
+ * or through local references, without dereferencing anything
+ */
+bool config::reads_file(size_t id) const {
+  // Bounds reference cycles, which are reported by `get()`
+  for (size_t depth = 0; id != npos && depth < 32; depth++) {
+    string section;
+    string raw;
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      section = m_section_names[m_entries[id].section];
+      raw = m_entries[id].raw;
+    }
+
+    if (raw.compare(0, 2, "${") != 0 || raw.back() != '}') {
+      return false;
+    }
+
+    auto path = raw.substr(2, raw.length() - 3);
+    if (path.compare(0, 5, "file:") == 0) {
+      return true;
+    }
+
+    size_t pos{path.find('.')};
+    if (pos == string::npos || path.find(':') < pos) {
+      return false;
+    }
+    id = find(local_section(path.substr(0, pos), section), path.substr(pos + 1));
+  }
+  return false;
+}
+
+/**
+ * Get the keys of the bar section that parameters of the section refer
+ * to with ${root.key}, directly or through other local references
+ *
+ * Those are always looked up in the section of the first bar
+ */
+vector<string> config::root_references(const string& section) const {
+  std::shared_lock<std::shared_timed_mutex> guard(m_sectionlock);
+
+  vector<string> keys;
+  vector<size_t> pending;
+  std::set<size_t> visited;
+
+  auto it = m_sections.find(section);
+  if (it == m_sections.end()) {
+    return keys;
+  }
+  for (auto&& param : it->second) {
+    pending.emplace_back(find(section, param.first));
+  }
+
+  while (!pending.empty()) {
+    size_t id{pending.back()};
+    pending.pop_back();
+    if (id == npos || !visited.emplace(id).second) {
+      continue;
+    }
+
+    string current;
+    string raw;
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      current = m_section_names[m_entries[id].section];
+      raw = m_entries[id].raw;
+    }
+
+    if (raw.compare(0, 2, "${") != 0 || raw.back() != '}') {
+      continue;
+    }
+
+    auto path = raw.substr(2, raw.length() - 3);
+    size_t pos{path.find('.')};
+    if (pos == string::npos || path.find(':') < pos) {
+      continue;
+    }
+
+    string target{path.substr(0, pos)};
+    string key{path.substr(pos + 1)};
+    if (target == "root" || target == "BAR") {
+      keys.emplace_back(key);
+    }
+    pending.emplace_back(find(local_section(move(target), current), key));
+  }
+
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  return keys;
+}
+
+/**
+ * Get the section named by a local reference
+ */
+string config::local_section(string section, const string& current_section) const {
+  section = string_util::replace(section, "BAR", this->section(), 0, 3);
+  section = string_util::replace(section, "root", this->section(), 0, 4);
+  return string_util::replace(section, "self", current_section, 0, 4);
+}
+
+/**
+ * Dereference value reference
+ */
+string config::dereference(
+    const string& section, const string& key, const string& var, bool& cacheable, size_t id) const {
+  if (var.empty() || var.compare(0, 2, "${") != 0 || var.back() != '}') {
+    return var;
+  }
+
+  auto path = var.substr(2, var.length() - 3);
+  size_t pos;
+
+  if (path.compare(0, 4, "env:") == 0) {
+    return dereference_env(path.substr(4));
+  } else if (path.compare(0, 5, "xrdb:") == 0) {
+    return dereference_xrdb(path.substr(5));
+  } else if (path.compare(0, 5, "file:") == 0) {
+    cacheable = false;
+    return dereference_file(path.substr(5));
+  } else if ((pos = path.find(".")) != string::npos) {
+    return dereference_local(path.substr(0, pos), path.substr(pos + 1), section, cacheable, id);
+  } else {
+    throw value_error("Invalid reference defined at \"" + section + "." + key + "\"");
+  }
+}
+
+/**
+ * Dereference local value reference defined using:
+ *  ${root.key}
+ *  ${root.key:fallback}
+ *  ${self.key}
+ *  ${self.key:fallback}
+ *  ${section.key}
+ *  ${section.key:fallback}
+ *
+ * The referencing entry is registered as a dependent of the target
+ */
+string config::dereference_local(
+    string section, const string& key, const string& current_section, bool& cacheable, size_t dependent) const {
+  if (section == "BAR") {
+    m_log.warn("${BAR.key} is deprecated. Use ${root.key} instead");
+  }
+
+  section = local_section(move(section), current_section);
+
+  size_t target{find(section, key)};
+
+  if (target != npos) {
+    size_t generation{0};
+    string value{resolve(target, cacheable, generation)};
+
+    if (dependent != npos) {
+      std::lock_guard<std::mutex> guard(m_lock);
+      auto& dependents = m_entries[target].dependents;
+      if (std::find(dependents.begin(), dependents.end(), dependent) == dependents.end()) {
+        dependents.emplace_back(dependent);
+      }
+    }
+    return value;
+  }
+
+  size_t pos;
+  if ((pos = key.find(':')) != string::npos) {
+    string fallback = key.substr(pos + 1);
+    m_log.info("The reference ${%s.%s} does not exist, using defined fallback value \"%s\"", section,
+        key.substr(0, pos), fallback);
+    return fallback;
+  }
+  throw value_error("The reference ${" + section + "." + key + "} does not exist (no fallback set)");
+}
+
+/**
+ * Dereference environment variable reference defined using:
+ *  ${env:key}
+ *  ${env:key:fallback value}
+ */
+string config::dereference_env(string var) const {
+  size_t pos;
+  string env_default;
+  /*
+   * This is needed because with only the string we cannot distinguish
+   * between an empty string as default and not default
+   */
+  bool has_default = false;
+
+  if ((pos = var.find(':')) != string::npos) {
+    env_default = var.substr(pos + 1);
+    has_default = true;
+    var.erase(pos);
+  }
+
+  if (env_util::has(var)) {
+    string env_value{env_util::get(var)};
+    m_log.info("Environment var reference ${%s} found (value=%s)", var, env_value);
+    return env_value;
+  } else if (has_default) {
+    m_log.info("Environment var ${%s} is undefined, using defined fallback value \"%s\"", var, env_default);
+    return env_default;
+  } else {
+    throw value_error(sstream() << "Environment var ${" << var << "} does not exist (no fallback set)");
+  }
+}
+
+/**
+ * Dereference X resource db value defined using:
+ *  ${xrdb:key}
+ *  ${xrdb:key:fallback value}
+ */
+string config::dereference_xrdb(string var) const {
+  size_t pos;
+#if not WITH_XRM
+  m_log.warn("No built-in support to dereference ${xrdb:%s} references (requires `xcb-util-xrm`)", var);
+  if ((pos = var.find(':')) != string::npos) {
+    return var.substr(pos + 1);
+  }
+  return "";
+#else
+  if (!m_xrm) {
+    throw application_error("xrm is not initialized");
+  }
+
+  string fallback;
+  bool has_fallback = false;
+  if ((pos = var.find(':')) != string::npos) {
+    fallback = var.substr(pos + 1);
+    has_fallback = true;
+    var.erase(pos);
+  }
+
+  try {
+    auto value = m_xrm->require<string>(var.c_str());
+    m_log.info("Found matching X resource \"%s\" (value=%s)", var, value);
+    return value;
+  } catch (const xresource_error& err) {
+    if (has_fallback) {
+      m_log.info("%s, using defined fallback value \"%s\"", err.what(), fallback);
+      return fallback;
+    }
+    throw value_error(sstream() << err.what() << " (no fallback set)");
+  }
+#endif
+}
+
+/**
+ * Dereference file reference by reading its contents
+ *  ${file:/absolute/file/path}
+ *  ${file:/absolute/file/path:fallback value}
+ */
+string config::dereference_file(string var) const {
+  size_t pos;
+  string fallback;
+  bool has_fallback = false;
+  if ((pos = var.find(':')) != string::npos) {
+    fallback = var.substr(pos + 1);
+    has_fallback = true;
+    var.erase(pos);
+  }
+  var = file_util::expand(var);
+
+  if (file_util::exists(var)) {
+    m_log.info("File reference \"%s\" found", var);
+    return string_util::trim(file_util::contents(var), '\n');
+  } else if (has_fallback) {
+    m_log.info("File reference \"%s\" not found, using defined fallback value \"%s\"", var, fallback);
+    return fallback;
+  } else {
+    throw value_error(sstream() << "The file \"" << var << "\" does not exist (no fallback set)");
+  }
+}
+
+/**
+ * Take the values of the given bar and module sections and of [settings]
+ */
+config_snapshot::config_snapshot(const config& conf, const vector<string>& bars, const vector<string>& modules)
+    : m_settings(conf.get_section("settings")) {
+  for (auto&& bar : bars) {
+    m_bars.emplace_back(conf.get_section(bar));
+    for (auto&& key : {"modules-left", "modules-center", "modules-right"}) {
+      m_bars.back().erase(key);
+    }
+  }
+  for (auto&& module : modules) {
+    m_modules.emplace(module, conf.get_section(module));
+  }
+}
+
+/**
+ * Check if the bars and the global settings are the same
+ */
+bool config_snapshot::bars_equal(const config_snapshot& other) const {
+  return m_bars == other.m_bars && m_settings == other.m_settings;
+}
+
+/**
+ * Check if the section of the module is the same, a module missing
+ * from either snapshot is never equal
+ */
+bool config_snapshot::module_equal(const config_snapshot& other, const string& name) const {
+  auto it = m_modules.find(name);
+  auto other_it = other.m_modules.find(name);
+  return it != m_modules.end() && other_it != other.m_modules.end() && !it->second.empty() &&
+         it->second == other_it->second;
+}
+
 template <>
 string config::convert(string&& value) const {
   return forward<string>(value);
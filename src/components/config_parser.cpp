@@ -1,12 +1,79 @@
-#include <algorithm>
-#include <fstream>
-
 #include "components/config_parser.hpp"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
 POLYBAR_NS
 
+namespace {
+  bool is_space(char c) {
+    return isspace(static_cast<unsigned char>(c));
+  }
+
+  void trim(const char*& begin, const char*& end) {
+    while (begin < end && is_space(*begin)) {
+      begin++;
+    }
+    while (end > begin && is_space(*(end - 1))) {
+      end--;
+    }
+  }
+
+  bool equals(const char* str, size_t len, const char* literal) {
+    return len == strlen(literal) && memcmp(str, literal, len) == 0;
+  }
+}  // namespace
+
+config_parser::source::source(const string& file) {
+  int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (fd == -1) {
+    throw application_error("Failed to open config file " + file + ": " + strerror(errno));
+  }
+
+  // The size is only a hint, the file may change while it is read
+  struct stat st {};
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    m_buffer.reserve(st.st_size + 1);
+  }
+
+  char buf[4096];
+  ssize_t bytes;
+  while ((bytes = read(fd, buf, sizeof(buf))) != 0) {
+    if (bytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      int err = errno;
+      close(fd);
+      throw application_error("Failed to read config file " + file + ": " + strerror(err));
+    }
+    m_buffer.append(buf, bytes);
+  }
+
+  close(fd);
+}
+
+const char* config_parser::source::data() const {
+  return m_buffer.data();
+}
+
+size_t config_parser::source::size() const {
+  return m_buffer.size();
+}
+
 config_parser::config_parser(const logger& logger, string&& file, string&& bar)
-    : m_log(logger), m_config(file_util::expand(file)), m_barname(move(bar)) {}
+    : m_log(logger), m_config(file_util::expand(file)), m_barname(move(bar)) {
+  for (size_t c = 0; c < m_name_chars.size(); c++) {
+    m_name_chars[c] = !isspace(c) && m_forbidden_chars.find(static_cast<char>(c)) == string::npos;
+  }
+}
+
+config_parser::~config_parser() = default;
 
 config::make_type config_parser::parse() {
   m_log.notice("Parsing config file: %s", m_config);
@@ -30,11 +97,13 @@ config::make_type config_parser::parse() {
   // Cast to non-const to set sections, included and xrm
   config& m_conf = const_cast<config&>(result);
 
-  m_conf.set_sections(move(sections));
-  m_conf.set_included(move(included));
+  // Set up first, so that no xrdb reference is looked up without it
   if (use_xrm) {
     m_conf.use_xrm();
   }
+  m_conf.set_sections(move(sections));
+  m_conf.set_included(move(included));
+  m_conf.resolve_all();
 
   return result;
 }
@@ -43,30 +112,34 @@ sectionmap_t config_parser::create_sectionmap() {
   sectionmap_t sections{};
 
   string current_section{};
+  valuemap_t* valuemap{nullptr};
 
-  for (const line_t& line : m_lines) {
-    if (!line.useful) {
-      continue;
-    }
+  for (size_t i = 0; i < m_lines.size(); i++) {
+    const token& line = *m_lines[i];
 
     if (line.is_header) {
-      current_section = line.header;
+      current_section.assign(line.key, line.key_len);
+      valuemap = &sections[current_section];
+
+      // Size the section for all the keys up to the next header at once
+      size_t keys{0};
+      for (size_t j = i + 1; j < m_lines.size() && !m_lines[j]->is_header; j++) {
+        keys++;
+      }
+      valuemap->reserve(valuemap->size() + keys);
     } else {
       // The first valid line in the config is not a section definition
-      if (current_section.empty()) {
+      if (valuemap == nullptr) {
         throw syntax_error("First valid line in config must be section header", m_files[line.file_index], line.line_no);
       }
 
-      const string& key = line.key;
-      const string& value = line.value;
-
-      valuemap_t& valuemap = sections[current_section];
+      auto inserted = valuemap->emplace(std::piecewise_construct, std::forward_as_tuple(line.key, line.key_len),
+          std::forward_as_tuple(line.value, line.value_len));
 
-      if (valuemap.find(key) == valuemap.end()) {
-        valuemap.emplace(key, value);
-      } else {
+      if (!inserted.second) {
         // Key already exists in this section
-        throw syntax_error("Duplicate key name \"" + key + "\" defined in section \"" + current_section + "\"",
+        throw syntax_error("Duplicate key name \"" + inserted.first->first + "\" defined in section \"" +
+                               current_section + "\"",
             m_files[line.file_index], line.line_no);
       }
     }
@@ -103,53 +176,122 @@ void config_parser::parse_file(const string& file, file_list path) {
      * `file` is already in the `files` vector so we calculate its index.
      *
      * This means that the file was already parsed, this can happen without
-     * cyclic dependencies, if the file is included twice
+     * cyclic dependencies, if the file is included twice. Its tokens are
+     * reused in that case
      */
     file_index = found - m_files.begin();
   }
 
   path.push_back(file);
 
-  int line_no = 0;
-
-  string line_str{};
+  if (m_sources.size() <= static_cast<size_t>(file_index)) {
+    m_sources.resize(file_index + 1);
+  }
 
-  std::ifstream in(file);
+  if (!m_sources[file_index]) {
+    m_sources[file_index] = make_unique<source>(file);
+    tokenize(*m_sources[file_index], file_index);
+  }
 
-  if (!in) {
-    throw application_error("Failed to open config file " + file + ": " + strerror(errno));
+  for (const token& line : m_sources[file_index]->tokens) {
+    if (!line.is_header && equals(line.key, line.key_len, "include-file")) {
+      parse_file(file_util::expand(string(line.value, line.value_len)), path);
+    } else {
+      m_lines.push_back(&line);
+    }
   }
+}
 
-  while (std::getline(in, line_str)) {
-    line_no++;
-    line_t line;
-    try {
-      line = parse_line(line_str);
-
-      // parse_line doesn't set these
-      line.file_index = file_index;
-      line.line_no = line_no;
-    } catch (syntax_error& err) {
-      /*
-       * Exceptions thrown by parse_line doesn't have the line
-       * numbers and files set, so we have to add them here
-       */
-      throw syntax_error(err.get_msg(), m_files[file_index], line_no);
+void config_parser::tokenize(source& src, int file_index) {
+  const char* pos = src.data();
+  const char* end = pos + src.size();
+  int line_no = 0;
+
+  while (pos < end) {
+    const char* eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    if (eol == nullptr) {
+      eol = end;
     }
 
+    line_no++;
+
+    const char* begin = pos;
+    const char* last = eol;
+    pos = eol < end ? eol + 1 : end;
+
+    trim(begin, last);
+
     // Skip useless lines (comments, empty lines)
-    if (!line.useful) {
+    if (begin == last || *begin == ';' || *begin == '#') {
       continue;
     }
 
-    if (!line.is_header && line.key == "include-file") {
-      parse_file(file_util::expand(line.value), path);
+    token line{file_index, line_no, false, nullptr, 0, nullptr, 0};
+
+    if (*begin == '[') {
+      const char* name = begin + 1;
+      size_t len = last - begin - 2;
+
+      if (last - begin < 2 || *(last - 1) != ']' || !is_valid_name(name, len) || is_reserved_name(name, len)) {
+        invalid_line(file_index, line_no, begin, last);
+      }
+
+      line.is_header = true;
+      line.key = name;
+      line.key_len = len;
     } else {
-      m_lines.push_back(line);
+      const char* eq = static_cast<const char*>(memchr(begin, '=', last - begin));
+      if (eq == nullptr) {
+        invalid_line(file_index, line_no, begin, last);
+      }
+
+      const char* key_end = eq;
+      const char* value = eq + 1;
+      const char* value_end = last;
+      trim(begin, key_end);
+      trim(value, value_end);
+
+      if (!is_valid_name(begin, key_end - begin)) {
+        invalid_line(file_index, line_no, begin, last);
+      }
+
+      // Only if the value is surrounded with double quotes are they removed
+      if (value_end - value >= 2 && *value == '"' && *(value_end - 1) == '"') {
+        value++;
+        value_end--;
+      }
+
+#if WITH_XRM
+      // Use xrm, if at least one value is an xrdb reference
+      if (!use_xrm && value_end - value >= 6 && memcmp(value, "${xrdb", 6) == 0) {
+        use_xrm = true;
+      }
+#endif
+
+      line.key = begin;
+      line.key_len = key_end - begin;
+      line.value = value;
+      line.value_len = value_end - value;
     }
+
+    src.tokens.push_back(line);
   }
 }
 
+void config_parser::invalid_line(int file_index, int line_no, const char* begin, const char* end) {
+  try {
+    parse_line(string(begin, end));
+  } catch (syntax_error& err) {
+    /*
+     * Exceptions thrown by parse_line doesn't have the line
+     * numbers and files set, so we have to add them here
+     */
+    throw syntax_error(err.get_msg(), m_files[file_index], line_no);
+  }
+
+  throw syntax_error("Malformed line", m_files[file_index], line_no);
+}
+
 line_t config_parser::parse_line(const string& line) {
   string line_trimmed = string_util::trim(line, isspace);
   line_type type = get_line_type(line_trimmed);
@@ -252,13 +394,17 @@ std::pair<string, string> config_parser::parse_key(const string& line) {
 }
 
 bool config_parser::is_valid_name(const string& name) {
-  if (name.empty()) {
+  return is_valid_name(name.data(), name.size());
+}
+
+bool config_parser::is_valid_name(const char* name, size_t len) const {
+  if (len == 0) {
     return false;
   }
 
-  for (const char c : name) {
+  for (size_t i = 0; i < len; i++) {
     // Names with forbidden chars or spaces are not valid
-    if (isspace(c) || m_forbidden_chars.find_first_of(c) != string::npos) {
+    if (!m_name_chars[static_cast<unsigned char>(name[i])]) {
       return false;
     }
   }
@@ -266,4 +412,14 @@ bool config_parser::is_valid_name(const string& name) {
   return true;
 }
 
+bool config_parser::is_reserved_name(const char* name, size_t len) const {
+  for (const auto& reserved : m_reserved_section_names) {
+    if (reserved.size() == len && reserved.compare(0, len, name, len) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 POLYBAR_NS_END
@@ -5,8 +5,13 @@
 #include "components/bar.hpp"
 #include "components/builder.hpp"
 #include "components/config.hpp"
+#include "components/config_parser.hpp"
+#include "components/eventloop.hpp"
+#include "components/frame_scheduler.hpp"
 #include "components/ipc.hpp"
 #include "components/logger.hpp"
+#include "components/parser.hpp"
+#include "components/script_executor.hpp"
 #include "components/types.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
@@ -15,6 +20,7 @@
 #include "utils/command.hpp"
 #include "utils/factory.hpp"
 #include "utils/inotify.hpp"
+#include "utils/io.hpp"
 #include "utils/string.hpp"
 #include "utils/time.hpp"
 #include "x11/connection.hpp"
@@ -41,27 +47,54 @@ void interrupt_handler(int signum) {
 /**
  * Build controller instance
  */
-controller::make_type controller::make(unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch) {
-  return factory_util::unique<controller>(connection::make(), signal_emitter::make(), logger::make(), config::make(),
-      bar::make(), forward<decltype(ipc)>(ipc), forward<decltype(config_watch)>(config_watch));
+controller::make_type controller::make(
+    const vector<string>& bars, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch) {
+  vector<unique_ptr<bar>> instances;
+  for (auto&& section : bars) {
+    instances.emplace_back(bar::make(section));
+  }
+
+  return factory_util::unique<controller>(connection::make(), signal_emitter::make(), eventloop::make(), logger::make(),
+      config::make(), move(instances), parser::make(), forward<decltype(ipc)>(ipc),
+      forward<decltype(config_watch)>(config_watch));
 }
 
 /**
  * Construct controller
+ *
+ * All bars share the connection, the event loop and the module
+ * instances that produce the same output for them
  */
-controller::controller(connection& conn, signal_emitter& emitter, const logger& logger, const config& config,
-    unique_ptr<bar>&& bar, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& confwatch)
+controller::controller(connection& conn, signal_emitter& emitter, eventloop& loop, const logger& logger,
+    const config& config, vector<unique_ptr<bar>>&& bars, unique_ptr<parser>&& parser, unique_ptr<ipc>&& ipc,
+    unique_ptr<inotify_watch>&& confwatch)
     : m_connection(conn)
     , m_sig(emitter)
+    , m_loop(loop)
     , m_log(logger)
     , m_conf(config)
-    , m_bar(forward<decltype(bar)>(bar))
+    , m_parser(forward<decltype(parser)>(parser))
     , m_ipc(forward<decltype(ipc)>(ipc))
     , m_confwatch(forward<decltype(confwatch)>(confwatch)) {
   m_swallow_input = m_conf.get("settings", "throttle-input-for", m_swallow_input);
-  m_swallow_limit = m_conf.deprecated("settings", "eventqueue-swallow", "throttle-output", m_swallow_limit);
   m_swallow_update = m_conf.deprecated("settings", "eventqueue-swallow-time", "throttle-output-for", m_swallow_update);
 
+  // The number of updates to swallow is replaced by the frame rate cap
+  m_conf.warn_deprecated("settings", "throttle-output", "max-fps");
+  m_conf.warn_deprecated("settings", "eventqueue-swallow", "max-fps");
+
+  // Keep the previous throttling behaviour unless a frame rate is given
+  double max_fps{m_swallow_update.count() > 0 ? 1000.0 / m_swallow_update.count() : 0.0};
+  m_frames = make_unique<frame_scheduler>(m_conf.get("settings", "max-fps", max_fps));
+
+  // In reactor mode the modules hand their timers and fds to the
+  // event loop instead of running in a thread of their own
+  m_loop.enable(m_conf.get("settings", "reactor", false));
+  eventloop::make_reactor().enable(m_loop.enabled());
+
+  // Number of script module commands that may run at the same time
+  script_executor::make().set_limit(m_conf.get<size_t>("settings", "script-concurrency", 8));
+
   if (pipe(g_eventpipe.data()) == 0) {
     m_queuefd[PIPE_READ] = make_unique<file_descriptor>(g_eventpipe[PIPE_READ]);
     m_queuefd[PIPE_WRITE] = make_unique<file_descriptor>(g_eventpipe[PIPE_WRITE]);
@@ -79,11 +112,19 @@ controller::controller(connection& conn, signal_emitter& emitter, const logger&
   sigaction(SIGUSR1, &act, nullptr);
   sigaction(SIGALRM, &act, nullptr);
 
+  for (auto&& instance : bars) {
+    m_bars.emplace_back();
+    m_bars.back().instance = move(instance);
+  }
+
   m_log.trace("controller: Setup user-defined modules");
+  std::map<string, module_t> reusable;
   size_t created_modules{0};
-  created_modules += setup_modules(alignment::LEFT);
-  created_modules += setup_modules(alignment::CENTER);
-  created_modules += setup_modules(alignment::RIGHT);
+  for (auto&& state : m_bars) {
+    created_modules += setup_modules(state, alignment::LEFT, reusable);
+    created_modules += setup_modules(state, alignment::CENTER, reusable);
+    created_modules += setup_modules(state, alignment::RIGHT, reusable);
+  }
 
   if (!created_modules) {
     throw application_error("No modules created");
@@ -139,23 +180,8 @@ bool controller::run(bool writeback, string snapshot_dst) {
 
   size_t started_modules{0};
   for (const auto& module : m_modules) {
-    auto inp_handler = dynamic_cast<input_handler*>(&*module);
-    auto evt_handler = dynamic_cast<event_handler_interface*>(&*module);
-
-    if (inp_handler != nullptr) {
-      m_inputhandlers.emplace_back(inp_handler);
-    }
-
-    if (evt_handler != nullptr) {
-      evt_handler->connect(m_connection);
-    }
-
-    try {
-      m_log.info("Starting %s", module->name());
-      module->start();
+    if (start_module(module)) {
       started_modules++;
-    } catch (const application_error& err) {
-      m_log.err("Failed to start '%s' (reason: %s)", module->name(), err.what());
     }
   }
 
@@ -166,8 +192,29 @@ bool controller::run(bool writeback, string snapshot_dst) {
   m_connection.flush();
   m_event_thread = thread(&controller::process_eventqueue, this);
 
+  // Module updates run next to the X events instead of between them
+  eventloop& reactor{eventloop::make_reactor()};
+  if (reactor.enabled()) {
+    m_reactor_running = true;
+    m_reactor_thread = thread([&] {
+      while (m_reactor_running) {
+        try {
+          reactor.dispatch(100);
+        } catch (const system_error& err) {
+          m_log.err("Failed to poll in module event loop: %s", err.what());
+          break;
+        }
+      }
+    });
+  }
+
   read_events();
 
+  if (m_reactor_thread.joinable()) {
+    m_reactor_running = false;
+    m_reactor_thread.join();
+  }
+
   if (m_event_thread.joinable()) {
     enqueue(make_quit_evt(static_cast<bool>(g_reload)));
     m_event_thread.join();
@@ -216,105 +263,96 @@ bool controller::enqueue(string&& input_data) {
 void controller::read_events() {
   m_log.info("Entering event loop (thread-id=%lu)", this_thread::get_id());
 
-  int fd_connection{-1};
+  int fd_queue{*m_queuefd[PIPE_READ]};
+  int fd_connection{m_connection.get_file_descriptor()};
   int fd_confwatch{-1};
-  int fd_ipc{-1};
 
-  vector<int> fds;
-  fds.emplace_back(*m_queuefd[PIPE_READ]);
-  fds.emplace_back((fd_connection = m_connection.get_file_descriptor()));
+  // Process event on the internal fd. The pipe only serves as a wakeup
+  // source so it is safe to drain it edge-triggered
+  io_util::set_nonblock(fd_queue);
+  m_loop.add(fd_queue,
+      [&] {
+        char buffer[BUFSIZ];
+        ssize_t bytes_read{0};
+        while ((bytes_read = read(fd_queue, &buffer, BUFSIZ)) > 0) {
+        }
+        if (bytes_read == -1 && errno != EAGAIN) {
+          m_log.err("Failed to read from eventpipe (err: %s)", strerror(errno));
+        }
+      },
+      EPOLLIN | EPOLLET);
+
+  // Process event on the xcb connection fd
+  m_loop.add(fd_connection, [&] {
+    if (m_connection.connection_has_error()) {
+      return;
+    }
+    shared_ptr<xcb_generic_event_t> evt{};
+    while ((evt = shared_ptr<xcb_generic_event_t>(xcb_poll_for_event(m_connection), free)) != nullptr) {
+      try {
+        m_connection.dispatch_event(evt);
+      } catch (xpp::connection_error& err) {
+        m_log.err("X connection error, terminating... (what: %s)", m_connection.error_str(err.code()));
+      } catch (const exception& err) {
+        m_log.err("Error in X event loop: %s", err.what());
+      }
+    }
+  });
+
+  // Process event on the config inotify watch fd
+  function<void()> on_confwatch = [&] {
+    unique_ptr<inotify_event> confevent{m_confwatch->await_match()};
+    if (!confevent) {
+      return;
+    }
+    if (confevent->mask & IN_IGNORED) {
+      // IN_IGNORED: file was deleted or filesystem was unmounted
+      //
+      // This happens in some configurations of vim when a file is saved,
+      // since it is not actually issuing calls to write() but rather
+      // moves a file into the original's place after moving the original
+      // file to a different location (and subsequently deleting it).
+      //
+      // We need to re-attach the watch to the new file in this case.
+      m_loop.remove(fd_confwatch);
+      m_confwatch = inotify_util::make_watch(m_confwatch->path());
+      m_confwatch->attach(IN_MODIFY | IN_IGNORED);
+      m_loop.add((fd_confwatch = m_confwatch->get_file_descriptor()), on_confwatch);
+    }
+    m_log.info("Configuration file changed");
+    reload();
+  };
 
   if (m_confwatch) {
     m_log.trace("controller: Attach config watch");
     m_confwatch->attach(IN_MODIFY | IN_IGNORED);
-    fds.emplace_back((fd_confwatch = m_confwatch->get_file_descriptor()));
+    m_loop.add((fd_confwatch = m_confwatch->get_file_descriptor()), on_confwatch);
   }
 
+  // The ipc channel and its clients are served from the loop
   if (m_ipc) {
-    fds.emplace_back((fd_ipc = m_ipc->get_file_descriptor()));
+    m_ipc->start();
   }
 
-  while (!g_terminate) {
-    fd_set readfds{};
-    FD_ZERO(&readfds);
-
-    int maxfd{0};
-    for (auto&& fd : fds) {
-      FD_SET(fd, &readfds);
-      maxfd = std::max(maxfd, fd);
-    }
-
-    // Wait until event is ready on one of the configured streams
-    int events = select(maxfd + 1, &readfds, nullptr, nullptr, nullptr);
-
-    // Check for errors
-    if (events == -1) {
-      /*
-       * The Interrupt errno is generated when polybar is stopped, so it
-       * shouldn't generate an error message
-       */
-      if (errno != EINTR) {
-        m_log.err("select failed in event loop: %s", strerror(errno));
-      }
-
-      break;
-    }
-
-    if (g_terminate || m_connection.connection_has_error()) {
+  while (!g_terminate && !m_connection.connection_has_error()) {
+    // Wait until event is ready on one of the registered streams
+    try {
+      m_loop.dispatch();
+    } catch (const system_error& err) {
+      m_log.err("Failed to poll in event loop: %s", err.what());
       break;
     }
+  }
 
-    // Process event on the internal fd
-    if (m_queuefd[PIPE_READ] && FD_ISSET(static_cast<int>(*m_queuefd[PIPE_READ]), &readfds)) {
-      char buffer[BUFSIZ];
-      if (read(static_cast<int>(*m_queuefd[PIPE_READ]), &buffer, BUFSIZ) == -1) {
-        m_log.err("Failed to read from eventpipe (err: %s)", strerror(errno));
-      }
-    }
-
-    // Process event on the config inotify watch fd
-    unique_ptr<inotify_event> confevent;
-    if (fd_confwatch > -1 && FD_ISSET(fd_confwatch, &readfds) && (confevent = m_confwatch->await_match())) {
-      if (confevent->mask & IN_IGNORED) {
-        // IN_IGNORED: file was deleted or filesystem was unmounted
-        //
-        // This happens in some configurations of vim when a file is saved,
-        // since it is not actually issuing calls to write() but rather
-        // moves a file into the original's place after moving the original
-        // file to a different location (and subsequently deleting it).
-        //
-        // We need to re-attach the watch to the new file in this case.
-        fds.erase(
-            std::remove_if(fds.begin(), fds.end(), [fd_confwatch](int fd) { return fd == fd_confwatch; }), fds.end());
-        m_confwatch = inotify_util::make_watch(m_confwatch->path());
-        m_confwatch->attach(IN_MODIFY | IN_IGNORED);
-        fds.emplace_back((fd_confwatch = m_confwatch->get_file_descriptor()));
-      }
-      m_log.info("Configuration file changed");
-      g_terminate = 1;
-      g_reload = 1;
-    }
-
-    // Process event on the xcb connection fd
-    if (fd_connection > -1 && FD_ISSET(fd_connection, &readfds)) {
-      shared_ptr<xcb_generic_event_t> evt{};
-      while ((evt = shared_ptr<xcb_generic_event_t>(xcb_poll_for_event(m_connection), free)) != nullptr) {
-        try {
-          m_connection.dispatch_event(evt);
-        } catch (xpp::connection_error& err) {
-          m_log.err("X connection error, terminating... (what: %s)", m_connection.error_str(err.code()));
-        } catch (const exception& err) {
-          m_log.err("Error in X event loop: %s", err.what());
-        }
-      }
+  // The callbacks reference this stack frame
+  for (int fd : {fd_queue, fd_connection, fd_confwatch}) {
+    if (fd > -1) {
+      m_loop.remove(fd);
     }
+  }
 
-    // Process event on the ipc fd
-    if (fd_ipc > -1 && FD_ISSET(fd_ipc, &readfds)) {
-      m_ipc->receive_message();
-      fds.erase(std::remove_if(fds.begin(), fds.end(), [fd_ipc](int fd) { return fd == fd_ipc; }), fds.end());
-      fds.emplace_back((fd_ipc = m_ipc->get_file_descriptor()));
-    }
+  if (m_ipc) {
+    m_ipc->stop();
   }
 }
 
@@ -332,7 +370,13 @@ void controller::process_eventqueue() {
 
   while (!g_terminate) {
     event evt{};
-    m_queue.wait_dequeue(evt);
+
+    // Sleep until the next event, or until the pending frame is due
+    if (!m_frames->pending()) {
+      m_queue.wait_dequeue(evt);
+    } else if (!m_queue.wait_dequeue_timed(evt, m_frames->until_due())) {
+      evt.type = event_type::NONE;
+    }
 
     if (g_terminate) {
       break;
@@ -346,42 +390,18 @@ void controller::process_eventqueue() {
       process_inputdata();
     } else if (evt.type == event_type::UPDATE && evt.flag) {
       process_update(true);
-    } else {
-      event next{};
-      size_t swallowed{0};
-      while (swallowed++ < m_swallow_limit && m_queue.wait_dequeue_timed(next, m_swallow_update)) {
-        if (next.type == event_type::QUIT) {
-          evt = next;
-          break;
-        } else if (next.type == event_type::INPUT) {
-          evt = next;
-          break;
-        } else if (evt.type != next.type) {
-          enqueue(move(next));
-          break;
-        } else {
-          m_log.trace_x("controller: Swallowing event within timeframe");
-          evt = next;
-        }
-      }
+    } else if (evt.type == event_type::CHECK) {
+      on(signals::eventqueue::check_state{});
+    } else if (evt.type != event_type::NONE && evt.type != event_type::UPDATE) {
+      m_log.warn("Unknown event type for enqueued event (%d)", evt.type);
+    }
 
-      if (evt.type == event_type::UPDATE) {
-        process_update(evt.flag);
-      } else if (evt.type == event_type::INPUT) {
-        process_inputdata();
-      } else if (evt.type == event_type::QUIT) {
-        if (evt.flag) {
-          on(signals::eventqueue::exit_reload{});
-        } else {
-          on(signals::eventqueue::exit_terminate{});
-        }
-      } else if (evt.type == event_type::CHECK) {
-        on(signals::eventqueue::check_state{});
-      } else {
-        m_log.warn("Unknown event type for enqueued event (%d)", evt.type);
-      }
+    if (m_frames->due()) {
+      process_update(false);
     }
   }
+
+  m_log.info("controller: Frame stats: %s", m_frames->report());
 }
 
 /**
@@ -393,9 +413,12 @@ void controller::process_inputdata() {
     m_lastinput = chrono::time_point_cast<decltype(m_swallow_input)>(chrono::system_clock::now());
     m_inputdata.clear();
 
-    for (auto&& handler : m_inputhandlers) {
-      if (handler->input(string{cmd})) {
-        return;
+    {
+      std::lock_guard<std::mutex> guard(m_modulelock);
+      for (auto&& handler : m_inputhandlers) {
+        if (handler->input(string{cmd})) {
+          return;
+        }
       }
     }
 
@@ -418,112 +441,430 @@ void controller::process_inputdata() {
   }
 }
 
+namespace {
+  /**
+   * Tag pairs that can be merged when a reset tag is directly
+   * followed by a tag of the same type that sets a new value
+   */
+  const array<pair<const char*, const char*>, 6> g_reset_tags{{
+      {"T-}%{T", "T"},
+      {"B-}%{B#", "B#"},
+      {"F-}%{F#", "F#"},
+      {"U-}%{U#", "U#"},
+      {"u-}%{u#", "u#"},
+      {"o-}%{o#", "o#"},
+  }};
+
+  /**
+   * Strip unnecessary reset tags and join consecutive tags
+   */
+  string compact_tags(string&& contents) {
+    for (auto&& tag : g_reset_tags) {
+      if (contents.find(tag.first) != string::npos) {
+        contents = string_util::replace_all(contents, tag.first, tag.second);
+      }
+    }
+    if (contents.find("}%{") != string::npos) {
+      contents = string_util::replace_all(contents, "}%{", " ");
+    }
+    return move(contents);
+  }
+
+  /**
+   * Append compacted contents to a compacted buffer, applying the
+   * compaction rules at the seam between the two
+   */
+  void splice_tags(string& dst, const string& src) {
+    if (!dst.empty() && dst.back() == '}' && src.compare(0, 2, "%{") == 0) {
+      for (auto&& tag : g_reset_tags) {
+        // e.g. "...F-}" + "%{F#fff}..." -> "...F#fff}..."
+        size_t n{strlen(tag.second)};
+        if (dst.size() >= 3 && dst.compare(dst.size() - 3, 3, tag.first, 3) == 0 &&
+            src.compare(2, n, tag.second) == 0) {
+          dst.erase(dst.size() - 2);
+          dst.append(src, 3, string::npos);
+          return;
+        }
+      }
+      dst.back() = ' ';
+      dst.append(src, 2, string::npos);
+    } else {
+      dst += src;
+    }
+  }
+}  // namespace
+
 /**
  * Process eventqueue update event
+ *
+ * Each module's output is compacted once when it changes and kept as a
+ * segment. Only blocks containing a changed segment are re-assembled
  */
 bool controller::process_update(bool force) {
-  const bar_settings& bar{m_bar->settings()};
-  string contents;
-  string padding_left(bar.padding.left, ' ');
-  string padding_right(bar.padding.right, ' ');
-  string margin_left(bar.module_margin.left, ' ');
-  string margin_right(bar.module_margin.right, ' ');
+  // Changes notified from here on are drawn by the next frame
+  m_frames->begin_frame();
 
-  builder build{bar};
-  build.node(bar.separator);
-  string separator{build.flush()};
+  // Module instances can be shared between bars, so each changed module is read once per frame
+  std::map<const modules::module_interface*, string> outputs;
+  vector<pair<string, render_list>> frames(m_bars.size());
+  size_t copied{0};
+  size_t rebuilt{0};
 
-  for (const auto& block : m_blocks) {
-    string block_contents;
-    bool is_left = false;
-    bool is_center = false;
-    bool is_right = false;
-    bool is_first = true;
+  std::unique_lock<std::mutex> guard(m_modulelock);
 
-    if (block.first == alignment::LEFT) {
-      is_left = true;
-    } else if (block.first == alignment::CENTER) {
-      is_center = true;
-    } else if (block.first == alignment::RIGHT) {
-      is_right = true;
+  for (auto&& module : m_modules) {
+    if (!module->running() || !module->changed()) {
+      continue;
+    }
+    try {
+      outputs.emplace(&*module, compact_tags(module->contents()));
+    } catch (const exception& err) {
+      m_log.err("Failed to get contents for \"%s\" (err: %s)", module->name(), err.what());
+      outputs.emplace(&*module, "");
     }
+  }
 
-    for (const auto& module : block.second) {
-      if (!module->running()) {
-        continue;
-      }
+  for (size_t i = 0; i < m_bars.size(); i++) {
+    assemble(m_bars[i], outputs, frames[i].first, frames[i].second, copied, rebuilt);
+  }
 
-      string module_contents;
+  guard.unlock();
 
-      try {
-        module_contents = module->contents();
-      } catch (const exception& err) {
-        m_log.err("Failed to get contents for \"%s\" (err: %s)", module->name(), err.what());
+  for (auto&& frame : frames) {
+    copied += frame.first.size();
+  }
+  m_bytes_copied += copied;
+  m_log.trace("controller: Assembled %lu bar(s) (copied=%lu, segments rebuilt=%lu, total copied=%lu)", frames.size(),
+      copied, rebuilt, m_bytes_copied);
+
+  for (size_t i = 0; i < m_bars.size(); i++) {
+    try {
+      if (!m_writeback) {
+        m_bars[i].instance->parse(move(frames[i].first), move(frames[i].second), force);
+      } else {
+        std::cout << frames[i].first << std::endl;
       }
+    } catch (const exception& err) {
+      m_log.err("Failed to update bar contents (reason: %s)", err.what());
+    }
+  }
+
+  m_frames->rendered();
+  if (m_frames->stats().rendered % 100 == 0) {
+    m_log.trace("controller: Frame stats: %s", m_frames->report());
+  }
 
-      if (module_contents.empty()) {
+  return true;
+}
+
+/**
+ * Assemble the contents of a single bar from the module outputs
+ *
+ * `outputs` holds the modules that changed since the last frame. Segments
+ * that have to be rebuilt for modules that didn't change read the cached
+ * module output and add it to `outputs` for the other bars
+ */
+void controller::assemble(bar_state& state, std::map<const modules::module_interface*, string>& outputs,
+    string& contents, render_list& ops, size_t& copied, size_t& rebuilt) {
+  // The snapshot stays alive until the update is done, even if the bar publishes a new one
+  bar_settings_t settings{state.instance->settings()};
+  const bar_settings& bar{*settings};
+
+  if (state.parts.settings != settings) {
+    build_glue(state, settings);
+  }
+
+  const glue& parts{state.parts};
+
+  for (const auto& block : state.blocks) {
+    auto& segments = state.segments[block.first];
+    auto& block_contents = state.block_contents[block.first];
+    auto& block_ops = state.block_ops[block.first];
+    bool dirty{segments.size() != block.second.size()};
+    segments.resize(block.second.size());
+
+    for (size_t i = 0; i < block.second.size(); i++) {
+      const auto& module = block.second[i];
+      auto& segment = segments[i];
+
+      if (!module->running()) {
+        dirty = dirty || !segment.contents.empty();
+        segment.contents.clear();
+        segment.ops.clear();
+        segment.valid = false;
         continue;
       }
 
-      if (!block_contents.empty() && !margin_right.empty()) {
-        block_contents += margin_right;
+      auto output = outputs.find(&*module);
+
+      if (segment.valid && output == outputs.end()) {
+        continue;
+      } else if (output == outputs.end()) {
+        try {
+          output = outputs.emplace(&*module, compact_tags(module->contents())).first;
+        } catch (const exception& err) {
+          m_log.err("Failed to get contents for \"%s\" (err: %s)", module->name(), err.what());
+          output = outputs.emplace(&*module, "").first;
+        }
       }
 
-      if (!block_contents.empty() && !separator.empty()) {
-        block_contents += separator;
+      segment.contents = output->second;
+      segment.ops.clear();
+      if (!m_writeback) {
+        parse(bar, segment.contents, segment.ops, module->name());
       }
 
-      if (!block_contents.empty() && !margin_left.empty() && !(is_left && is_first)) {
-        block_contents += margin_left;
+      segment.valid = true;
+      copied += segment.contents.size();
+      rebuilt++;
+      dirty = true;
+    }
+
+    if (dirty) {
+      bool is_left = block.first == alignment::LEFT;
+      bool is_first = true;
+
+      block_contents.clear();
+      block_ops.clear();
+
+      for (const auto& segment : segments) {
+        if (segment.contents.empty()) {
+          continue;
+        }
+
+        if (!block_contents.empty() && !parts.margin_right.empty()) {
+          block_contents += parts.margin_right;
+          block_ops.append(parts.margin_right_ops);
+        }
+
+        if (!block_contents.empty() && !parts.separator.empty()) {
+          splice_tags(block_contents, parts.separator);
+          block_ops.append(parts.separator_ops);
+        }
+
+        if (!block_contents.empty() && !parts.margin_left.empty() && !(is_left && is_first)) {
+          block_contents += parts.margin_left;
+          block_ops.append(parts.margin_left_ops);
+        }
+
+        splice_tags(block_contents, segment.contents);
+        block_ops.append(segment.ops);
+
+        is_first = false;
       }
 
-      block_contents.reserve(module_contents.size());
-      block_contents += module_contents;
+      if (!block_contents.empty() && block.first == alignment::RIGHT) {
+        block_contents += parts.padding_right;
+        block_ops.append(parts.padding_right_ops);
+      }
 
-      is_first = false;
+      copied += block_contents.size();
     }
 
     if (block_contents.empty()) {
       continue;
-    } else if (is_left) {
+    } else if (block.first == alignment::LEFT) {
       contents += "%{l}";
-      contents += padding_left;
-    } else if (is_center) {
+      contents += parts.padding_left;
+      ops.add(render_op_type::ALIGNMENT, alignment::LEFT);
+      ops.append(parts.padding_left_ops);
+    } else if (block.first == alignment::CENTER) {
       contents += "%{c}";
-    } else if (is_right) {
+      ops.add(render_op_type::ALIGNMENT, alignment::CENTER);
+    } else if (block.first == alignment::RIGHT) {
       contents += "%{r}";
-      block_contents += padding_right;
+      ops.add(render_op_type::ALIGNMENT, alignment::RIGHT);
+    }
+
+    contents += block_contents;
+    ops.append(block_ops);
+  }
+}
+
+/**
+ * Build the glue between the segments of the bar for the given settings
+ *
+ * Segments were parsed against the previous settings, so they are
+ * rebuilt as well
+ */
+void controller::build_glue(bar_state& state, bar_settings_t settings) {
+  const bar_settings& bar{*settings};
+  glue& parts{state.parts};
+  parts = glue{};
+
+  parts.padding_left.assign(bar.padding.left, ' ');
+  parts.padding_right.assign(bar.padding.right, ' ');
+  parts.margin_left.assign(bar.module_margin.left, ' ');
+  parts.margin_right.assign(bar.module_margin.right, ' ');
+
+  builder build{bar};
+  build.node(bar.separator);
+  parts.separator = compact_tags(build.flush());
+
+  if (!m_writeback) {
+    parse(bar, parts.separator, parts.separator_ops, "separator");
+    parse(bar, parts.margin_left, parts.margin_left_ops, "module-margin");
+    parse(bar, parts.margin_right, parts.margin_right_ops, "module-margin");
+    parse(bar, parts.padding_left, parts.padding_left_ops, "padding");
+    parse(bar, parts.padding_right, parts.padding_right_ops, "padding");
+  }
+
+  for (auto&& block : state.segments) {
+    for (auto&& segment : block.second) {
+      segment.valid = false;
     }
+  }
+
+  parts.settings = move(settings);
+}
+
+/**
+ * Parse formatting string into render ops
+ *
+ * Ops parsed before an error are kept so that the rest of the
+ * bar can still be drawn
+ */
+void controller::parse(const bar_settings& bar, const string& data, render_list& ops, const string& context) {
+  try {
+    m_parser->parse(bar, data, ops);
+  } catch (const parser_error& err) {
+    m_log.err("Failed to parse contents of %s (reason: %s)", context, err.what());
+  }
+}
 
-    // Strip unnecessary reset tags
-    block_contents = string_util::replace_all(block_contents, "T-}%{T", "T");
-    block_contents = string_util::replace_all(block_contents, "B-}%{B#", "B#");
-    block_contents = string_util::replace_all(block_contents, "F-}%{F#", "F#");
-    block_contents = string_util::replace_all(block_contents, "U-}%{U#", "U#");
-    block_contents = string_util::replace_all(block_contents, "u-}%{u#", "u#");
-    block_contents = string_util::replace_all(block_contents, "o-}%{o#", "o#");
+/**
+ * Re-read the config file and apply the changes in place
+ *
+ * Modules whose section still resolves to the same values keep running,
+ * the others are created again. The X connection, fonts, window and tray
+ * stay untouched, which is why a change to the bar section (other than
+ * its module lists) or to the global settings still restarts the process
+ */
+void controller::reload() {
+  m_log.notice("Reloading configuration");
 
-    // Join consecutive tags
-    contents += string_util::replace_all(block_contents, "}%{", " ");
+  vector<string> bar_sections;
+  for (auto&& state : m_bars) {
+    bar_sections.emplace_back(state.instance->settings()->section);
+  }
+  vector<string> module_sections;
+  for (auto&& module : m_modules) {
+    module_sections.emplace_back(module->name());
   }
 
+  config_snapshot previous_conf{m_conf, bar_sections, module_sections};
+
   try {
-    if (!m_writeback) {
-      m_bar->parse(move(contents), force);
-    } else {
-      std::cout << contents << std::endl;
-    }
+    config_parser parser{m_log, string{m_conf.filepath()}, m_conf.section().substr(4)};
+    parser.parse();
   } catch (const exception& err) {
-    m_log.err("Failed to update bar contents (reason: %s)", err.what());
+    m_log.err("Failed to reload configuration, keeping the current one (reason: %s)", err.what());
+    return;
   }
 
-  return true;
+  config_snapshot current_conf{m_conf, bar_sections, module_sections};
+
+  if (!current_conf.bars_equal(previous_conf)) {
+    m_log.notice("Bar settings changed, restarting...");
+    on(signals::eventqueue::exit_reload{});
+    return;
+  }
+
+  std::map<string, module_t> reusable;
+  for (auto&& instance : m_instances) {
+    const auto& module = instance.second;
+    if (module->running() && current_conf.module_equal(previous_conf, module->name())) {
+      reusable.emplace(instance);
+    }
+  }
+
+  vector<module_t> previous;
+  size_t created_modules{0};
+  {
+    std::lock_guard<std::mutex> guard(m_modulelock);
+    previous = move(m_modules);
+    m_modules.clear();
+    m_instances.clear();
+    m_inputhandlers.clear();
+
+    for (auto&& state : m_bars) {
+      state.blocks.clear();
+      state.segments.clear();
+      state.block_contents.clear();
+      state.block_ops.clear();
+
+      created_modules += setup_modules(state, alignment::LEFT, reusable);
+      created_modules += setup_modules(state, alignment::CENTER, reusable);
+      created_modules += setup_modules(state, alignment::RIGHT, reusable);
+    }
+  }
+
+  // The new modules are running before the old ones go away,
+  // so that the bar never looks as if it had no modules left
+  size_t started_modules{0};
+  size_t kept_modules{0};
+  for (auto&& module : m_modules) {
+    if (std::find(previous.begin(), previous.end(), module) != previous.end()) {
+      kept_modules++;
+    } else if (start_module(module)) {
+      started_modules++;
+    }
+  }
+
+  size_t stopped_modules{0};
+  for (auto&& module : previous) {
+    if (std::find(m_modules.begin(), m_modules.end(), module) != m_modules.end()) {
+      continue;
+    }
+
+    auto cleanup_ms = time_util::measure([&module] { module->stop(); });
+    m_log.info("Deconstruction of %s took %lu ms.", module->name(), cleanup_ms);
+
+    auto evt_handler = dynamic_cast<event_handler_interface*>(&*module);
+    if (evt_handler != nullptr) {
+      evt_handler->disconnect(m_connection);
+    }
+    stopped_modules++;
+  }
+  previous.clear();
+
+  if (!created_modules) {
+    m_log.warn("No modules created");
+  }
+
+  m_log.notice("Configuration reloaded (started=%lu, stopped=%lu, unchanged=%lu)", started_modules, stopped_modules,
+      kept_modules);
+  enqueue(make_update_evt(true));
+}
+
+/**
+ * Hook up the event handler of the module and start it
+ */
+bool controller::start_module(const module_t& module) {
+  auto evt_handler = dynamic_cast<event_handler_interface*>(&*module);
+
+  if (evt_handler != nullptr) {
+    evt_handler->connect(m_connection);
+  }
+
+  try {
+    m_log.info("Starting %s", module->name());
+    module->start();
+    return true;
+  } catch (const application_error& err) {
+    m_log.err("Failed to start '%s' (reason: %s)", module->name(), err.what());
+    return false;
+  }
 }
 
 /**
- * Creates module instances for all the modules in the given alignment block
+ * Creates module instances for all the modules in the given alignment block of the bar
+ *
+ * Bars that would get the same output from a module share its instance.
+ * Modules found in `reusable` under their key are taken over instead of
+ * creating a new instance
  */
-size_t controller::setup_modules(alignment align) {
+size_t controller::setup_modules(bar_state& state, alignment align, std::map<string, module_t>& reusable) {
   size_t count{0};
 
   string key;
@@ -546,11 +887,22 @@ size_t controller::setup_modules(alignment align) {
       break;
   }
 
+  bar_settings_t settings{state.instance->settings()};
+
   string configured_modules;
   if (!key.empty()) {
-    configured_modules = m_conf.get(m_conf.section(), key, ""s);
+    configured_modules = m_conf.get(settings->section, key, ""s);
   }
 
+  auto add_module = [&](const string& instance_key, const module_t& module) {
+    auto inp_handler = dynamic_cast<input_handler*>(&*module);
+    if (inp_handler != nullptr) {
+      m_inputhandlers.emplace_back(inp_handler);
+    }
+    m_modules.push_back(module);
+    m_instances.emplace(instance_key, module);
+  };
+
   for (auto& module_name : string_util::split(configured_modules, ' ')) {
     if (module_name.empty()) {
       continue;
@@ -558,17 +910,44 @@ size_t controller::setup_modules(alignment align) {
 
     try {
       auto type = m_conf.get("module/" + module_name, "type");
+      auto instance_key = share_key(module_name, type, *settings);
+
+      // References to the root section always resolve against the first bar
+      if (settings->section != m_conf.section()) {
+        for (auto&& root_key : m_conf.root_references("module/" + module_name)) {
+          if (m_conf.get(settings->section, root_key, ""s) != m_conf.get(m_conf.section(), root_key, ""s)) {
+            throw application_error("${root." + root_key + "} is taken from " + m_conf.section() +
+                                    " for all bars, but differs in " + settings->section);
+          }
+        }
+      }
+
+      auto instance = m_instances.find(instance_key);
+      if (instance != m_instances.end()) {
+        state.blocks[align].push_back(instance->second);
+        count++;
+        continue;
+      }
+
+      auto reused = reusable.find(instance_key);
+      if (reused != reusable.end()) {
+        add_module(instance_key, reused->second);
+        state.blocks[align].push_back(reused->second);
+        reusable.erase(reused);
+        count++;
+        continue;
+      }
 
       if (type == "custom/ipc" && !m_ipc) {
         throw application_error("Inter-process messaging needs to be enabled");
       }
 
-      auto ptr = make_module(move(type), m_bar->settings(), module_name, m_log);
+      auto ptr = make_module(move(type), settings, module_name, m_log);
       module_t module = shared_ptr<modules::module_interface>(ptr);
       ptr = nullptr;
 
-      m_modules.push_back(module);
-      m_blocks[align].push_back(module);
+      add_module(instance_key, module);
+      state.blocks[align].push_back(module);
       count++;
     } catch (const runtime_error& err) {
       m_log.err("Disabling module \"%s\" (reason: %s)", module_name, err.what());
@@ -582,7 +961,11 @@ size_t controller::setup_modules(alignment align) {
  * Process broadcast events
  */
 bool controller::on(const signals::eventqueue::notify_change&) {
-  return enqueue(make_update_evt(false));
+  // Only the first change of a frame needs to wake up the event queue
+  if (m_frames->request()) {
+    return enqueue(make_update_evt(false));
+  }
+  return true;
 }
 
 /**
@@ -612,9 +995,12 @@ bool controller::on(const signals::eventqueue::exit_reload&) {
  * Process eventqueue check event
  */
 bool controller::on(const signals::eventqueue::check_state&) {
-  for (const auto& module : m_modules) {
-    if (module->running()) {
-      return true;
+  {
+    std::lock_guard<std::mutex> guard(m_modulelock);
+    for (const auto& module : m_modules) {
+      if (module->running()) {
+        return true;
+      }
     }
   }
   m_log.warn("No running modules...");
@@ -624,8 +1010,14 @@ bool controller::on(const signals::eventqueue::check_state&) {
 
 /**
  * Process ui ready event
+ *
+ * Events are processed once the windows of all bars are mapped
  */
 bool controller::on(const signals::ui::ready&) {
+  if (++m_ready_bars < m_bars.size()) {
+    return false;
+  }
+
   m_process_events = true;
   enqueue(make_update_evt(true));
 
@@ -685,15 +1077,22 @@ bool controller::on(const signals::ipc::command& evt) {
   if (command == "quit") {
     enqueue(make_quit_evt(false));
   } else if (command == "restart") {
-    enqueue(make_quit_evt(true));
+    reload();
   } else if (command == "hide") {
-    m_bar->hide();
+    for (auto&& state : m_bars) {
+      state.instance->hide();
+    }
   } else if (command == "show") {
-    m_bar->show();
+    for (auto&& state : m_bars) {
+      state.instance->show();
+    }
   } else if (command == "toggle") {
-    m_bar->toggle();
+    for (auto&& state : m_bars) {
+      state.instance->toggle();
+    }
   } else {
     m_log.warn("\"%s\" is not a valid ipc command", command);
+    return false;
   }
 
   return true;
@@ -705,6 +1104,7 @@ bool controller::on(const signals::ipc::command& evt) {
 bool controller::on(const signals::ipc::hook& evt) {
   string hook{evt.cast()};
 
+  std::lock_guard<std::mutex> guard(m_modulelock);
   for (const auto& module : m_modules) {
     if (!module->running()) {
       continue;
@@ -0,0 +1,131 @@
+#include "components/damage_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+POLYBAR_NS
+
+/**
+ * Damage the whole drawable area on the next update
+ */
+void damage_tracker::invalidate() {
+  m_pending = true;
+}
+
+/**
+ * Whether the last update damaged the whole drawable area
+ */
+bool damage_tracker::full() const {
+  return m_full;
+}
+
+/**
+ * Compare the given blocks with the ones of the previous update
+ * and get the damaged regions of the drawable area
+ *
+ * If the drawable area itself changed, or the tracker was invalidated,
+ * the whole area is returned and full() is set
+ */
+vector<xcb_rectangle_t> damage_tracker::update(const xcb_rectangle_t& rect, std::map<alignment, block> blocks) {
+  vector<xcb_rectangle_t> regions;
+
+  m_full = m_pending || rect.x != m_rect.x || rect.y != m_rect.y || rect.width != m_rect.width ||
+           rect.height != m_rect.height;
+  m_pending = false;
+  m_rect = rect;
+
+  const auto damage = [&](double x0, double x1) {
+    x0 = std::max(0.0, std::floor(x0));
+    x1 = std::min(static_cast<double>(rect.width), std::ceil(x1));
+    if (x1 > x0) {
+      regions.emplace_back(xcb_rectangle_t{
+          static_cast<int16_t>(rect.x + x0), rect.y, static_cast<uint16_t>(x1 - x0), rect.height});
+    }
+  };
+
+  // Blocks that are gone compare against an empty block
+  for (auto&& p : m_prev) {
+    blocks.emplace(p.first, block{});
+  }
+
+  for (auto&& b : blocks) {
+    auto& prev = m_prev[b.first];
+    auto& cur = b.second;
+
+    if (m_full) {
+      // no need to compute anything
+    } else if (cur.x != prev.x || cur.w != prev.w || !cur.fits || !prev.fits) {
+      if (cur.spans != prev.spans || cur.x != prev.x || cur.w != prev.w) {
+        damage(prev.x, prev.x + prev.w);
+        damage(cur.x, cur.x + cur.w);
+      }
+    } else {
+      size_t first{0};
+      while (first < cur.spans.size() && first < prev.spans.size() && cur.spans[first] == prev.spans[first]) {
+        first++;
+      }
+
+      size_t cur_end{cur.spans.size()};
+      size_t prev_end{prev.spans.size()};
+      while (cur_end > first && prev_end > first && cur.spans[cur_end - 1] == prev.spans[prev_end - 1]) {
+        cur_end--;
+        prev_end--;
+      }
+
+      if (first != cur_end || first != prev_end) {
+        double x0{cur.w};
+        double x1{0.0};
+        for (size_t i = first; i < cur_end; i++) {
+          x0 = std::min(x0, cur.spans[i].x0);
+          x1 = std::max(x1, cur.spans[i].x1);
+        }
+        for (size_t i = first; i < prev_end; i++) {
+          x0 = std::min(x0, prev.spans[i].x0);
+          x1 = std::max(x1, prev.spans[i].x1);
+        }
+        damage(cur.x + x0, cur.x + x1);
+      }
+    }
+
+    prev = move(cur);
+  }
+
+  if (m_full) {
+    return {rect};
+  }
+
+  return merge(move(regions));
+}
+
+/**
+ * Sort the regions and join the ones that overlap or touch
+ *
+ * All regions span the full height of the drawable area, so
+ * only their horizontal extent is considered
+ */
+vector<xcb_rectangle_t> damage_tracker::merge(vector<xcb_rectangle_t> regions) {
+  if (regions.size() < 2) {
+    return regions;
+  }
+
+  std::sort(regions.begin(), regions.end(),
+      [](const xcb_rectangle_t& a, const xcb_rectangle_t& b) { return a.x < b.x; });
+
+  vector<xcb_rectangle_t> merged;
+  merged.reserve(regions.size());
+  merged.emplace_back(regions.front());
+
+  for (auto it = regions.begin() + 1; it != regions.end(); ++it) {
+    auto& last = merged.back();
+    int end{last.x + last.width};
+    if (it->x <= end) {
+      last.width = static_cast<uint16_t>(std::max(end, it->x + it->width) - last.x);
+    } else {
+      merged.emplace_back(*it);
+    }
+  }
+
+  return merged;
+}
+
+POLYBAR_NS_END
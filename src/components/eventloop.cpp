@@ -0,0 +1,240 @@
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <array>
+
+#include "components/eventloop.hpp"
+#include "errors.hpp"
+#include "utils/factory.hpp"
+#include "utils/scope.hpp"
+
+POLYBAR_NS
+
+namespace {
+  /**
+   * Pack the fd together with the registration generation so that
+   * events for an fd that got removed and reused within the same
+   * dispatch batch can be told apart
+   */
+  inline uint64_t make_key(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+  }
+}  // namespace
+
+/**
+ * Create instance
+ */
+eventloop::make_type eventloop::make() {
+  return static_cast<eventloop&>(*factory_util::singleton<eventloop>());
+}
+
+/**
+ * Create the instance the modules register with in reactor mode
+ */
+eventloop::make_type eventloop::make_reactor() {
+  static eventloop reactor;
+  return reactor;
+}
+
+/**
+ * Construct event loop
+ */
+eventloop::eventloop() {
+  if ((m_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    throw system_error("Failed to create epoll instance");
+  }
+}
+
+/**
+ * Deconstruct event loop
+ */
+eventloop::~eventloop() {
+  std::lock_guard<std::mutex> guard(m_lock);
+  for (auto&& h : m_handlers) {
+    if (h.second->timer) {
+      close(h.first);
+    }
+  }
+  m_handlers.clear();
+  close(m_fd);
+}
+
+/**
+ * Toggle reactor mode
+ */
+void eventloop::enable(bool state) {
+  m_enabled = state;
+}
+
+/**
+ * Check if reactor mode is active
+ */
+bool eventloop::enabled() const {
+  return m_enabled;
+}
+
+/**
+ * Register callback for events on the given fd
+ *
+ * Registering an fd that is already known replaces the
+ * previous callback
+ */
+void eventloop::add(int fd, callback cb, uint32_t events) {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  auto h = make_shared<handler>();
+  h->func = move(cb);
+  h->generation = ++m_generation;
+  h->timer = false;
+
+  auto it = m_handlers.find(fd);
+  if (it != m_handlers.end()) {
+    h->timer = it->second->timer;
+    epoll_ctl(m_fd, EPOLL_CTL_DEL, fd, nullptr);
+  }
+
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.u64 = make_key(fd, h->generation);
+
+  if (epoll_ctl(m_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    throw system_error("Failed to add fd to epoll set");
+  }
+
+  m_handlers[fd] = move(h);
+}
+
+/**
+ * Create a one-shot timer that fires after `initial`.
+ *
+ * The callback is expected to re-arm the timer using `arm()`
+ */
+int eventloop::add_timer(callback cb, duration initial) {
+  int fd{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)};
+  if (fd == -1) {
+    throw system_error("Failed to create timerfd");
+  }
+
+  add(fd, move(cb));
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_handlers[fd]->timer = true;
+  }
+  arm(fd, initial);
+
+  return fd;
+}
+
+/**
+ * Arm timer to expire once after the given timeout
+ */
+void eventloop::arm(int timer_fd, duration timeout) {
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(timeout).count();
+
+  // A zero value would disarm the timer
+  if (ns <= 0) {
+    ns = 1;
+  }
+
+  itimerspec spec{};
+  spec.it_value.tv_sec = ns / 1000000000;
+  spec.it_value.tv_nsec = ns % 1000000000;
+
+  if (timerfd_settime(timer_fd, 0, &spec, nullptr) == -1) {
+    throw system_error("Failed to arm timerfd");
+  }
+}
+
+/**
+ * Unregister fd. Timers created by the loop are also closed
+ *
+ * When called from another thread while the callback of the fd is
+ * running, this waits for the callback to return so that its owner can
+ * be destroyed right after
+ */
+void eventloop::remove(int fd) {
+  std::unique_lock<std::mutex> guard(m_lock);
+
+  if (m_dispatcher != std::this_thread::get_id()) {
+    m_idle.wait(guard, [&] { return m_current != fd; });
+  }
+
+  auto it = m_handlers.find(fd);
+  if (it == m_handlers.end()) {
+    return;
+  }
+
+  epoll_ctl(m_fd, EPOLL_CTL_DEL, fd, nullptr);
+
+  if (it->second->timer) {
+    close(fd);
+  }
+
+  m_handlers.erase(it);
+}
+
+/**
+ * Wait for events and run the callbacks of all ready fds
+ *
+ * Returns the number of dispatched callbacks
+ */
+size_t eventloop::dispatch(int timeout_ms) {
+  std::array<epoll_event, 32> events;
+  int count{epoll_wait(m_fd, events.data(), events.size(), timeout_ms)};
+
+  if (count == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    throw system_error("Failed to wait for epoll events");
+  }
+
+  size_t dispatched{0};
+
+  for (int i = 0; i < count; i++) {
+    int fd{static_cast<int>(events[i].data.u64 & 0xffffffff)};
+    uint32_t generation{static_cast<uint32_t>(events[i].data.u64 >> 32)};
+    shared_ptr<handler> h;
+
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      auto it = m_handlers.find(fd);
+      if (it == m_handlers.end() || it->second->generation != generation) {
+        continue;
+      }
+      h = it->second;
+      m_current = fd;
+      m_dispatcher = std::this_thread::get_id();
+    }
+
+    auto done = scope_util::make_exit_handler([this] {
+      {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_current = -1;
+      }
+      m_idle.notify_all();
+    });
+
+    if (h->timer) {
+      uint64_t expirations{0};
+      if (read(fd, &expirations, sizeof(expirations)) == -1 && errno == EAGAIN) {
+        continue;
+      }
+    }
+
+    h->func();
+    dispatched++;
+  }
+
+  return dispatched;
+}
+
+/**
+ * Get the epoll file descriptor, which becomes readable
+ * whenever one of the registered fds is ready
+ */
+int eventloop::get_file_descriptor() const {
+  return m_fd;
+}
+
+POLYBAR_NS_END
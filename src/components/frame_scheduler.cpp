@@ -0,0 +1,148 @@
+#include "components/frame_scheduler.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+POLYBAR_NS
+
+constexpr array<unsigned int, 8> frame_scheduler::latency_buckets;
+
+/**
+ * Construct scheduler, a max_fps of 0 disables the cap
+ */
+frame_scheduler::frame_scheduler(double max_fps) {
+  if (max_fps > 0.0) {
+    m_interval = chrono::duration_cast<clock::duration>(chrono::duration<double>(1.0 / max_fps));
+  }
+}
+
+/**
+ * Mark the bar as dirty
+ *
+ * Returns true if this opened a new frame, false if the request was
+ * coalesced into a frame that was already pending
+ */
+bool frame_scheduler::request(clock::time_point now) {
+  std::lock_guard<std::mutex> guard(m_lock);
+  if (m_pending) {
+    m_metrics.coalesced++;
+    return false;
+  }
+  m_pending = true;
+  m_requested = now;
+  return true;
+}
+
+bool frame_scheduler::pending() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_pending;
+}
+
+/**
+ * Check if the pending frame may be rendered
+ */
+bool frame_scheduler::due(clock::time_point now) const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_pending && now >= deadline();
+}
+
+/**
+ * Get the time left until the pending frame is due
+ */
+frame_scheduler::clock::duration frame_scheduler::until_due(clock::time_point now) const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  auto when = deadline();
+  return when > now ? when - now : clock::duration::zero();
+}
+
+/**
+ * Take the pending frame before its contents are read
+ *
+ * Requests made from now on open a new frame instead of being
+ * coalesced into the one that is being built
+ */
+void frame_scheduler::begin_frame() {
+  std::lock_guard<std::mutex> guard(m_lock);
+  take_pending();
+}
+
+/**
+ * Record that a frame has been put on screen
+ *
+ * Also used for forced updates, which bypass the deadline and
+ * take care of any pending frame as well. If begin_frame() wasn't
+ * called, the frame is taken here
+ */
+void frame_scheduler::rendered(clock::time_point now) {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  if (!m_building) {
+    take_pending();
+  }
+
+  if (m_frame_has_request) {
+    auto latency =
+        static_cast<size_t>(chrono::duration_cast<chrono::milliseconds>(now - m_frame_requested_at).count());
+    size_t bucket{0};
+    while (bucket < latency_buckets.size() && latency >= latency_buckets[bucket]) {
+      bucket++;
+    }
+    m_metrics.latency[bucket]++;
+
+    // Frame slots that passed while the frame was late
+    auto late = now - m_frame_deadline;
+    if (m_interval.count() > 0 && late > m_interval) {
+      m_metrics.dropped += late / m_interval;
+    }
+  }
+
+  m_metrics.rendered++;
+  m_building = false;
+  m_lastframe = now;
+}
+
+frame_scheduler::metrics frame_scheduler::stats() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_metrics;
+}
+
+/**
+ * Get a one-line summary of the metrics
+ */
+string frame_scheduler::report() const {
+  auto m = stats();
+  std::ostringstream ss;
+  ss << "rendered=" << m.rendered << " coalesced=" << m.coalesced << " dropped=" << m.dropped << " latency(ms)=";
+  for (size_t i = 0; i < m.latency.size(); i++) {
+    if (i > 0) {
+      ss << ",";
+    }
+    if (i < latency_buckets.size()) {
+      ss << "<" << latency_buckets[i];
+    } else {
+      ss << ">=" << latency_buckets.back();
+    }
+    ss << ":" << m.latency[i];
+  }
+  return ss.str();
+}
+
+/**
+ * Earliest time the pending frame may be rendered, expects the lock to be held
+ */
+frame_scheduler::clock::time_point frame_scheduler::deadline() const {
+  return std::max(m_requested, m_lastframe + m_interval);
+}
+
+/**
+ * Move the pending request to the frame being built, expects the lock to be held
+ */
+void frame_scheduler::take_pending() {
+  m_building = true;
+  m_frame_has_request = m_pending;
+  m_frame_requested_at = m_requested;
+  m_frame_deadline = deadline();
+  m_pending = false;
+}
+
+POLYBAR_NS_END
@@ -1,6 +1,9 @@
 #include <fcntl.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/un.h>
 
+#include "components/eventloop.hpp"
 #include "components/ipc.hpp"
 #include "components/logger.hpp"
 #include "events/signal.hpp"
@@ -11,17 +14,26 @@
 
 POLYBAR_NS
 
+namespace {
+  /**
+   * Number of messages read from a client before the
+   * event loop gets to serve the other file descriptors
+   */
+  constexpr size_t max_batch{64};
+}  // namespace
+
 /**
  * Create instance
  */
 ipc::make_type ipc::make() {
-  return factory_util::unique<ipc>(signal_emitter::make(), logger::make());
+  return factory_util::unique<ipc>(signal_emitter::make(), eventloop::make(), logger::make());
 }
 
 /**
  * Construct ipc handler
  */
-ipc::ipc(signal_emitter& emitter, const logger& logger) : m_sig(emitter), m_log(logger) {
+ipc::ipc(signal_emitter& emitter, eventloop& loop, const logger& logger)
+    : m_sig(emitter), m_loop(loop), m_log(logger) {
   m_path = string_util::replace(PATH_MESSAGING_FIFO, "%pid%", to_string(getpid()));
 
   if (file_util::exists(m_path) && unlink(m_path.c_str()) == -1) {
@@ -32,47 +44,112 @@ ipc::ipc(signal_emitter& emitter, const logger& logger) : m_sig(emitter), m_log(
   }
 
   m_log.info("Created ipc channel at: %s", m_path);
-  m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+
+  // Holding a write end ourselves means the fifo never reports EOF,
+  // so it doesn't have to be reopened after every message
+  m_fd = file_util::make_file_descriptor(m_path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+  m_socket_path = string_util::replace(PATH_MESSAGING_SOCKET, "%pid%", to_string(getpid()));
+
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+
+  if (m_socket_path.size() >= sizeof(addr.sun_path)) {
+    throw application_error("Path of ipc socket is too long: " + m_socket_path);
+  }
+  memcpy(addr.sun_path, m_socket_path.c_str(), m_socket_path.size() + 1);
+
+  if (file_util::exists(m_socket_path) && unlink(m_socket_path.c_str()) == -1) {
+    throw system_error("Failed to remove ipc socket");
+  }
+
+  m_socket = make_unique<file_descriptor>(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+
+  if (*m_socket == -1) {
+    throw system_error("Failed to create ipc socket");
+  } else if (bind(*m_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    throw system_error("Failed to bind ipc socket");
+  } else if (chmod(m_socket_path.c_str(), 0600) == -1 || listen(*m_socket, SOMAXCONN) == -1) {
+    unlink(m_socket_path.c_str());
+    throw system_error("Failed to listen on ipc socket");
+  }
+
+  m_log.info("Created ipc socket at: %s", m_socket_path);
 }
 
 /**
  * Deconstruct ipc handler
  */
 ipc::~ipc() {
+  stop();
+
   m_fd.reset();
+  m_socket.reset();
 
   if (!m_path.empty()) {
     m_log.trace("ipc: Removing file handle");
     unlink(m_path.c_str());
   }
+  if (!m_socket_path.empty()) {
+    unlink(m_socket_path.c_str());
+  }
 }
 
 /**
- * Receive available ipc messages and delegate valid events
+ * Start serving the fifo and the socket from the event loop
  */
-void ipc::receive_message() {
-  m_log.info("Receiving ipc message");
+void ipc::start() {
+  if (m_started) {
+    return;
+  }
+  m_started = true;
+
+  m_loop.add(*m_fd, [this] { receive_message(); });
+  m_loop.add(*m_socket, [this] { accept_clients(); });
+}
 
-  char buffer[BUFSIZ]{'\0'};
+/**
+ * Remove all file descriptors from the event loop and disconnect the clients
+ */
+void ipc::stop() {
+  if (!m_started) {
+    return;
+  }
+  m_started = false;
+
+  m_loop.remove(*m_fd);
+  m_loop.remove(*m_socket);
+
+  while (!m_clients.empty()) {
+    close_client(m_clients.begin()->first);
+  }
+}
+
+/**
+ * Receive available fifo messages and delegate valid events
+ *
+ * Every line is a message. Since writers usually write a whole message
+ * at once, data without a trailing newline is a message as well
+ */
+void ipc::receive_message() {
+  char buffer[BUFSIZ];
   ssize_t bytes_read{0};
+  string data;
 
-  if ((bytes_read = read(*m_fd, &buffer, BUFSIZ)) == -1) {
-    m_log.err("Failed to read from ipc channel (err: %s)", strerror(errno));
-  } else if (bytes_read > 0) {
-    string payload{string_util::trim(string{buffer}, '\n')};
+  while ((bytes_read = read(*m_fd, &buffer, BUFSIZ)) > 0) {
+    data.append(buffer, bytes_read);
+  }
 
-    if (payload.find(ipc_command_prefix) == 0) {
-      m_sig.emit(signals::ipc::command{payload.substr(strlen(ipc_command_prefix))});
-    } else if (payload.find(ipc_hook_prefix) == 0) {
-      m_sig.emit(signals::ipc::hook{payload.substr(strlen(ipc_hook_prefix))});
-    } else if (payload.find(ipc_action_prefix) == 0) {
-      m_sig.emit(signals::ipc::action{payload.substr(strlen(ipc_action_prefix))});
-    } else if (!payload.empty()) {
-      m_log.warn("Received unknown ipc message: (payload=%s)", payload);
-    }
+  if (bytes_read == -1 && errno != EAGAIN) {
+    m_log.err("Failed to read from ipc channel (err: %s)", strerror(errno));
   }
 
-  m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+  vector<string> messages{string_util::split(data, '\n')};
+
+  if (!messages.empty()) {
+    m_log.info("Receiving %lu ipc message(s)", messages.size());
+    process(messages);
+  }
 }
 
 /**
@@ -82,4 +159,159 @@ int ipc::get_file_descriptor() const {
   return *m_fd;
 }
 
+/**
+ * Get the path of the ipc socket
+ */
+const string& ipc::get_socket_path() const {
+  return m_socket_path;
+}
+
+/**
+ * Accept all pending connections on the ipc socket
+ */
+void ipc::accept_clients() {
+  int fd;
+
+  while ((fd = accept4(*m_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+    m_log.trace("ipc: Accepted client (fd=%i)", fd);
+    m_clients.emplace(fd, std::deque<string>{});
+    m_loop.add(fd, [this, fd] { receive_packets(fd); });
+  }
+
+  if (errno != EAGAIN && errno != EWOULDBLOCK) {
+    m_log.err("Failed to accept ipc client (err: %s)", strerror(errno));
+  }
+}
+
+/**
+ * Handle the messages a client has sent and reply to each of them
+ *
+ * While replies are queued the client is only watched for becoming
+ * writable, its messages are read again once they have all been sent
+ */
+void ipc::receive_packets(int fd) {
+  if (!m_clients[fd].empty()) {
+    if (!send_replies(fd)) {
+      close_client(fd);
+      return;
+    } else if (!m_clients[fd].empty()) {
+      return;
+    }
+    m_loop.add(fd, [this, fd] { receive_packets(fd); });
+  }
+
+  char buffer[BUFSIZ];
+  vector<string> messages;
+  vector<bool> truncated;
+  bool closed{false};
+
+  while (messages.size() < max_batch) {
+    ssize_t bytes{recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT | MSG_TRUNC)};
+
+    if (bytes == 0) {
+      closed = true;
+      break;
+    } else if (bytes == -1) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        m_log.warn("Failed to read from ipc client (err: %s)", strerror(errno));
+        closed = true;
+      }
+      break;
+    }
+
+    bool too_long{static_cast<size_t>(bytes) > sizeof(buffer)};
+    messages.emplace_back(buffer, too_long ? 0 : bytes);
+    truncated.emplace_back(too_long);
+  }
+
+  if (!messages.empty()) {
+    vector<string> replies{process(messages)};
+
+    auto& pending = m_clients[fd];
+    for (size_t i = 0; i < replies.size(); i++) {
+      pending.emplace_back(truncated[i] ? ipc_reply_error + "message too long"s : move(replies[i]));
+    }
+
+    if (!send_replies(fd)) {
+      closed = true;
+    } else if (!closed && !pending.empty()) {
+      m_log.trace("ipc: Waiting for client to take %lu replies (fd=%i)", pending.size(), fd);
+      m_loop.add(fd, [this, fd] { receive_packets(fd); }, EPOLLOUT);
+    }
+  }
+
+  if (closed) {
+    close_client(fd);
+  }
+}
+
+/**
+ * Send queued replies until the socket is full
+ *
+ * Returns false if the client is gone
+ */
+bool ipc::send_replies(int fd) {
+  auto& pending = m_clients[fd];
+
+  while (!pending.empty()) {
+    const string& reply{pending.front()};
+
+    if (send(fd, reply.c_str(), reply.size(), MSG_DONTWAIT | MSG_NOSIGNAL) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    pending.pop_front();
+  }
+
+  return true;
+}
+
+/**
+ * Disconnect the client
+ */
+void ipc::close_client(int fd) {
+  m_log.trace("ipc: Closing client (fd=%i)", fd);
+  m_loop.remove(fd);
+  m_clients.erase(fd);
+  close(fd);
+}
+
+/**
+ * Delegate a batch of messages and return the reply to each of them
+ *
+ * Every hook runs, even when it is repeated right away. Hook scripts
+ * may have side effects, and the redraws they cause are merged by the
+ * frame scheduler anyway
+ */
+vector<string> ipc::process(const vector<string>& messages) {
+  vector<string> replies;
+  replies.reserve(messages.size());
+
+  for (auto&& message : messages) {
+    string payload{string_util::trim(string{message}, '\n')};
+    bool handled{false};
+
+    if (payload.find(ipc_hook_prefix) == 0) {
+      handled = m_sig.emit(signals::ipc::hook{payload.substr(strlen(ipc_hook_prefix))});
+    } else if (payload.find(ipc_command_prefix) == 0) {
+      handled = m_sig.emit(signals::ipc::command{payload.substr(strlen(ipc_command_prefix))});
+    } else if (payload.find(ipc_action_prefix) == 0) {
+      handled = m_sig.emit(signals::ipc::action{payload.substr(strlen(ipc_action_prefix))});
+    } else if (payload.empty()) {
+      replies.emplace_back(ipc_reply_error + "empty message"s);
+      continue;
+    } else {
+      m_log.warn("Received unknown ipc message: (payload=%s)", payload);
+      replies.emplace_back(ipc_reply_error + "unknown message type"s);
+      continue;
+    }
+
+    replies.emplace_back(handled ? ipc_reply_ok : ipc_reply_error + "message was not handled"s);
+  }
+
+  return replies;
+}
+
 POLYBAR_NS_END
@@ -2,8 +2,6 @@
 
 #include "components/parser.hpp"
 #include "components/types.hpp"
-#include "events/signal.hpp"
-#include "events/signal_emitter.hpp"
 #include "settings.hpp"
 #include "utils/color.hpp"
 #include "utils/factory.hpp"
@@ -12,34 +10,37 @@
 
 POLYBAR_NS
 
-using namespace signals::parser;
-
 /**
  * Create instance
  */
 parser::make_type parser::make() {
-  return factory_util::unique<parser>(signal_emitter::make());
+  return factory_util::unique<parser>();
 }
 
 /**
- * Construct parser instance
+ * Process input string and append the resulting render ops
+ *
+ * The input is never modified or copied, tags and text runs are
+ * consumed by moving a cursor through the original buffer
  */
-parser::parser(signal_emitter& emitter) : m_sig(emitter) {}
+void parser::parse(const bar_settings& bar, const string& data, render_list& ops) {
+  m_actions.clear();
 
-/**
- * Process input string
- */
-void parser::parse(const bar_settings& bar, string data) {
-  while (!data.empty()) {
-    size_t pos{string::npos};
-
-    if (data.compare(0, 2, "%{") == 0 && (pos = data.find('}')) != string::npos) {
-      codeblock(data.substr(2, pos - 2), bar);
-      data.erase(0, pos + 1);
-    } else if ((pos = data.find("%{")) != string::npos) {
-      data.erase(0, text(data.substr(0, pos)));
+  size_t pos{0};
+  size_t len{data.size()};
+
+  while (pos < len) {
+    size_t end{string::npos};
+
+    if (data.compare(pos, 2, "%{") == 0 && (end = data.find('}', pos)) != string::npos) {
+      codeblock(data, pos + 2, end, bar, ops);
+      pos = end + 1;
+    } else if ((end = data.find("%{", pos + 1)) != string::npos) {
+      text(data, pos, end, ops);
+      pos = end;
     } else {
-      data.erase(0, text(data.substr(0)));
+      text(data, pos, len, ops);
+      pos = len;
     }
   }
 
@@ -50,135 +51,135 @@ void parser::parse(const bar_settings& bar, string data) {
 
 /**
  * Process contents within tag blocks, i.e: %{...}
+ *
+ * The tag contents are found in data[begin, end)
  */
-void parser::codeblock(string&& data, const bar_settings& bar) {
-  size_t pos;
+void parser::codeblock(const string& data, size_t begin, size_t end, const bar_settings& bar, render_list& ops) {
+  size_t pos{begin};
 
-  while (data.length()) {
-    data = string_util::ltrim(move(data), ' ');
+  while (pos < end) {
+    while (pos < end && data[pos] == ' ') {
+      pos++;
+    }
 
-    if (data.empty()) {
+    if (pos == end) {
       break;
     }
 
-    char tag{data[0]};
+    char tag{data[pos++]};
 
     /*
      * Contains the string from the current position to the next space or
-     * closing curly bracket (})
+     * the end of the block
      *
      * This may be unsuitable for some tags (e.g. action tag) to use
-     * These MUST set value to the actual string they parsed from the beginning
-     * of data (or a string with the same length). The length of value is used
-     * to progress the cursor further.
+     * These MUST set `consumed` to the number of characters they parsed
+     * from the current position. It is used to progress the cursor further.
      *
      * example:
      *
      * data = A1:echo "test": ...}
      *
-     * erase(0,1)
-     * -> data = 1:echo "test": ...}
+     * tag = A, pos -> 1:echo "test": ...}
      *
      * case 'A', parse_action_cmd
-     * -> value = echo "test"
+     * -> cmd = echo "test"
      *
-     * Padding value
-     * -> value = echo "test"0::
+     * consumed = length of 1:echo "test":
      *
-     * erase(0, value.length())
-     * -> data =  ...}
+     * pos += consumed
+     * -> pos ->  ...}
      *
      */
-    string value;
-
-    // Remove the tag
-    data.erase(0, 1);
-
-    if ((pos = data.find_first_of(" }")) != string::npos) {
-      value = data.substr(0, pos);
-    } else {
-      value = data;
+    size_t value_end{data.find(' ', pos)};
+    if (value_end == string::npos || value_end > end) {
+      value_end = end;
     }
 
+    m_value.assign(data, pos, value_end - pos);
+    size_t consumed{m_value.size()};
+
     switch (tag) {
       case 'B':
-        m_sig.emit(change_background{parse_color(value, bar.background)});
+        ops.add(render_op_type::BACKGROUND, parse_color(m_value, bar.background));
         break;
 
       case 'F':
-        m_sig.emit(change_foreground{parse_color(value, bar.foreground)});
+        ops.add(render_op_type::FOREGROUND, parse_color(m_value, bar.foreground));
         break;
 
       case 'T':
-        m_sig.emit(change_font{parse_fontindex(value)});
+        ops.add(render_op_type::FONT, parse_fontindex(m_value));
         break;
 
       case 'U':
-        m_sig.emit(change_underline{parse_color(value, bar.underline.color)});
-        m_sig.emit(change_overline{parse_color(value, bar.overline.color)});
+        ops.add(render_op_type::UNDERLINE, parse_color(m_value, bar.underline.color));
+        ops.add(render_op_type::OVERLINE, parse_color(m_value, bar.overline.color));
         break;
 
       case 'u':
-        m_sig.emit(change_underline{parse_color(value, bar.underline.color)});
+        ops.add(render_op_type::UNDERLINE, parse_color(m_value, bar.underline.color));
         break;
 
       case 'o':
-        m_sig.emit(change_overline{parse_color(value, bar.overline.color)});
+        ops.add(render_op_type::OVERLINE, parse_color(m_value, bar.overline.color));
         break;
 
       case 'R':
-        m_sig.emit(reverse_colors{});
+        ops.add(render_op_type::REVERSE);
         break;
 
       case 'O':
-        m_sig.emit(offset_pixel{static_cast<int>(std::strtol(value.c_str(), nullptr, 10))});
+        ops.add(render_op_type::OFFSET, static_cast<int>(std::strtol(m_value.c_str(), nullptr, 10)));
         break;
 
       case 'l':
-        m_sig.emit(change_alignment{alignment::LEFT});
+        ops.add(render_op_type::ALIGNMENT, alignment::LEFT);
         break;
 
       case 'c':
-        m_sig.emit(change_alignment{alignment::CENTER});
+        ops.add(render_op_type::ALIGNMENT, alignment::CENTER);
         break;
 
       case 'r':
-        m_sig.emit(change_alignment{alignment::RIGHT});
+        ops.add(render_op_type::ALIGNMENT, alignment::RIGHT);
         break;
 
       case '+':
-        m_sig.emit(attribute_set{parse_attr(value[0])});
+        ops.add(render_op_type::ATTRIBUTE_SET, parse_attr(m_value[0]));
         break;
 
       case '-':
-        m_sig.emit(attribute_unset{parse_attr(value[0])});
+        ops.add(render_op_type::ATTRIBUTE_UNSET, parse_attr(m_value[0]));
         break;
 
       case '!':
-        m_sig.emit(attribute_toggle{parse_attr(value[0])});
+        ops.add(render_op_type::ATTRIBUTE_TOGGLE, parse_attr(m_value[0]));
         break;
 
       case 'A': {
-        bool has_btn_id = (data[0] != ':');
-        if (isdigit(data[0]) || !has_btn_id) {
-          value = parse_action_cmd(data.substr(has_btn_id ? 1 : 0));
-          mousebtn btn = parse_action_btn(data);
+        char btn_id{pos < end ? data[pos] : '\0'};
+        bool has_btn_id = (btn_id != ':');
+        if (isdigit(btn_id) || !has_btn_id) {
+          size_t cmd_begin{pos + (has_btn_id ? 1 : 0)};
+          size_t cmd_end{parse_action_cmd(data, cmd_begin, end)};
+          mousebtn btn = parse_action_btn(btn_id);
           m_actions.push_back(static_cast<int>(btn));
 
-          // Unescape colons inside command before sending it to the renderer
-          auto cmd = string_util::replace_all(value, "\\:", ":");
-          m_sig.emit(action_begin{action{btn, cmd}});
-
-          /*
-           * make sure value has the same length as the inside of the action
-           * tag which is btn_id + ':' + value + ':'
-           */
-          if (has_btn_id) {
-            value += "0";
+          if (cmd_end != string::npos) {
+            m_value.assign(data, cmd_begin + 1, cmd_end - cmd_begin - 1);
+          } else {
+            m_value.clear();
           }
-          value += "::";
+
+          // Unescape colons inside command before sending it to the renderer
+          auto cmd = string_util::replace_all(m_value, "\\:", ":");
+          ops.add_string(cmd, 0, cmd.size(), render_op_type::ACTION_BEGIN, btn);
+
+          // btn_id + ':' + cmd + ':'
+          consumed = (has_btn_id ? 1 : 0) + m_value.size() + 2;
         } else if (!m_actions.empty()) {
-          m_sig.emit(action_end{parse_action_btn(value)});
+          ops.add(render_op_type::ACTION_END, parse_action_btn(m_value[0]));
           m_actions.pop_back();
         }
         break;
@@ -186,33 +187,31 @@ void parser::codeblock(string&& data, const bar_settings& bar) {
 
       // Internal Polybar control tags
       case 'P':
-        m_sig.emit(control{parse_control(value)});
+        ops.add(render_op_type::CONTROL, parse_control(m_value));
         break;
 
       default:
         throw unrecognized_token("Unrecognized token '" + string{tag} + "'");
     }
 
-    if (!data.empty()) {
-      // Remove the parsed string from data
-      data.erase(0, !value.empty() ? value.length() : 1);
+    if (pos < end) {
+      pos += consumed ? consumed : 1;
     }
   }
 }
 
 /**
- * Process text contents
+ * Process text contents found in data[begin, end)
  */
-size_t parser::text(string&& data) {
+void parser::text(const string& data, size_t begin, size_t end, render_list& ops) {
+  ops.add_string(data, begin, end - begin, render_op_type::TEXT);
+
 #ifdef DEBUG_WHITESPACE
-  string::size_type p;
-  while ((p = data.find(' ')) != string::npos) {
-    data.replace(p, 1, "-"s);
+  string::size_type p{ops.ops.back().offset};
+  while ((p = ops.strings.find(' ', p)) != string::npos) {
+    ops.strings.replace(p, 1, "-"s);
   }
 #endif
-
-  m_sig.emit(signals::parser::text{forward<string>(data)});
-  return data.size();
 }
 
 /**
@@ -257,11 +256,11 @@ attribute parser::parse_attr(const char attr) {
 /**
  * Process action button token and convert it to the correct value
  */
-mousebtn parser::parse_action_btn(const string& data) {
-  if (data[0] == ':') {
+mousebtn parser::parse_action_btn(char btn) {
+  if (btn == ':') {
     return mousebtn::LEFT;
-  } else if (isdigit(data[0])) {
-    return static_cast<mousebtn>(data[0] - '0');
+  } else if (isdigit(btn)) {
+    return static_cast<mousebtn>(btn - '0');
   } else if (!m_actions.empty()) {
     return static_cast<mousebtn>(m_actions.back());
   } else {
@@ -278,20 +277,36 @@ mousebtn parser::parse_action_btn(const string& data) {
  * Returns everything inside the unescaped colons as is
  */
 string parser::parse_action_cmd(string&& data) {
-  if (data[0] != ':') {
+  size_t end{parse_action_cmd(data, 0, data.size())};
+
+  if (end == string::npos) {
     return "";
   }
 
-  size_t end{1};
-  while ((end = data.find(':', end)) != string::npos && data[end - 1] == '\\') {
-    end++;
+  return data.substr(1, end - 1);
+}
+
+/**
+ * Find the unescaped colon closing the action cmd that starts
+ * with the colon at data[begin]
+ *
+ * Returns string::npos if there is none before `end`
+ */
+size_t parser::parse_action_cmd(const string& data, size_t begin, size_t end) {
+  if (begin >= end || data[begin] != ':') {
+    return string::npos;
   }
 
-  if (end == string::npos) {
-    return "";
+  size_t pos{begin + 1};
+  while ((pos = data.find(':', pos)) != string::npos && pos < end && data[pos - 1] == '\\') {
+    pos++;
   }
 
-  return data.substr(1, end - 1);
+  if (pos >= end) {
+    return string::npos;
+  }
+
+  return pos;
 }
 
 controltag parser::parse_control(const string& data) {
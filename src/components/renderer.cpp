@@ -1,5 +1,7 @@
 #include "components/renderer.hpp"
 
+#include <cmath>
+
 #include "cairo/context.hpp"
 #include "components/config.hpp"
 #include "events/signal.hpp"
@@ -16,6 +18,12 @@ POLYBAR_NS
 
 static constexpr double BLOCK_GAP{20.0};
 
+namespace {
+  inline void hash_combine(size_t& seed, size_t value) {
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+}  // namespace
+
 /**
  * Create instance
  */
@@ -120,14 +128,14 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
   m_log.trace("renderer: Load fonts");
   {
     double dpi_x = 96, dpi_y = 96;
-    if (m_conf.has(m_conf.section(), "dpi")) {
-      dpi_x = dpi_y = m_conf.get<double>("dpi");
+    if (m_conf.has(m_bar.section, "dpi")) {
+      dpi_x = dpi_y = m_conf.get<double>(m_bar.section, "dpi");
     } else {
-      if (m_conf.has(m_conf.section(), "dpi-x")) {
-        dpi_x = m_conf.get<double>("dpi-x");
+      if (m_conf.has(m_bar.section, "dpi-x")) {
+        dpi_x = m_conf.get<double>(m_bar.section, "dpi-x");
       }
-      if (m_conf.has(m_conf.section(), "dpi-y")) {
-        dpi_y = m_conf.get<double>("dpi-y");
+      if (m_conf.has(m_bar.section, "dpi-y")) {
+        dpi_y = m_conf.get<double>(m_bar.section, "dpi-y");
       }
     }
 
@@ -144,24 +152,17 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
 
     m_log.info("Configured DPI = %gx%g", dpi_x, dpi_y);
 
-    auto fonts = m_conf.get_list<string>(m_conf.section(), "font", {});
+    auto fonts = m_conf.get_list<string>(m_bar.section, "font", {});
     if (fonts.empty()) {
       m_log.warn("No fonts specified, using fallback font \"fixed\"");
       fonts.emplace_back("fixed");
     }
 
-    for (const auto& f : fonts) {
-      int offset{0};
-      string pattern{f};
-      size_t pos = pattern.rfind(';');
-      if (pos != string::npos) {
-        offset = std::strtol(pattern.substr(pos + 1).c_str(), nullptr, 10);
-        pattern.erase(pos);
-      }
-      auto font = cairo::make_font(*m_context, string{pattern}, offset, dpi_x, dpi_y);
-      m_log.notice("Loaded font \"%s\" (name=%s, offset=%i, file=%s)", pattern, font->name(), offset, font->file());
-      *m_context << move(font);
+    auto font_set = cairo::make_font_set(m_log, fonts, dpi_x, dpi_y);
+    if (font_set.use_count() > 1) {
+      m_log.info("renderer: Sharing the fonts and shaped text of another bar");
     }
+    *m_context << move(font_set);
   }
 
   m_pseudo_transparency = m_conf.get<bool>("settings", "pseudo-transparency", m_pseudo_transparency);
@@ -176,7 +177,7 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
   m_comp_ul = m_conf.get<cairo_operator_t>("settings", "compositing-underline", m_comp_ul);
   m_comp_border = m_conf.get<cairo_operator_t>("settings", "compositing-border", m_comp_border);
 
-  m_fixedcenter = m_conf.get(m_conf.section(), "fixed-center", true);
+  m_fixedcenter = m_conf.get(m_bar.section, "fixed-center", true);
 }
 
 /**
@@ -194,10 +195,10 @@ xcb_window_t renderer::window() const {
 }
 
 /**
- * Get completed action blocks
+ * Get the index of the completed action blocks of the last frame
  */
-const vector<action_block> renderer::actions() const {
-  return m_actions;
+shared_ptr<const action_index> renderer::actions() const {
+  return std::atomic_load(&m_action_index);
 }
 
 /**
@@ -211,6 +212,7 @@ void renderer::begin(xcb_rectangle_t rect) {
   m_actions.clear();
   m_attr.reset();
   m_align = alignment::NONE;
+  m_spans.clear();
 
   // Reset colors
   m_bg = m_bar.background;
@@ -218,8 +220,63 @@ void renderer::begin(xcb_rectangle_t rect) {
   m_ul = m_bar.underline.color;
   m_ol = m_bar.overline.color;
 
-  // Clear canvas
+  // The alignment blocks are rendered into separate groups which
+  // only get composited onto the canvas in end(), once it's known
+  // which parts of the bar actually changed
+  m_context->save();
+
+  // clang-format off
+  m_context->clip(cairo::rect{
+      static_cast<double>(m_rect.x),
+      static_cast<double>(m_rect.y),
+      static_cast<double>(m_rect.width),
+      static_cast<double>(m_rect.height)});
+  // clang-format on
+}
+
+/**
+ * End render routine
+ */
+void renderer::end() {
+  m_log.trace_x("renderer: end");
+
+  for (auto&& a : m_actions) {
+    a.start_x += block_x(a.align) + m_rect.x;
+    a.end_x += block_x(a.align) + m_rect.x;
+  }
+  std::atomic_store(&m_action_index, shared_ptr<const action_index>{make_shared<action_index>(m_actions)});
+
+  if (m_align != alignment::NONE) {
+    m_log.trace_x("renderer: pop(%i)", static_cast<int>(m_align));
+    m_context->pop(&m_blocks[m_align].pattern);
+  }
+
+  m_context->restore();
+
+  auto regions = damaged_regions();
+
+  if (regions.empty()) {
+    m_log.trace("renderer: Skipping redraw (no damage)");
+    for (auto&& b : m_blocks) {
+      if (b.second.pattern != nullptr) {
+        m_context->destroy(&b.second.pattern);
+      }
+    }
+    return;
+  }
+
   m_context->save();
+
+  // Restrict all drawing to the damaged regions
+  if (!m_damage.full()) {
+    for (auto&& r : regions) {
+      *m_context << cairo::rect{static_cast<double>(r.x), static_cast<double>(r.y), static_cast<double>(r.width),
+          static_cast<double>(r.height)};
+    }
+    m_context->clip();
+  }
+
+  // Clear canvas
   m_context->clear();
 
   // when pseudo-transparency is requested, render the bar into a new layer
@@ -254,23 +311,8 @@ void renderer::begin(xcb_rectangle_t rect) {
       static_cast<double>(m_rect.width),
       static_cast<double>(m_rect.height)});
   // clang-format on
-}
-
-/**
- * End render routine
- */
-void renderer::end() {
-  m_log.trace_x("renderer: end");
-
-  for (auto&& a : m_actions) {
-    a.start_x += block_x(a.align) + m_rect.x;
-    a.end_x += block_x(a.align) + m_rect.x;
-  }
 
   if (m_align != alignment::NONE) {
-    m_log.trace_x("renderer: pop(%i)", static_cast<int>(m_align));
-    m_context->pop(&m_blocks[m_align].pattern);
-
     // Capture the concatenated block contents
     // so that it can be masked with the corner pattern
     m_context->push();
@@ -321,11 +363,41 @@ void renderer::end() {
   m_context->restore();
   m_surface->flush();
 
-  flush();
+  flush(regions);
 
   m_sig.emit(signals::ui::changed{});
 }
 
+/**
+ * Get the regions of the canvas that need to be redrawn
+ *
+ * If the drawable area itself changed the whole bar is redrawn
+ */
+vector<xcb_rectangle_t> renderer::damaged_regions() {
+  // The desktop background below the bar might have changed as well
+  if (m_pseudo_transparency) {
+    m_damage.invalidate();
+  }
+
+  std::map<alignment, damage_tracker::block> blocks;
+  for (auto&& b : m_blocks) {
+    auto& cur = blocks[b.first];
+    cur.x = b.second.pattern != nullptr ? block_x(b.first) : 0.0;
+    cur.w = b.second.pattern != nullptr ? block_w(b.first) : 0.0;
+    cur.fits = cur.x + cur.w <= m_rect.width;
+    cur.spans = move(m_spans[b.first]);
+  }
+
+  auto regions = m_damage.update(m_rect, move(blocks));
+
+  if (m_damage.full()) {
+    regions.clear();
+    regions.emplace_back(xcb_rectangle_t{0, 0, m_bar.size.w, m_bar.size.h});
+  }
+
+  return regions;
+}
+
 /**
  * Flush contents of given alignment block
  */
@@ -393,6 +465,13 @@ void renderer::flush(alignment a) {
  * Flush pixmap contents onto the target window
  */
 void renderer::flush() {
+  flush(vector<xcb_rectangle_t>{xcb_rectangle_t{0, 0, m_bar.size.w, m_bar.size.h}});
+}
+
+/**
+ * Flush the given regions of the pixmap onto the target window
+ */
+void renderer::flush(const vector<xcb_rectangle_t>& regions) {
   m_log.trace_x("renderer: flush");
 
   highlight_clickable_areas();
@@ -417,9 +496,17 @@ void renderer::flush() {
 #endif
 
   m_surface->flush();
-  m_connection.copy_area(m_pixmap, m_window, m_gcontext, 0, 0, 0, 0, m_bar.size.w, m_bar.size.h);
+
+  size_t pixels{0};
+  for (auto&& r : regions) {
+    m_connection.copy_area(m_pixmap, m_window, m_gcontext, r.x, r.y, r.x, r.y, r.width, r.height);
+    pixels += r.width * r.height;
+  }
   m_connection.flush();
 
+  m_pixels_touched += pixels;
+  m_log.trace("renderer: Copied %lu pixels in %lu regions (total=%lu)", pixels, regions.size(), m_pixels_touched);
+
   if (!m_snapshot_dst.empty()) {
     try {
       m_surface->write_png(m_snapshot_dst);
@@ -697,6 +784,8 @@ void renderer::draw_text(const string& contents) {
     block.bg_rect.h = m_rect.height;
   }
 
+  double x0{m_blocks[m_align].x};
+
   m_context->save();
   *m_context << origin;
   *m_context << m_comp_fg;
@@ -709,6 +798,16 @@ void renderer::draw_text(const string& contents) {
     fill_underline(origin.x, dx);
     fill_overline(origin.x, dx);
   }
+
+  // Track the drawn range for damage computation
+  size_t hash{std::hash<string>{}(contents)};
+  hash_combine(hash, m_font);
+  hash_combine(hash, m_fg);
+  hash_combine(hash, block.bg_rect.h != 0.0 ? m_bg : m_bar.background);
+  hash_combine(hash, m_attr.to_ulong());
+  hash_combine(hash, m_ul);
+  hash_combine(hash, m_ol);
+  m_spans[m_align].emplace_back(damage_tracker::span{x0, m_blocks[m_align].x, hash});
 }
 
 /**
@@ -741,53 +840,90 @@ bool renderer::on(const signals::ui::request_snapshot& evt) {
   return true;
 }
 
-bool renderer::on(const signals::parser::change_background& evt) {
-  const unsigned int color{evt.cast()};
-  if (color != m_bg) {
-    m_log.trace_x("renderer: change_background(#%08x)", color);
-    m_bg = color;
-  }
-  return true;
-}
-
-bool renderer::on(const signals::parser::change_foreground& evt) {
-  const unsigned int color{evt.cast()};
-  if (color != m_fg) {
-    m_log.trace_x("renderer: change_foreground(#%08x)", color);
-    m_fg = color;
-  }
-  return true;
-}
-
-bool renderer::on(const signals::parser::change_underline& evt) {
-  const unsigned int color{evt.cast()};
-  if (color != m_ul) {
-    m_log.trace_x("renderer: change_underline(#%08x)", color);
-    m_ul = color;
-  }
-  return true;
-}
-
-bool renderer::on(const signals::parser::change_overline& evt) {
-  const unsigned int color{evt.cast()};
-  if (color != m_ol) {
-    m_log.trace_x("renderer: change_overline(#%08x)", color);
-    m_ol = color;
-  }
-  return true;
-}
-
-bool renderer::on(const signals::parser::change_font& evt) {
-  const int font{evt.cast()};
-  if (font != m_font) {
-    m_log.trace_x("renderer: change_font(%i)", font);
-    m_font = font;
+/**
+ * Process the render ops produced by the parser
+ */
+void renderer::render(const render_list& list) {
+  for (auto&& op : list.ops) {
+    switch (op.type) {
+      case render_op_type::BACKGROUND:
+        m_log.trace_x("renderer: change_background(#%08x)", op.color);
+        m_bg = op.color;
+        break;
+
+      case render_op_type::FOREGROUND:
+        m_log.trace_x("renderer: change_foreground(#%08x)", op.color);
+        m_fg = op.color;
+        break;
+
+      case render_op_type::UNDERLINE:
+        m_log.trace_x("renderer: change_underline(#%08x)", op.color);
+        m_ul = op.color;
+        break;
+
+      case render_op_type::OVERLINE:
+        m_log.trace_x("renderer: change_overline(#%08x)", op.color);
+        m_ol = op.color;
+        break;
+
+      case render_op_type::FONT:
+        m_log.trace_x("renderer: change_font(%i)", op.value);
+        m_font = op.value;
+        break;
+
+      case render_op_type::ALIGNMENT:
+        change_alignment(op.align);
+        break;
+
+      case render_op_type::REVERSE:
+        m_log.trace_x("renderer: reverse_colors");
+        std::swap(m_fg, m_bg);
+        break;
+
+      case render_op_type::OFFSET:
+        m_log.trace_x("renderer: offset_pixel(%i)", op.value);
+        m_blocks[m_align].x += op.value;
+        break;
+
+      case render_op_type::ATTRIBUTE_SET:
+        m_log.trace_x("renderer: attribute_set(%i)", static_cast<int>(op.attr));
+        m_attr.set(static_cast<int>(op.attr), true);
+        break;
+
+      case render_op_type::ATTRIBUTE_UNSET:
+        m_log.trace_x("renderer: attribute_unset(%i)", static_cast<int>(op.attr));
+        m_attr.set(static_cast<int>(op.attr), false);
+        break;
+
+      case render_op_type::ATTRIBUTE_TOGGLE:
+        m_log.trace_x("renderer: attribute_toggle(%i)", static_cast<int>(op.attr));
+        m_attr.flip(static_cast<int>(op.attr));
+        break;
+
+      case render_op_type::ACTION_BEGIN:
+        action_begin(op.btn, list.strings.substr(op.offset, op.length));
+        break;
+
+      case render_op_type::ACTION_END:
+        action_end(op.btn);
+        break;
+
+      case render_op_type::TEXT:
+        m_text.assign(list.strings, op.offset, op.length);
+        draw_text(m_text);
+        break;
+
+      case render_op_type::CONTROL:
+        control(op.ctrl);
+        break;
+
+      case render_op_type::NONE:
+        break;
+    }
   }
-  return true;
 }
 
-bool renderer::on(const signals::parser::change_alignment& evt) {
-  auto align = static_cast<const alignment&>(evt.cast());
+void renderer::change_alignment(alignment align) {
   if (align != m_align) {
     m_log.trace_x("renderer: change_alignment(%i)", static_cast<int>(align));
 
@@ -799,62 +935,26 @@ bool renderer::on(const signals::parser::change_alignment& evt) {
     m_align = align;
     m_blocks[m_align].x = 0.0;
     m_blocks[m_align].y = 0.0;
+    m_spans[m_align].clear();
     m_context->push();
     m_log.trace_x("renderer: push(%i)", static_cast<int>(m_align));
 
     fill_background();
   }
-  return true;
-}
-
-bool renderer::on(const signals::parser::reverse_colors&) {
-  m_log.trace_x("renderer: reverse_colors");
-  m_fg = m_fg + m_bg;
-  m_bg = m_fg - m_bg;
-  m_fg = m_fg - m_bg;
-  return true;
-}
-
-bool renderer::on(const signals::parser::offset_pixel& evt) {
-  m_log.trace_x("renderer: offset_pixel(%f)", evt.cast());
-  m_blocks[m_align].x += evt.cast();
-  return true;
-}
-
-bool renderer::on(const signals::parser::attribute_set& evt) {
-  m_log.trace_x("renderer: attribute_set(%i)", static_cast<int>(evt.cast()));
-  m_attr.set(static_cast<int>(evt.cast()), true);
-  return true;
-}
-
-bool renderer::on(const signals::parser::attribute_unset& evt) {
-  m_log.trace_x("renderer: attribute_unset(%i)", static_cast<int>(evt.cast()));
-  m_attr.set(static_cast<int>(evt.cast()), false);
-  return true;
 }
 
-bool renderer::on(const signals::parser::attribute_toggle& evt) {
-  m_log.trace_x("renderer: attribute_toggle(%i)", static_cast<int>(evt.cast()));
-  m_attr.flip(static_cast<int>(evt.cast()));
-  return true;
-}
-
-bool renderer::on(const signals::parser::action_begin& evt) {
-  auto a = evt.cast();
-  m_log.trace_x("renderer: action_begin(btn=%i, command=%s)", static_cast<int>(a.button), a.command);
+void renderer::action_begin(mousebtn btn, string&& command) {
+  m_log.trace_x("renderer: action_begin(btn=%i, command=%s)", static_cast<int>(btn), command);
   action_block action{};
-  action.button = a.button == mousebtn::NONE ? mousebtn::LEFT : a.button;
+  action.button = btn == mousebtn::NONE ? mousebtn::LEFT : btn;
   action.align = m_align;
   action.start_x = m_blocks.at(m_align).x;
-  action.command = a.command;
+  action.command = forward<string>(command);
   action.active = true;
   m_actions.emplace_back(action);
-  return true;
 }
 
-bool renderer::on(const signals::parser::action_end& evt) {
-  auto btn = evt.cast();
-
+void renderer::action_end(mousebtn btn) {
   /*
    * Iterate actions in reverse and find the FIRST active action that matches
    */
@@ -866,18 +966,9 @@ bool renderer::on(const signals::parser::action_end& evt) {
       break;
     }
   }
-  return true;
-}
-
-bool renderer::on(const signals::parser::text& evt) {
-  auto text = evt.cast();
-  draw_text(text);
-  return true;
 }
 
-bool renderer::on(const signals::parser::control& evt) {
-  auto ctrl = evt.cast();
-
+void renderer::control(controltag ctrl) {
   switch (ctrl) {
     case controltag::R:
       m_bg = m_bar.background;
@@ -891,8 +982,6 @@ bool renderer::on(const signals::parser::control& evt) {
     case controltag::NONE:
       break;
   }
-
-  return true;
 }
 
 POLYBAR_NS_END
@@ -0,0 +1,129 @@
+#include "components/sampler.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "errors.hpp"
+#include "utils/factory.hpp"
+
+POLYBAR_NS
+
+/**
+ * Create instance
+ */
+sampler::make_type sampler::make() {
+  return static_cast<sampler&>(*factory_util::singleton<sampler>());
+}
+
+/**
+ * Get the shared source for the given file, opening it if
+ * nobody is subscribed to it
+ */
+sampler::handle sampler::subscribe(const string& path) {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  for (auto it = m_sources.begin(); it != m_sources.end();) {
+    if (it->second.expired() && it->first != path) {
+      it = m_sources.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  auto& entry = m_sources[path];
+  auto src = entry.lock();
+  if (!src) {
+    src = make_shared<source>(path);
+    entry = src;
+  }
+  return src;
+}
+
+/**
+ * Open file, throws if it does not exist
+ */
+sampler::source::source(string path) : m_path(move(path)) {
+  if ((m_fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC)) == -1) {
+    throw system_error("Failed to open " + m_path);
+  }
+  m_buffer.resize(256);
+}
+
+sampler::source::~source() {
+  if (m_fd != -1) {
+    close(m_fd);
+  }
+}
+
+const string& sampler::source::path() const {
+  return m_path;
+}
+
+/**
+ * Number of times the file was actually read
+ */
+size_t sampler::source::reads() const {
+  return m_reads;
+}
+
+/**
+ * Open the file again, e.g. after the device behind a sysfs
+ * attribute was removed and added back, expects the lock to be held
+ */
+bool sampler::source::reopen() {
+  if (m_fd != -1) {
+    close(m_fd);
+  }
+  m_fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+  return m_fd != -1;
+}
+
+/**
+ * Re-read the file unless the current sample is recent enough,
+ * expects the lock to be held
+ *
+ * A file that went stale is reopened once per sample. Failed reads
+ * leave an empty sample, like `file_util::contents` would
+ */
+void sampler::source::refresh(clock::time_point now, clock::duration max_age) {
+  if (m_reads > 0 && now - m_sampled < max_age) {
+    return;
+  }
+
+  m_length = 0;
+
+  bool reopened{false};
+  if (m_fd == -1) {
+    reopened = true;
+    reopen();
+  }
+
+  // procfs may return less than a full buffer before reaching the end
+  // of the file, so keep reading until pread returns 0
+  ssize_t bytes{0};
+  while (m_fd != -1 && (bytes = pread(m_fd, &m_buffer[m_length], m_buffer.size() - m_length, m_length)) != 0) {
+    if (bytes > 0) {
+      m_length += bytes;
+      if (m_length == m_buffer.size()) {
+        // The buffer keeps its size for the next samples
+        m_buffer.resize(m_buffer.size() * 2);
+      }
+    } else if (errno == EINTR) {
+      continue;
+    } else if ((errno == ENODEV || errno == ESTALE) && !reopened) {
+      reopened = true;
+      m_length = 0;
+      reopen();
+    } else {
+      m_length = 0;
+      break;
+    }
+  }
+
+  m_reads++;
+  m_sampled = now;
+}
+
+POLYBAR_NS_END
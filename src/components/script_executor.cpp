@@ -0,0 +1,576 @@
+#include "components/script_executor.hpp"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <future>
+#include <sstream>
+
+#include "components/eventloop.hpp"
+#include "components/logger.hpp"
+#include "errors.hpp"
+#include "utils/env.hpp"
+#include "utils/factory.hpp"
+
+extern char** environ;
+
+POLYBAR_NS
+
+namespace {
+  // Output beyond this is read and dropped
+  constexpr size_t MAX_OUTPUT{64 * 1024};
+
+  // How often commands without a pidfd are checked for having exited
+  constexpr long REAP_INTERVAL_NS{10 * 1000 * 1000};
+
+  /**
+   * Get a file descriptor that becomes readable once the process exits
+   *
+   * Returns -1 on kernels older than 5.3, in which case the command is
+   * polled with `WNOHANG` instead
+   */
+  int pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+  }
+
+  inline chrono::microseconds to_microseconds(const timeval& tv) {
+    return chrono::seconds{tv.tv_sec} + chrono::microseconds{tv.tv_usec};
+  }
+
+  template <typename Duration>
+  inline double to_milliseconds(Duration d) {
+    return chrono::duration_cast<chrono::duration<double, std::milli>>(d).count();
+  }
+}  // namespace
+
+/**
+ * Create instance
+ */
+script_executor::make_type script_executor::make() {
+  return static_cast<script_executor&>(
+      *factory_util::singleton<script_executor>(eventloop::make_reactor(), logger::make()));
+}
+
+/**
+ * Construct executor
+ */
+script_executor::script_executor(eventloop& loop, const logger& logger) : m_loop(loop), m_log(logger) {
+  if ((m_epoll = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    throw system_error("Failed to create epoll instance");
+  }
+  if ((m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+    close(m_epoll);
+    throw system_error("Failed to create eventfd");
+  }
+  if ((m_reaper = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1) {
+    close(m_wakeup);
+    close(m_epoll);
+    throw system_error("Failed to create timerfd");
+  }
+
+  for (auto fd : {m_wakeup, m_reaper}) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+/**
+ * Deconstruct executor, terminating commands that are still running
+ */
+script_executor::~script_executor() {
+  m_active = false;
+  uint64_t value{1};
+  if (write(m_wakeup, &value, sizeof(value)) == -1) {
+    m_log.trace("script_executor: Failed to wake up dispatcher");
+  }
+
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  if (m_started) {
+    m_loop.remove(m_epoll);
+  }
+
+  for (auto&& it : m_jobs) {
+    auto& j = *it.second;
+    if (j.pid != -1 && !j.exited) {
+      killpg(j.pid, SIGTERM);
+      waitpid(j.pid, nullptr, 0);
+    }
+    unwatch(j.out);
+    unwatch(j.pidfd);
+  }
+
+  close(m_reaper);
+  close(m_wakeup);
+  close(m_epoll);
+}
+
+/**
+ * Set the number of commands that are allowed to run at the same time
+ */
+void script_executor::set_limit(size_t limit) {
+  std::lock_guard<std::mutex> guard(m_lock);
+  m_limit = std::max<size_t>(limit, 1);
+}
+
+/**
+ * Run the command and call `cb` with its result once it exits
+ *
+ * The callback is called from the dispatching thread. Returns a
+ * ticket that can be used to cancel the callback. Statistics are kept
+ * under `key`, which defaults to the command itself; callers that
+ * expand placeholders into the command should pass the unexpanded one
+ */
+size_t script_executor::submit(const string& cmd, callback cb, const string& key) {
+  std::unique_lock<std::mutex> guard(m_lock);
+
+  if (!m_started) {
+    start();
+  }
+
+  auto& j = m_jobs[cmd];
+  if (j) {
+    m_stats[key.empty() ? cmd : key].shared++;
+  } else {
+    j = make_shared<job>();
+    j->cmd = cmd;
+    j->key = key.empty() ? cmd : key;
+    j->submitted = clock::now();
+    m_queue.emplace_back(j);
+  }
+
+  size_t ticket{++m_ticket};
+  j->callbacks.emplace_back(ticket, move(cb));
+  m_tickets.emplace(ticket, j);
+  guard.unlock();
+
+  // Commands are only spawned from the dispatcher
+  uint64_t value{1};
+  if (write(m_wakeup, &value, sizeof(value)) == -1) {
+    m_log.err("script_executor: Failed to wake up dispatcher (%s)", strerror(errno));
+  }
+
+  return ticket;
+}
+
+/**
+ * Drop the callback of the given ticket
+ *
+ * If nobody else waits for the command, it is removed from the queue
+ * or terminated if it already runs. When this returns, the callback
+ * is guaranteed not to be running, unless called from the callback
+ * itself
+ */
+void script_executor::cancel(size_t ticket) {
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto it = m_tickets.find(ticket);
+
+    if (it != m_tickets.end()) {
+      auto j = it->second.lock();
+      m_tickets.erase(it);
+
+      if (j) {
+        auto& cbs = j->callbacks;
+        cbs.erase(std::remove_if(cbs.begin(), cbs.end(), [&](const pair<size_t, callback>& cb) { return cb.first == ticket; }),
+            cbs.end());
+
+        if (cbs.empty() && j->pid == -1) {
+          m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), j), m_queue.end());
+          m_jobs.erase(j->cmd);
+        } else if (cbs.empty() && !j->exited) {
+          killpg(j->pid, SIGTERM);
+        }
+      }
+    }
+  }
+
+  if (m_caller.load() != std::this_thread::get_id()) {
+    std::lock_guard<std::mutex> guard(m_calllock);
+  }
+}
+
+/**
+ * Run the command and wait for its result
+ *
+ * Must not be called from the dispatching thread
+ */
+script_executor::result script_executor::run(const string& cmd) {
+  std::promise<result> promise;
+  auto future = promise.get_future();
+  submit(cmd, [&](const result& res) { promise.set_value(res); });
+  return future.get();
+}
+
+/**
+ * Get the accumulated statistics of the commands submitted with `key`
+ */
+script_executor::stats script_executor::get_stats(const string& key) const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  auto it = m_stats.find(key);
+  return it != m_stats.end() ? it->second : stats{};
+}
+
+/**
+ * Average spawn latency, queueing delay and cpu time of the commands
+ * submitted with `key`
+ */
+string script_executor::report(const string& key) const {
+  auto s = get_stats(key);
+  if (s.runs == 0) {
+    return "no runs";
+  }
+
+  std::ostringstream ss;
+  ss << "runs=" << s.runs << " shared=" << s.shared << " spawn(ms)=" << to_milliseconds(s.spawn / s.runs)
+     << " queued(ms)=" << to_milliseconds(s.queued / s.runs) << " user(ms)=" << to_milliseconds(s.user / s.runs)
+     << " sys(ms)=" << to_milliseconds(s.system / s.runs);
+  return ss.str();
+}
+
+/**
+ * Wait for output or exiting commands, start queued commands and
+ * call the callbacks of the ones that completed
+ *
+ * Returns the number of completed commands
+ */
+size_t script_executor::dispatch(int timeout_ms) {
+  std::array<epoll_event, 16> events;
+  int count{epoll_wait(m_epoll, events.data(), events.size(), timeout_ms)};
+
+  if (count == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    throw system_error("Failed to wait for epoll events");
+  }
+
+  std::unique_lock<std::mutex> guard(m_lock);
+
+  for (int i = 0; i < count; i++) {
+    int fd{events[i].data.fd};
+
+    if (fd == m_wakeup) {
+      uint64_t value;
+      if (read(m_wakeup, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        m_log.err("script_executor: Failed to read eventfd (%s)", strerror(errno));
+      }
+      continue;
+    } else if (fd == m_reaper) {
+      uint64_t value;
+      if (read(m_reaper, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        m_log.err("script_executor: Failed to read timerfd (%s)", strerror(errno));
+      }
+      for (auto&& j : vector<shared_ptr<job>>(m_polled)) {
+        reap(*j, false);
+        complete(j);
+      }
+      continue;
+    }
+
+    auto it = m_fds.find(fd);
+    if (it == m_fds.end()) {
+      continue;
+    }
+
+    auto j = it->second;
+
+    if (fd == j->out) {
+      drain(*j);
+      if (j->eof) {
+        unwatch(j->out);
+        // Usually the command has exited by now, otherwise the
+        // reaper timer picks it up
+        if (j->pidfd == -1) {
+          reap(*j, false);
+        }
+      }
+    } else if (fd == j->pidfd) {
+      reap(*j, false);
+    }
+
+    complete(j);
+  }
+
+  while (m_running < m_limit && !m_queue.empty() && m_active) {
+    auto j = m_queue.front();
+    m_queue.pop_front();
+    spawn(j);
+    complete(j);
+  }
+
+  auto done = move(m_done);
+  m_done.clear();
+
+  // Taken before releasing the lock, so that cancel() can't slip in
+  // between and return while the callbacks are still to be called
+  std::lock_guard<std::mutex> calling(m_calllock);
+  guard.unlock();
+  m_caller = std::this_thread::get_id();
+
+  for (auto&& j : done) {
+    for (auto&& cb : j->callbacks) {
+      cb.second(j->res);
+    }
+  }
+
+  m_caller = std::thread::id{};
+
+  return done.size();
+}
+
+/**
+ * Get the epoll file descriptor, which becomes readable whenever
+ * there is something to dispatch
+ */
+int script_executor::get_file_descriptor() const {
+  return m_epoll;
+}
+
+/**
+ * Start dispatching, either from the event loop or from a separate
+ * thread. Deferred until the first command is submitted so that the
+ * reactor mode setting is known at that point
+ */
+void script_executor::start() {
+  m_started = true;
+
+  if (m_loop.enabled()) {
+    m_loop.add(m_epoll, [this] { dispatch(0); });
+    return;
+  }
+
+  m_thread = std::thread([this] {
+    while (m_active) {
+      try {
+        dispatch();
+      } catch (const exception& err) {
+        m_log.err("script_executor: %s", err.what());
+        break;
+      }
+    }
+  });
+}
+
+/**
+ * Spawn the shell for the command with its output connected to a pipe
+ *
+ * On failure the job is marked as exited with status -1
+ */
+void script_executor::spawn(const shared_ptr<job>& j) {
+  static const string shell{env_util::get("POLYBAR_SHELL", "/bin/sh")};
+
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) {
+    m_log.err("script_executor: Failed to allocate output stream for \"%s\" (%s)", j->cmd, strerror(errno));
+    j->exited = true;
+    return;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, fds[PIPE_WRITE], STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, fds[PIPE_WRITE], STDERR_FILENO);
+
+  // Reset the signals handled by polybar and run the command in its
+  // own process group, so that it can be terminated as a whole
+  sigset_t mask;
+  sigset_t defaults;
+  sigemptyset(&mask);
+  sigemptyset(&defaults);
+  for (auto sig : {SIGINT, SIGQUIT, SIGTERM, SIGUSR1, SIGALRM, SIGPIPE, SIGCHLD}) {
+    sigaddset(&defaults, sig);
+  }
+
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setsigmask(&attr, &mask);
+  posix_spawnattr_setsigdefault(&attr, &defaults);
+  posix_spawnattr_setpgroup(&attr, 0);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+  char* argv[]{const_cast<char*>(shell.c_str()), const_cast<char*>("-c"), const_cast<char*>(j->cmd.c_str()), nullptr};
+
+  auto started = clock::now();
+  int err{posix_spawnp(&j->pid, shell.c_str(), &actions, &attr, argv, environ)};
+  auto spawned = clock::now();
+
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[PIPE_WRITE]);
+
+  if (err != 0) {
+    m_log.err("script_executor: Failed to run \"%s\" (%s)", j->cmd, strerror(err));
+    close(fds[PIPE_READ]);
+    j->pid = -1;
+    j->exited = true;
+    return;
+  }
+
+  m_running++;
+
+  auto& s = m_stats[j->key];
+  s.runs++;
+  s.queued += started - j->submitted;
+  s.spawn += spawned - started;
+
+  fcntl(fds[PIPE_READ], F_SETFL, O_NONBLOCK);
+  j->out = fds[PIPE_READ];
+  watch(j->out, j);
+
+  if (m_use_pidfd && (j->pidfd = pidfd_open(j->pid)) != -1) {
+    watch(j->pidfd, j);
+  } else {
+    m_polled.emplace_back(j);
+    if (m_polled.size() == 1) {
+      poll(true);
+    }
+  }
+
+  m_log.trace("script_executor: Spawned \"%s\" (pid %i) in %.3f ms", j->cmd, j->pid, to_milliseconds(spawned - started));
+}
+
+/**
+ * Read all output that is currently available
+ */
+void script_executor::drain(job& j) {
+  char buffer[4096];
+
+  while (j.out != -1) {
+    auto bytes = read(j.out, buffer, sizeof(buffer));
+
+    if (bytes > 0) {
+      auto keep = std::min(static_cast<size_t>(bytes), MAX_OUTPUT - std::min(MAX_OUTPUT, j.res.output.size()));
+      j.res.output.append(buffer, keep);
+    } else if (bytes == 0) {
+      j.eof = true;
+      break;
+    } else if (errno != EINTR) {
+      break;
+    }
+  }
+}
+
+/**
+ * Collect the exit status and resource usage of the command
+ */
+void script_executor::reap(job& j, bool block) {
+  int status{0};
+  rusage usage{};
+  pid_t pid;
+
+  do {
+    pid = wait4(j.pid, &status, block ? 0 : WNOHANG, &usage);
+  } while (pid == -1 && errno == EINTR);
+
+  if (pid == 0) {
+    return;
+  }
+
+  j.exited = true;
+
+  if (pid == j.pid) {
+    j.res.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    auto& s = m_stats[j.key];
+    s.user += to_microseconds(usage.ru_utime);
+    s.system += to_microseconds(usage.ru_stime);
+  }
+
+  // Pick up what was written right before exiting. Anything written
+  // later by processes that inherited the pipe is ignored
+  drain(j);
+}
+
+/**
+ * Finish the job if the command has exited
+ */
+bool script_executor::complete(const shared_ptr<job>& j) {
+  if (!j->exited) {
+    return false;
+  }
+
+  // Processes that inherited the pipe may keep it open, but nothing
+  // they write is read once the command itself has exited
+  unwatch(j->out);
+  unwatch(j->pidfd);
+
+  auto polled = std::find(m_polled.begin(), m_polled.end(), j);
+  if (polled != m_polled.end()) {
+    m_polled.erase(polled);
+    if (m_polled.empty()) {
+      poll(false);
+    }
+  }
+
+  if (j->pid != -1) {
+    m_running--;
+    m_log.trace("script_executor: \"%s\" (pid %i) exited with status %i", j->cmd, j->pid, j->res.status);
+  }
+
+  auto it = m_jobs.find(j->cmd);
+  if (it != m_jobs.end() && it->second == j) {
+    m_jobs.erase(it);
+  }
+  for (auto&& cb : j->callbacks) {
+    m_tickets.erase(cb.first);
+  }
+
+  m_done.emplace_back(j);
+  return true;
+}
+
+void script_executor::watch(int fd, const shared_ptr<job>& j) {
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    throw system_error("Failed to add fd to epoll set");
+  }
+
+  m_fds[fd] = j;
+}
+
+void script_executor::unwatch(int& fd) {
+  if (fd != -1) {
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    m_fds.erase(fd);
+    close(fd);
+    fd = -1;
+  }
+}
+
+/**
+ * Arm or disarm the timer that polls commands without a pidfd
+ */
+void script_executor::poll(bool enable) {
+  itimerspec spec{};
+  if (enable) {
+    spec.it_value.tv_nsec = REAP_INTERVAL_NS;
+    spec.it_interval.tv_nsec = REAP_INTERVAL_NS;
+  }
+  timerfd_settime(m_reaper, 0, &spec, nullptr);
+}
+
+POLYBAR_NS_END
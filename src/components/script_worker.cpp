@@ -0,0 +1,157 @@
+#include "components/script_worker.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+
+#include "components/logger.hpp"
+#include "utils/io.hpp"
+#include "utils/string.hpp"
+
+POLYBAR_NS
+
+/**
+ * Construct worker, the command is started on the first query
+ */
+script_worker::script_worker(const logger& logger, string name, string request, int request_signal,
+    chrono::duration<double> timeout)
+    : m_log(logger)
+    , m_name(move(name))
+    , m_request(move(request))
+    , m_request_signal(request_signal)
+    , m_timeout(timeout) {}
+
+/**
+ * Ask the worker for new output, (re)starting it first if needed
+ *
+ * Returns true with the reply in `reply`. Returns false if the request
+ * could not be sent, the worker exited or did not reply in time, or
+ * `stopping` was set while waiting
+ */
+bool script_worker::query(const string& exec, int counter, string& reply, const std::atomic<bool>& stopping) {
+  if (!running()) {
+    if (m_command) {
+      m_log.warn("%s: Worker exited with status %i, restarting", m_name, m_command->get_exit_status());
+    }
+    start(exec);
+  }
+
+  if (!request(counter)) {
+    m_log.warn("%s: Failed to send request to worker", m_name);
+    m_command.reset();
+    return false;
+  }
+
+  int fd = m_command->get_stdout(PIPE_READ);
+  auto deadline = chrono::steady_clock::now() + m_timeout;
+
+  while (!stopping) {
+    if (next_line(reply)) {
+      return true;
+    } else if (chrono::steady_clock::now() >= deadline) {
+      m_log.warn("%s: Worker did not reply within %.1fs, restarting", m_name, m_timeout.count());
+      m_command.reset();
+      break;
+    } else if (io_util::poll_read(fd, 25)) {
+      if (!fill(fd)) {
+        break;
+      }
+    } else if (!m_command->is_running()) {
+      break;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Terminate the worker
+ */
+void script_worker::stop() {
+  m_command.reset();
+}
+
+bool script_worker::running() {
+  return m_command && m_command->is_running();
+}
+
+/**
+ * Get the pid of the worker, -1 if it isn't running
+ */
+pid_t script_worker::get_pid() {
+  return running() ? m_command->get_pid() : -1;
+}
+
+void script_worker::start(const string& exec) {
+  m_log.info("%s: Starting worker: \"%s\"", m_name, exec);
+  m_command = command_util::make_command(exec);
+  m_command->exec(false);
+  io_util::set_nonblock(m_command->get_stdout(PIPE_READ));
+  m_buffer.clear();
+}
+
+/**
+ * Send the request line or signal
+ *
+ * Output still buffered doesn't answer this request and is dropped
+ */
+bool script_worker::request(int counter) {
+  m_buffer.clear();
+
+  if (m_request_signal != 0) {
+    return kill(m_command->get_pid(), m_request_signal) == 0;
+  }
+
+  string line{string_util::replace_all(m_request, "%counter%", to_string(counter))};
+
+  // A worker that exited since the last check would raise SIGPIPE,
+  // which is blocked for the write so that it fails with EPIPE instead
+  sigset_t mask;
+  sigset_t prev;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &mask, &prev);
+
+  bool written{m_command->writeline(line) > 0};
+
+  if (!written) {
+    timespec none{};
+    sigtimedwait(&mask, nullptr, &none);
+  }
+  pthread_sigmask(SIG_SETMASK, &prev, nullptr);
+
+  return written;
+}
+
+/**
+ * Append what the worker has written so far to the buffer
+ *
+ * Returns false once its stdout is closed or can't be read
+ */
+bool script_worker::fill(int fd) {
+  char buffer[BUFSIZ];
+  ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+
+  if (bytes > 0) {
+    m_buffer.append(buffer, bytes);
+    return true;
+  }
+  return bytes == -1 && (errno == EAGAIN || errno == EINTR);
+}
+
+/**
+ * Take the first complete line off the buffer
+ */
+bool script_worker::next_line(string& line) {
+  auto end = m_buffer.find('\n');
+  if (end == string::npos) {
+    return false;
+  }
+
+  line = m_buffer.substr(0, end);
+  m_buffer.erase(0, end + 1);
+  return true;
+}
+
+POLYBAR_NS_END
@@ -1,110 +1,199 @@
+#include "components/taskqueue.hpp"
+
 #include <algorithm>
 
-#include "components/taskqueue.hpp"
+#include "components/eventloop.hpp"
 #include "utils/factory.hpp"
 
 POLYBAR_NS
 
 taskqueue::make_type taskqueue::make() {
-  return factory_util::unique<taskqueue>();
+  return factory_util::unique<taskqueue>(eventloop::make());
 }
 
-taskqueue::taskqueue() {
-  m_thread = std::thread([&] {
-    while (m_active) {
-      std::unique_lock<std::mutex> guard(m_lock);
-
-      if (m_deferred.empty()) {
-        m_hold.wait(guard);
-      } else {
-        auto now = deferred::clock::now();
-        auto wait = m_deferred.front()->now + m_deferred.front()->wait;
-        for (auto&& task : m_deferred) {
-          auto when = task->now + task->wait;
-          if (when < wait) {
-            wait = move(when);
-          }
-        }
-        if (wait > now) {
-          m_hold.wait_for(guard, wait - now);
-        }
-      }
-      if (!m_deferred.empty()) {
-        guard.unlock();
-        tick();
-      }
-    }
-  });
-}
+taskqueue::taskqueue(eventloop& loop) : m_loop(loop) {}
 
 taskqueue::~taskqueue() {
-  if (m_active && m_thread.joinable()) {
-    m_active = false;
-    m_hold.notify_all();
+  m_active = false;
+  m_hold.notify_all();
+  if (m_thread.joinable()) {
     m_thread.join();
   }
+  if (m_timer != -1) {
+    m_loop.remove(m_timer);
+  }
 }
 
 void taskqueue::defer(
     string id, deferred::duration ms, deferred::callback fn, deferred::duration offset, size_t count) {
   std::unique_lock<std::mutex> guard(m_lock);
-  deferred::timepoint now{chrono::time_point_cast<deferred::duration>(deferred::clock::now() + move(offset))};
-  m_deferred.emplace_back(make_unique<deferred>(move(id), move(now), move(ms), move(fn), move(count)));
+  schedule(move(id), move(ms), move(fn), move(offset), count);
   guard.unlock();
   m_hold.notify_one();
 }
 
 void taskqueue::defer_unique(
     string id, deferred::duration ms, deferred::callback fn, deferred::duration offset, size_t count) {
-  purge(id);
   std::unique_lock<std::mutex> guard(m_lock);
-  deferred::timepoint now{chrono::time_point_cast<deferred::duration>(deferred::clock::now() + move(offset))};
-  m_deferred.emplace_back(make_unique<deferred>(move(id), move(now), move(ms), move(fn), move(count)));
+  erase(id);
+  schedule(move(id), move(ms), move(fn), move(offset), count);
   guard.unlock();
   m_hold.notify_one();
 }
 
-void taskqueue::tick() {
-  if (!m_lock.try_lock()) {
+bool taskqueue::purge(const string& id) {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return erase(id) > 0;
+}
+
+bool taskqueue::exist(const string& id) {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_ids.find(id) != m_ids.end();
+}
+
+/**
+ * Start dispatching tasks, either from the event loop or from
+ * a separate thread. Deferred until the first task is added so that
+ * the reactor mode setting is known at that point
+ */
+void taskqueue::start() {
+  m_started = true;
+
+  if (m_loop.enabled()) {
+    m_timer = m_loop.add_timer([this] {
+      tick();
+      std::lock_guard<std::mutex> guard(m_lock);
+      rearm();
+    });
     return;
   }
-  std::unique_lock<std::mutex> guard(m_lock, std::adopt_lock);
-  auto now = chrono::time_point_cast<deferred::duration>(deferred::clock::now());
-  vector<pair<deferred::callback, size_t>> cbs;
-  for (auto it = m_deferred.rbegin(); it != m_deferred.rend(); ++it) {
-    auto& task = *it;
-    if (task->now + task->wait > now) {
-      continue;
-    } else if (task->count--) {
-      cbs.emplace_back(make_pair(task->func, task->count));
-      task->now = now;
-    } else {
-      m_deferred.erase(std::remove_if(m_deferred.begin(), m_deferred.end(),
-                           [&](const unique_ptr<deferred>& d) { return d == task; }),
-          m_deferred.end());
+
+  m_thread = std::thread([this] {
+    std::unique_lock<std::mutex> guard(m_lock);
+    while (m_active) {
+      if (m_heap.empty()) {
+        m_hold.wait(guard);
+      } else if (m_heap.front().deadline > deferred::clock::now()) {
+        m_hold.wait_until(guard, m_heap.front().deadline);
+      } else {
+        guard.unlock();
+        tick();
+        guard.lock();
+      }
     }
+  });
+}
+
+/**
+ * Add task, expects the lock to be held
+ */
+void taskqueue::schedule(
+    string&& id, deferred::duration ms, deferred::callback&& fn, deferred::duration offset, size_t count) {
+  if (count == 0) {
+    return;
   }
-  guard.unlock();
-  for (auto&& p : cbs) {
-    p.first(p.second);
+
+  if (!m_started) {
+    start();
   }
+
+  auto now = chrono::time_point_cast<deferred::duration>(deferred::clock::now() + offset);
+  auto handle = ++m_handle;
+  auto task = make_unique<deferred>(move(id), now + ms, ms, move(fn), count);
+
+  push(task->deadline, handle);
+  m_ids.emplace(task->id, handle);
+  m_tasks.emplace(handle, move(task));
+
+  rearm();
 }
 
-bool taskqueue::purge(const string& id) {
-  std::lock_guard<std::mutex> guard(m_lock);
-  return m_deferred.erase(std::remove_if(m_deferred.begin(), m_deferred.end(),
-                              [id](const unique_ptr<deferred>& d) { return d->id == id; }),
-             m_deferred.end()) == m_deferred.end();
+void taskqueue::push(deferred::timepoint deadline, size_t handle) {
+  m_heap.emplace_back(entry{deadline, handle});
+  std::push_heap(m_heap.begin(), m_heap.end(), std::greater<entry>{});
 }
 
-bool taskqueue::exist(const string& id) {
-  std::lock_guard<std::mutex> guard(m_lock);
-  for (const auto& task : m_deferred) {
-    if (task->id == id) {
-      return true;
+/**
+ * Remove all tasks with the given id, expects the lock to be held
+ *
+ * Their heap entries are dropped once they reach the top
+ */
+size_t taskqueue::erase(const string& id) {
+  auto range = m_ids.equal_range(id);
+  size_t count{0};
+  for (auto it = range.first; it != range.second; ++it, ++count) {
+    m_tasks.erase(it->second);
+  }
+  m_ids.erase(range.first, range.second);
+  return count;
+}
+
+/**
+ * Arm the event loop timer for the earliest deadline, expects the lock to be held
+ */
+void taskqueue::rearm() {
+  if (m_timer == -1 || m_heap.empty()) {
+    return;
+  }
+
+  auto delay = m_heap.front().deadline - deferred::clock::now();
+  m_loop.arm(m_timer, chrono::duration_cast<chrono::duration<double>>(delay));
+}
+
+/**
+ * Run all tasks that are due
+ *
+ * Repeated tasks are rescheduled relative to their previous deadline
+ * to keep their cadence. A task that fell behind by a whole interval
+ * is rescheduled relative to now, so that the missed runs don't fire
+ * in a burst
+ */
+void taskqueue::tick() {
+  vector<pair<deferred::callback, size_t>> cbs;
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto now = chrono::time_point_cast<deferred::duration>(deferred::clock::now());
+
+    vector<entry> due;
+    while (!m_heap.empty() && m_heap.front().deadline <= now) {
+      due.emplace_back(m_heap.front());
+      std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<entry>{});
+      m_heap.pop_back();
     }
+
+    for (auto&& e : due) {
+      auto it = m_tasks.find(e.handle);
+      if (it == m_tasks.end() || it->second->deadline != e.deadline) {
+        continue;
+      }
+
+      auto& task = it->second;
+      cbs.emplace_back(task->func, --task->count);
+
+      if (task->count) {
+        task->deadline += task->wait;
+        if (task->deadline <= now) {
+          task->deadline = now + task->wait;
+        }
+        push(task->deadline, e.handle);
+        continue;
+      }
+
+      auto range = m_ids.equal_range(task->id);
+      for (auto id = range.first; id != range.second; ++id) {
+        if (id->second == e.handle) {
+          m_ids.erase(id);
+          break;
+        }
+      }
+      m_tasks.erase(it);
+    }
+  }
+
+  for (auto&& p : cbs) {
+    p.first(p.second);
   }
-  return false;
 }
 
 POLYBAR_NS_END
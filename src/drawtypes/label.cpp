@@ -1,5 +1,6 @@
 #include "drawtypes/label.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <utility>
 
@@ -15,9 +16,10 @@ namespace drawtypes {
    * Here tokens are replaced with values and minlen and maxlen properties are applied
    */
   string label::get() const {
-    const size_t len = string_util::char_len(m_tokenized);
+    const string& tokenized = this->tokenized();
+    const size_t len = string_util::char_len(tokenized);
     if (len >= m_minlen) {
-      string text = m_tokenized;
+      string text = tokenized;
       if (m_maxlen > 0 && len > m_maxlen) {
         if (m_ellipsis) {
           text = string_util::utf8_truncate(std::move(text), m_maxlen - 3) + "...";
@@ -43,11 +45,11 @@ namespace drawtypes {
         --left_fill_len;
       }
     }
-    return string(left_fill_len, ' ') + m_tokenized + string(right_fill_len, ' ');
+    return string(left_fill_len, ' ') + tokenized + string(right_fill_len, ' ');
   }
 
   label::operator bool() {
-    return !m_tokenized.empty();
+    return !tokenized().empty();
   }
 
   label_t label::clone() {
@@ -61,43 +63,120 @@ namespace drawtypes {
   }
 
   void label::clear() {
-    m_tokenized.clear();
+    m_cleared = true;
+    m_dirty = true;
   }
 
   void label::reset_tokens() {
-    m_tokenized = m_text;
+    if (m_custom) {
+      compile(m_text);
+    }
+    for (auto&& slot : m_slots) {
+      slot.bound = false;
+    }
+    m_cleared = false;
+    m_dirty = true;
   }
 
   void label::reset_tokens(const string& tokenized) {
-    m_tokenized = tokenized;
+    compile(tokenized);
+    m_custom = true;
   }
 
   bool label::has_token(const string& token) const {
-    return m_tokenized.find(token) != string::npos;
+    return tokenized().find(token) != string::npos;
   }
 
+  /**
+   * Bind the value to the slots of the token that are still unbound
+   *
+   * Each slot applies the min/max settings of its own token definition
+   */
   void label::replace_token(const string& token, string replacement) {
-    if (!has_token(token)) {
+    if (m_cleared) {
       return;
     }
 
-    for (auto&& tok : m_tokens) {
-      string repl{replacement};
-      if (token == tok.token) {
-        if (tok.max != 0_z && string_util::char_len(repl) > tok.max) {
-          repl = string_util::utf8_truncate(std::move(repl), tok.max) + tok.suffix;
-        } else if (tok.min != 0_z && repl.length() < tok.min) {
-          repl.insert(0_z, tok.min - repl.length(), tok.zpad ? '0' : ' ');
-        }
+    for (auto&& slot : m_slots) {
+      const auto& tok = m_tokens[slot.token];
+      if (slot.bound || token != tok.token) {
+        continue;
+      }
 
-        /*
-         * Only replace first occurence, so that the proper token objects can be used
-         */
-        m_tokenized = string_util::replace(m_tokenized, token, move(repl));
+      slot.value.assign(replacement);
+      if (tok.max != 0_z && string_util::char_len(slot.value) > tok.max) {
+        slot.value = string_util::utf8_truncate(std::move(slot.value), tok.max) + tok.suffix;
+      } else if (tok.min != 0_z && slot.value.length() < tok.min) {
+        slot.value.insert(0_z, tok.min - slot.value.length(), tok.zpad ? '0' : ' ');
       }
+      slot.bound = true;
+      m_dirty = true;
     }
   }
 
+  /**
+   * Split the text into literals and a slot for every token occurrence
+   *
+   * Each token definition takes the first occurrence that isn't taken by
+   * a definition before it, the same one a replacement in order would hit
+   */
+  void label::compile(const string& text) {
+    m_literals.clear();
+    m_slots.clear();
+
+    // Start of each occurrence and the index of its token definition
+    vector<pair<size_t, size_t>> found;
+    for (size_t i = 0; i < m_tokens.size(); i++) {
+      const string& name{m_tokens[i].token};
+      size_t start{text.find(name)};
+
+      while (start != string::npos && std::any_of(found.begin(), found.end(), [&](const pair<size_t, size_t>& f) {
+        return f.first < start + name.size() && start < f.first + m_tokens[f.second].token.size();
+      })) {
+        start = text.find(name, start + 1);
+      }
+      if (start != string::npos) {
+        found.emplace_back(start, i);
+      }
+    }
+    std::sort(found.begin(), found.end());
+
+    size_t pos{0};
+    for (auto&& f : found) {
+      m_literals.emplace_back(text.substr(pos, f.first - pos));
+      m_slots.emplace_back(slot{f.second, ""s, false});
+      pos = f.first + m_tokens[f.second].token.size();
+    }
+    m_literals.emplace_back(text.substr(pos));
+
+    m_custom = false;
+    m_cleared = false;
+    m_dirty = true;
+  }
+
+  /**
+   * Get the text with the bound values filled in
+   *
+   * Unbound slots keep their token
+   */
+  const string& label::tokenized() const {
+    if (!m_dirty) {
+      return m_tokenized;
+    }
+
+    m_tokenized.clear();
+    if (!m_cleared) {
+      for (size_t i = 0; i < m_slots.size(); i++) {
+        m_tokenized += m_literals[i];
+        m_tokenized += m_slots[i].bound ? m_slots[i].value : m_tokens[m_slots[i].token].token;
+      }
+      m_tokenized += m_literals.back();
+    }
+    m_dirty = false;
+
+    return m_tokenized;
+  }
+
   void label::replace_defined_values(const label_t& label) {
     if (!label->m_foreground.empty()) {
       m_foreground = label->m_foreground;
@@ -1,9 +1,20 @@
 #include "events/signal_emitter.hpp"
+
+#include <algorithm>
+
+#include "errors.hpp"
 #include "utils/factory.hpp"
 
 POLYBAR_NS
 
-signal_receivers_t g_signal_receivers;
+namespace signals {
+  namespace detail {
+    size_t next_signal_id() {
+      static std::atomic<size_t> counter{0};
+      return counter++;
+    }
+  }  // namespace detail
+}  // namespace signals
 
 /**
  * Create instance
@@ -12,4 +23,119 @@ signal_emitter::make_type signal_emitter::make() {
   return static_cast<signal_emitter&>(*factory_util::singleton<signal_emitter>());
 }
 
+/**
+ * Construct emitter with an empty receiver table
+ */
+signal_emitter::signal_emitter() {
+  for (auto&& receivers : m_receivers) {
+    receivers.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * Get the current receivers of the signal with the given id
+ */
+const signal_emitter::receiver_list* signal_emitter::lookup(size_t id) const {
+  if (id >= max_signals) {
+    return nullptr;
+  }
+  return m_receivers[id].load();
+}
+
+/**
+ * Add receiver to a copy of the list for the given id,
+ * after all receivers with the same or higher priority
+ */
+void signal_emitter::attach(signal_receiver_interface* s, size_t id, void* sink) {
+  if (id >= max_signals) {
+    throw application_error("Too many signal types (max " + to_string(max_signals) + ")");
+  }
+
+  auto current = lookup(id);
+  receiver_list receivers{current != nullptr ? *current : receiver_list{}};
+
+  auto pos = std::upper_bound(receivers.begin(), receivers.end(), s->priority(),
+      [](signal_receiver_interface::prio p, const shared_ptr<receiver_entry>& item) { return p < item->priority; });
+  receivers.insert(pos, make_shared<receiver_entry>(s->priority(), s, sink));
+
+  publish(id, move(receivers));
+}
+
+/**
+ * Remove receiver from a copy of the list for the given id
+ */
+void signal_emitter::detach(signal_receiver_interface* d, size_t id) {
+  auto current = lookup(id);
+  if (current == nullptr) {
+    return;
+  }
+
+  receiver_list receivers{*current};
+  receivers.erase(std::remove_if(receivers.begin(), receivers.end(),
+                      [&](const shared_ptr<receiver_entry>& item) {
+                        if (item->receiver != d) {
+                          return false;
+                        }
+                        item->detached.store(true, std::memory_order_release);
+                        return true;
+                      }),
+      receivers.end());
+
+  publish(id, move(receivers));
+}
+
+/**
+ * Make the given list visible to emitters
+ *
+ * Readers might still iterate the previous list, so it is retired
+ * until no emit is running
+ */
+void signal_emitter::publish(size_t id, receiver_list&& receivers) {
+  auto previous = move(m_current[id]);
+  m_current[id] = make_unique<const receiver_list>(forward<receiver_list>(receivers));
+  m_receivers[id].store(m_current[id].get());
+
+  if (previous) {
+    m_retired.emplace_back(move(previous));
+    m_retiring.store(true);
+  }
+
+  reclaim_locked();
+}
+
+/**
+ * Free the retired lists if no emit is running, called by the
+ * last emit to finish
+ *
+ * Gives up if a writer holds the lock, it reclaims the lists itself
+ */
+void signal_emitter::reclaim() const {
+  std::unique_lock<std::mutex> guard(m_lock, std::try_to_lock);
+  if (guard.owns_lock()) {
+    reclaim_locked();
+  }
+}
+
+/**
+ * Free the retired lists if no emit is running
+ *
+ * Emits increment the reader count before loading a list, so once
+ * the count is seen at zero after a list was replaced, no emit can
+ * get hold of that list anymore
+ */
+void signal_emitter::reclaim_locked() const {
+  if (m_readers.load() == 0) {
+    m_retired.clear();
+    m_retiring.store(false);
+  }
+}
+
+/**
+ * Get the number of lists waiting to be freed
+ */
+size_t signal_emitter::retired() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_retired.size();
+}
+
 POLYBAR_NS_END
@@ -1,7 +1,14 @@
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
 #include <vector>
 
 #include "common.hpp"
@@ -15,6 +22,35 @@ using namespace std;
 #define IPC_CHANNEL_PREFIX "/tmp/polybar_mqueue."
 #endif
 
+#ifndef IPC_SOCKET_PREFIX
+#define IPC_SOCKET_PREFIX "/tmp/polybar_ipc."
+#endif
+
+/**
+ * Time to wait for the reply to a message sent over the socket
+ */
+static constexpr int reply_timeout_ms{5000};
+
+/**
+ * Thrown for arguments that don't form a message, with the expected usage
+ */
+class usage_error : public invalid_argument {
+ public:
+  using invalid_argument::invalid_argument;
+};
+
+/**
+ * Connection to a single polybar process
+ *
+ * Uses the ipc socket if the process has one and falls back to the fifo
+ */
+struct channel {
+  string pid;
+  string path;
+  bool socket{false};
+  int fd{-1};
+};
+
 void display(const string& msg) {
   fprintf(stdout, "%s\n", msg.c_str());
 }
@@ -25,7 +61,7 @@ void log(int exit_code, const string& msg) {
 }
 
 void usage(const string& parameters) {
-  fprintf(stderr, "Usage: polybar-msg [-p pid] %s\n", parameters.c_str());
+  fprintf(stderr, "Usage: polybar-msg [-p pid] [-s] %s\n", parameters.c_str());
   exit(127);
 }
 
@@ -41,6 +77,152 @@ bool validate_type(const string& type) {
   return (type == "action" || type == "cmd" || type == "hook");
 }
 
+/**
+ * Build the message for the given type and payload arguments
+ */
+string make_message(vector<string> args) {
+  if (args.size() < 2) {
+    throw usage_error("<command=(action|cmd|hook)> <payload> [...]");
+  } else if (!validate_type(args[0])) {
+    throw invalid_argument("\"" + args[0] + "\" is not a valid type.");
+  }
+
+  string ipc_type{args[0]};
+  args.erase(args.begin());
+  string ipc_payload{args[0]};
+  args.erase(args.begin());
+
+  // Check hook specific args
+  if (ipc_type == "hook") {
+    if (args.size() != 1) {
+      throw usage_error("hook <module-name> <hook-index>");
+    } else if (ipc_payload.find("module/") != 0) {
+      ipc_payload = "module/" + ipc_payload + args[0];
+    } else {
+      ipc_payload += args[0];
+    }
+  }
+
+  return ipc_type + ':' + ipc_payload;
+}
+
+/**
+ * Split a line read in streaming mode into message arguments
+ *
+ * Action and command payloads may contain spaces, hooks take a module
+ * name and an index
+ */
+vector<string> split_line(const string& line) {
+  vector<string> args;
+  size_t pos{line.find_first_not_of(" \t")};
+
+  while (pos != string::npos) {
+    bool rest{args.size() == 1 && args[0] != "hook"};
+    size_t end{rest ? line.find_last_not_of(" \t") + 1 : line.find_first_of(" \t", pos)};
+    args.emplace_back(line.substr(pos, end == string::npos ? string::npos : end - pos));
+    pos = end == string::npos ? end : line.find_first_not_of(" \t", end);
+  }
+
+  return args;
+}
+
+/**
+ * Find the channels of all running processes, or of the one with the given pid
+ *
+ * Channels left behind by processes that are no longer running are removed
+ */
+vector<channel> find_channels(const string& pid) {
+  std::map<string, channel> channels;
+
+  for (auto&& prefix : {IPC_CHANNEL_PREFIX, IPC_SOCKET_PREFIX}) {
+    bool socket{strcmp(prefix, IPC_SOCKET_PREFIX) == 0};
+
+    for (auto&& path : file_util::glob(prefix + "*"s)) {
+      string owner{path.substr(strlen(prefix))};
+
+      if (!file_util::exists("/proc/" + owner)) {
+        remove_pipe(path);
+      } else if (pid.empty() || pid == owner) {
+        auto& chan = channels[owner];
+        if (socket || chan.path.empty()) {
+          chan = channel{owner, path, socket};
+        }
+      }
+    }
+  }
+
+  vector<channel> result;
+  for (auto&& chan : channels) {
+    result.emplace_back(chan.second);
+  }
+  return result;
+}
+
+/**
+ * Open the channel, returns false if nobody is listening on it anymore
+ */
+bool open_channel(channel& chan) {
+  if (!chan.socket) {
+    chan.fd = open(chan.path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    return chan.fd != -1;
+  }
+
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, chan.path.c_str(), sizeof(addr.sun_path) - 1);
+
+  chan.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (chan.fd == -1 || connect(chan.fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    if (chan.fd != -1) {
+      close(chan.fd);
+      chan.fd = -1;
+    }
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Send the message over the channel
+ *
+ * Returns the error reported by polybar or an empty string on success
+ */
+string send_message(const channel& chan, const string& message) {
+  if (!chan.socket) {
+    // Fifo messages are separated by newlines
+    string line{message + '\n'};
+    if (write(chan.fd, line.c_str(), line.size()) == -1) {
+      return strerror(errno);
+    }
+    return "";
+  }
+
+  if (send(chan.fd, message.c_str(), message.size(), MSG_NOSIGNAL) == -1) {
+    return strerror(errno);
+  }
+
+  struct pollfd fds {
+    chan.fd, POLLIN, 0
+  };
+  if (poll(&fds, 1, reply_timeout_ms) <= 0) {
+    return "No reply";
+  }
+
+  char reply[BUFSIZ];
+  ssize_t bytes{recv(chan.fd, reply, sizeof(reply), 0)};
+  if (bytes <= 0) {
+    return bytes == 0 ? "Connection closed" : strerror(errno);
+  }
+
+  string response{reply, static_cast<size_t>(bytes)};
+  if (response == "ok") {
+    return "";
+  } else if (response.compare(0, 7, "error: ") == 0) {
+    return response.substr(7);
+  }
+  return response;
+}
+
 int main(int argc, char** argv) {
   const int E_NO_CHANNELS{2};
   const int E_MESSAGE_TYPE{3};
@@ -49,85 +231,108 @@ int main(int argc, char** argv) {
   const int E_WRITE{6};
 
   vector<string> args{argv + 1, argv + argc};
-  string::size_type p;
-  int pid{0};
+  string pid;
+  bool stream{false};
 
   // If -p <pid> is passed, check if the process is running and that
-  // a valid channel pipe is available
-  if (args.size() >= 2 && args[0].compare(0, 2, "-p") == 0) {
-    if (!file_util::exists("/proc/" + args[1])) {
-      log(E_INVALID_PID, "No process with pid " + args[1]);
-    } else if (!file_util::exists(IPC_CHANNEL_PREFIX + args[1])) {
-      log(E_INVALID_CHANNEL, "No channel available for pid " + args[1]);
-    }
+  // a valid channel is available
+  while (!args.empty() && args[0].compare(0, 1, "-") == 0) {
+    if (args[0] == "-p" && args.size() >= 2) {
+      if (!file_util::exists("/proc/" + args[1])) {
+        log(E_INVALID_PID, "No process with pid " + args[1]);
+      } else if (!file_util::exists(IPC_CHANNEL_PREFIX + args[1]) && !file_util::exists(IPC_SOCKET_PREFIX + args[1])) {
+        log(E_INVALID_CHANNEL, "No channel available for pid " + args[1]);
+      }
 
-    pid = strtol(args[1].c_str(), nullptr, 10);
-    args.erase(args.begin());
-    args.erase(args.begin());
+      pid = to_string(strtol(args[1].c_str(), nullptr, 10));
+      args.erase(args.begin(), args.begin() + 2);
+    } else if (args[0] == "-s" || args[0] == "--stream") {
+      stream = true;
+      args.erase(args.begin());
+    } else {
+      break;
+    }
   }
 
-  // Validate args
   auto help = find_if(args.begin(), args.end(), [](string a) { return a == "-h" || a == "--help"; }) != args.end();
-  if (help || args.size() < 2) {
+  if (help || (stream && !args.empty())) {
     usage("<command=(action|cmd|hook)> <payload> [...]");
-  } else if (!validate_type(args[0])) {
-    log(E_MESSAGE_TYPE, "\"" + args[0] + "\" is not a valid type.");
   }
 
-  string ipc_type{args[0]};
-  args.erase(args.begin());
-  string ipc_payload{args[0]};
-  args.erase(args.begin());
+  string message;
 
-  // Check hook specific args
-  if (ipc_type == "hook") {
-    if (args.size() != 1) {
-      usage("hook <module-name> <hook-index>");
-    } else if ((p = ipc_payload.find("module/")) != 0) {
-      ipc_payload = "module/" + ipc_payload + args[0];
-      args.erase(args.begin());
-    } else {
-      ipc_payload += args[0];
-      args.erase(args.begin());
+  if (!stream) {
+    try {
+      message = make_message(args);
+    } catch (const usage_error& err) {
+      usage(err.what());
+    } catch (const invalid_argument& err) {
+      log(E_MESSAGE_TYPE, err.what());
     }
   }
 
-  // Get availble channel pipes
-  auto pipes = file_util::glob(IPC_CHANNEL_PREFIX + "*"s);
+  auto channels = find_channels(pid);
 
-  // Remove stale channel files without a running parent process
-  for (auto it = pipes.rbegin(); it != pipes.rend(); it++) {
-    if ((p = it->rfind('.')) == string::npos) {
-      continue;
-    } else if (!file_util::exists("/proc/" + it->substr(p + 1))) {
-      remove_pipe(*it);
-      pipes.erase(remove(pipes.begin(), pipes.end(), *it), pipes.end());
-    } else if (pid && to_string(pid) != it->substr(p + 1)) {
-      pipes.erase(remove(pipes.begin(), pipes.end(), *it), pipes.end());
+  for (auto it = channels.begin(); it != channels.end();) {
+    if (open_channel(*it)) {
+      it++;
+    } else if (!it->socket) {
+      remove_pipe(it->path);
+      it = channels.erase(it);
+    } else {
+      it = channels.erase(it);
     }
   }
 
-  if (pipes.empty()) {
+  if (channels.empty()) {
     log(E_NO_CHANNELS, "No active ipc channels");
   }
 
   int exit_status = 127;
 
-  // Write message to each available channel or match
-  // against pid if one was defined
-  for (auto&& channel : pipes) {
-    try {
-      file_descriptor fd(channel, O_WRONLY | O_NONBLOCK);
-      string payload{ipc_type + ':' + ipc_payload};
-      if (write(fd, payload.c_str(), payload.size()) != -1) {
-        display("Successfully wrote \"" + payload + "\" to \"" + channel + "\"");
+  if (!stream) {
+    // Write message to each available channel or match
+    // against pid if one was defined
+    for (auto&& chan : channels) {
+      string error{send_message(chan, message)};
+      if (error.empty()) {
+        display("Successfully wrote \"" + message + "\" to \"" + chan.path + "\"");
         exit_status = 0;
       } else {
-        log(E_WRITE, "Failed to write \"" + payload + "\" to \"" + channel + "\" (err: " + strerror(errno) + ")");
+        log(E_WRITE, "Failed to write \"" + message + "\" to \"" + chan.path + "\" (err: " + error + ")");
       }
-    } catch (const exception& err) {
-      remove_pipe(channel);
     }
+  } else {
+    // Keep the channels open and send one message per line of input
+    exit_status = 0;
+    string line;
+
+    while (getline(cin, line)) {
+      if (line.find_first_not_of(" \t") == string::npos) {
+        continue;
+      }
+
+      try {
+        message = make_message(split_line(line));
+      } catch (const invalid_argument& err) {
+        fprintf(stderr, "polybar-msg: Invalid message \"%s\" (%s)\n", line.c_str(), err.what());
+        exit_status = E_MESSAGE_TYPE;
+        continue;
+      }
+
+      for (auto&& chan : channels) {
+        string error{send_message(chan, message)};
+        if (!error.empty()) {
+          fprintf(stderr, "polybar-msg: Failed to write \"%s\" to \"%s\" (err: %s)\n", message.c_str(),
+              chan.path.c_str(), error.c_str());
+          exit_status = E_WRITE;
+        }
+      }
+    }
+  }
+
+  for (auto&& chan : channels) {
+    close(chan.fd);
   }
 
   return exit_status;
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "components/bar.hpp"
 #include "components/command_line.hpp"
 #include "components/config.hpp"
@@ -101,8 +103,8 @@ int main(int argc, char** argv) {
     if (!cli->has(0)) {
       cli->usage();
       return EXIT_FAILURE;
-    } else if (cli->has(1)) {
-      fprintf(stderr, "Unrecognized argument \"%s\"\n", cli->get(1).c_str());
+    } else if (cli->has(1) && (cli->has("stdout") || cli->has("png"))) {
+      fprintf(stderr, "Only a single bar can be written to stdout or saved as snapshot\n");
       cli->usage();
       return EXIT_FAILURE;
     }
@@ -119,6 +121,18 @@ int main(int argc, char** argv) {
     config_parser parser{logger, move(confpath), cli->get(0)};
     config::make_type conf = parser.parse();
 
+    // All bars are drawn by this process, the first one is the one the config was loaded for
+    vector<string> bars{conf.section()};
+    for (size_t i = 1; cli->has(i); i++) {
+      string section{"bar/" + cli->get(i)};
+      if (!conf.has_section(section)) {
+        throw application_error("Undefined bar: " + cli->get(i));
+      } else if (std::find(bars.begin(), bars.end(), section) != bars.end()) {
+        throw application_error("Bar passed more than once: " + cli->get(i));
+      }
+      bars.emplace_back(move(section));
+    }
+
     //==================================================
     // Dump requested data
     //==================================================
@@ -127,7 +141,7 @@ int main(int argc, char** argv) {
       return EXIT_SUCCESS;
     }
     if (cli->has("print-wmname")) {
-      printf("%s\n", bar::make(true)->settings().wmname.c_str());
+      printf("%s\n", bar::make(conf.section(), true)->settings()->wmname.c_str());
       return EXIT_SUCCESS;
     }
 
@@ -144,7 +158,7 @@ int main(int argc, char** argv) {
       config_watch = inotify_util::make_watch(conf.filepath());
     }
 
-    auto ctrl = controller::make(move(ipc), move(config_watch));
+    auto ctrl = controller::make(bars, move(ipc), move(config_watch));
 
     if (!ctrl->run(cli->has("stdout"), cli->get("png"))) {
       reload = true;
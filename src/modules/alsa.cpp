@@ -18,7 +18,7 @@ using namespace alsa;
 namespace modules {
   template class module<alsa_module>;
 
-  alsa_module::alsa_module(const bar_settings& bar, string name_) : event_module<alsa_module>(bar, move(name_)) {
+  alsa_module::alsa_module(bar_settings_t bar, string name_) : event_module<alsa_module>(bar, move(name_)) {
     // Load configuration values
     m_mapped = m_conf.get(name(), "mapped", m_mapped);
     m_interval = m_conf.get(name(), "interval", m_interval);
@@ -201,19 +201,26 @@ namespace modules {
     return m_builder->flush();
   }
 
-  bool alsa_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_BAR_VOLUME) {
-      builder->node(m_bar_volume->output(m_volume));
-    } else if (tag == TAG_RAMP_VOLUME && (!m_headphones || !*m_ramp_headphones)) {
-      builder->node(m_ramp_volume->get_by_percentage(m_volume));
-    } else if (tag == TAG_RAMP_VOLUME && m_headphones && *m_ramp_headphones) {
-      builder->node(m_ramp_headphones->get_by_percentage(m_volume));
-    } else if (tag == TAG_LABEL_VOLUME) {
-      builder->node(m_label_volume);
-    } else if (tag == TAG_LABEL_MUTED) {
-      builder->node(m_label_muted);
-    } else {
-      return false;
+  bool alsa_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_BAR_VOLUME:
+        builder->node(m_bar_volume->output(m_volume));
+        break;
+      case ID_RAMP_VOLUME:
+        if (m_headphones && *m_ramp_headphones) {
+          builder->node(m_ramp_headphones->get_by_percentage(m_volume));
+        } else {
+          builder->node(m_ramp_volume->get_by_percentage(m_volume));
+        }
+        break;
+      case ID_LABEL_VOLUME:
+        builder->node(m_label_volume);
+        break;
+      case ID_LABEL_MUTED:
+        builder->node(m_label_muted);
+        break;
+      default:
+        return false;
     }
     return true;
   }
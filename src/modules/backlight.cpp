@@ -6,6 +6,7 @@
 #include "modules/meta/base.inl"
 #include "utils/file.hpp"
 #include "utils/math.hpp"
+#include "utils/procfs.hpp"
 
 POLYBAR_NS
 
@@ -16,14 +17,14 @@ namespace modules {
     if (!file_util::exists(path)) {
       throw module_error("The file '" + path + "' does not exist");
     }
-    m_path = path;
+    m_src = sampler::make().subscribe(path);
   }
 
   float backlight_module::brightness_handle::read() const {
-    return std::strtof(file_util::contents(m_path).c_str(), nullptr);
+    return static_cast<float>(sampler::make().read(m_src, sampler::clock::duration::zero(), procfs_util::parse_integer));
   }
 
-  backlight_module::backlight_module(const bar_settings& bar, string name_)
+  backlight_module::backlight_module(bar_settings_t bar, string name_)
       : inotify_module<backlight_module>(bar, move(name_)) {
     auto card = m_conf.get(name(), "card");
 
@@ -58,10 +59,7 @@ namespace modules {
 
     // Add inotify watch
     watch(path_backlight_val);
-  }
-
-  void backlight_module::idle() {
-    sleep(75ms);
+    m_idle_interval = 75ms;
   }
 
   bool backlight_module::on_event(inotify_event* event) {
@@ -99,15 +97,19 @@ namespace modules {
     return m_builder->flush();
   }
 
-  bool backlight_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_BAR) {
-      builder->node(m_progressbar->output(m_percentage));
-    } else if (tag == TAG_RAMP) {
-      builder->node(m_ramp->get_by_percentage(m_percentage));
-    } else if (tag == TAG_LABEL) {
-      builder->node(m_label);
-    } else {
-      return false;
+  bool backlight_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_BAR:
+        builder->node(m_progressbar->output(m_percentage));
+        break;
+      case ID_RAMP:
+        builder->node(m_ramp->get_by_percentage(m_percentage));
+        break;
+      case ID_LABEL:
+        builder->node(m_label);
+        break;
+      default:
+        return false;
     }
     return true;
   }
@@ -5,6 +5,7 @@
 #include "drawtypes/ramp.hpp"
 #include "utils/file.hpp"
 #include "utils/math.hpp"
+#include "utils/procfs.hpp"
 #include "utils/string.hpp"
 
 #include "modules/meta/base.inl"
@@ -23,7 +24,7 @@ namespace modules {
   /**
    * Bootstrap module by setting up required components
    */
-  battery_module::battery_module(const bar_settings& bar, string name_)
+  battery_module::battery_module(bar_settings_t bar, string name_)
       : inotify_module<battery_module>(bar, move(name_)) {
     // Load configuration values
     m_fullat = math_util::min(m_conf.get(name(), "full-at", m_fullat), 100);
@@ -33,12 +34,15 @@ namespace modules {
     auto path_adapter = string_util::replace(PATH_ADAPTER, "%adapter%", m_conf.get(name(), "adapter", "ADP1"s)) + "/";
     auto path_battery = string_util::replace(PATH_BATTERY, "%battery%", m_conf.get(name(), "battery", "BAT0"s)) + "/";
 
+    auto& values = sampler::make();
+
     // Make state reader
     if (file_util::exists((m_fstate = path_adapter + "online"))) {
-      m_state_reader = make_unique<state_reader>([=] { return file_util::contents(m_fstate).compare(0, 1, "1") == 0; });
+      m_state_src = values.subscribe(m_fstate);
+      m_state_reader = make_unique<state_reader>([this] { return read_prefix(m_state_src, "1"); });
     } else if (file_util::exists((m_fstate = path_battery + "status"))) {
-      m_state_reader =
-          make_unique<state_reader>([=] { return file_util::contents(m_fstate).compare(0, 8, "Charging") == 0; });
+      m_state_src = values.subscribe(m_fstate);
+      m_state_reader = make_unique<state_reader>([this] { return read_prefix(m_state_src, "Charging"); });
     } else {
       throw module_error("No suitable way to get current charge state");
     }
@@ -50,9 +54,12 @@ namespace modules {
       throw module_error("No suitable way to get max capacity value");
     }
 
-    m_capacity_reader = make_unique<capacity_reader>([=] {
-      auto cap_now = std::strtoul(file_util::contents(m_fcapnow).c_str(), nullptr, 10);
-      auto cap_max = std::strtoul(file_util::contents(m_fcapfull).c_str(), nullptr, 10);
+    m_capnow_src = values.subscribe(m_fcapnow);
+    m_capfull_src = values.subscribe(m_fcapfull);
+
+    m_capacity_reader = make_unique<capacity_reader>([this] {
+      auto cap_now = read_value(m_capnow_src);
+      auto cap_max = read_value(m_capfull_src);
       return math_util::percentage(cap_now, 0UL, cap_max);
     });
 
@@ -63,11 +70,14 @@ namespace modules {
       throw module_error("No suitable way to get current charge rate value");
     }
 
+    m_rate_src = values.subscribe(m_frate);
+    m_voltage_src = values.subscribe(m_fvoltage);
+
     m_rate_reader = make_unique<rate_reader>([this] {
-      unsigned long rate{std::strtoul(file_util::contents(m_frate).c_str(), nullptr, 10)};
-      unsigned long volt{std::strtoul(file_util::contents(m_fvoltage).c_str(), nullptr, 10) / 1000UL};
-      unsigned long now{std::strtoul(file_util::contents(m_fcapnow).c_str(), nullptr, 10)};
-      unsigned long max{std::strtoul(file_util::contents(m_fcapfull).c_str(), nullptr, 10)};
+      unsigned long rate{read_value(m_rate_src)};
+      unsigned long volt{read_value(m_voltage_src) / 1000UL};
+      unsigned long now{read_value(m_capnow_src)};
+      unsigned long max{read_value(m_capfull_src)};
       unsigned long cap{read(*m_state_reader) ? max - now : now};
 
       if (rate && volt && cap) {
@@ -88,13 +98,13 @@ namespace modules {
 
       // if the rate we found was the current, calculate power (P = I*V)
       if (string_util::contains(m_frate, "current_now")) {
-        unsigned long current{std::strtoul(file_util::contents(m_frate).c_str(), nullptr, 10)};
-        unsigned long voltage{std::strtoul(file_util::contents(m_fvoltage).c_str(), nullptr, 10)};
+        unsigned long current{read_value(m_rate_src)};
+        unsigned long voltage{read_value(m_voltage_src)};
 
         consumption = ((voltage / 1000.0) * (current /  1000.0)) / 1e6;
       // if it was power, just use as is
       } else {
-        unsigned long power{std::strtoul(file_util::contents(m_frate).c_str(), nullptr, 10)};
+        unsigned long power{read_value(m_rate_src)};
 
         consumption = power / 1e6;
       }
@@ -176,7 +186,7 @@ namespace modules {
   }
 
   /**
-   * Idle between polling inotify watches for events.
+   * Called between polling inotify watches for events.
    *
    * If the defined interval has been reached, trigger a manual
    * poll in case the inotify events aren't fired.
@@ -184,7 +194,7 @@ namespace modules {
    * This fallback is needed because some systems won't
    * report inotify events for files on sysfs.
    */
-  void battery_module::idle() {
+  void battery_module::fallback_poll() {
     if (m_interval.count() > 0) {
       auto now = chrono::system_clock::now();
       if (chrono::duration_cast<decltype(m_interval)>(now - m_lastpoll) > m_interval) {
@@ -193,8 +203,6 @@ namespace modules {
         read(*m_capacity_reader);
       }
     }
-
-    this->inotify_module::idle();
   }
 
   /**
@@ -260,23 +268,31 @@ namespace modules {
   /**
    * Generate module output using defined drawtypes
    */
-  bool battery_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_ANIMATION_CHARGING) {
-      builder->node(m_animation_charging->get());
-    } else if (tag == TAG_ANIMATION_DISCHARGING) {
-      builder->node(m_animation_discharging->get());
-    } else if (tag == TAG_BAR_CAPACITY) {
-      builder->node(m_bar_capacity->output(clamp_percentage(m_percentage, m_state)));
-    } else if (tag == TAG_RAMP_CAPACITY) {
-      builder->node(m_ramp_capacity->get_by_percentage(clamp_percentage(m_percentage, m_state)));
-    } else if (tag == TAG_LABEL_CHARGING) {
-      builder->node(m_label_charging);
-    } else if (tag == TAG_LABEL_DISCHARGING) {
-      builder->node(m_label_discharging);
-    } else if (tag == TAG_LABEL_FULL) {
-      builder->node(m_label_full);
-    } else {
-      return false;
+  bool battery_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_ANIMATION_CHARGING:
+        builder->node(m_animation_charging->get());
+        break;
+      case ID_ANIMATION_DISCHARGING:
+        builder->node(m_animation_discharging->get());
+        break;
+      case ID_BAR_CAPACITY:
+        builder->node(m_bar_capacity->output(clamp_percentage(m_percentage, m_state)));
+        break;
+      case ID_RAMP_CAPACITY:
+        builder->node(m_ramp_capacity->get_by_percentage(clamp_percentage(m_percentage, m_state)));
+        break;
+      case ID_LABEL_CHARGING:
+        builder->node(m_label_charging);
+        break;
+      case ID_LABEL_DISCHARGING:
+        builder->node(m_label_discharging);
+        break;
+      case ID_LABEL_FULL:
+        builder->node(m_label_full);
+        break;
+      default:
+        return false;
     }
 
     return true;
@@ -338,6 +354,24 @@ namespace modules {
     return {buffer};
   }
 
+  /**
+   * Read a numeric sysfs attribute
+   *
+   * Always takes a fresh sample since reads are triggered by
+   * inotify events on the very same files
+   */
+  unsigned long battery_module::read_value(const sampler::handle& src) const {
+    return sampler::make().read(src, sampler::clock::duration::zero(), [](const char* data, size_t len) {
+      return static_cast<unsigned long>(procfs_util::parse_integer(data, len));
+    });
+  }
+
+  bool battery_module::read_prefix(const sampler::handle& src, const char* prefix) const {
+    return sampler::make().read(src, sampler::clock::duration::zero(), [&](const char* data, size_t len) {
+      return procfs_util::starts_with(data, len, prefix);
+    });
+  }
+
   /**
    * Subthread runner that emits update events to refresh <animation-charging>
    * or <animation-discharging> in case they are used. Note, that it is ok to
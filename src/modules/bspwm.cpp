@@ -40,7 +40,7 @@ namespace {
 namespace modules {
   template class module<bspwm_module>;
 
-  bspwm_module::bspwm_module(const bar_settings& bar, string name_) : event_module<bspwm_module>(bar, move(name_)) {
+  bspwm_module::bspwm_module(bar_settings_t bar, string name_) : event_module<bspwm_module>(bar, move(name_)) {
     auto socket_path = bspwm_util::get_socket_path();
 
     if (!file_util::exists(socket_path)) {
@@ -154,227 +154,250 @@ namespace modules {
     return m_subscriber->peek(1);
   }
 
+  int bspwm_module::event_fd() const {
+    return m_subscriber ? m_subscriber->get_file_descriptor() : -1;
+  }
+
   bool bspwm_module::update() {
     if (!m_subscriber) {
       return false;
     }
 
-    string data{m_subscriber->receive(BUFSIZ)};
+    m_pending += m_subscriber->receive(BUFSIZ);
     bool result = false;
 
-    for (auto&& status_line : string_util::split(data, '\n')) {
+    // Reports may be split across reads, keep the incomplete tail around
+    size_t pos{0};
+    size_t eol;
+    while ((eol = m_pending.find('\n', pos)) != string::npos) {
       // Need to return true if ANY of the handle_status calls
       // return true
-      result = this->handle_status(status_line) || result;
+      result = this->handle_status(&m_pending[pos], eol - pos) || result;
+      pos = eol + 1;
     }
+    m_pending.erase(0, pos);
 
     return result;
   }
 
-  bool bspwm_module::handle_status(string& data) {
-    if (data.empty()) {
+  bool bspwm_module::handle_status(const char* data, size_t len) {
+    if (len == 0) {
       return false;
     }
 
     size_t prefix_len{strlen(BSPWM_STATUS_PREFIX)};
-    if (data.compare(0, prefix_len, BSPWM_STATUS_PREFIX) != 0) {
-      m_log.err("%s: Unknown status '%s'", name(), data);
+    if (len < prefix_len || strncmp(data, BSPWM_STATUS_PREFIX, prefix_len) != 0) {
+      m_log.err("%s: Unknown status '%s'", name(), string{data, len});
       return false;
     }
 
-    string_util::hash_type hash;
-    if ((hash = string_util::hash(data)) == m_hash) {
+    if (!m_status.parse(data + prefix_len, len - prefix_len)) {
       return false;
     }
 
-    m_hash = hash;
-
-    size_t pos;
+    m_log.info("%s: Parsing socket data: %s", name(), string{data, len});
 
-    // Extract the string for the defined monitor
-    if (m_pinworkspaces) {
-      const auto needle_active = ":M" + m_bar.monitor->name + ":";
-      const auto needle_inactive = ":m" + m_bar.monitor->name + ":";
+    return rebuild();
+  }
 
-      if ((pos = data.find(BSPWM_STATUS_PREFIX)) != string::npos) {
-        data = data.replace(pos, prefix_len, ":");
-      }
-      if ((pos = data.find(needle_active)) != string::npos) {
-        data.erase(0, pos + 1);
-      }
-      if ((pos = data.find(needle_inactive)) != string::npos) {
-        data.erase(0, pos + 1);
-      }
-      if ((pos = data.find(":m", 1)) != string::npos) {
-        data.erase(pos);
-      }
-      if ((pos = data.find(":M", 1)) != string::npos) {
-        data.erase(pos);
+  /**
+   * Update the monitors and labels from the parsed status
+   *
+   * Monitors and workspaces whose revision didn't change since the
+   * last report keep their labels. Returns false if none of the shown
+   * monitors changed
+   */
+  bool bspwm_module::rebuild() {
+    vector<const bspwm_util::monitor_status*> shown;
+    for (auto&& status : m_status.monitors()) {
+      if (!m_pinworkspaces || status.name == m_bar.monitor->name) {
+        shown.emplace_back(&status);
       }
-    } else if ((pos = data.find(BSPWM_STATUS_PREFIX)) != string::npos) {
-      data = data.replace(pos, prefix_len, ":");
-    } else {
-      return false;
+    }
+    if (m_pinworkspaces && shown.empty() && !m_status.monitors().empty()) {
+      shown.emplace_back(&m_status.monitors().front());
     }
 
-    m_log.info("%s: Parsing socket data: %s", name(), data);
-
-    m_monitors.clear();
+    vector<unique_ptr<bspwm_monitor>> previous;
+    previous.swap(m_monitors);
 
+    bool changed{previous.size() != shown.size()};
     size_t workspace_n{0U};
 
-    for (auto&& tag : string_util::split(data, ':')) {
-      auto value = tag.substr(1);
-      auto mode_flag = mode::NONE;
-      unsigned int workspace_mask{0U};
+    for (size_t i = 0; i < shown.size(); i++) {
+      const auto& status = *shown[i];
+      auto mon = i < previous.size() ? move(previous[i]) : factory_util::unique<bspwm_monitor>();
 
-      if (tag[0] == 'm' || tag[0] == 'M') {
-        m_monitors.emplace_back(factory_util::unique<bspwm_monitor>());
-        m_monitors.back()->name = value;
+      if (mon->revision != status.revision || mon->first_index != workspace_n) {
+        changed = true;
 
-        if (m_monitorlabel) {
-          m_monitors.back()->label = m_monitorlabel->clone();
-          m_monitors.back()->label->replace_token("%name%", value);
+        if (m_monitorlabel && (!mon->label || mon->name != status.name)) {
+          mon->label = m_monitorlabel->clone();
+          mon->label->replace_token("%name%", status.name);
         }
-      }
-
-      switch (tag[0]) {
-        case 'm':
-          m_monitors.back()->focused = false;
-          break;
-        case 'M':
-          m_monitors.back()->focused = true;
-          break;
-        case 'F':
-          workspace_mask = make_mask(state::FOCUSED, state::EMPTY);
-          break;
-        case 'O':
-          workspace_mask = make_mask(state::FOCUSED, state::OCCUPIED);
-          break;
-        case 'U':
-          workspace_mask = make_mask(state::FOCUSED, state::URGENT);
-          break;
-        case 'f':
-          workspace_mask = make_mask(state::EMPTY);
-          break;
-        case 'o':
-          workspace_mask = make_mask(state::OCCUPIED);
-          break;
-        case 'u':
-          workspace_mask = make_mask(state::URGENT);
-          break;
-        case 'L':
-          switch (value[0]) {
-            case 0:
-              break;
-            case 'M':
-              mode_flag = mode::LAYOUT_MONOCLE;
-              break;
-            case 'T':
-              mode_flag = mode::LAYOUT_TILED;
-              break;
-            default:
-              m_log.warn("%s: Undefined L => '%s'", name(), value);
-          }
-          break;
 
-        case 'T':
-          switch (value[0]) {
-            case 0:
-              break;
-            case 'T':
-              break;
-            case '=':
-              mode_flag = mode::STATE_FULLSCREEN;
-              break;
-            case 'F':
-              mode_flag = mode::STATE_FLOATING;
-              break;
-            case 'P':
-              mode_flag = mode::STATE_PSEUDOTILED;
-              break;
-            default:
-              m_log.warn("%s: Undefined T => '%s'", name(), value);
-          }
-          break;
-
-        case 'G':
-          if (!m_monitors.back()->focused) {
-            break;
-          }
+        mon->name = status.name;
+        mon->focused = status.focused;
+        mon->revision = status.revision;
+        mon->first_index = workspace_n;
+        mon->modes.clear();
+        add_modes(*mon, status);
+
+        if (m_formatter->has(TAG_LABEL_STATE)) {
+          vector<bspwm_workspace> workspaces;
+          workspaces.reserve(status.desktops.size());
+
+          for (size_t j = 0; j < status.desktops.size(); j++) {
+            const auto& desktop = status.desktops[j];
+            size_t index{workspace_n + j + 1};
+
+            if (j < mon->workspaces.size() && mon->workspaces[j].revision == desktop.revision &&
+                mon->workspaces[j].index == index) {
+              workspaces.emplace_back(move(mon->workspaces[j]));
+              continue;
+            }
 
-          for (size_t i = 0U; i < value.length(); i++) {
-            switch (value[i]) {
-              case 0:
+            unsigned int mask{0U};
+            switch (desktop.flag) {
+              case 'F':
+                mask = make_mask(state::FOCUSED, state::EMPTY);
                 break;
-              case 'L':
-                mode_flag = mode::NODE_LOCKED;
+              case 'O':
+                mask = make_mask(state::FOCUSED, state::OCCUPIED);
                 break;
-              case 'S':
-                mode_flag = mode::NODE_STICKY;
+              case 'U':
+                mask = make_mask(state::FOCUSED, state::URGENT);
                 break;
-              case 'P':
-                mode_flag = mode::NODE_PRIVATE;
+              case 'f':
+                mask = make_mask(state::EMPTY);
                 break;
-              case 'M':
-                mode_flag = mode::NODE_MARKED;
+              case 'o':
+                mask = make_mask(state::OCCUPIED);
+                break;
+              case 'u':
+                mask = make_mask(state::URGENT);
                 break;
-              default:
-                m_log.warn("%s: Undefined G => '%s'", name(), value.substr(i, 1));
             }
 
-            if (mode_flag != mode::NONE && !m_modelabels.empty()) {
-              m_monitors.back()->modes.emplace_back(m_modelabels.find(mode_flag)->second->clone());
-            }
+            workspaces.emplace_back(bspwm_workspace{
+                mask, make_workspace_label(mask, desktop.name, status.focused, index), desktop.revision, index});
           }
-          continue;
 
-        default:
-          m_log.warn("%s: Undefined tag => '%s'", name(), tag.substr(0, 1));
-          continue;
+          mon->workspaces.swap(workspaces);
+        }
       }
 
-      if (!m_monitors.back()) {
-        m_log.warn("%s: No monitor created", name());
-        continue;
+      if (m_formatter->has(TAG_LABEL_STATE)) {
+        workspace_n += status.desktops.size();
       }
 
-      if (workspace_mask && m_formatter->has(TAG_LABEL_STATE)) {
-        auto icon = m_icons->get(value, DEFAULT_ICON, m_fuzzy_match);
-        auto label = m_statelabels.at(workspace_mask)->clone();
+      m_monitors.emplace_back(move(mon));
+    }
 
-        if (!m_monitors.back()->focused) {
-          if (m_statelabels[make_mask(state::DIMMED)]) {
-            label->replace_defined_values(m_statelabels[make_mask(state::DIMMED)]);
-          }
-          if (workspace_mask & make_mask(state::EMPTY)) {
-            label->replace_defined_values(m_statelabels[make_mask(state::DIMMED, state::EMPTY)]);
-          }
-          if (workspace_mask & make_mask(state::OCCUPIED)) {
-            label->replace_defined_values(m_statelabels[make_mask(state::DIMMED, state::OCCUPIED)]);
-          }
-          if (workspace_mask & make_mask(state::FOCUSED)) {
-            label->replace_defined_values(m_statelabels[make_mask(state::DIMMED, state::FOCUSED)]);
-          }
-          if (workspace_mask & make_mask(state::URGENT)) {
-            label->replace_defined_values(m_statelabels[make_mask(state::DIMMED, state::URGENT)]);
-          }
-        }
+    return changed;
+  }
 
-        label->reset_tokens();
-        label->replace_token("%name%", value);
-        label->replace_token("%icon%", icon->get());
-        label->replace_token("%index%", to_string(++workspace_n));
+  /**
+   * Create the mode labels for the layout, state and flags of the monitor
+   */
+  void bspwm_module::add_modes(bspwm_monitor& mon, const bspwm_util::monitor_status& status) const {
+    if (m_modelabels.empty()) {
+      return;
+    }
 
-        m_monitors.back()->workspaces.emplace_back(workspace_mask, move(label));
+    const auto add = [&](mode mode_flag) {
+      if (mode_flag != mode::NONE) {
+        mon.modes.emplace_back(m_modelabels.find(mode_flag)->second->clone());
       }
+    };
+
+    switch (status.layout.empty() ? '\0' : status.layout[0]) {
+      case '\0':
+        break;
+      case 'M':
+        add(mode::LAYOUT_MONOCLE);
+        break;
+      case 'T':
+        add(mode::LAYOUT_TILED);
+        break;
+      default:
+        m_log.warn("%s: Undefined L => '%s'", name(), status.layout);
+    }
+
+    switch (status.state.empty() ? '\0' : status.state[0]) {
+      case '\0':
+      case 'T':
+        break;
+      case '=':
+        add(mode::STATE_FULLSCREEN);
+        break;
+      case 'F':
+        add(mode::STATE_FLOATING);
+        break;
+      case 'P':
+        add(mode::STATE_PSEUDOTILED);
+        break;
+      default:
+        m_log.warn("%s: Undefined T => '%s'", name(), status.state);
+    }
 
-      if (mode_flag != mode::NONE && !m_modelabels.empty()) {
-        m_monitors.back()->modes.emplace_back(m_modelabels.find(mode_flag)->second->clone());
+    if (!status.focused) {
+      return;
+    }
+
+    for (auto&& flag : status.flags) {
+      switch (flag) {
+        case 'L':
+          add(mode::NODE_LOCKED);
+          break;
+        case 'S':
+          add(mode::NODE_STICKY);
+          break;
+        case 'P':
+          add(mode::NODE_PRIVATE);
+          break;
+        case 'M':
+          add(mode::NODE_MARKED);
+          break;
+        default:
+          m_log.warn("%s: Undefined G => '%c'", name(), flag);
       }
     }
+  }
 
-    return true;
+  label_t bspwm_module::make_workspace_label(unsigned int mask, const string& ws_name, bool focused, size_t index) const {
+    auto icon = m_icons->get(ws_name, DEFAULT_ICON, m_fuzzy_match);
+    auto label = m_statelabels.at(mask)->clone();
+
+    if (!focused) {
+      const auto dim = [&](unsigned int dimmed) {
+        auto it = m_statelabels.find(dimmed);
+        if (it != m_statelabels.end() && it->second) {
+          label->replace_defined_values(it->second);
+        }
+      };
+
+      dim(make_mask(state::DIMMED));
+      if (mask & make_mask(state::EMPTY)) {
+        dim(make_mask(state::DIMMED, state::EMPTY));
+      }
+      if (mask & make_mask(state::OCCUPIED)) {
+        dim(make_mask(state::DIMMED, state::OCCUPIED));
+      }
+      if (mask & make_mask(state::FOCUSED)) {
+        dim(make_mask(state::DIMMED, state::FOCUSED));
+      }
+      if (mask & make_mask(state::URGENT)) {
+        dim(make_mask(state::DIMMED, state::URGENT));
+      }
+    }
+
+    label->reset_tokens();
+    label->replace_token("%name%", ws_name);
+    label->replace_token("%icon%", icon->get());
+    label->replace_token("%index%", to_string(index));
+
+    return label;
   }
 
   string bspwm_module::get_output() {
@@ -388,11 +411,11 @@ namespace modules {
     return output;
   }
 
-  bool bspwm_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_MONITOR) {
+  bool bspwm_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL_MONITOR) {
       builder->node(m_monitors[m_index]->label);
       return true;
-    } else if (tag == TAG_LABEL_STATE && !m_monitors[m_index]->workspaces.empty()) {
+    } else if (id == ID_LABEL_STATE && !m_monitors[m_index]->workspaces.empty()) {
       size_t workspace_n{0U};
 
       if (m_scroll) {
@@ -401,7 +424,7 @@ namespace modules {
       }
 
       for (auto&& ws : m_monitors[m_index]->workspaces) {
-        if (ws.second.get()) {
+        if (ws.label.get()) {
           if(workspace_n != 0 && *m_labelseparator) {
             builder->node(m_labelseparator);
           }
@@ -409,12 +432,12 @@ namespace modules {
           workspace_n++;
 
           if (m_click) {
-            builder->cmd(mousebtn::LEFT, sstream() << EVENT_CLICK << m_index << "+" << workspace_n, ws.second);
+            builder->cmd(mousebtn::LEFT, sstream() << EVENT_CLICK << m_index << "+" << workspace_n, ws.label);
           } else {
-            builder->node(ws.second);
+            builder->node(ws.label);
           }
 
-          if (m_inlinemode && m_monitors[m_index]->focused && check_mask(ws.first, bspwm_state::FOCUSED)) {
+          if (m_inlinemode && m_monitors[m_index]->focused && check_mask(ws.mask, bspwm_state::FOCUSED)) {
             for (auto&& mode : m_monitors[m_index]->modes) {
               builder->node(mode);
             }
@@ -428,7 +451,7 @@ namespace modules {
       }
 
       return workspace_n > 0;
-    } else if (tag == TAG_LABEL_MODE && !m_inlinemode && m_monitors[m_index]->focused &&
+    } else if (id == ID_LABEL_MODE && !m_inlinemode && m_monitors[m_index]->focused &&
                !m_monitors[m_index]->modes.empty()) {
       int modes_n = 0;
 
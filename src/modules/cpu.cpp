@@ -1,6 +1,3 @@
-#include <fstream>
-#include <istream>
-
 #include "modules/cpu.hpp"
 
 #include "drawtypes/label.hpp"
@@ -15,11 +12,13 @@ POLYBAR_NS
 namespace modules {
   template class module<cpu_module>;
 
-  cpu_module::cpu_module(const bar_settings& bar, string name_) : timer_module<cpu_module>(bar, move(name_)) {
+  cpu_module::cpu_module(bar_settings_t bar, string name_) : timer_module<cpu_module>(bar, move(name_)) {
     m_interval = m_conf.get<decltype(m_interval)>(name(), "interval", 1s);
 
     m_ramp_padding = m_conf.get<decltype(m_ramp_padding)>(name(), "ramp-coreload-spacing", 1);
 
+    m_stat = sampler::make().subscribe(PATH_CPU_INFO);
+
     m_formatter->add(DEFAULT_FORMAT, TAG_LABEL, {TAG_LABEL, TAG_BAR_LOAD, TAG_RAMP_LOAD, TAG_RAMP_LOAD_PER_CORE});
 
     // warmup cpu times
@@ -80,58 +79,43 @@ namespace modules {
     return true;
   }
 
-  bool cpu_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL) {
-      builder->node(m_label);
-    } else if (tag == TAG_BAR_LOAD) {
-      builder->node(m_barload->output(m_total));
-    } else if (tag == TAG_RAMP_LOAD) {
-      builder->node(m_rampload->get_by_percentage(m_total));
-    } else if (tag == TAG_RAMP_LOAD_PER_CORE) {
-      auto i = 0;
-      for (auto&& load : m_load) {
-        if (i++ > 0) {
-          builder->space(m_ramp_padding);
+  bool cpu_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_LABEL:
+        builder->node(m_label);
+        break;
+      case ID_BAR_LOAD:
+        builder->node(m_barload->output(m_total));
+        break;
+      case ID_RAMP_LOAD:
+        builder->node(m_rampload->get_by_percentage(m_total));
+        break;
+      case ID_RAMP_LOAD_PER_CORE: {
+        auto i = 0;
+        for (auto&& load : m_load) {
+          if (i++ > 0) {
+            builder->space(m_ramp_padding);
+          }
+          builder->node(m_rampload_core->get_by_percentage(load));
         }
-        builder->node(m_rampload_core->get_by_percentage(load));
+        builder->node(builder->flush());
+        break;
       }
-      builder->node(builder->flush());
-    } else {
-      return false;
+      default:
+        return false;
     }
     return true;
   }
 
   bool cpu_module::read_values() {
     m_cputimes_prev.swap(m_cputimes);
-    m_cputimes.clear();
 
-    try {
-      std::ifstream in(PATH_CPU_INFO);
-      string str;
-
-      while (std::getline(in, str) && str.compare(0, 3, "cpu") == 0) {
-        // skip line with accumulated value
-        if (str.compare(0, 4, "cpu ") == 0) {
-          continue;
-        }
-
-        auto values = string_util::split(str, ' ');
-
-        m_cputimes.emplace_back(new cpu_time);
-        m_cputimes.back()->user = std::stoull(values[1], nullptr, 10);
-        m_cputimes.back()->nice = std::stoull(values[2], nullptr, 10);
-        m_cputimes.back()->system = std::stoull(values[3], nullptr, 10);
-        m_cputimes.back()->idle = std::stoull(values[4], nullptr, 10);
-        m_cputimes.back()->steal = std::stoull(values[8], nullptr, 10);
-        m_cputimes.back()->total = m_cputimes.back()->user + m_cputimes.back()->nice + m_cputimes.back()->system +
-                                   m_cputimes.back()->idle + m_cputimes.back()->steal;
-      }
-    } catch (const std::ios_base::failure& e) {
-      m_log.err("Failed to read CPU values (what: %s)", e.what());
-    }
+    // Accept samples taken by other cpu modules within half an interval
+    auto max_age = chrono::duration_cast<sampler::clock::duration>(m_interval / 2);
 
-    return !m_cputimes.empty();
+    return sampler::make().read(m_stat, max_age, [&](const char* data, size_t len) {
+      return procfs_util::parse_stat(data, len, m_cputimes) > 0;
+    });
   }
 
   float cpu_module::get_load(size_t core) const {
@@ -144,10 +128,10 @@ namespace modules {
     auto& last = m_cputimes[core];
     auto& prev = m_cputimes_prev[core];
 
-    auto last_idle = last->idle;
-    auto prev_idle = prev->idle;
+    auto last_idle = last.idle;
+    auto prev_idle = prev.idle;
 
-    auto diff = last->total - prev->total;
+    auto diff = last.total - prev.total;
 
     if (diff == 0) {
       return 0;
@@ -12,7 +12,7 @@ POLYBAR_NS
 namespace modules {
   template class module<date_module>;
 
-  date_module::date_module(const bar_settings& bar, string name_) : timer_module<date_module>(bar, move(name_)) {
+  date_module::date_module(bar_settings_t bar, string name_) : timer_module<date_module>(bar, move(name_)) {
     if (!m_bar.locale.empty()) {
       datetime_stream.imbue(std::locale(m_bar.locale.c_str()));
     }
@@ -36,8 +36,9 @@ namespace modules {
     if (m_formatter->has(TAG_DATE)) {
       m_log.warn("%s: The format tag `<date>` is deprecated, use `<label>` instead.", name());
 
-      m_formatter->get(DEFAULT_FORMAT)->value =
-          string_util::replace_all(m_formatter->get(DEFAULT_FORMAT)->value, TAG_DATE, TAG_LABEL);
+      auto format = m_formatter->get(DEFAULT_FORMAT);
+      format->value = string_util::replace_all(format->value, TAG_DATE, TAG_LABEL);
+      format->compile();
     }
 
     if (m_formatter->has(TAG_LABEL)) {
@@ -111,17 +112,19 @@ namespace modules {
     return true;
   }
 
-  bool date_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL) {
-      if (!m_dateformat_alt.empty() || !m_timeformat_alt.empty()) {
-        builder->cmd(mousebtn::LEFT, EVENT_TOGGLE);
-        builder->node(m_label);
-        builder->cmd_close();
-      } else {
-        builder->node(m_label);
-      }
-    } else {
-      return false;
+  bool date_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_LABEL:
+        if (!m_dateformat_alt.empty() || !m_timeformat_alt.empty()) {
+          builder->cmd(mousebtn::LEFT, EVENT_TOGGLE);
+          builder->node(m_label);
+          builder->cmd_close();
+        } else {
+          builder->node(m_label);
+        }
+        break;
+      default:
+        return false;
     }
 
     return true;
@@ -25,7 +25,7 @@ namespace modules {
    * Bootstrap the module by reading config values and
    * setting up required components
    */
-  fs_module::fs_module(const bar_settings& bar, string name_) : timer_module<fs_module>(bar, move(name_)) {
+  fs_module::fs_module(bar_settings_t bar, string name_) : timer_module<fs_module>(bar, move(name_)) {
     m_mountpoints = m_conf.get_list(name(), "mount");
     m_remove_unmounted = m_conf.get(name(), "remove-unmounted", m_remove_unmounted);
     m_fixed = m_conf.get(name(), "fixed-values", m_fixed);
@@ -147,16 +147,16 @@ namespace modules {
   /**
    * Output content using configured format tags
    */
-  bool fs_module::build(builder* builder, const string& tag) const {
+  bool fs_module::build_tag(builder* builder, int id, const string&) const {
     auto& mount = m_mounts[m_index];
 
-    if (tag == TAG_BAR_FREE) {
+    if (id == ID_BAR_FREE) {
       builder->node(m_barfree->output(mount->percentage_free));
-    } else if (tag == TAG_BAR_USED) {
+    } else if (id == ID_BAR_USED) {
       builder->node(m_barused->output(mount->percentage_used));
-    } else if (tag == TAG_RAMP_CAPACITY) {
+    } else if (id == ID_RAMP_CAPACITY) {
       builder->node(m_rampcapacity->get_by_percentage(mount->percentage_free));
-    } else if (tag == TAG_LABEL_MOUNTED) {
+    } else if (id == ID_LABEL_MOUNTED) {
       m_labelmounted->reset_tokens();
       m_labelmounted->replace_token("%mountpoint%", mount->mountpoint);
       m_labelmounted->replace_token("%type%", mount->type);
@@ -170,7 +170,7 @@ namespace modules {
       m_labelmounted->replace_token(
           "%used%", string_util::filesize(mount->bytes_used, m_fixed ? 2 : 0, m_fixed, m_bar.locale));
       builder->node(m_labelmounted);
-    } else if (tag == TAG_LABEL_UNMOUNTED) {
+    } else if (id == ID_LABEL_UNMOUNTED) {
       m_labelunmounted->reset_tokens();
       m_labelunmounted->replace_token("%mountpoint%", mount->mountpoint);
       builder->node(m_labelunmounted);
@@ -14,7 +14,7 @@ namespace modules {
   /**
    * Construct module
    */
-  github_module::github_module(const bar_settings& bar, string name_)
+  github_module::github_module(bar_settings_t bar, string name_)
       : timer_module<github_module>(bar, move(name_)), m_http(http_util::make_downloader()) {
     m_accesstoken = m_conf.get(name(), "token");
     m_user = m_conf.get(name(), "user", ""s);
@@ -119,16 +119,17 @@ namespace modules {
   /**
    * Build module content
    */
-  bool github_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL) {
-      builder->node(m_label);
-      return true;
-    } else if (tag == TAG_LABEL_OFFLINE) {
-      builder->node(m_label_offline);
-      return true;
+  bool github_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_LABEL:
+        builder->node(m_label);
+        return true;
+      case ID_LABEL_OFFLINE:
+        builder->node(m_label_offline);
+        return true;
+      default:
+        return false;
     }
-
-    return false;
   }
 }  // namespace modules
 
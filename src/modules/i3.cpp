@@ -1,5 +1,7 @@
 #include <sys/socket.h>
 
+#include <algorithm>
+
 #include "drawtypes/iconset.hpp"
 #include "drawtypes/label.hpp"
 #include "modules/i3.hpp"
@@ -13,7 +15,7 @@ POLYBAR_NS
 namespace modules {
   template class module<i3_module>;
 
-  i3_module::i3_module(const bar_settings& bar, string name_) : event_module<i3_module>(bar, move(name_)) {
+  i3_module::i3_module(bar_settings_t bar, string name_) : event_module<i3_module>(bar, move(name_)) {
     auto socket_path = i3ipc::get_socketpath();
 
     if (!file_util::exists(socket_path)) {
@@ -65,6 +67,9 @@ namespace modules {
     }
 
     try {
+      if (m_formatter->has(TAG_LABEL_STATE)) {
+        m_ipc->on_workspace_event = [this](const i3ipc::workspace_event_t& evt) { on_workspace_event(evt); };
+      }
       if (m_modelabel) {
         m_ipc->on_mode_event = [this](const i3ipc::mode_t& mode) {
           m_modeactive = (mode.change != DEFAULT_MODE);
@@ -106,6 +111,8 @@ namespace modules {
         m_log.warn("%s: Attempting to reconnect socket (reason: %s)", name(), err.what());
         m_ipc->connect_event_socket(true);
         m_log.info("%s: Reconnecting socket succeeded", name());
+        // Events might have been missed while disconnected
+        m_resync = true;
       } catch (const exception& err) {
         m_log.err("%s: Failed to reconnect socket (reason: %s)", name(), err.what());
       }
@@ -113,6 +120,10 @@ namespace modules {
     }
   }
 
+  int i3_module::event_fd() const {
+    return m_ipc ? m_ipc->get_event_socket_fd() : -1;
+  }
+
   bool i3_module::update() {
     /*
      * update only populates m_workspaces and those are only needed when
@@ -121,67 +132,139 @@ namespace modules {
     if (!m_formatter->has(TAG_LABEL_STATE)) {
       return true;
     }
-    m_workspaces.clear();
-    i3_util::connection_t ipc;
 
     try {
-      vector<shared_ptr<i3_util::workspace_t>> workspaces;
-
-      if (m_pinworkspaces) {
-        workspaces = i3_util::workspaces(ipc, m_bar.monitor->name);
-      } else {
-        workspaces = i3_util::workspaces(ipc);
+      if (m_resync) {
+        resync();
       }
+    } catch (const exception& err) {
+      m_log.err("%s: %s", name(), err.what());
+      return false;
+    }
 
-      if (m_indexsort) {
-        sort(workspaces.begin(), workspaces.end(), i3_util::ws_numsort);
+    vector<const i3_util::workspace_state*> workspaces;
+    for (auto&& ws : m_model.workspaces()) {
+      if (!m_pinworkspaces || ws.output == m_bar.monitor->name) {
+        workspaces.emplace_back(&ws);
       }
+    }
 
-      for (auto&& ws : workspaces) {
-        state ws_state{state::NONE};
+    if (m_indexsort) {
+      std::stable_sort(workspaces.begin(), workspaces.end(), [](auto a, auto b) { return a->num < b->num; });
+    }
 
-        if (ws->focused) {
-          ws_state = state::FOCUSED;
-        } else if (ws->urgent) {
-          ws_state = state::URGENT;
-        } else if (ws->visible) {
-          ws_state = state::VISIBLE;
-        } else {
-          ws_state = state::UNFOCUSED;
-        }
+    // Labels of workspaces that didn't change since the last update are reused
+    vector<unique_ptr<workspace>> previous;
+    previous.swap(m_workspaces);
 
-        string ws_name{ws->name};
+    for (auto&& ws : workspaces) {
+      auto it = find_if(previous.begin(), previous.end(),
+          [&](const unique_ptr<workspace>& w) { return w && w->name == ws->name && w->revision == ws->revision; });
 
-        // Remove workspace numbers "0:"
-        if (m_strip_wsnumbers) {
-          ws_name.erase(0, string_util::find_nth(ws_name, 0, ":", 1) + 1);
-        }
+      if (it != previous.end()) {
+        m_workspaces.emplace_back(move(*it));
+      } else {
+        m_workspaces.emplace_back(make_workspace(*ws));
+      }
+    }
 
-        // Trim leading and trailing whitespace
-        ws_name = string_util::trim(move(ws_name), ' ');
+    return true;
+  }
 
-        auto icon = m_icons->get(ws->name, DEFAULT_WS_ICON, m_fuzzy_match);
-        auto label = m_statelabels.find(ws_state)->second->clone();
+  /**
+   * Apply workspace event payloads to the cached model
+   *
+   * Events the model can't handle by itself (init, rename, ...)
+   * trigger a full GET_WORKSPACES resync on the next update
+   */
+  void i3_module::on_workspace_event(const i3ipc::workspace_event_t& evt) {
+    if (m_resync || !evt.current) {
+      m_resync = true;
+      return;
+    }
 
-        label->reset_tokens();
-        label->replace_token("%output%", ws->output);
-        label->replace_token("%name%", ws_name);
-        label->replace_token("%icon%", icon->get());
-        label->replace_token("%index%", to_string(ws->num));
-        m_workspaces.emplace_back(factory_util::unique<workspace>(ws->name, ws_state, move(label)));
+    switch (evt.type) {
+      case i3ipc::WorkspaceEventType::FOCUS:
+        m_resync = !m_model.focus(evt.current->name);
+        break;
+      case i3ipc::WorkspaceEventType::URGENT:
+        m_resync = !m_model.urgent(evt.current->name, evt.current->urgent);
+        break;
+      case i3ipc::WorkspaceEventType::EMPTY:
+        m_resync = !m_model.empty(evt.current->name);
+        break;
+      case i3ipc::WorkspaceEventType::MOVE:
+        m_resync = !m_model.move(evt.current->name, evt.current->output);
+        break;
+      default:
+        m_resync = true;
+        break;
+    }
+  }
+
+  /**
+   * Reload the workspace model using the persistent command socket
+   */
+  void i3_module::resync() {
+    vector<i3_util::workspace_state> model;
+
+    {
+      std::lock_guard<std::mutex> guard(m_cmdlock);
+      for (auto&& ws : i3_util::workspaces(*m_ipc)) {
+        i3_util::workspace_state state;
+        state.name = ws->name;
+        state.output = ws->output;
+        state.num = ws->num;
+        state.focused = ws->focused;
+        state.visible = ws->visible;
+        state.urgent = ws->urgent;
+        model.emplace_back(move(state));
       }
+    }
 
-      return true;
-    } catch (const exception& err) {
-      m_log.err("%s: %s", name(), err.what());
-      return false;
+    m_log.trace("%s: Resynced %lu workspaces", name(), model.size());
+    m_model.reset(move(model));
+    m_resync = false;
+  }
+
+  unique_ptr<i3_module::workspace> i3_module::make_workspace(const i3_util::workspace_state& ws) const {
+    state ws_state{state::NONE};
+
+    if (ws.focused) {
+      ws_state = state::FOCUSED;
+    } else if (ws.urgent) {
+      ws_state = state::URGENT;
+    } else if (ws.visible) {
+      ws_state = state::VISIBLE;
+    } else {
+      ws_state = state::UNFOCUSED;
     }
+
+    string ws_name{ws.name};
+
+    // Remove workspace numbers "0:"
+    if (m_strip_wsnumbers) {
+      ws_name.erase(0, string_util::find_nth(ws_name, 0, ":", 1) + 1);
+    }
+
+    // Trim leading and trailing whitespace
+    ws_name = string_util::trim(move(ws_name), ' ');
+
+    auto icon = m_icons->get(ws.name, DEFAULT_WS_ICON, m_fuzzy_match);
+    auto label = m_statelabels.find(ws_state)->second->clone();
+
+    label->reset_tokens();
+    label->replace_token("%output%", ws.output);
+    label->replace_token("%name%", ws_name);
+    label->replace_token("%icon%", icon->get());
+    label->replace_token("%index%", to_string(ws.num));
+    return factory_util::unique<workspace>(ws.name, ws_state, move(label), ws.revision);
   }
 
-  bool i3_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_MODE && m_modeactive) {
+  bool i3_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL_MODE && m_modeactive) {
       builder->node(m_modelabel);
-    } else if (tag == TAG_LABEL_STATE && !m_workspaces.empty()) {
+    } else if (id == ID_LABEL_STATE && !m_workspaces.empty()) {
       if (m_scroll) {
         builder->cmd(mousebtn::SCROLL_DOWN, EVENT_SCROLL_DOWN);
         builder->cmd(mousebtn::SCROLL_UP, EVENT_SCROLL_UP);
@@ -226,7 +309,8 @@ namespace modules {
     }
 
     try {
-      const i3_util::connection_t conn{};
+      std::lock_guard<std::mutex> guard(m_cmdlock);
+      const i3_util::connection_t& conn{*m_ipc};
 
       if (cmd.compare(0, strlen(EVENT_CLICK), EVENT_CLICK) == 0) {
         cmd.erase(0, strlen(EVENT_CLICK));
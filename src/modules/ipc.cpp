@@ -12,7 +12,7 @@ namespace modules {
    * Load user-defined ipc hooks and
    * create formatting tags
    */
-  ipc_module::ipc_module(const bar_settings& bar, string name_) : static_module<ipc_module>(bar, move(name_)) {
+  ipc_module::ipc_module(bar_settings_t bar, string name_) : static_module<ipc_module>(bar, move(name_)) {
     size_t index = 0;
 
     for (auto&& command : m_conf.get_list<string>(name(), "hook")) {
@@ -89,8 +89,8 @@ namespace modules {
   /**
    * Output content retrieved from hook commands
    */
-  bool ipc_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_OUTPUT) {
+  bool ipc_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_OUTPUT) {
       builder->node(m_output);
       return true;
     } else {
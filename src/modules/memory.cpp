@@ -1,7 +1,3 @@
-#include <fstream>
-#include <iomanip>
-#include <istream>
-
 #include "drawtypes/label.hpp"
 #include "drawtypes/progressbar.hpp"
 #include "drawtypes/ramp.hpp"
@@ -15,8 +11,9 @@ POLYBAR_NS
 namespace modules {
   template class module<memory_module>;
 
-  memory_module::memory_module(const bar_settings& bar, string name_) : timer_module<memory_module>(bar, move(name_)) {
+  memory_module::memory_module(bar_settings_t bar, string name_) : timer_module<memory_module>(bar, move(name_)) {
     m_interval = m_conf.get<decltype(m_interval)>(name(), "interval", 1s);
+    m_meminfo = sampler::make().subscribe(PATH_MEMORY_INFO);
 
     m_formatter->add(DEFAULT_FORMAT, TAG_LABEL, {TAG_LABEL, TAG_BAR_USED, TAG_BAR_FREE, TAG_RAMP_USED, TAG_RAMP_FREE,
                                                  TAG_BAR_SWAP_USED, TAG_BAR_SWAP_FREE, TAG_RAMP_SWAP_USED, TAG_RAMP_SWAP_FREE});
@@ -52,42 +49,24 @@ namespace modules {
   }
 
   bool memory_module::update() {
-    unsigned long long kb_total{0ULL};
-    unsigned long long kb_avail{0ULL};
-    unsigned long long kb_swap_total{0ULL};
-    unsigned long long kb_swap_free{0ULL};
-
-    try {
-      std::ifstream meminfo(PATH_MEMORY_INFO);
-      std::map<std::string, unsigned long long int> parsed;
-
-      std::string line;
-      while (std::getline(meminfo, line)) {
-        size_t sep_off = line.find(':');
-        size_t value_off = line.find_first_of("123456789", sep_off);
-
-        if (sep_off == std::string::npos || value_off == std::string::npos) continue;
-
-        std::string id = line.substr(0, sep_off);
-        unsigned long long int value = std::strtoull(&line[value_off], nullptr, 10);
-        parsed[id] = value;
-      }
-
-      kb_total = parsed["MemTotal"];
-      kb_swap_total = parsed["SwapTotal"];
-      kb_swap_free = parsed["SwapFree"];
+    auto max_age = chrono::duration_cast<sampler::clock::duration>(m_interval / 2);
+    if (!sampler::make().read(m_meminfo, max_age, [&](const char* data, size_t len) {
+          return procfs_util::parse_meminfo(data, len, m_values);
+        })) {
+      m_log.err("Failed to read memory values");
+    }
 
-      // newer kernels (3.4+) have an accurate available memory field,
-      // see https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/commit/?id=34e431b0ae398fc54ea69ff85ec700722c9da773
-      // for details
-      if (parsed.count("MemAvailable")) {
-        kb_avail = parsed["MemAvailable"];
-      } else {
-        // old kernel; give a best-effort approximation of available memory
-        kb_avail = parsed["MemFree"] + parsed["Buffers"] + parsed["Cached"] + parsed["SReclaimable"] - parsed["Shmem"];
-      }
-    } catch (const std::exception& err) {
-      m_log.err("Failed to read memory values (what: %s)", err.what());
+    unsigned long long kb_total{m_values.total};
+    unsigned long long kb_avail{m_values.available};
+    unsigned long long kb_swap_total{m_values.swap_total};
+    unsigned long long kb_swap_free{m_values.swap_free};
+
+    // newer kernels (3.4+) have an accurate available memory field,
+    // see https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/commit/?id=34e431b0ae398fc54ea69ff85ec700722c9da773
+    // for details
+    if (!m_values.has_available) {
+      // old kernel; give a best-effort approximation of available memory
+      kb_avail = m_values.free + m_values.buffers + m_values.cached + m_values.sreclaimable - m_values.shmem;
     }
 
     m_perc_memfree = math_util::percentage(kb_avail, kb_total);
@@ -119,27 +98,37 @@ namespace modules {
     return true;
   }
 
-  bool memory_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_BAR_USED) {
-      builder->node(m_bar_memused->output(m_perc_memused));
-    } else if (tag == TAG_BAR_FREE) {
-      builder->node(m_bar_memfree->output(m_perc_memfree));
-    } else if (tag == TAG_LABEL) {
-      builder->node(m_label);
-    } else if (tag == TAG_RAMP_FREE) {
-      builder->node(m_ramp_memfree->get_by_percentage(m_perc_memfree));
-    } else if (tag == TAG_RAMP_USED) {
-      builder->node(m_ramp_memused->get_by_percentage(m_perc_memused));
-    } else if (tag == TAG_BAR_SWAP_USED) {
-      builder->node(m_bar_swapused->output(m_perc_swap_used));
-    } else if (tag == TAG_BAR_SWAP_FREE) {
-      builder->node(m_bar_swapfree->output(m_perc_swap_free));
-    } else if (tag == TAG_RAMP_SWAP_FREE) {
-      builder->node(m_ramp_swapfree->get_by_percentage(m_perc_swap_free));
-    } else if (tag == TAG_RAMP_SWAP_USED) {
-      builder->node(m_ramp_swapused->get_by_percentage(m_perc_swap_used));
-    } else {
-      return false;
+  bool memory_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_BAR_USED:
+        builder->node(m_bar_memused->output(m_perc_memused));
+        break;
+      case ID_BAR_FREE:
+        builder->node(m_bar_memfree->output(m_perc_memfree));
+        break;
+      case ID_LABEL:
+        builder->node(m_label);
+        break;
+      case ID_RAMP_FREE:
+        builder->node(m_ramp_memfree->get_by_percentage(m_perc_memfree));
+        break;
+      case ID_RAMP_USED:
+        builder->node(m_ramp_memused->get_by_percentage(m_perc_memused));
+        break;
+      case ID_BAR_SWAP_USED:
+        builder->node(m_bar_swapused->output(m_perc_swap_used));
+        break;
+      case ID_BAR_SWAP_FREE:
+        builder->node(m_bar_swapfree->output(m_perc_swap_free));
+        break;
+      case ID_RAMP_SWAP_FREE:
+        builder->node(m_ramp_swapfree->get_by_percentage(m_perc_swap_free));
+        break;
+      case ID_RAMP_SWAP_USED:
+        builder->node(m_ramp_swapused->get_by_percentage(m_perc_swap_used));
+        break;
+      default:
+        return false;
     }
     return true;
   }
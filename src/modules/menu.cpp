@@ -11,7 +11,7 @@ POLYBAR_NS
 namespace modules {
   template class module<menu_module>;
 
-  menu_module::menu_module(const bar_settings& bar, string name_) : static_module<menu_module>(bar, move(name_)) {
+  menu_module::menu_module(bar_settings_t bar, string name_) : static_module<menu_module>(bar, move(name_)) {
     m_expand_right = m_conf.get(name(), "expand-right", m_expand_right);
 
     string default_format;
@@ -63,16 +63,16 @@ namespace modules {
     }
   }
 
-  bool menu_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_TOGGLE && m_level == -1) {
+  bool menu_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL_TOGGLE && m_level == -1) {
       builder->cmd(mousebtn::LEFT, string(EVENT_MENU_OPEN) + "0");
       builder->node(m_labelopen);
       builder->cmd_close();
-    } else if (tag == TAG_LABEL_TOGGLE && m_level > -1) {
+    } else if (id == ID_LABEL_TOGGLE && m_level > -1) {
       builder->cmd(mousebtn::LEFT, EVENT_MENU_CLOSE);
       builder->node(m_labelclose);
       builder->cmd_close();
-    } else if (tag == TAG_MENU && m_level > -1) {
+    } else if (id == ID_MENU && m_level > -1) {
       auto spacing = m_formatter->get(get_format())->spacing;
       for (auto&& item : m_levels[m_level]->items) {
         /*
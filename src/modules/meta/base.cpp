@@ -1,14 +1,50 @@
+#include <algorithm>
 #include <utility>
 
 #include "components/builder.hpp"
 #include "drawtypes/label.hpp"
 #include "modules/meta/base.hpp"
+#include "utils/string.hpp"
 
 POLYBAR_NS
 
 namespace modules {
   // module_format {{{
 
+  /**
+   * Split the value into literal text and tags
+   *
+   * Building the output walks the tokens instead of scanning the value
+   * again, so this has to be called whenever the value is changed
+   */
+  void module_format::compile() {
+    tokens.clear();
+
+    size_t pos{0};
+    size_t start, end;
+    while ((start = value.find('<', pos)) != string::npos && (end = value.find('>', start)) != string::npos) {
+      if (start > pos) {
+        string text{value.substr(pos, start - pos)};
+        string trimmed{string_util::ltrim(string{text}, ' ')};
+        tokens.emplace_back(token{move(text), move(trimmed), false});
+      }
+      string tag{value.substr(start, end - start + 1)};
+      auto id = tag_ids.find(tag);
+      tokens.emplace_back(token{move(tag), "", true, id != tag_ids.end() ? id->second : -1});
+      pos = end + 1;
+    }
+
+    tail = value.substr(pos);
+  }
+
+  /**
+   * Check if the tag is used in the format
+   */
+  bool module_format::uses(const string& tag) const {
+    return std::find_if(tokens.begin(), tokens.end(), [&](const token& t) { return t.tag && t.text == tag; }) !=
+           tokens.end();
+  }
+
   string module_format::decorate(builder* builder, string output) {
     if (output.empty()) {
       builder->flush();
@@ -85,6 +121,11 @@ namespace modules {
   // }}}
   // module_formatter {{{
 
+  /**
+   * Add a format, numbering its tags and whitelisted tags in the order
+   * they appear here, unless an earlier format numbered them already.
+   * The id is passed to module::build_tag() along with the tag
+   */
   void module_formatter::add(string name, string fallback, vector<string>&& tags, vector<string>&& whitelist) {
     const auto formatdef = [&](
         const string& param, const auto& fallback) { return m_conf.get("settings", "format-" + param, fallback); };
@@ -121,19 +162,16 @@ namespace modules {
     tag_collection.insert(tag_collection.end(), format->tags.begin(), format->tags.end());
     tag_collection.insert(tag_collection.end(), whitelist.begin(), whitelist.end());
 
-    size_t start, end;
-    string value{format->value};
-    while ((start = value.find('<')) != string::npos && (end = value.find('>', start)) != string::npos) {
-      if (start > 0) {
-        value.erase(0, start);
-        end -= start;
-        start = 0;
-      }
-      string tag{value.substr(start, end + 1)};
-      if (find(tag_collection.begin(), tag_collection.end(), tag) == tag_collection.end()) {
-        throw undefined_format_tag(tag + " is not a valid format tag for \"" + name + "\"");
+    for (auto&& tag : tag_collection) {
+      m_tag_ids.emplace(tag, static_cast<int>(m_tag_ids.size()));
+    }
+    format->tag_ids = m_tag_ids;
+    format->compile();
+
+    for (auto&& token : format->tokens) {
+      if (token.tag && find(tag_collection.begin(), tag_collection.end(), token.text) == tag_collection.end()) {
+        throw undefined_format_tag(token.text + " is not a valid format tag for \"" + name + "\"");
       }
-      value.erase(0, tag.size());
     }
 
     m_formats.insert(make_pair(move(name), move(format)));
@@ -144,12 +182,12 @@ namespace modules {
     if (format == m_formats.end()) {
       throw undefined_format(format_name);
     }
-    return format->second->value.find(tag) != string::npos;
+    return format->second->uses(tag);
   }
 
   bool module_formatter::has(const string& tag) {
     for (auto&& format : m_formats) {
-      if (format.second->value.find(tag) != string::npos) {
+      if (format.second->uses(tag)) {
         return true;
       }
     }
@@ -13,7 +13,7 @@ POLYBAR_NS
 namespace modules {
   template class module<mpd_module>;
 
-  mpd_module::mpd_module(const bar_settings& bar, string name_) : event_module<mpd_module>(bar, move(name_)) {
+  mpd_module::mpd_module(bar_settings_t bar, string name_) : event_module<mpd_module>(bar, move(name_)) {
     m_host = m_conf.get(name(), "host", m_host);
     m_port = m_conf.get(name(), "port", m_port);
     m_pass = m_conf.get(name(), "password", m_pass);
@@ -311,43 +311,92 @@ namespace modules {
     }
   }
 
-  bool mpd_module::build(builder* builder, const string& tag) const {
+  bool mpd_module::build_tag(builder* builder, int id, const string&) const {
     bool is_playing = m_status && m_status->match_state(mpdstate::PLAYING);
     bool is_paused = m_status && m_status->match_state(mpdstate::PAUSED);
     bool is_stopped = m_status && m_status->match_state(mpdstate::STOPPED);
 
-    if (tag == TAG_LABEL_SONG && !is_stopped) {
-      builder->node(m_label_song);
-    } else if (tag == TAG_LABEL_TIME && !is_stopped) {
-      builder->node(m_label_time);
-    } else if (tag == TAG_BAR_PROGRESS && !is_stopped) {
-      builder->node(m_bar_progress->output(!m_status ? 0 : m_status->get_elapsed_percentage()));
-    } else if (tag == TAG_LABEL_OFFLINE) {
-      builder->node(m_label_offline);
-    } else if (tag == TAG_ICON_RANDOM) {
-      builder->cmd(mousebtn::LEFT, EVENT_RANDOM, m_icons->get("random"));
-    } else if (tag == TAG_ICON_REPEAT) {
-      builder->cmd(mousebtn::LEFT, EVENT_REPEAT, m_icons->get("repeat"));
-    } else if (tag == TAG_ICON_REPEAT_ONE || tag == TAG_ICON_SINGLE) {
-      builder->cmd(mousebtn::LEFT, EVENT_SINGLE, m_icons->get("single"));
-    } else if (tag == TAG_ICON_CONSUME) {
-      builder->cmd(mousebtn::LEFT, EVENT_CONSUME, m_icons->get("consume"));
-    } else if (tag == TAG_ICON_PREV) {
-      builder->cmd(mousebtn::LEFT, EVENT_PREV, m_icons->get("prev"));
-    } else if ((tag == TAG_ICON_STOP || tag == TAG_TOGGLE_STOP) && (is_playing || is_paused)) {
-      builder->cmd(mousebtn::LEFT, EVENT_STOP, m_icons->get("stop"));
-    } else if ((tag == TAG_ICON_PAUSE || tag == TAG_TOGGLE) && is_playing) {
-      builder->cmd(mousebtn::LEFT, EVENT_PAUSE, m_icons->get("pause"));
-    } else if ((tag == TAG_ICON_PLAY || tag == TAG_TOGGLE || tag == TAG_TOGGLE_STOP) && !is_playing) {
-      builder->cmd(mousebtn::LEFT, EVENT_PLAY, m_icons->get("play"));
-    } else if (tag == TAG_ICON_NEXT) {
-      builder->cmd(mousebtn::LEFT, EVENT_NEXT, m_icons->get("next"));
-    } else if (tag == TAG_ICON_SEEKB) {
-      builder->cmd(mousebtn::LEFT, EVENT_SEEK + "-5"s, m_icons->get("seekb"));
-    } else if (tag == TAG_ICON_SEEKF) {
-      builder->cmd(mousebtn::LEFT, EVENT_SEEK + "+5"s, m_icons->get("seekf"));
-    } else {
-      return false;
+    switch (id) {
+      case ID_LABEL_SONG:
+        if (is_stopped) {
+          return false;
+        }
+        builder->node(m_label_song);
+        break;
+      case ID_LABEL_TIME:
+        if (is_stopped) {
+          return false;
+        }
+        builder->node(m_label_time);
+        break;
+      case ID_BAR_PROGRESS:
+        if (is_stopped) {
+          return false;
+        }
+        builder->node(m_bar_progress->output(!m_status ? 0 : m_status->get_elapsed_percentage()));
+        break;
+      case ID_LABEL_OFFLINE:
+        builder->node(m_label_offline);
+        break;
+      case ID_ICON_RANDOM:
+        builder->cmd(mousebtn::LEFT, EVENT_RANDOM, m_icons->get("random"));
+        break;
+      case ID_ICON_REPEAT:
+        builder->cmd(mousebtn::LEFT, EVENT_REPEAT, m_icons->get("repeat"));
+        break;
+      case ID_ICON_REPEAT_ONE:
+      case ID_ICON_SINGLE:
+        builder->cmd(mousebtn::LEFT, EVENT_SINGLE, m_icons->get("single"));
+        break;
+      case ID_ICON_CONSUME:
+        builder->cmd(mousebtn::LEFT, EVENT_CONSUME, m_icons->get("consume"));
+        break;
+      case ID_ICON_PREV:
+        builder->cmd(mousebtn::LEFT, EVENT_PREV, m_icons->get("prev"));
+        break;
+      case ID_ICON_STOP:
+        if (!is_playing && !is_paused) {
+          return false;
+        }
+        builder->cmd(mousebtn::LEFT, EVENT_STOP, m_icons->get("stop"));
+        break;
+      case ID_ICON_PAUSE:
+        if (!is_playing) {
+          return false;
+        }
+        builder->cmd(mousebtn::LEFT, EVENT_PAUSE, m_icons->get("pause"));
+        break;
+      case ID_ICON_PLAY:
+        if (is_playing) {
+          return false;
+        }
+        builder->cmd(mousebtn::LEFT, EVENT_PLAY, m_icons->get("play"));
+        break;
+      case ID_TOGGLE:
+        if (is_playing) {
+          builder->cmd(mousebtn::LEFT, EVENT_PAUSE, m_icons->get("pause"));
+        } else {
+          builder->cmd(mousebtn::LEFT, EVENT_PLAY, m_icons->get("play"));
+        }
+        break;
+      case ID_TOGGLE_STOP:
+        if (is_playing || is_paused) {
+          builder->cmd(mousebtn::LEFT, EVENT_STOP, m_icons->get("stop"));
+        } else {
+          builder->cmd(mousebtn::LEFT, EVENT_PLAY, m_icons->get("play"));
+        }
+        break;
+      case ID_ICON_NEXT:
+        builder->cmd(mousebtn::LEFT, EVENT_NEXT, m_icons->get("next"));
+        break;
+      case ID_ICON_SEEKB:
+        builder->cmd(mousebtn::LEFT, EVENT_SEEK + "-5"s, m_icons->get("seekb"));
+        break;
+      case ID_ICON_SEEKF:
+        builder->cmd(mousebtn::LEFT, EVENT_SEEK + "+5"s, m_icons->get("seekf"));
+        break;
+      default:
+        return false;
     }
 
     return true;
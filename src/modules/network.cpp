@@ -1,5 +1,7 @@
 #include "modules/network.hpp"
 
+#include <poll.h>
+
 #include "drawtypes/animation.hpp"
 #include "drawtypes/label.hpp"
 #include "drawtypes/ramp.hpp"
@@ -12,7 +14,7 @@ POLYBAR_NS
 namespace modules {
   template class module<network_module>;
 
-  network_module::network_module(const bar_settings& bar, string name_)
+  network_module::network_module(bar_settings_t bar, string name_)
       : timer_module<network_module>(bar, move(name_)) {
     // Load configuration values
     m_interface = m_conf.get(name(), "interface", m_interface);
@@ -21,6 +23,11 @@ namespace modules {
     m_accumulate = m_conf.get(name(), "accumulate-stats", m_accumulate);
     m_interval = m_conf.get<decltype(m_interval)>(name(), "interval", 1s);
     m_unknown_up = m_conf.get<bool>(name(), "unknown-as-up", false);
+    m_ping_method = m_conf.get(name(), "ping-method", m_ping_method);
+
+    if (m_ping_method != "command" && m_ping_method != "icmp") {
+      throw module_error("Invalid ping-method \"" + m_ping_method + "\", expected \"command\" or \"icmp\"");
+    }
 
     m_conf.warn_deprecated(name(), "udspeed-minwidth", "%downspeed:min:max% and %upspeed:min:max%");
 
@@ -63,26 +70,70 @@ namespace modules {
     // Get an intstance of the network interface
     if (net::is_wireless_interface(m_interface)) {
       m_wireless = factory_util::unique<net::wireless_network>(m_interface);
-      m_wireless->set_unknown_up(m_unknown_up);
     } else {
       m_wired = factory_util::unique<net::wired_network>(m_interface);
-      m_wired->set_unknown_up(m_unknown_up);
     };
 
+    active()->set_unknown_up(m_unknown_up);
+    active()->set_probe(m_ping_method == "icmp");
+
     // We only need to start the subthread if the packetloss animation is used
     if (m_animation_packetloss) {
       m_threads.emplace_back(thread(&network_module::subthread_routine, this));
     }
   }
 
+  /**
+   * Start the interval timer and listen for link and association
+   * changes, which are applied as soon as they are reported
+   */
+  void network_module::start() {
+    timer_module::start();
+
+    auto fds = active()->event_fds();
+    if (fds.empty()) {
+      return;
+    }
+
+    if (m_loop.enabled()) {
+      for (auto&& fd : fds) {
+        m_loop.add(fd, [this] { on_event(); });
+        m_eventfds.emplace_back(fd);
+      }
+    } else {
+      m_threads.emplace_back(thread(&network_module::event_routine, this, move(fds)));
+    }
+  }
+
+  /**
+   * The event fds are removed before the locks are taken, since their
+   * callbacks take the same locks
+   */
+  void network_module::stop() {
+    for (auto&& fd : m_eventfds) {
+      m_loop.remove(fd);
+    }
+    m_eventfds.clear();
+    timer_module::stop();
+  }
+
   void network_module::teardown() {
+    if (m_ping.valid()) {
+      m_ping.wait();
+    }
     m_wireless.reset();
     m_wired.reset();
   }
 
+  net::network* network_module::active() const {
+    if (m_wireless) {
+      return m_wireless.get();
+    }
+    return m_wired.get();
+  }
+
   bool network_module::update() {
-    net::network* network =
-        m_wireless ? static_cast<net::network*>(m_wireless.get()) : static_cast<net::network*>(m_wired.get());
+    net::network* network = active();
 
     if (!network->query(m_accumulate)) {
       m_log.warn("%s: Failed to query interface '%s'", name(), m_interface);
@@ -90,6 +141,48 @@ namespace modules {
       return false;
     }
 
+    // Ignore the first run
+    if (m_counter == -1) {
+      m_counter = 0;
+    } else if (m_ping_nth_update > 0 && network->connected() && (++m_counter % m_ping_nth_update) == 0) {
+      start_ping(network);
+      m_counter = 0;
+    }
+
+    m_upspeed = network->upspeed(m_udspeed_minwidth);
+    m_downspeed = network->downspeed(m_udspeed_minwidth);
+
+    refresh();
+    return true;
+  }
+
+  /**
+   * Test connectivity on a thread of its own, since the ping can take
+   * seconds and the update may run on the shared event loop
+   *
+   * The module is redrawn when the result differs from the last one.
+   * A test that is still running covers the current interval as well
+   */
+  void network_module::start_ping(net::network* network) {
+    if (m_ping.valid() && m_ping.wait_for(chrono::seconds::zero()) != std::future_status::ready) {
+      return;
+    }
+
+    m_ping = std::async(std::launch::async, [this, network] {
+      bool packetloss{!network->ping()};
+      if (m_packetloss.exchange(packetloss) != packetloss && running()) {
+        broadcast();
+      }
+    });
+  }
+
+  /**
+   * Update the connection state and the labels from the last
+   * query without sampling the transfer counters again
+   */
+  void network_module::refresh() {
+    net::network* network = active();
+
     try {
       if (m_wireless) {
         m_signal = m_wireless->signal();
@@ -101,25 +194,14 @@ namespace modules {
 
     m_connected = network->connected();
 
-    // Ignore the first run
-    if (m_counter == -1) {
-      m_counter = 0;
-    } else if (m_ping_nth_update > 0 && m_connected && (++m_counter % m_ping_nth_update) == 0) {
-      m_packetloss = !network->ping();
-      m_counter = 0;
-    }
-
-    auto upspeed = network->upspeed(m_udspeed_minwidth);
-    auto downspeed = network->downspeed(m_udspeed_minwidth);
-
     // Update label contents
     const auto replace_tokens = [&](label_t& label) {
       label->reset_tokens();
       label->replace_token("%ifname%", m_interface);
       label->replace_token("%local_ip%", network->ip());
       label->replace_token("%local_ip6%", network->ip6());
-      label->replace_token("%upspeed%", upspeed);
-      label->replace_token("%downspeed%", downspeed);
+      label->replace_token("%upspeed%", m_upspeed);
+      label->replace_token("%downspeed%", m_downspeed);
 
       if (m_wired) {
         label->replace_token("%linkspeed%", m_wired->linkspeed());
@@ -139,8 +221,42 @@ namespace modules {
     if (m_label[connection_state::DISCONNECTED]) {
       replace_tokens(m_label[connection_state::DISCONNECTED]);
     }
+  }
 
-    return true;
+  /**
+   * Apply pending link and association changes
+   */
+  void network_module::on_event() {
+    try {
+      std::unique_lock<std::mutex> guard(m_updatelock);
+      if (!running() || active() == nullptr || !active()->process_events()) {
+        return;
+      }
+      refresh();
+      guard.unlock();
+      broadcast();
+    } catch (const exception& err) {
+      halt(err.what());
+    }
+  }
+
+  /**
+   * Thread mode counterpart of the event loop registration
+   */
+  void network_module::event_routine(vector<int> fds) {
+    vector<pollfd> pfds;
+    for (auto&& fd : fds) {
+      pfds.emplace_back(pollfd{fd, POLLIN, 0});
+    }
+
+    // The timeout bounds how long stopping the module has to wait
+    while (running()) {
+      if (poll(pfds.data(), pfds.size(), 500) > 0) {
+        on_event();
+      }
+    }
+
+    m_log.trace("%s: Reached end of network event thread", name());
   }
 
   string network_module::get_format() const {
@@ -153,21 +269,28 @@ namespace modules {
     }
   }
 
-  bool network_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_CONNECTED) {
-      builder->node(m_label.at(connection_state::CONNECTED));
-    } else if (tag == TAG_LABEL_DISCONNECTED) {
-      builder->node(m_label.at(connection_state::DISCONNECTED));
-    } else if (tag == TAG_LABEL_PACKETLOSS) {
-      builder->node(m_label.at(connection_state::PACKETLOSS));
-    } else if (tag == TAG_ANIMATION_PACKETLOSS) {
-      builder->node(m_animation_packetloss->get());
-    } else if (tag == TAG_RAMP_SIGNAL) {
-      builder->node(m_ramp_signal->get_by_percentage(m_signal));
-    } else if (tag == TAG_RAMP_QUALITY) {
-      builder->node(m_ramp_quality->get_by_percentage(m_quality));
-    } else {
-      return false;
+  bool network_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_LABEL_CONNECTED:
+        builder->node(m_label.at(connection_state::CONNECTED));
+        break;
+      case ID_LABEL_DISCONNECTED:
+        builder->node(m_label.at(connection_state::DISCONNECTED));
+        break;
+      case ID_LABEL_PACKETLOSS:
+        builder->node(m_label.at(connection_state::PACKETLOSS));
+        break;
+      case ID_ANIMATION_PACKETLOSS:
+        builder->node(m_animation_packetloss->get());
+        break;
+      case ID_RAMP_SIGNAL:
+        builder->node(m_ramp_signal->get_by_percentage(m_signal));
+        break;
+      case ID_RAMP_QUALITY:
+        builder->node(m_ramp_quality->get_by_percentage(m_quality));
+        break;
+      default:
+        return false;
     }
     return true;
   }
@@ -13,7 +13,7 @@ POLYBAR_NS
 namespace modules {
   template class module<pulseaudio_module>;
 
-  pulseaudio_module::pulseaudio_module(const bar_settings& bar, string name_)
+  pulseaudio_module::pulseaudio_module(bar_settings_t bar, string name_)
       : event_module<pulseaudio_module>(bar, move(name_)) {
     // Load configuration values
     m_interval = m_conf.get(name(), "interval", m_interval);
@@ -127,17 +127,22 @@ namespace modules {
     return m_builder->flush();
   }
 
-  bool pulseaudio_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_BAR_VOLUME) {
-      builder->node(m_bar_volume->output(m_volume));
-    } else if (tag == TAG_RAMP_VOLUME) {
-      builder->node(m_ramp_volume->get_by_percentage(m_volume));
-    } else if (tag == TAG_LABEL_VOLUME) {
-      builder->node(m_label_volume);
-    } else if (tag == TAG_LABEL_MUTED) {
-      builder->node(m_label_muted);
-    } else {
-      return false;
+  bool pulseaudio_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_BAR_VOLUME:
+        builder->node(m_bar_volume->output(m_volume));
+        break;
+      case ID_RAMP_VOLUME:
+        builder->node(m_ramp_volume->get_by_percentage(m_volume));
+        break;
+      case ID_LABEL_VOLUME:
+        builder->node(m_label_volume);
+        break;
+      case ID_LABEL_MUTED:
+        builder->node(m_label_muted);
+        break;
+      default:
+        return false;
     }
     return true;
   }
@@ -1,4 +1,7 @@
 #include "modules/script.hpp"
+
+#include <csignal>
+
 #include "drawtypes/label.hpp"
 #include "modules/meta/base.inl"
 
@@ -7,14 +10,68 @@ POLYBAR_NS
 namespace modules {
   template class module<script_module>;
 
+  namespace {
+    /**
+     * Signals that can be used to request output from persistent workers
+     */
+    int parse_signal(const string& name) {
+      static const map<string, int> signals{
+          {"HUP", SIGHUP}, {"USR1", SIGUSR1}, {"USR2", SIGUSR2}, {"ALRM", SIGALRM}, {"CONT", SIGCONT}};
+
+      auto it = signals.find(name.compare(0, 3, "SIG") == 0 ? name.substr(3) : name);
+      if (it == signals.end()) {
+        throw module_error("Unsupported request-signal \"" + name + "\"");
+      }
+      return it->second;
+    }
+  }  // namespace
+
   /**
    * Construct script module by loading configuration values
    * and setting up formatting objects
    */
-  script_module::script_module(const bar_settings& bar, string name_)
-      : module<script_module>(bar, move(name_)), m_handler([&]() -> function<chrono::duration<double>()> {
+  script_module::script_module(bar_settings_t bar, string name_)
+      : module<script_module>(bar, move(name_))
+      , m_handler([&]() -> function<chrono::duration<double>()> {
 
         m_tail = m_conf.get(name(), "tail", false);
+        m_persistent = m_conf.get(name(), "persistent", false);
+
+        if (m_tail && m_persistent) {
+          throw module_error("The tail and persistent options are mutually exclusive");
+        }
+
+        // Handler for persistent workers {{{
+        //
+        // The command is started once and asked for new output on each
+        // interval, it has to reply with a single line
+
+        if (m_persistent) {
+          return [&] {
+            string exec{string_util::replace_all(m_exec, "%counter%", to_string(m_counter))};
+            string reply;
+            bool replied{false};
+
+            try {
+              replied = m_worker->query(exec, ++m_counter, reply, m_stopping);
+            } catch (const command_error& err) {
+              m_log.err("%s: %s", name(), err.what());
+              throw module_error("Failed to execute command, stopping module...");
+            }
+
+            if (replied) {
+              if ((m_output = reply) != m_prev) {
+                m_prev = m_output;
+                broadcast();
+              }
+              return m_interval;
+            }
+
+            return m_stopping ? chrono::duration<double>{0} : std::max<chrono::duration<double>>(m_interval, 1s);
+          };
+        }
+
+        // }}}
         // Handler for continuous tail commands {{{
 
         if (m_tail) {
@@ -56,36 +113,39 @@ namespace modules {
         // Handler for basic shell commands {{{
 
         return [&] {
-          try {
-            auto exec = string_util::replace_all(m_exec, "%counter%", to_string(++m_counter));
-            m_log.info("%s: Invoking shell command: \"%s\"", name(), exec);
-            m_command = command_util::make_command(exec);
-            m_command->exec(true);
-          } catch (const exception& err) {
-            m_log.err("%s: %s", name(), err.what());
-            throw module_error("Failed to execute command, stopping module...");
-          }
+          auto exec = string_util::replace_all(m_exec, "%counter%", to_string(++m_counter));
+          m_log.info("%s: Invoking shell command: \"%s\"", name(), exec);
 
-          int fd = m_command->get_stdout(PIPE_READ);
-          if (fd != -1 && io_util::poll_read(fd) && (m_output = m_command->readline()) != m_prev) {
-            broadcast();
-            m_prev = m_output;
-          } else if (m_command->get_exit_status() != 0) {
-            m_output.clear();
-            m_prev.clear();
-            broadcast();
+          script_executor::result res;
+          if (!execute(exec, res, m_exec)) {
+            return chrono::duration<double>{0};
           }
-
-          return std::max(m_command->get_exit_status() == 0 ? m_interval : 1s, m_interval);
+          return handle_result(res);
         };
 
         // }}}
-      }()) {
+      }())
+      , m_executor(script_executor::make()) {
     // Load configuration values
     m_exec = m_conf.get(name(), "exec", m_exec);
     m_exec_if = m_conf.get(name(), "exec-if", m_exec_if);
     m_interval = m_conf.get<decltype(m_interval)>(name(), "interval", 5s);
 
+    if (m_persistent) {
+      m_request = m_conf.get(name(), "request", m_request);
+      m_request_timeout = m_conf.get<decltype(m_request_timeout)>(name(), "request-timeout", m_request_timeout);
+
+      auto signal = m_conf.get(name(), "request-signal", ""s);
+      if (!signal.empty()) {
+        m_request_signal = parse_signal(signal);
+      }
+      if (m_request.empty() && m_request_signal == 0) {
+        throw module_error("A persistent worker needs a request line or a request-signal");
+      }
+
+      m_worker = make_unique<script_worker>(m_log, name(), m_request, m_request_signal, m_request_timeout);
+    }
+
     // Load configured click handlers
     m_actions[mousebtn::LEFT] = m_conf.get(name(), "click-left", ""s);
     m_actions[mousebtn::MIDDLE] = m_conf.get(name(), "click-middle", ""s);
@@ -105,8 +165,16 @@ namespace modules {
 
   /**
    * Start the module worker
+   *
+   * In reactor mode, commands that aren't tailed are run from a timer
+   * on the event loop instead of a thread of their own
    */
   void script_module::start() {
+    if (m_loop.enabled() && !m_tail && !m_persistent) {
+      m_timer = m_loop.add_timer([this] { tick(); });
+      return;
+    }
+
     m_mainthread = thread([&] {
       try {
         while (running() && !m_stopping) {
@@ -128,12 +196,45 @@ namespace modules {
    * Stop the module worker by terminating any running commands
    */
   void script_module::stop() {
-    m_stopping = true;
+    {
+      std::lock_guard<std::mutex> guard(m_sleeplock);
+      m_stopping = true;
+    }
     wakeup();
 
+    if (m_timer != -1) {
+      m_loop.remove(m_timer);
+      m_timer = -1;
+
+      // Cancelling waits for a running callback, which may have submitted
+      // the next command before it saw m_stopping, so repeat until the
+      // current ticket is one that has been cancelled
+      size_t cancelled{0};
+      while (true) {
+        size_t ticket;
+        {
+          std::lock_guard<std::mutex> guard(m_sleeplock);
+          ticket = m_ticket;
+        }
+        if (ticket == cancelled) {
+          break;
+        }
+        m_executor.cancel(ticket);
+        cancelled = ticket;
+      }
+    }
+
     std::lock_guard<decltype(m_handler)> guard(m_handler);
 
     m_command.reset();
+    if (m_worker) {
+      m_worker->stop();
+    }
+
+    if (!m_tail && !m_persistent) {
+      m_log.info("%s: Script stats: %s", name(), m_executor.report(m_exec));
+    }
+
     module::stop();
   }
 
@@ -141,9 +242,46 @@ namespace modules {
    * Check if defined condition is met
    */
   bool script_module::check_condition() {
-    if (m_exec_if.empty()) {
-      return true;
-    } else if (command_util::make_command(m_exec_if)->exec(true) == 0) {
+    script_executor::result res;
+    return m_exec_if.empty() || (execute(m_exec_if, res) && handle_condition(res));
+  }
+
+  /**
+   * Run command through the executor and wait for it to finish
+   *
+   * Returns false if the module was stopped in the meantime
+   */
+  bool script_module::execute(const string& cmd, script_executor::result& res, const string& key) {
+    bool done{false};
+
+    auto ticket = m_executor.submit(
+        cmd,
+        [&](const script_executor::result& r) {
+          {
+            std::lock_guard<std::mutex> guard(m_sleeplock);
+            res = r;
+            done = true;
+          }
+          m_sleephandler.notify_all();
+        },
+        key);
+
+    std::unique_lock<std::mutex> guard(m_sleeplock);
+    m_sleephandler.wait(guard, [&] { return done || m_stopping; });
+    guard.unlock();
+
+    if (!done) {
+      // The callback refers to this stack frame
+      m_executor.cancel(ticket);
+    }
+    return done;
+  }
+
+  /**
+   * Clear the output if the exec-if condition failed
+   */
+  bool script_module::handle_condition(const script_executor::result& res) {
+    if (res.status == 0) {
       return true;
     } else if (!m_output.empty()) {
       broadcast();
@@ -153,6 +291,82 @@ namespace modules {
     return false;
   }
 
+  /**
+   * Update the output from the first line written by the command
+   *
+   * Returns the delay until the next run
+   */
+  chrono::duration<double> script_module::handle_result(const script_executor::result& res) {
+    auto line = res.output.substr(0, res.output.find('\n'));
+
+    if (!res.output.empty() && (m_output = line) != m_prev) {
+      broadcast();
+      m_prev = m_output;
+    } else if (res.status != 0) {
+      m_output.clear();
+      m_prev.clear();
+      broadcast();
+    }
+
+    return std::max(res.status == 0 ? m_interval : 1s, m_interval);
+  }
+
+  /**
+   * Arm the reactor mode timer
+   */
+  void script_module::schedule(chrono::duration<double> delay) {
+    if (running() && !m_stopping && m_timer != -1) {
+      m_loop.arm(m_timer, delay);
+    }
+  }
+
+  /**
+   * Reactor mode counterpart of the worker thread, the callbacks
+   * are called from the event loop as well
+   *
+   * Commands are submitted under m_sleeplock and not at all once the
+   * module is stopping, so that stop() cancels the last one
+   */
+  void script_module::tick() {
+    const auto run = [this] {
+      std::lock_guard<std::mutex> guard(m_sleeplock);
+      if (m_stopping) {
+        return;
+      }
+
+      auto exec = string_util::replace_all(m_exec, "%counter%", to_string(++m_counter));
+      m_log.info("%s: Invoking shell command: \"%s\"", name(), exec);
+      m_ticket = m_executor.submit(
+          exec,
+          [this](const script_executor::result& res) {
+            try {
+              schedule(handle_result(res));
+            } catch (const exception& err) {
+              halt(err.what());
+            }
+          },
+          m_exec);
+    };
+
+    if (m_exec_if.empty()) {
+      run();
+      return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_sleeplock);
+    if (m_stopping) {
+      return;
+    }
+
+    m_ticket = m_executor.submit(m_exec_if, [this, run](const script_executor::result& res) {
+      if (handle_condition(res)) {
+        run();
+      } else {
+        schedule(std::max<chrono::duration<double>>(m_interval, 1s));
+      }
+    });
+  }
+
   /**
    * Process mutex wrapped script handler
    */
@@ -188,11 +402,13 @@ namespace modules {
         auto action_replaced = string_util::replace_all(action, "%counter%", cnt);
 
         /*
-         * The pid token is only for tailed commands.
+         * The pid token is only for tailed commands and persistent workers.
          * If the command is not specified or running, replacement is unnecessary as well
          */
         if(m_tail && m_command && m_command->is_running()) {
           action_replaced = string_util::replace_all(action_replaced, "%pid%", to_string(m_command->get_pid()));
+        } else if (m_persistent && m_worker->running()) {
+          action_replaced = string_util::replace_all(action_replaced, "%pid%", to_string(m_worker->get_pid()));
         }
         m_builder->cmd(btn, action_replaced);
       }
@@ -206,11 +422,13 @@ namespace modules {
   /**
    * Output format tags
    */
-  bool script_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL) {
-      builder->node(m_label);
-    } else {
-      return false;
+  bool script_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_LABEL:
+        builder->node(m_label);
+        break;
+      default:
+        return false;
     }
 
     return true;
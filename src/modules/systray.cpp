@@ -14,7 +14,7 @@ namespace modules {
   /**
    * Construct module
    */
-  systray_module::systray_module(const bar_settings& bar, string name_)
+  systray_module::systray_module(bar_settings_t bar, string name_)
       : static_module<systray_module>(bar, move(name_)), m_connection(connection::make()) {
     // Add formats and elements
     m_formatter->add(DEFAULT_FORMAT, TAG_LABEL_TOGGLE, {TAG_LABEL_TOGGLE, TAG_TRAY_CLIENTS});
@@ -39,12 +39,12 @@ namespace modules {
   /**
    * Build output
    */
-  bool systray_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_TOGGLE) {
+  bool systray_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL_TOGGLE) {
       builder->cmd(mousebtn::LEFT, EVENT_TOGGLE);
       builder->node(m_label);
       builder->cmd_close();
-    } else if (tag == TAG_TRAY_CLIENTS && !m_hidden) {
+    } else if (id == ID_TRAY_CLIENTS && !m_hidden) {
       builder->append(TRAY_PLACEHOLDER);
     } else {
       return false;
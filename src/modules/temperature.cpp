@@ -4,6 +4,7 @@
 #include "drawtypes/ramp.hpp"
 #include "utils/file.hpp"
 #include "utils/math.hpp"
+#include "utils/procfs.hpp"
 #include <cmath>
 
 #include "modules/meta/base.inl"
@@ -13,7 +14,7 @@ POLYBAR_NS
 namespace modules {
   template class module<temperature_module>;
 
-  temperature_module::temperature_module(const bar_settings& bar, string name_)
+  temperature_module::temperature_module(bar_settings_t bar, string name_)
       : timer_module<temperature_module>(bar, move(name_)) {
     m_zone = m_conf.get(name(), "thermal-zone", 0);
     m_path = m_conf.get(name(), "hwmon-path", ""s);
@@ -30,6 +31,8 @@ namespace modules {
       throw module_error("The file '" + m_path + "' does not exist");
     }
 
+    m_input = sampler::make().subscribe(m_path);
+
     m_formatter->add(DEFAULT_FORMAT, TAG_LABEL, {TAG_LABEL, TAG_RAMP});
     m_formatter->add(FORMAT_WARN, TAG_LABEL_WARN, {TAG_LABEL_WARN, TAG_RAMP});
 
@@ -51,7 +54,8 @@ namespace modules {
   }
 
   bool temperature_module::update() {
-    m_temp = std::strtol(file_util::contents(m_path).c_str(), nullptr, 10) / 1000.0f + 0.5f;
+    auto max_age = chrono::duration_cast<sampler::clock::duration>(m_interval / 2);
+    m_temp = sampler::make().read(m_input, max_age, procfs_util::parse_integer) / 1000.0f + 0.5f;
     int temp_f = floor(((1.8 * m_temp) + 32) + 0.5);
     m_perc = math_util::cap(math_util::percentage(m_temp, m_tempbase, m_tempwarn), 0, 100);
 
@@ -91,15 +95,19 @@ namespace modules {
     }
   }
 
-  bool temperature_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL) {
-      builder->node(m_label.at(temp_state::NORMAL));
-    } else if (tag == TAG_LABEL_WARN) {
-      builder->node(m_label.at(temp_state::WARN));
-    } else if (tag == TAG_RAMP) {
-      builder->node(m_ramp->get_by_percentage(m_perc));
-    } else {
-      return false;
+  bool temperature_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_LABEL:
+        builder->node(m_label.at(temp_state::NORMAL));
+        break;
+      case ID_LABEL_WARN:
+        builder->node(m_label.at(temp_state::WARN));
+        break;
+      case ID_RAMP:
+        builder->node(m_ramp->get_by_percentage(m_perc));
+        break;
+      default:
+        return false;
     }
     return true;
   }
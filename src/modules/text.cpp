@@ -7,7 +7,7 @@ POLYBAR_NS
 namespace modules {
   template class module<text_module>;
 
-  text_module::text_module(const bar_settings& bar, string name_) : static_module<text_module>(bar, move(name_)) {
+  text_module::text_module(bar_settings_t bar, string name_) : static_module<text_module>(bar, move(name_)) {
     m_formatter->add("content", "", {});
 
     if (m_formatter->get("content")->value.empty()) {
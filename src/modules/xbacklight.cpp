@@ -16,13 +16,13 @@ namespace modules {
   /**
    * Construct module
    */
-  xbacklight_module::xbacklight_module(const bar_settings& bar, string name_)
+  xbacklight_module::xbacklight_module(bar_settings_t bar, string name_)
       : static_module<xbacklight_module>(bar, move(name_)), m_connection(connection::make()) {
     auto output = m_conf.get(name(), "output", m_bar.monitor->name);
 
-    auto monitors = randr_util::get_monitors(m_connection, m_connection.root(), bar.monitor_strict, false);
+    auto monitors = randr_util::get_monitors(m_connection, m_connection.root(), m_bar.monitor_strict, false);
 
-    m_output = randr_util::match_monitor(monitors, output, bar.monitor_exact);
+    m_output = randr_util::match_monitor(monitors, output, m_bar.monitor_exact);
 
     // If we didn't get a match we stop the module
     if (!m_output) {
@@ -131,15 +131,19 @@ namespace modules {
   /**
    * Output content as defined in the config
    */
-  bool xbacklight_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_BAR) {
-      builder->node(m_progressbar->output(m_percentage));
-    } else if (tag == TAG_RAMP) {
-      builder->node(m_ramp->get_by_percentage(m_percentage));
-    } else if (tag == TAG_LABEL) {
-      builder->node(m_label);
-    } else {
-      return false;
+  bool xbacklight_module::build_tag(builder* builder, int id, const string&) const {
+    switch (id) {
+      case ID_BAR:
+        builder->node(m_progressbar->output(m_percentage));
+        break;
+      case ID_RAMP:
+        builder->node(m_ramp->get_by_percentage(m_percentage));
+        break;
+      case ID_LABEL:
+        builder->node(m_label);
+        break;
+      default:
+        return false;
     }
     return true;
   }
@@ -23,7 +23,7 @@ namespace modules {
   /**
    * Construct module
    */
-  xkeyboard_module::xkeyboard_module(const bar_settings& bar, string name_)
+  xkeyboard_module::xkeyboard_module(bar_settings_t bar, string name_)
       : static_module<xkeyboard_module>(bar, move(name_)), m_connection(connection::make()) {
 
 
@@ -185,10 +185,10 @@ namespace modules {
   /**
    * Map format tags to content
    */
-  bool xkeyboard_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_LAYOUT) {
+  bool xkeyboard_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL_LAYOUT) {
       builder->node(m_layout);
-    } else if (tag == TAG_LABEL_INDICATOR && !m_indicators.empty()) {
+    } else if (id == ID_LABEL_INDICATOR && !m_indicators.empty()) {
       size_t n{0};
       for (auto&& indicator : m_indicators) {
         if (n++) {
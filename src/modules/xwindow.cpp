@@ -61,7 +61,7 @@ namespace modules {
   /**
    * Construct module
    */
-  xwindow_module::xwindow_module(const bar_settings& bar, string name_)
+  xwindow_module::xwindow_module(bar_settings_t bar, string name_)
       : static_module<xwindow_module>(bar, move(name_)), m_connection(connection::make()) {
     // Initialize ewmh atoms
     if ((ewmh_util::initialize()) == nullptr) {
@@ -131,8 +131,8 @@ namespace modules {
   /**
    * Output content as defined in the config
    */
-  bool xwindow_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL && m_label && m_label.get()) {
+  bool xwindow_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL && m_label && m_label.get()) {
       builder->node(m_label);
       return true;
     }
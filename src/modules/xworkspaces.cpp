@@ -33,7 +33,7 @@ namespace modules {
   /**
    * Construct module
    */
-  xworkspaces_module::xworkspaces_module(const bar_settings& bar, string name_)
+  xworkspaces_module::xworkspaces_module(bar_settings_t bar, string name_)
       : static_module<xworkspaces_module>(bar, move(name_)), m_connection(connection::make()) {
     // Load config values
     m_pinworkspaces = m_conf.get(name(), "pin-workspaces", m_pinworkspaces);
@@ -339,15 +339,15 @@ namespace modules {
   /**
    * Output content as defined in the config
    */
-  bool xworkspaces_module::build(builder* builder, const string& tag) const {
-    if (tag == TAG_LABEL_MONITOR) {
+  bool xworkspaces_module::build_tag(builder* builder, int id, const string&) const {
+    if (id == ID_LABEL_MONITOR) {
       if (m_viewports[m_index]->state != viewport_state::NONE) {
         builder->node(m_viewports[m_index]->label);
         return true;
       } else {
         return false;
       }
-    } else if (tag == TAG_LABEL_STATE) {
+    } else if (id == ID_LABEL_STATE) {
       unsigned int added_states = 0;
       for (auto&& desktop : m_viewports[m_index]->desktops) {
         if (desktop->label.get()) {
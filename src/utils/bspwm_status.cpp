@@ -0,0 +1,125 @@
+#include "utils/bspwm_status.hpp"
+
+#include <cstring>
+
+POLYBAR_NS
+
+namespace bspwm_util {
+  namespace {
+    /**
+     * Assign the given range unless the string already holds it
+     */
+    inline bool assign(string& dst, const char* src, size_t len) {
+      if (dst.size() == len && memcmp(dst.data(), src, len) == 0) {
+        return false;
+      }
+      dst.assign(src, len);
+      return true;
+    }
+  }  // namespace
+
+  /**
+   * Parse a report with the status prefix already stripped, e.g.
+   * "MeDP1:OI:fII:LT:TT:G:mHDMI1:oIII"
+   *
+   * Returns true if anything changed since the previous report
+   */
+  bool status_parser::parse(const char* data, size_t len) {
+    const char* it{data};
+    const char* end{data + len};
+
+    size_t monitor_n{0};
+    size_t desktop_n{0};
+    monitor_status* mon{nullptr};
+
+    const auto finish_monitor = [&] {
+      if (mon != nullptr && mon->desktops.size() != desktop_n) {
+        mon->desktops.resize(desktop_n);
+        touch(*mon);
+      }
+    };
+
+    while (it < end) {
+      auto sep = static_cast<const char*>(memchr(it, ':', end - it));
+      const char* token_end{sep != nullptr ? sep : end};
+
+      if (token_end != it) {
+        char type{*it};
+        const char* value{it + 1};
+        size_t value_len = token_end - value;
+
+        if (type == 'm' || type == 'M') {
+          finish_monitor();
+
+          if (monitor_n == m_monitors.size()) {
+            m_monitors.emplace_back();
+          }
+          mon = &m_monitors[monitor_n++];
+          desktop_n = 0;
+
+          bool modified{assign(mon->name, value, value_len)};
+          if (mon->focused != (type == 'M')) {
+            mon->focused = type == 'M';
+            modified = true;
+            // Desktops get dimmed with their monitor
+            for (auto&& desktop : mon->desktops) {
+              touch(desktop);
+            }
+          }
+          if (modified) {
+            touch(*mon);
+          }
+        } else if (mon == nullptr) {
+          // Nothing to attach the token to
+        } else if (strchr("FOUfou", type) != nullptr) {
+          if (desktop_n == mon->desktops.size()) {
+            mon->desktops.emplace_back();
+          }
+          auto& desktop = mon->desktops[desktop_n++];
+          bool modified{assign(desktop.name, value, value_len)};
+          if (desktop.flag != type) {
+            desktop.flag = type;
+            modified = true;
+          }
+          if (modified) {
+            touch(desktop);
+            touch(*mon);
+          }
+        } else if (type == 'L' && assign(mon->layout, value, value_len)) {
+          touch(*mon);
+        } else if (type == 'T' && assign(mon->state, value, value_len)) {
+          touch(*mon);
+        } else if (type == 'G' && assign(mon->flags, value, value_len)) {
+          touch(*mon);
+        }
+      }
+
+      it = token_end + 1;
+    }
+
+    finish_monitor();
+
+    if (m_monitors.size() != monitor_n) {
+      m_monitors.resize(monitor_n);
+      m_revision++;
+    }
+
+    bool changed{m_revision != m_parsed};
+    m_parsed = m_revision;
+    return changed;
+  }
+
+  const vector<monitor_status>& status_parser::monitors() const {
+    return m_monitors;
+  }
+
+  void status_parser::touch(monitor_status& mon) {
+    mon.revision = ++m_revision;
+  }
+
+  void status_parser::touch(desktop_status& desktop) {
+    desktop.revision = ++m_revision;
+  }
+}  // namespace bspwm_util
+
+POLYBAR_NS_END
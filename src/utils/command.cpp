@@ -81,6 +81,10 @@ int command::exec(bool wait_for_completion) {
     setpgid(m_forkpid, 0);
     process_util::exec_sh(m_cmd.c_str());
   } else {
+    // Also done here, so that terminate() can't race the child into
+    // signalling a process group that doesn't exist yet
+    setpgid(m_forkpid, m_forkpid);
+
     // Close file descriptors that won't be used by the parent
     if ((m_stdin[PIPE_READ] = close(m_stdin[PIPE_READ])) == -1) {
       throw command_error("Failed to close fd");
@@ -0,0 +1,119 @@
+#include "utils/i3_workspaces.hpp"
+
+#include <algorithm>
+
+POLYBAR_NS
+
+namespace i3_util {
+  /**
+   * Replace the model with the result of a GET_WORKSPACES request
+   */
+  void workspace_model::reset(vector<workspace_state>&& workspaces) {
+    m_workspaces = forward<decltype(workspaces)>(workspaces);
+    for (auto&& ws : m_workspaces) {
+      touch(ws);
+    }
+  }
+
+  /**
+   * Apply a "focus" event
+   *
+   * The focused workspace becomes the visible one on its output. The
+   * previously focused one stays visible if it is shown on another output
+   */
+  bool workspace_model::focus(const string& name) {
+    auto* ws = find(name);
+    if (ws == nullptr) {
+      return false;
+    }
+
+    for (auto&& other : m_workspaces) {
+      bool visible{other.visible && other.output != ws->output};
+      if (&other != ws && (other.focused || other.visible != visible)) {
+        other.focused = false;
+        other.visible = visible;
+        touch(other);
+      }
+    }
+
+    if (!ws->focused || !ws->visible) {
+      ws->focused = true;
+      ws->visible = true;
+      touch(*ws);
+    }
+
+    return true;
+  }
+
+  /**
+   * Apply an "urgent" event
+   */
+  bool workspace_model::urgent(const string& name, bool state) {
+    auto* ws = find(name);
+    if (ws == nullptr) {
+      return false;
+    }
+    if (ws->urgent != state) {
+      ws->urgent = state;
+      touch(*ws);
+    }
+    return true;
+  }
+
+  /**
+   * Apply an "empty" event, i3 destroys the workspace right after
+   */
+  bool workspace_model::empty(const string& name) {
+    auto it = std::find_if(
+        m_workspaces.begin(), m_workspaces.end(), [&](const workspace_state& ws) { return ws.name == name; });
+    if (it != m_workspaces.end()) {
+      m_workspaces.erase(it);
+      m_revision++;
+    }
+    return true;
+  }
+
+  /**
+   * Apply a "move" event, the payload has the workspace's new output
+   *
+   * When a visible workspace leaves an output, i3 shows another one
+   * there without telling which, so that requires a resync
+   */
+  bool workspace_model::move(const string& name, const string& output) {
+    auto* ws = find(name);
+    if (ws == nullptr || (ws->visible && ws->output != output)) {
+      return false;
+    }
+    if (ws->output != output) {
+      ws->output = output;
+      touch(*ws);
+    }
+    return true;
+  }
+
+  const vector<workspace_state>& workspace_model::workspaces() const {
+    return m_workspaces;
+  }
+
+  /**
+   * Counter that changes with every modification of the model
+   */
+  size_t workspace_model::revision() const {
+    return m_revision;
+  }
+
+  workspace_state* workspace_model::find(const string& name) {
+    for (auto&& ws : m_workspaces) {
+      if (ws.name == name) {
+        return &ws;
+      }
+    }
+    return nullptr;
+  }
+
+  void workspace_model::touch(workspace_state& ws) {
+    ws.revision = ++m_revision;
+  }
+}  // namespace i3_util
+
+POLYBAR_NS_END
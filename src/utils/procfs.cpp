@@ -0,0 +1,151 @@
+#include "utils/procfs.hpp"
+
+#include <cstring>
+
+POLYBAR_NS
+
+namespace procfs_util {
+  namespace {
+    inline void skip_blank(const char*& it, const char* end) {
+      while (it != end && (*it == ' ' || *it == '\t')) {
+        it++;
+      }
+    }
+
+    inline unsigned long long scan_ull(const char*& it, const char* end) {
+      unsigned long long value{0};
+      skip_blank(it, end);
+      while (it != end && *it >= '0' && *it <= '9') {
+        value = value * 10 + static_cast<unsigned long long>(*it++ - '0');
+      }
+      return value;
+    }
+
+    inline const char* next_line(const char* it, const char* end) {
+      auto eol = static_cast<const char*>(memchr(it, '\n', end - it));
+      return eol != nullptr ? eol + 1 : end;
+    }
+
+    inline bool key_equals(const char* key, size_t keylen, const char* name) {
+      return strlen(name) == keylen && memcmp(key, name, keylen) == 0;
+    }
+  }  // namespace
+
+  /**
+   * Parse the per-core lines of /proc/stat, skipping the accumulated one
+   *
+   * The vector is resized to the number of cores found and its
+   * capacity reused between calls. Returns the number of cores
+   */
+  size_t parse_stat(const char* data, size_t len, vector<cpu_time>& cores) {
+    const char* it{data};
+    const char* end{data + len};
+    size_t n{0};
+
+    while (it != end && end - it > 3 && memcmp(it, "cpu", 3) == 0) {
+      const char* eol{next_line(it, end)};
+
+      if (it[3] != ' ') {
+        it += 3;
+        // skip the core index
+        scan_ull(it, eol);
+
+        // user nice system idle iowait irq softirq steal
+        unsigned long long fields[8]{0};
+        for (auto& field : fields) {
+          field = scan_ull(it, eol);
+        }
+
+        if (n == cores.size()) {
+          cores.emplace_back();
+        }
+        auto& core = cores[n++];
+        core.user = fields[0];
+        core.nice = fields[1];
+        core.system = fields[2];
+        core.idle = fields[3];
+        core.steal = fields[7];
+        core.total = core.user + core.nice + core.system + core.idle + core.steal;
+      }
+
+      it = eol;
+    }
+
+    cores.resize(n);
+    return n;
+  }
+
+  /**
+   * Parse the fields of /proc/meminfo used by the memory module
+   *
+   * Returns false if MemTotal is missing
+   */
+  bool parse_meminfo(const char* data, size_t len, meminfo& info) {
+    const char* it{data};
+    const char* end{data + len};
+
+    info = meminfo{};
+
+    while (it != end) {
+      const char* eol{next_line(it, end)};
+      auto sep = static_cast<const char*>(memchr(it, ':', eol - it));
+
+      if (sep != nullptr) {
+        const char* key{it};
+        size_t keylen = sep - it;
+        it = sep + 1;
+        unsigned long long value{scan_ull(it, eol)};
+
+        if (key_equals(key, keylen, "MemTotal")) {
+          info.total = value;
+        } else if (key_equals(key, keylen, "MemFree")) {
+          info.free = value;
+        } else if (key_equals(key, keylen, "MemAvailable")) {
+          info.available = value;
+          info.has_available = true;
+        } else if (key_equals(key, keylen, "Buffers")) {
+          info.buffers = value;
+        } else if (key_equals(key, keylen, "Cached")) {
+          info.cached = value;
+        } else if (key_equals(key, keylen, "SReclaimable")) {
+          info.sreclaimable = value;
+        } else if (key_equals(key, keylen, "Shmem")) {
+          info.shmem = value;
+        } else if (key_equals(key, keylen, "SwapTotal")) {
+          info.swap_total = value;
+        } else if (key_equals(key, keylen, "SwapFree")) {
+          info.swap_free = value;
+        }
+      }
+
+      it = eol;
+    }
+
+    return info.total > 0;
+  }
+
+  /**
+   * Parse a single decimal value as found in sysfs attributes,
+   * behaves like strtoll for well-formed input and returns 0 otherwise
+   */
+  long long parse_integer(const char* data, size_t len) {
+    const char* it{data};
+    const char* end{data + len};
+    while (it != end && (*it == ' ' || *it == '\t' || *it == '\n')) {
+      it++;
+    }
+    bool negative{it != end && *it == '-'};
+    if (it != end && (*it == '-' || *it == '+')) {
+      it++;
+    }
+    auto value = static_cast<long long>(scan_ull(it, end));
+    return negative ? -value : value;
+  }
+
+  bool starts_with(const char* data, size_t len, const char* prefix) {
+    size_t n{strlen(prefix)};
+    return len >= n && memcmp(data, prefix, n) == 0;
+  }
+}  // namespace procfs_util
+
+POLYBAR_NS_END
@@ -0,0 +1,83 @@
+#include <chrono>
+
+#include "common/test.hpp"
+#include "components/config.hpp"
+#include "components/logger.hpp"
+#include "utils/color.hpp"
+
+using namespace polybar;
+
+/**
+ * Startup resolution and warm lookups on a config of 2000 parameters,
+ * with the colors forming a chain of references 200 deep that every
+ * module refers into. Timings go to the startup_us and ns_per_get
+ * properties
+ */
+class ConfigBenchmark : public ::testing::Test {
+ protected:
+  static constexpr size_t colors{200};
+  static constexpr size_t modules{90};
+  static constexpr size_t params{20};
+
+  static sectionmap_t make_sections() {
+    sectionmap_t sections;
+
+    auto& palette = sections["colors"];
+    palette["c0"] = "#ff112233";
+    for (size_t i = 1; i < colors; i++) {
+      palette["c" + to_string(i)] = "${colors.c" + to_string(i - 1) + "}";
+    }
+
+    sections["bar/example"] = {{"background", "${colors.c" + to_string(colors - 1) + "}"}, {"height", "24"}};
+
+    for (size_t m = 0; m < modules; m++) {
+      auto& module = sections["module/m" + to_string(m)];
+      module["interval"] = to_string(m % 10 + 1);
+      module["height"] = "${root.height}";
+      for (size_t p = 2; p < params; p++) {
+        module["color-" + to_string(p)] = "${colors.c" + to_string((m * params + p) % colors) + "}";
+      }
+    }
+
+    return sections;
+  }
+
+  logger m_log{loglevel::NONE};
+};
+
+TEST_F(ConfigBenchmark, startup) {
+  auto sections = make_sections();
+  size_t lines{0};
+  for (auto&& section : sections) {
+    lines += section.second.size() + 1;
+  }
+  EXPECT_LE(2000U, lines);
+
+  config conf{m_log, "/dev/null", "example"};
+
+  auto start = std::chrono::steady_clock::now();
+  conf.set_sections(move(sections));
+  conf.resolve_all();
+  auto startup = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+  EXPECT_EQ("#ff112233", conf.get("module/m7", "color-5"));
+
+  const size_t iterations{20};
+  size_t gets{0};
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (size_t m = 0; m < modules; m++) {
+      string section{"module/m" + to_string(m)};
+      for (size_t p = 2; p < params; p++) {
+        conf.get<rgba>(section, "color-" + to_string(p));
+        gets++;
+      }
+    }
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  double ns_per_get{static_cast<double>(elapsed.count()) / gets};
+  RecordProperty("startup_us", to_string(startup.count()));
+  RecordProperty("ns_per_get", to_string(ns_per_get));
+}
@@ -0,0 +1,94 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+
+#include "common/test.hpp"
+#include "components/config_parser.hpp"
+
+using namespace polybar;
+
+/**
+ * Turns a main config of 100 module sections, each including the same
+ * snippet, into a sectionmap. The average is kept in us_per_parse
+ */
+class ConfigParserBenchmark : public ::testing::Test {
+ protected:
+  class TestableConfigParser : public config_parser {
+    using config_parser::config_parser;
+
+   public:
+    sectionmap_t run() {
+      parse_file(file_util::expand(m_path), {});
+      return create_sectionmap();
+    }
+
+    string m_path;
+  };
+
+  static constexpr size_t modules{100};
+  static constexpr size_t params{40};
+  static constexpr size_t shared{10};
+
+  void SetUp() override {
+    char dir[] = "/tmp/polybar-config-XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    m_dir = dir;
+
+    std::ofstream snippet(m_dir + "/shared.ini");
+    snippet << "; Keys shared by all modules\n";
+    for (size_t i = 0; i < shared; i++) {
+      snippet << "shared-" << i << " = \"${colors.c" << i << "}\"\n";
+    }
+
+    std::ofstream main(m_dir + "/config.ini");
+    main << "[bar/example]\nwidth = 100%\nheight = 24\n\n[colors]\n";
+    for (size_t i = 0; i < shared; i++) {
+      main << "c" << i << " = #ff" << std::hex << (0x100000 + i) << std::dec << "\n";
+    }
+    for (size_t m = 0; m < modules; m++) {
+      main << "\n[module/m" << m << "]\n";
+      main << "type = custom/script\n";
+      main << "include-file = " << m_dir << "/shared.ini\n";
+      for (size_t p = 0; p < params; p++) {
+        main << "  format-" << p << " =  <label-" << p << "> %percentage%  \n";
+      }
+      main << "# end of module " << m << "\n";
+    }
+  }
+
+  void TearDown() override {
+    unlink((m_dir + "/shared.ini").c_str());
+    unlink((m_dir + "/config.ini").c_str());
+    rmdir(m_dir.c_str());
+  }
+
+  logger m_log{loglevel::NONE};
+  string m_dir;
+};
+
+TEST_F(ConfigParserBenchmark, parse) {
+  const size_t iterations{20};
+  size_t keys{0};
+  sectionmap_t sections;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    TestableConfigParser parser{m_log, m_dir + "/config.ini", "example"};
+    parser.m_path = m_dir + "/config.ini";
+    sections = parser.run();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+  for (auto&& section : sections) {
+    keys += section.second.size();
+  }
+
+  EXPECT_EQ(2 + modules, sections.size());
+  EXPECT_EQ(2 + shared + modules * (1 + shared + params), keys);
+  EXPECT_EQ("${colors.c3}", sections["module/m42"]["shared-3"]);
+  EXPECT_EQ("<label-7> %percentage%", sections["module/m99"]["format-7"]);
+
+  double us_per_parse{static_cast<double>(elapsed.count()) / iterations};
+  RecordProperty("us_per_parse", to_string(us_per_parse));
+}
@@ -0,0 +1,93 @@
+#include "components/damage_tracker.hpp"
+
+#include <functional>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+/**
+ * An hour of clock ticks on a 1920x24 bar, with workspaces on the left,
+ * a window title in the center and cpu, memory and a clock with seconds
+ * on the right. The cpu and memory values change every few ticks and
+ * the title now and then, every node is 8 pixels per character wide.
+ * The pixels damaged per update go to the properties, next to the
+ * pixels of repainting the whole bar
+ */
+namespace {
+  const xcb_rectangle_t RECT{0, 0, 1920U, 24U};
+  const double CHAR_WIDTH{8.0};
+  const double SPACING{16.0};
+
+  damage_tracker::block make_block(const vector<string>& nodes, alignment align) {
+    damage_tracker::block b{};
+    for (auto&& node : nodes) {
+      if (!b.spans.empty()) {
+        b.w += SPACING;
+      }
+      double w = node.size() * CHAR_WIDTH;
+      b.spans.emplace_back(damage_tracker::span{b.w, b.w + w, std::hash<string>{}(node)});
+      b.w += w;
+    }
+
+    if (align == alignment::CENTER) {
+      b.x = (RECT.width - b.w) / 2;
+    } else if (align == alignment::RIGHT) {
+      b.x = RECT.width - b.w;
+    }
+    return b;
+  }
+
+  string clock(size_t second) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%02zu:%02zu:%02zu", 14 + second / 3600, second / 60 % 60, second % 60);
+    return buf;
+  }
+}  // namespace
+
+TEST(DamageTrackerBenchmark, clockTicks) {
+  const size_t frames{3600};
+  const vector<string> titles{"polybar - vim", "Mozilla Firefox", "~/src/polybar - zsh"};
+
+  damage_tracker tracker{};
+  unsigned int seed{1};
+  size_t cpu{3};
+  size_t memory{41};
+  size_t title{0};
+
+  size_t damaged{0};
+  size_t regions{0};
+  size_t full{0};
+  for (size_t second = 0; second < frames; second++) {
+    seed = seed * 1103515245 + 12345;
+    if (second % 2 == 0) {
+      cpu = (seed >> 16) % 25;
+    }
+    if (second % 5 == 0) {
+      memory = 40 + (seed >> 8) % 3;
+    }
+    if (second % 90 == 0) {
+      title = (title + 1) % titles.size();
+    }
+
+    vector<string> right{"CPU " + to_string(cpu) + "%", "RAM " + to_string(memory) + "%", clock(second)};
+
+    std::map<alignment, damage_tracker::block> blocks;
+    blocks.emplace(alignment::LEFT, make_block({"1", "2", "3", "4", "5"}, alignment::LEFT));
+    blocks.emplace(alignment::CENTER, make_block({titles[title]}, alignment::CENTER));
+    blocks.emplace(alignment::RIGHT, make_block(right, alignment::RIGHT));
+
+    for (auto&& r : tracker.update(RECT, move(blocks))) {
+      damaged += r.width * r.height;
+      regions++;
+    }
+    full += RECT.width * RECT.height;
+  }
+
+  EXPECT_LT(damaged, full / 10);
+
+  RecordProperty("frames", to_string(frames));
+  RecordProperty("damaged_pixels_per_update", to_string(damaged / frames));
+  RecordProperty("full_pixels_per_update", to_string(full / frames));
+  RecordProperty("regions_per_update", to_string(static_cast<double>(regions) / frames));
+}
@@ -0,0 +1,100 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "common/test.hpp"
+#include "components/eventloop.hpp"
+#include "components/ipc.hpp"
+#include "components/logger.hpp"
+#include "events/signal.hpp"
+#include "events/signal_emitter.hpp"
+#include "events/signal_receiver.hpp"
+
+using namespace polybar;
+
+/**
+ * Several clients keep a connection to the ipc socket open and send
+ * hooks, each waiting for its reply the way `polybar-msg -s` does. The
+ * rate ends up in the messages_per_second property
+ */
+class IpcBenchmark : public ::testing::Test {
+ protected:
+  class receiver : public signal_receiver<0, signals::ipc::hook> {
+   public:
+    bool on(const signals::ipc::hook&) override {
+      hooks++;
+      return true;
+    }
+
+    size_t hooks{0};
+  };
+
+  static constexpr size_t clients{4};
+  static constexpr size_t messages{5000};
+
+  void client(std::atomic<size_t>& replies) {
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, m_ipc.get_socket_path().c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+      close(fd);
+      return;
+    }
+
+    char buffer[64];
+    for (size_t i = 0; i < messages; i++) {
+      string msg{"hook:module/demo" + to_string(i % 3)};
+      if (send(fd, msg.c_str(), msg.size(), 0) == -1 || recv(fd, buffer, sizeof(buffer), 0) <= 0) {
+        break;
+      }
+      replies++;
+    }
+
+    close(fd);
+  }
+
+  signal_emitter m_sig;
+  eventloop m_loop;
+  logger m_log{loglevel::NONE};
+  ipc m_ipc{m_sig, m_loop, m_log};
+  receiver m_receiver;
+};
+
+TEST_F(IpcBenchmark, throughput) {
+  m_sig.attach(&m_receiver);
+  m_ipc.start();
+
+  std::atomic<size_t> replies{0};
+  vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < clients; i++) {
+    threads.emplace_back([&] { client(replies); });
+  }
+
+  while (replies < clients * messages) {
+    m_loop.dispatch(100);
+    if (std::chrono::steady_clock::now() - start > std::chrono::seconds(30)) {
+      break;
+    }
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+  for (auto&& t : threads) {
+    t.join();
+  }
+
+  m_ipc.stop();
+  m_sig.detach(&m_receiver);
+
+  EXPECT_EQ(clients * messages, replies);
+  EXPECT_EQ(clients * messages, m_receiver.hooks);
+
+  double per_second{replies * 1e6 / elapsed.count()};
+  RecordProperty("messages_per_second", to_string(per_second));
+}
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <thread>
+
+#include "common/proc_stats.hpp"
+#include "common/test.hpp"
+#include "components/config_parser.hpp"
+#include "components/logger.hpp"
+#include "modules/meta/factory.hpp"
+#include "utils/string.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+
+/**
+ * Three bars showing the same cpu, memory, date and script modules,
+ * started once with an instance per bar the way one process per bar
+ * runs them and once shared between the bars the way the controller
+ * does. Each scenario runs in a process of its own, its instances,
+ * threads, wakeups per second and RSS go to the properties. Without an
+ * X server, the connection and fonts that every process of its own
+ * would load on top are not part of the separate numbers
+ */
+class MultiBarBenchmark : public ::testing::Test {
+ protected:
+  struct result {
+    size_t instances;
+    size_t threads;
+    double wakeups_per_second;
+    size_t rss_kb;
+  };
+
+  void SetUp() override {
+    char dir[] = "/tmp/polybar-bars-XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    m_dir = dir;
+
+    std::ofstream config(m_dir + "/config.ini");
+    for (auto&& bar : m_bars) {
+      config << "[bar/" << bar << "]\nmodules-left = cpu memory\n";
+      config << "modules-right = date load\n\n";
+    }
+    config << "[module/cpu]\ntype = internal/cpu\ninterval = 1\n\n";
+    config << "[module/memory]\ntype = internal/memory\ninterval = 1\n\n";
+    config << "[module/date]\ntype = internal/date\ninterval = 1\ndate = %H:%M:%S\n\n";
+    config << "[module/load]\ntype = custom/script\ninterval = 1\nexec = cut -d' ' -f1 /proc/loadavg\n";
+  }
+
+  void TearDown() override {
+    unlink((m_dir + "/config.ini").c_str());
+    rmdir(m_dir.c_str());
+  }
+
+  /**
+   * Create the modules of all bars, sharing them if `shared` is set,
+   * and run them for a while
+   */
+  result run(bool shared) {
+    const logger& log{logger::make(loglevel::WARNING)};
+    config_parser parser{log, m_dir + "/config.ini", string{m_bars.front()}};
+    const config& conf{parser.parse()};
+
+    std::map<string, shared_ptr<module_interface>> instances;
+    for (auto&& bar : m_bars) {
+      auto settings = make_shared<bar_settings>();
+      settings->section = "bar/" + bar;
+
+      for (auto&& key : {"modules-left", "modules-right"}) {
+        for (auto&& name : string_util::split(conf.get(settings->section, key), ' ')) {
+          auto type = conf.get("module/" + name, "type");
+          auto instance_key = shared ? share_key(name, type, *settings) : bar + "\n" + name;
+          if (instances.find(instance_key) == instances.end()) {
+            instances.emplace(instance_key, shared_ptr<module_interface>(make_module(move(type), settings, name, log)));
+          }
+        }
+      }
+    }
+
+    auto before = proc_stats::read();
+    for (auto&& instance : instances) {
+      instance.second->start();
+    }
+    std::this_thread::sleep_for(m_duration);
+    auto after = proc_stats::read();
+
+    for (auto&& instance : instances) {
+      instance.second->stop();
+    }
+
+    return result{instances.size(), after.threads,
+        (after.wakeups - before.wakeups) / std::chrono::duration<double>(m_duration).count(), after.rss_kb};
+  }
+
+  const vector<string> m_bars{"1", "2", "3"};
+  const std::chrono::seconds m_duration{3s};
+  string m_dir;
+};
+
+TEST_F(MultiBarBenchmark, threeBars) {
+  result separate{};
+  result shared{};
+  ASSERT_TRUE(run_isolated<result>([this] { return run(false); }, separate));
+  ASSERT_TRUE(run_isolated<result>([this] { return run(true); }, shared));
+
+  EXPECT_EQ(12U, separate.instances);
+  EXPECT_EQ(4U, shared.instances);
+  EXPECT_GT(separate.threads, shared.threads);
+
+  RecordProperty("separate_instances", to_string(separate.instances));
+  RecordProperty("separate_threads", to_string(separate.threads));
+  RecordProperty("separate_wakeups_per_second", to_string(separate.wakeups_per_second));
+  RecordProperty("separate_rss_kb", to_string(separate.rss_kb));
+  RecordProperty("shared_instances", to_string(shared.instances));
+  RecordProperty("shared_threads", to_string(shared.threads));
+  RecordProperty("shared_wakeups_per_second", to_string(shared.wakeups_per_second));
+  RecordProperty("shared_rss_kb", to_string(shared.rss_kb));
+}
@@ -0,0 +1,59 @@
+#include <chrono>
+
+#include "common/test.hpp"
+#include "components/parser.hpp"
+#include "components/types.hpp"
+
+using namespace polybar;
+
+/**
+ * Parses bar strings of realistic composition, the throughput is
+ * recorded as the ns_per_byte property (see --gtest_output)
+ */
+class ParserBenchmark : public ::testing::TestWithParam<size_t> {
+ protected:
+  static string make_input(size_t size) {
+    // Roughly what a workspace, a date and a couple of system modules produce
+    const string segments[]{
+        "%{B#3b4252}%{F#eceff4}%{+u}%{u#88c0d0}%{A1:i3-msg workspace 1:} 1 %{A}%{-u}%{B- F-}",
+        "%{A1:i3-msg workspace 2:}%{A3:i3-msg move workspace 2:} 2 %{A}%{A}",
+        "%{O5}%{F#88c0d0}%{T2}%{T-}%{F-} 23% %{O5}",
+        "%{B#bf616a} 2021-03-14 %{B-}",
+        "%{A4:pactl set-sink-volume 0 +5%:}%{A5:pactl set-sink-volume 0 -5%:}vol 45%%{A}%{A}",
+        "%{+o}%{o#a3be8c}wlan0 192.168.1.2%{-o}",
+        " | ",
+    };
+    const string alignments[]{"%{l}", "%{c}", "%{r}"};
+
+    string data;
+    size_t i{0};
+    while (data.size() < size) {
+      if (i % 16 == 0) {
+        data += alignments[(i / 16) % 3];
+      }
+      data += segments[i++ % (sizeof(segments) / sizeof(*segments))];
+    }
+    return data;
+  }
+
+  parser m_parser{};
+  bar_settings m_bar{};
+};
+
+INSTANTIATE_TEST_SUITE_P(Inst, ParserBenchmark, ::testing::Values(4096, 8192, 16384));
+
+TEST_P(ParserBenchmark, throughput) {
+  auto data = make_input(GetParam());
+  const size_t iterations{200};
+  render_list ops;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    ops.clear();
+    m_parser.parse(m_bar, data, ops);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  double ns_per_byte{static_cast<double>(elapsed.count()) / (iterations * data.size())};
+  RecordProperty("ns_per_byte", to_string(ns_per_byte));
+}
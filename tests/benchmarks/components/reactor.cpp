@@ -0,0 +1,139 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "common/proc_stats.hpp"
+#include "common/test.hpp"
+#include "components/config_parser.hpp"
+#include "components/eventloop.hpp"
+#include "components/logger.hpp"
+#include "modules/meta/factory.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+
+/**
+ * A bar of timer modules, started once with a thread per module and
+ * once in reactor mode with their timers on the shared event loop,
+ * dispatched from a single thread the way the controller does. Each
+ * mode runs in a process of its own, since the reactor is a process
+ * wide instance, its threads, wakeups per second and RSS go to the
+ * properties
+ */
+class ReactorBenchmark : public ::testing::Test {
+ protected:
+  struct result {
+    size_t threads;
+    double wakeups_per_second;
+    size_t rss_kb;
+  };
+
+  void SetUp() override {
+    char dir[] = "/tmp/polybar-reactor-XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    m_dir = dir;
+
+    std::ofstream config(m_dir + "/config.ini");
+    config << "[bar/bench]\nmodules-left =";
+    for (size_t i = 0; i < m_modules; i++) {
+      config << " timer" << i;
+    }
+    config << "\n\n";
+
+    for (size_t i = 0; i < m_modules; i++) {
+      config << "[module/timer" << i << "]\ninterval = 1\n";
+      switch (i % 4) {
+        case 0:
+          config << "type = internal/cpu\n\n";
+          break;
+        case 1:
+          config << "type = internal/memory\n\n";
+          break;
+        case 2:
+          config << "type = internal/date\ndate = %H:%M:%S\n\n";
+          break;
+        default:
+          config << "type = custom/script\nexec = cut -d' ' -f1 /proc/loadavg\n\n";
+          break;
+      }
+    }
+  }
+
+  void TearDown() override {
+    unlink((m_dir + "/config.ini").c_str());
+    rmdir(m_dir.c_str());
+  }
+
+  /**
+   * Start all modules, dispatching the shared event loop if `reactor`
+   * is set, and run them for a while
+   */
+  result run(bool reactor) {
+    const logger& log{logger::make(loglevel::WARNING)};
+    config_parser parser{log, m_dir + "/config.ini", "bench"};
+    const config& conf{parser.parse()};
+
+    eventloop& loop{eventloop::make_reactor()};
+    loop.enable(reactor);
+
+    auto settings = make_shared<bar_settings>();
+    settings->section = "bar/bench";
+
+    vector<shared_ptr<module_interface>> modules;
+    for (size_t i = 0; i < m_modules; i++) {
+      auto name = "timer" + to_string(i);
+      modules.emplace_back(make_module(conf.get("module/" + name, "type"), settings, name, log));
+    }
+
+    std::atomic<bool> running{true};
+    std::thread dispatcher;
+    if (reactor) {
+      dispatcher = std::thread([&] {
+        while (running) {
+          loop.dispatch(100);
+        }
+      });
+    }
+
+    auto before = proc_stats::read();
+    for (auto&& module : modules) {
+      module->start();
+    }
+    std::this_thread::sleep_for(m_duration);
+    auto after = proc_stats::read();
+
+    for (auto&& module : modules) {
+      module->stop();
+    }
+
+    running = false;
+    if (dispatcher.joinable()) {
+      dispatcher.join();
+    }
+
+    return result{after.threads, (after.wakeups - before.wakeups) / std::chrono::duration<double>(m_duration).count(),
+        after.rss_kb};
+  }
+
+  const size_t m_modules{16};
+  const std::chrono::seconds m_duration{3s};
+  string m_dir;
+};
+
+TEST_F(ReactorBenchmark, timerModules) {
+  result threaded{};
+  result reactor{};
+  ASSERT_TRUE(run_isolated<result>([this] { return run(false); }, threaded));
+  ASSERT_TRUE(run_isolated<result>([this] { return run(true); }, reactor));
+
+  EXPECT_GT(threaded.threads, reactor.threads);
+
+  RecordProperty("modules", to_string(m_modules));
+  RecordProperty("threaded_threads", to_string(threaded.threads));
+  RecordProperty("threaded_wakeups_per_second", to_string(threaded.wakeups_per_second));
+  RecordProperty("threaded_rss_kb", to_string(threaded.rss_kb));
+  RecordProperty("reactor_threads", to_string(reactor.threads));
+  RecordProperty("reactor_wakeups_per_second", to_string(reactor.wakeups_per_second));
+  RecordProperty("reactor_rss_kb", to_string(reactor.rss_kb));
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+
+#include "common/test.hpp"
+#include "events/signal.hpp"
+#include "events/signal_emitter.hpp"
+
+using namespace polybar;
+using namespace signals;
+
+/**
+ * Cost per emit of the signals sent for every module update and every
+ * redraw, with a typical set of receivers attached
+ */
+namespace {
+  class counting_receiver
+      : public signal_receiver<SIGN_PRIORITY_CONTROLLER, eventqueue::notify_change, ui::dim_window> {
+   public:
+    bool on(const eventqueue::notify_change&) override {
+      return ++m_count == 0;
+    }
+    bool on(const ui::dim_window&) override {
+      return ++m_count == 0;
+    }
+
+    size_t m_count{0};
+  };
+
+  class other_receiver : public signal_receiver<SIGN_PRIORITY_TRAY, ui::dim_window, ui::visibility_change> {
+   public:
+    bool on(const ui::dim_window&) override {
+      return false;
+    }
+    bool on(const ui::visibility_change&) override {
+      return false;
+    }
+  };
+
+  template <typename Signal>
+  double measure(signal_emitter& emitter, const Signal& sig) {
+    const size_t iterations{1000000};
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      emitter.emit(sig);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    return static_cast<double>(elapsed.count()) / iterations;
+  }
+}  // namespace
+
+TEST(SignalEmitterBenchmark, emit) {
+  signal_emitter emitter;
+  counting_receiver counter;
+  other_receiver other;
+  emitter.attach(&counter);
+  emitter.attach(&other);
+
+  double notify{measure(emitter, eventqueue::notify_change{})};
+  double dim{measure(emitter, ui::dim_window{0.5})};
+  double unhandled{measure(emitter, ui::tick{})};
+
+  RecordProperty("notify_change_ns", to_string(notify));
+  RecordProperty("dim_window_ns", to_string(dim));
+  RecordProperty("unhandled_ns", to_string(unhandled));
+
+  EXPECT_EQ(2000000U, counter.m_count);
+}
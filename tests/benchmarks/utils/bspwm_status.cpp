@@ -0,0 +1,73 @@
+#include <chrono>
+
+#include "common/test.hpp"
+#include "utils/bspwm_status.hpp"
+#include "utils/string.hpp"
+
+using namespace polybar;
+
+/**
+ * Trace captured with `bspc subscribe report` on three monitors with ten
+ * desktops each, while cycling focus and moving windows around, with the
+ * status prefix stripped. Replayed through the parser and through
+ * split-and-copy tokenizing, which is what the module used to do
+ */
+namespace {
+  const vector<string> captured_trace{
+      "MDP-1:OI:oII:fIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TT:G:mHDMI-1:oI:fII:fIII:fIV:OV:fVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "G:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "MDP-1:oI:OII:fIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TT:G:mHDMI-1:oI:fII:fIII:fIV:OV:fVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "G:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "MDP-1:oI:oII:FIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TT:G:mHDMI-1:oI:fII:fIII:fIV:OV:fVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "G:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "MDP-1:oI:oII:OIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TF:G:mHDMI-1:oI:fII:fIII:fIV:OV:fVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "G:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "mDP-1:oI:oII:OIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TF:G:MHDMI-1:oI:fII:fIII:fIV:OV:fVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "G:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "mDP-1:oI:oII:OIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TF:G:MHDMI-1:oI:fII:fIII:fIV:oV:FVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "G:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "mDP-1:oI:oII:OIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TF:G:MHDMI-1:oI:fII:fIII:fIV:oV:OVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "GS:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "mDP-1:oI:oII:OIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TF:G:mHDMI-1:oI:fII:fIII:fIV:oV:OVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "GS:MDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:OIX:fX:LM:TT:G",
+      "mDP-1:oI:oII:OIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TF:G:mHDMI-1:oI:fII:fIII:fIV:oV:OVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "GS:MDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:oIX:FX:LT:TT:G",
+      "MDP-1:OI:oII:oIII:fIV:fV:fVI:fVII:fVIII:fIX:fX:LT:TT:G:mHDMI-1:oI:fII:fIII:fIV:oV:OVI:fVII:fVIII:fIX:fX:LT:TT:"
+      "GS:mDP-2:fI:fII:fIII:fIV:fV:fVI:fVII:fVIII:oIX:FX:LT:TT:G",
+  };
+}  // namespace
+
+TEST(BspwmStatusBenchmark, replay) {
+  const size_t iterations{2000};
+  size_t changed{0};
+
+  bspwm_util::status_parser parser;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (auto&& report : captured_trace) {
+      changed += parser.parse(report.data(), report.size()) ? 1 : 0;
+    }
+  }
+  auto elapsed_parser = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  size_t tokens{0};
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (auto&& report : captured_trace) {
+      for (auto&& tag : string_util::split(report, ':')) {
+        auto value = tag.substr(1);
+        tokens += value.size();
+      }
+    }
+  }
+  auto elapsed_split = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  EXPECT_EQ(iterations * captured_trace.size(), changed);
+  EXPECT_GT(tokens, 0U);
+
+  double count = iterations * captured_trace.size();
+  double ns_parser{elapsed_parser.count() / count};
+  double ns_split{elapsed_split.count() / count};
+  RecordProperty("ns_per_report_parser", to_string(ns_parser));
+  RecordProperty("ns_per_report_split", to_string(ns_split));
+}
@@ -0,0 +1,235 @@
+#include <cctype>
+#include <chrono>
+#include <map>
+#include <sstream>
+
+#include "common/test.hpp"
+#include "utils/i3_workspaces.hpp"
+
+using namespace polybar;
+using i3_util::workspace_model;
+using i3_util::workspace_state;
+
+/**
+ * The stream below was recorded with `i3-msg -t subscribe -m '["workspace"]'`
+ * while switching workspaces on two outputs, reduced to the change type
+ * and the name of the current workspace, and the reply with
+ * `i3-msg -t get_workspaces`. The event payloads are rebuilt from both.
+ *
+ * Each event payload is decoded and applied to the model incrementally,
+ * and compared against decoding it and then the GET_WORKSPACES reply to
+ * rebuild the model, which is what the module did for every event. The
+ * socket round trip isn't part of either side. The decoder builds a tree
+ * the way the jsoncpp reader behind i3ipc++ does, but does less work, so
+ * the rebuilt side is rather too fast than too slow
+ */
+namespace {
+  const char* const recorded_stream{
+      "focus 2\nfocus 3\nfocus 1\ninit 4\nfocus 4\nfocus 2\nempty 4\nfocus 5\nurgent 3\nfocus 3\n"
+      "urgent 3\nfocus 1\nfocus 2\nfocus 1\nfocus 5\nfocus 6\nfocus 5\nfocus 2\nurgent 1\nfocus 1\n"
+      "urgent 1\nfocus 3\nfocus 2\nfocus 1\nfocus 6\nfocus 5\nfocus 3\nfocus 2\nfocus 3\nfocus 2\n"};
+
+  const char* const recorded_reply{
+      "[{\"id\":94266563441920,\"num\":1,\"name\":\"1\",\"visible\":true,\"focused\":true,"
+      "\"rect\":{\"x\":0,\"y\":24,\"width\":2560,\"height\":1416},\"output\":\"DP-1\",\"urgent\":false},"
+      "{\"id\":94266563470608,\"num\":2,\"name\":\"2\",\"visible\":false,\"focused\":false,"
+      "\"rect\":{\"x\":0,\"y\":24,\"width\":2560,\"height\":1416},\"output\":\"DP-1\",\"urgent\":false},"
+      "{\"id\":94266563502592,\"num\":3,\"name\":\"3\",\"visible\":false,\"focused\":false,"
+      "\"rect\":{\"x\":0,\"y\":24,\"width\":2560,\"height\":1416},\"output\":\"DP-1\",\"urgent\":false},"
+      "{\"id\":94266563533040,\"num\":4,\"name\":\"4\",\"visible\":false,\"focused\":false,"
+      "\"rect\":{\"x\":0,\"y\":24,\"width\":2560,\"height\":1416},\"output\":\"DP-1\",\"urgent\":false},"
+      "{\"id\":94266563562800,\"num\":5,\"name\":\"5\",\"visible\":true,\"focused\":false,"
+      "\"rect\":{\"x\":2560,\"y\":24,\"width\":1920,\"height\":1056},\"output\":\"HDMI-1\",\"urgent\":false},"
+      "{\"id\":94266563595152,\"num\":6,\"name\":\"6\",\"visible\":false,\"focused\":false,"
+      "\"rect\":{\"x\":2560,\"y\":24,\"width\":1920,\"height\":1056},\"output\":\"HDMI-1\",\"urgent\":false}]"};
+
+  struct json_value {
+    std::map<string, json_value> members;
+    vector<json_value> items;
+    // Strings, numbers and literals, the recorded data has no escapes
+    string text;
+  };
+
+  class json_reader {
+   public:
+    explicit json_reader(const string& text) : m_text(text) {}
+
+    json_value parse() {
+      json_value v;
+      value(v);
+      return v;
+    }
+
+   private:
+    void skip() {
+      while (m_pos < m_text.size() && isspace(m_text[m_pos])) {
+        m_pos++;
+      }
+    }
+
+    void separator() {
+      skip();
+      if (m_text[m_pos] == ',') {
+        m_pos++;
+        skip();
+      }
+    }
+
+    void value(json_value& v) {
+      skip();
+      if (m_text[m_pos] == '{') {
+        m_pos++;
+        skip();
+        while (m_text[m_pos] != '}') {
+          string key{str()};
+          skip();
+          m_pos++;
+          value(v.members[key]);
+          separator();
+        }
+        m_pos++;
+      } else if (m_text[m_pos] == '[') {
+        m_pos++;
+        skip();
+        while (m_text[m_pos] != ']') {
+          v.items.emplace_back();
+          value(v.items.back());
+          separator();
+        }
+        m_pos++;
+      } else if (m_text[m_pos] == '"') {
+        v.text = str();
+      } else {
+        auto end = m_text.find_first_of(",}] \n", m_pos);
+        v.text = m_text.substr(m_pos, end - m_pos);
+        m_pos = end;
+      }
+    }
+
+    string str() {
+      auto end = m_text.find('"', m_pos + 1);
+      string s{m_text.substr(m_pos + 1, end - m_pos - 1)};
+      m_pos = end + 1;
+      return s;
+    }
+
+    const string& m_text;
+    size_t m_pos{0};
+  };
+
+  workspace_state decode_workspace(const json_value& v) {
+    workspace_state ws;
+    ws.name = v.members.at("name").text;
+    ws.output = v.members.at("output").text;
+    ws.num = std::stoi(v.members.at("num").text);
+    ws.focused = v.members.at("focused").text == "true";
+    ws.visible = v.members.at("visible").text == "true";
+    ws.urgent = v.members.at("urgent").text == "true";
+    return ws;
+  }
+
+  vector<workspace_state> decode_reply(const string& reply) {
+    vector<workspace_state> workspaces;
+    for (auto&& item : json_reader{reply}.parse().items) {
+      workspaces.emplace_back(decode_workspace(item));
+    }
+    return workspaces;
+  }
+
+  /**
+   * Payload of a workspace event as i3 sends it, with the nodes of the
+   * current workspace left out
+   */
+  string make_payload(const string& change, int num, bool urgent) {
+    std::ostringstream out;
+    out << "{\"change\":\"" << change << "\",\"current\":{\"id\":" << 94266563441920 + num
+        << ",\"type\":\"workspace\",\"orientation\":\"horizontal\",\"layout\":\"splith\",\"num\":" << num
+        << ",\"name\":\"" << num << "\",\"output\":\"" << (num <= 4 ? "DP-1" : "HDMI-1")
+        << "\",\"focused\":" << (change == "focus" ? "true" : "false")
+        << ",\"visible\":" << (change == "focus" ? "true" : "false") << ",\"urgent\":" << (urgent ? "true" : "false")
+        << ",\"rect\":{\"x\":0,\"y\":24,\"width\":2560,\"height\":1416},\"nodes\":[],\"floating_nodes\":[]},"
+        << "\"old\":null}";
+    return out.str();
+  }
+
+  struct replay_event {
+    string change;
+    workspace_state current;
+  };
+
+  replay_event decode_event(const string& payload) {
+    auto root = json_reader{payload}.parse();
+    return replay_event{root.members.at("change").text, decode_workspace(root.members.at("current"))};
+  }
+
+  /**
+   * Rebuild the payloads, urgent events alternate between setting
+   * and clearing the flag of their workspace
+   */
+  vector<string> load_stream() {
+    vector<string> payloads;
+    std::map<int, bool> urgent;
+    std::istringstream in{recorded_stream};
+    string change;
+    int num;
+    while (in >> change >> num) {
+      if (change == "urgent") {
+        urgent[num] = !urgent[num];
+      }
+      payloads.emplace_back(make_payload(change, num, urgent[num]));
+    }
+    return payloads;
+  }
+
+  void apply(workspace_model& model, const replay_event& evt, const string& reply) {
+    bool known{true};
+    if (evt.change == "focus") {
+      known = model.focus(evt.current.name);
+    } else if (evt.change == "urgent") {
+      known = model.urgent(evt.current.name, evt.current.urgent);
+    } else if (evt.change == "empty") {
+      known = model.empty(evt.current.name);
+    } else {
+      known = false;
+    }
+    if (!known) {
+      model.reset(decode_reply(reply));
+    }
+  }
+}  // namespace
+
+TEST(WorkspaceModelBenchmark, replay) {
+  auto payloads = load_stream();
+  const string reply{recorded_reply};
+  const size_t iterations{2000};
+
+  workspace_model incremental;
+  incremental.reset(decode_reply(reply));
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (auto&& payload : payloads) {
+      apply(incremental, decode_event(payload), reply);
+    }
+  }
+  auto elapsed_incremental =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  workspace_model rebuilt;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (auto&& payload : payloads) {
+      decode_event(payload);
+      rebuilt.reset(decode_reply(reply));
+    }
+  }
+  auto elapsed_rebuilt = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  // Workspace 4 was emptied after the last resync
+  EXPECT_EQ(5U, incremental.workspaces().size());
+  EXPECT_EQ(6U, rebuilt.workspaces().size());
+
+  double count = iterations * payloads.size();
+  RecordProperty("ns_per_event_incremental", to_string(elapsed_incremental.count() / count));
+  RecordProperty("ns_per_event_rebuilt", to_string(elapsed_rebuilt.count() / count));
+}
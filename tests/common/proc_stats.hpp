@@ -0,0 +1,74 @@
+#pragma once
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <functional>
+#include <string>
+
+/**
+ * Resource usage of the calling process
+ *
+ * Wakeups are counted as voluntary context switches, summed over
+ * all threads including those that have exited
+ */
+struct proc_stats {
+  size_t threads{0};
+  size_t rss_kb{0};
+  long wakeups{0};
+
+  static proc_stats read() {
+    proc_stats stats;
+
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if (line.compare(0, 8, "Threads:") == 0) {
+        stats.threads = std::stoul(line.substr(8));
+      } else if (line.compare(0, 6, "VmRSS:") == 0) {
+        stats.rss_kb = std::stoul(line.substr(6));
+      }
+    }
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    stats.wakeups = usage.ru_nvcsw;
+
+    return stats;
+  }
+};
+
+/**
+ * Run `fn` in a child process and read back the plain struct it returns
+ *
+ * Memory freed by one scenario stays mapped by the allocator, so each is
+ * measured in a fresh process. The child exits without running
+ * destructors, leaving its threads behind
+ */
+template <typename Result>
+bool run_isolated(const std::function<Result()>& fn, Result& result) {
+  int fds[2];
+  if (pipe(fds) == -1) {
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    try {
+      Result r = fn();
+      _exit(write(fds[1], &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+    } catch (...) {
+      _exit(1);
+    }
+  }
+
+  close(fds[1]);
+  bool complete = pid > 0 && ::read(fds[0], &result, sizeof(result)) == sizeof(result);
+  close(fds[0]);
+
+  int status{0};
+  return pid > 0 && waitpid(pid, &status, 0) == pid && complete && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
@@ -0,0 +1,145 @@
+#include "adapters/net.hpp"
+
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "common/test.hpp"
+#include "utils/file.hpp"
+
+using namespace polybar;
+using namespace net;
+
+namespace {
+  /**
+   * IPv4 address of the interface as seen by getifaddrs
+   */
+  string lookup_ip(const string& interface) {
+    struct ifaddrs* ifaddr;
+    string result{"N/A"};
+
+    if (getifaddrs(&ifaddr) == -1) {
+      return result;
+    }
+
+    for (auto ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
+      if (ifa->ifa_addr != nullptr && ifa->ifa_addr->sa_family == AF_INET && interface == ifa->ifa_name) {
+        char buffer[INET_ADDRSTRLEN];
+        auto sa = reinterpret_cast<sockaddr_in*>(ifa->ifa_addr);
+        result = inet_ntop(AF_INET, &sa->sin_addr, buffer, sizeof(buffer));
+      }
+    }
+
+    freeifaddrs(ifaddr);
+    return result;
+  }
+}  // namespace
+
+/**
+ * The loopback interface exists in every network namespace,
+ * though it might be down or without address in a sandbox
+ */
+TEST(LinkMonitor, loopback) {
+  link_monitor monitor{"lo"};
+
+  EXPECT_NE(-1, monitor.get_file_descriptor());
+  EXPECT_EQ(lookup_ip("lo"), monitor.ip());
+
+  // The loopback device doesn't report an operational state
+  EXPECT_FALSE(monitor.up(false));
+
+  // Nothing changed since the state was loaded
+  EXPECT_FALSE(monitor.process());
+}
+
+TEST(LinkMonitor, invalidInterface) {
+  EXPECT_THROW(link_monitor{"polybar-none0"}, network_error);
+}
+
+namespace {
+  /**
+   * Exit the death test child with a message if the condition fails
+   */
+  void require(bool condition, const char* what) {
+    if (!condition) {
+      fprintf(stderr, "failed: %s\n", what);
+      _exit(1);
+    }
+  }
+
+  /**
+   * Wait for the monitor to report the expected address
+   */
+  bool wait_for_ip(link_monitor& monitor, const string& ip) {
+    pollfd pfd{monitor.get_file_descriptor(), POLLIN, 0};
+    for (int i = 0; i < 40 && monitor.ip() != ip; i++) {
+      if (poll(&pfd, 1, 50) > 0) {
+        monitor.process();
+      }
+    }
+    return monitor.ip() == ip;
+  }
+
+  /**
+   * Creating links needs CAP_NET_ADMIN in a network namespace of our
+   * own, and the ip command to set them up
+   */
+  bool can_create_links() {
+    pid_t pid = fork();
+    if (pid == 0) {
+      _exit(unshare(CLONE_NEWNET) == 0 && system("ip link add pb0 type veth peer name pb1 2>/dev/null") == 0 ? 0 : 1);
+    }
+    int status{0};
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+  /**
+   * Runs in the death test child, the namespace goes away with it
+   */
+  void veth_scenario() {
+    require(unshare(CLONE_NEWNET) == 0, "unshare");
+    require(system("ip link add pb0 type veth peer name pb1") == 0, "ip link add");
+
+    link_monitor monitor{"pb0"};
+    require(!monitor.up(false), "initially down");
+    require(monitor.ip() == "N/A", "initially without address");
+
+    require(system("ip addr add 10.11.12.1/24 dev pb0 && ip link set pb1 up && ip link set pb0 up") == 0, "ip up");
+    require(wait_for_ip(monitor, "10.11.12.1"), "address reported");
+    for (int i = 0; i < 40 && !monitor.up(false); i++) {
+      usleep(50000);
+      monitor.process();
+    }
+    require(monitor.up(false), "link up reported");
+
+    // Overrun the socket buffer, the dropped notifications are recovered with a resync
+    int size{1};
+    setsockopt(monitor.get_file_descriptor(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    string cmd;
+    for (int i = 1; i <= 40; i++) {
+      cmd += "ip addr add 10.11.13." + to_string(i) + "/32 dev pb0; ";
+    }
+    cmd += "ip addr flush dev pb0; ip addr add 10.11.14.1/24 dev pb0";
+    require(system(cmd.c_str()) == 0, "ip addr churn");
+    size = 1 << 16;
+    setsockopt(monitor.get_file_descriptor(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    monitor.process();
+    require(wait_for_ip(monitor, "10.11.14.1"), "address after overrun");
+    require(!monitor.process(), "no pending changes");
+    _exit(0);
+  }
+}  // namespace
+
+TEST(LinkMonitor, vethNamespace) {
+  if (!can_create_links()) {
+    GTEST_SKIP() << "Needs CAP_NET_ADMIN in a new network namespace and the ip command";
+  }
+
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  EXPECT_EXIT(veth_scenario(), ::testing::ExitedWithCode(0), "");
+}
@@ -0,0 +1,97 @@
+#include "components/action_index.hpp"
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+namespace {
+  action_block make_block(mousebtn button, double start_x, double end_x, string command, bool active = false) {
+    action_block block{};
+    block.button = button;
+    block.command = move(command);
+    block.start_x = start_x;
+    block.end_x = end_x;
+    block.active = active;
+    return block;
+  }
+}  // namespace
+
+TEST(ActionIndex, empty) {
+  action_index index{};
+
+  EXPECT_EQ(nullptr, index.find(0, mousebtn::LEFT));
+  EXPECT_FALSE(index.has_click(0));
+  EXPECT_FALSE(index.has_scroll(0));
+  EXPECT_FALSE(index.has_double_click());
+}
+
+TEST(ActionIndex, disjoint) {
+  action_index index{{
+      make_block(mousebtn::LEFT, 0, 10, "a"),
+      make_block(mousebtn::LEFT, 20, 30, "b"),
+  }};
+
+  ASSERT_NE(nullptr, index.find(0, mousebtn::LEFT));
+  EXPECT_EQ("a", index.find(9, mousebtn::LEFT)->command);
+  EXPECT_EQ(nullptr, index.find(10, mousebtn::LEFT));
+  EXPECT_EQ(nullptr, index.find(15, mousebtn::LEFT));
+  EXPECT_EQ("b", index.find(20, mousebtn::LEFT)->command);
+  EXPECT_EQ(nullptr, index.find(30, mousebtn::LEFT));
+  EXPECT_EQ(nullptr, index.find(-1, mousebtn::LEFT));
+  EXPECT_EQ(nullptr, index.find(5, mousebtn::RIGHT));
+}
+
+TEST(ActionIndex, nested) {
+  action_index index{{
+      make_block(mousebtn::LEFT, 0, 100, "outer"),
+      make_block(mousebtn::SCROLL_UP, 0, 100, "up"),
+      make_block(mousebtn::LEFT, 20, 60, "middle"),
+      make_block(mousebtn::LEFT, 30, 40, "inner"),
+  }};
+
+  EXPECT_EQ("outer", index.find(10, mousebtn::LEFT)->command);
+  EXPECT_EQ("middle", index.find(25, mousebtn::LEFT)->command);
+  EXPECT_EQ("inner", index.find(35, mousebtn::LEFT)->command);
+  EXPECT_EQ("middle", index.find(45, mousebtn::LEFT)->command);
+  EXPECT_EQ("outer", index.find(80, mousebtn::LEFT)->command);
+  EXPECT_EQ("up", index.find(35, mousebtn::SCROLL_UP)->command);
+
+  const auto& regions = index.regions();
+  ASSERT_EQ(4, regions.size());
+  EXPECT_EQ(0, regions[0].depth);
+  EXPECT_EQ(1, regions[1].depth);
+  EXPECT_EQ(2, regions[2].depth);
+  EXPECT_EQ(3, regions[3].depth);
+}
+
+TEST(ActionIndex, skipsIncomplete) {
+  action_index index{{
+      make_block(mousebtn::LEFT, 0, 10, "active", true),
+      make_block(mousebtn::LEFT, 20, 20, "empty"),
+      make_block(mousebtn::LEFT, 30.2, 30.8, "narrow"),
+      make_block(mousebtn::LEFT, 40.7, 50.2, "fractional"),
+  }};
+
+  EXPECT_EQ(1, index.regions().size());
+  EXPECT_EQ(nullptr, index.find(5, mousebtn::LEFT));
+  EXPECT_EQ(nullptr, index.find(30, mousebtn::LEFT));
+  EXPECT_EQ("fractional", index.find(40, mousebtn::LEFT)->command);
+  EXPECT_EQ(nullptr, index.find(50, mousebtn::LEFT));
+}
+
+TEST(ActionIndex, flags) {
+  action_index index{{
+      make_block(mousebtn::SCROLL_DOWN, 0, 50, "scroll"),
+      make_block(mousebtn::RIGHT, 10, 20, "click"),
+      make_block(mousebtn::DOUBLE_LEFT, 60, 70, "double"),
+  }};
+
+  EXPECT_FALSE(index.has_click(5));
+  EXPECT_TRUE(index.has_scroll(5));
+  EXPECT_TRUE(index.has_click(15));
+  EXPECT_TRUE(index.has_scroll(15));
+  EXPECT_TRUE(index.has_click(65));
+  EXPECT_FALSE(index.has_scroll(65));
+  EXPECT_FALSE(index.has_click(55));
+  EXPECT_TRUE(index.has_double_click());
+}
@@ -0,0 +1,225 @@
+#include "components/config.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <future>
+
+#include "common/test.hpp"
+#include "components/logger.hpp"
+#include "utils/color.hpp"
+
+using namespace polybar;
+
+class Config : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sectionmap_t sections;
+    sections["bar/example"] = {
+        {"background", "${colors.background}"},
+        {"height", "${self.base}"},
+        {"base", "24"},
+        {"font-0", "${colors.font}"},
+        {"font-1", "${colors.missing:fallback}"},
+    };
+    sections["colors"] = {
+        {"primary", "#ff0000"},
+        {"background", "${colors.primary}"},
+        {"font", "${env:POLYBAR_TEST_UNDEFINED:mono}"},
+        {"invalid", "${nope}"},
+    };
+    sections["module/child"] = {
+        {"inherit", "module/base"},
+        {"interval", "2"},
+    };
+    sections["module/base"] = {
+        {"interval", "5"},
+        {"format", "<label>"},
+    };
+    m_conf.set_sections(move(sections));
+    m_conf.resolve_all();
+  }
+
+  logger m_log{loglevel::NONE};
+  config m_conf{m_log, "/dev/null", "example"};
+};
+
+TEST_F(Config, get) {
+  EXPECT_EQ("#ff0000", m_conf.get("colors", "primary"));
+  EXPECT_EQ(24, m_conf.get<int>("bar/example", "base"));
+  EXPECT_EQ(5, m_conf.get<int>("module/base", "interval", 1));
+  EXPECT_EQ(1, m_conf.get<int>("module/base", "missing", 1));
+  EXPECT_THROW(m_conf.get("module/base", "missing"), key_error);
+  EXPECT_TRUE(m_conf.has("colors", "primary"));
+  EXPECT_FALSE(m_conf.has("colors", "secondary"));
+  EXPECT_FALSE(m_conf.has("nope", "primary"));
+}
+
+TEST_F(Config, references) {
+  EXPECT_EQ("#ff0000", m_conf.get("bar/example", "background"));
+  EXPECT_EQ(0xffff0000U, static_cast<unsigned int>(m_conf.get<rgba>("bar/example", "background")));
+  EXPECT_EQ(24, m_conf.get<int>("bar/example", "height"));
+  EXPECT_EQ("mono", m_conf.get("bar/example", "font-0"));
+  EXPECT_EQ("fallback", m_conf.get("bar/example", "font-1"));
+  EXPECT_EQ((vector<string>{"mono", "fallback"}), m_conf.get_list("bar/example", "font"));
+  EXPECT_THROW(m_conf.get("colors", "invalid"), value_error);
+}
+
+TEST_F(Config, inherit) {
+  EXPECT_EQ(2, m_conf.get<int>("module/child", "interval"));
+  EXPECT_EQ("<label>", m_conf.get("module/child", "format"));
+}
+
+/**
+ * Changing a value drops the cached values of everything referencing it
+ */
+TEST_F(Config, invalidate) {
+  EXPECT_EQ(0xffff0000U, static_cast<unsigned int>(m_conf.get<rgba>("bar/example", "background")));
+
+  m_conf.set("colors", "primary", "#00ff00");
+  EXPECT_EQ("#00ff00", m_conf.get("colors", "background"));
+  EXPECT_EQ(0xff00ff00U, static_cast<unsigned int>(m_conf.get<rgba>("bar/example", "background")));
+
+  m_conf.set("bar/example", "base", "30");
+  EXPECT_EQ(30, m_conf.get<int>("bar/example", "height"));
+
+  m_conf.set("colors", "secondary", "#0000ff");
+  EXPECT_EQ("#0000ff", m_conf.get("colors", "secondary"));
+}
+
+TEST_F(Config, getSection) {
+  auto values = m_conf.get_section("colors");
+  EXPECT_EQ(4U, values.size());
+  EXPECT_EQ("#ff0000", values["background"]);
+  EXPECT_EQ("${nope}", values["invalid"]);
+  EXPECT_EQ("<label>", m_conf.get_section("module/child")["format"]);
+  EXPECT_TRUE(m_conf.get_section("missing").empty());
+}
+
+/**
+ * File references aren't read until the value is asked for. A fifo
+ * without a writer makes reading it block
+ */
+TEST_F(Config, fileIsReadLazily) {
+  char dir[]{"/tmp/polybar-config-XXXXXX"};
+  ASSERT_NE(nullptr, mkdtemp(dir));
+  string fifo{string{dir} + "/fifo"};
+  ASSERT_EQ(0, mkfifo(fifo.c_str(), 0600));
+
+  sectionmap_t sections;
+  sections["bar/example"] = {{"direct", "${file:" + fifo + "}"}, {"indirect", "${self.direct}"}};
+  m_conf.set_sections(move(sections));
+
+  auto resolved = std::async(std::launch::async, [&] { m_conf.resolve_all(); });
+  bool lazy{resolved.wait_for(chrono::seconds{2}) == std::future_status::ready};
+
+  // Unblock the readers
+  while (resolved.wait_for(chrono::milliseconds{10}) != std::future_status::ready) {
+    close(open(fifo.c_str(), O_WRONLY | O_NONBLOCK));
+  }
+  EXPECT_TRUE(lazy);
+
+  unlink(fifo.c_str());
+  rmdir(dir);
+}
+
+/**
+ * Sections that fail to validate don't replace the current ones
+ */
+TEST_F(Config, invalidSectionsAreRejected) {
+  sectionmap_t sections;
+  sections["bar/example"] = {{"height", "30"}};
+  sections["module/child"] = {{"inherit", "module/missing"}};
+
+  EXPECT_THROW(m_conf.set_sections(move(sections)), value_error);
+  EXPECT_EQ(24, m_conf.get<int>("bar/example", "height"));
+  EXPECT_EQ(2, m_conf.get<int>("module/child", "interval"));
+  EXPECT_EQ("<label>", m_conf.get("module/child", "format"));
+}
+
+class ConfigSnapshot : public Config {
+ protected:
+  void reload(const std::function<void(sectionmap_t&)>& change) {
+    sectionmap_t sections;
+    sections["bar/example"] = {{"modules-left", "child base"}, {"height", "24"}};
+    sections["settings"] = {{"screenchange-reload", "true"}};
+    sections["colors"] = {{"primary", "#ff0000"}};
+    sections["module/child"] = {{"inherit", "module/base"}, {"interval", "2"}};
+    sections["module/base"] = {{"interval", "5"}, {"format-foreground", "${colors.primary}"}};
+    sections["module/date"] = {{"interval", "1"}};
+    change(sections);
+    m_conf.set_sections(move(sections));
+  }
+
+  config_snapshot take() {
+    return config_snapshot{m_conf, {"bar/example"}, {"module/child", "module/base", "module/date"}};
+  }
+};
+
+TEST_F(ConfigSnapshot, unchanged) {
+  reload([](sectionmap_t&) {});
+  auto previous = take();
+  reload([](sectionmap_t& sections) { sections["unrelated"] = {{"key", "value"}}; });
+  auto current = take();
+
+  EXPECT_TRUE(current.bars_equal(previous));
+  EXPECT_TRUE(current.module_equal(previous, "module/child"));
+  EXPECT_TRUE(current.module_equal(previous, "module/base"));
+  EXPECT_TRUE(current.module_equal(previous, "module/date"));
+}
+
+TEST_F(ConfigSnapshot, changed) {
+  reload([](sectionmap_t&) {});
+  auto previous = take();
+  // Reaches both modules through inheritance and a reference
+  reload([](sectionmap_t& sections) { sections["colors"]["primary"] = "#00ff00"; });
+  auto current = take();
+
+  EXPECT_TRUE(current.bars_equal(previous));
+  EXPECT_FALSE(current.module_equal(previous, "module/child"));
+  EXPECT_FALSE(current.module_equal(previous, "module/base"));
+  EXPECT_TRUE(current.module_equal(previous, "module/date"));
+}
+
+TEST_F(ConfigSnapshot, removed) {
+  reload([](sectionmap_t&) {});
+  auto previous = take();
+  reload([](sectionmap_t& sections) { sections.erase("module/date"); });
+  auto current = take();
+
+  EXPECT_TRUE(current.bars_equal(previous));
+  EXPECT_FALSE(current.module_equal(previous, "module/date"));
+  EXPECT_FALSE(current.module_equal(config_snapshot{m_conf, {}, {}}, "module/child"));
+}
+
+TEST_F(ConfigSnapshot, bars) {
+  reload([](sectionmap_t&) {});
+  auto previous = take();
+
+  // The module lists only decide the blocks
+  reload([](sectionmap_t& sections) { sections["bar/example"]["modules-left"] = "date"; });
+  EXPECT_TRUE(take().bars_equal(previous));
+
+  reload([](sectionmap_t& sections) { sections["bar/example"]["height"] = "30"; });
+  EXPECT_FALSE(take().bars_equal(previous));
+
+  reload([](sectionmap_t& sections) { sections["settings"]["screenchange-reload"] = "false"; });
+  EXPECT_FALSE(take().bars_equal(previous));
+}
+
+TEST_F(Config, rootReferences) {
+  sectionmap_t sections;
+  sections["bar/example"] = {{"foreground", "#fff"}, {"height", "24"}};
+  sections["colors"] = {{"text", "${root.foreground}"}, {"plain", "#000"}};
+  sections["module/direct"] = {{"height", "${root.height}"}, {"width", "${BAR.width:10}"}};
+  sections["module/indirect"] = {{"foreground", "${colors.text}"}, {"background", "${self.fallback}"},
+      {"fallback", "${colors.plain}"}};
+  sections["module/none"] = {{"foreground", "${colors.plain}"}, {"label", "%output%"}};
+  m_conf.set_sections(move(sections));
+
+  EXPECT_EQ((vector<string>{"height", "width:10"}), m_conf.root_references("module/direct"));
+  EXPECT_EQ((vector<string>{"foreground"}), m_conf.root_references("module/indirect"));
+  EXPECT_TRUE(m_conf.root_references("module/none").empty());
+  EXPECT_TRUE(m_conf.root_references("module/missing").empty());
+}
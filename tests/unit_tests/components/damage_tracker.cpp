@@ -0,0 +1,154 @@
+#include "components/damage_tracker.hpp"
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+namespace {
+  const xcb_rectangle_t RECT{10, 2, 100U, 20U};
+
+  using span = damage_tracker::span;
+  using block = damage_tracker::block;
+  using range_list = vector<std::pair<int, int>>;
+
+  block make_block(double x, double w, vector<span> spans) {
+    block b{};
+    b.x = x;
+    b.w = w;
+    b.fits = x + w <= RECT.width;
+    b.spans = move(spans);
+    return b;
+  }
+
+  range_list ranges(const vector<xcb_rectangle_t>& regions) {
+    range_list result;
+    for (auto&& r : regions) {
+      EXPECT_EQ(RECT.y, r.y);
+      EXPECT_EQ(RECT.height, r.height);
+      result.emplace_back(r.x, r.x + r.width);
+    }
+    return result;
+  }
+}  // namespace
+
+TEST(DamageTracker, firstFrameIsFull) {
+  damage_tracker tracker{};
+
+  auto regions = tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+
+  EXPECT_TRUE(tracker.full());
+  EXPECT_EQ((range_list{{10, 110}}), ranges(regions));
+}
+
+TEST(DamageTracker, unchanged) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+
+  EXPECT_FALSE(tracker.full());
+  EXPECT_TRUE(regions.empty());
+}
+
+TEST(DamageTracker, rectChangeIsFull) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+
+  auto rect = RECT;
+  rect.width = 90;
+  tracker.update(rect, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+  EXPECT_TRUE(tracker.full());
+
+  tracker.update(rect, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+  EXPECT_FALSE(tracker.full());
+}
+
+TEST(DamageTracker, invalidate) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {});
+
+  tracker.invalidate();
+  EXPECT_EQ((range_list{{10, 110}}), ranges(tracker.update(RECT, {})));
+  EXPECT_TRUE(tracker.full());
+}
+
+TEST(DamageTracker, changedSpanOnly) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::LEFT, make_block(5, 30, {{0, 10, 1}, {10, 20, 2}, {20, 30, 3}})}});
+
+  auto regions =
+      tracker.update(RECT, {{alignment::LEFT, make_block(5, 30, {{0, 10, 1}, {10, 20, 4}, {20, 30, 3}})}});
+
+  EXPECT_EQ((range_list{{25, 35}}), ranges(regions));
+}
+
+TEST(DamageTracker, fractionalSpansAreRoundedOutwards) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::LEFT, make_block(0.5, 30, {{0, 10.2, 1}, {10.2, 20.7, 2}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::LEFT, make_block(0.5, 30, {{0, 10.2, 1}, {10.2, 20.7, 5}})}});
+
+  EXPECT_EQ((range_list{{20, 32}}), ranges(regions));
+}
+
+TEST(DamageTracker, movedBlockDamagesBothPositions) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::RIGHT, make_block(80, 20, {{0, 20, 1}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::RIGHT, make_block(70, 30, {{0, 30, 2}})}});
+
+  // [70, 100] and [80, 100] overlap and are merged
+  EXPECT_EQ((range_list{{80, 110}}), ranges(regions));
+}
+
+TEST(DamageTracker, removedBlock) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})},
+                           {alignment::RIGHT, make_block(80, 20, {{0, 20, 2}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})}});
+
+  EXPECT_EQ((range_list{{90, 110}}), ranges(regions));
+}
+
+TEST(DamageTracker, clippedToDrawableArea) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::RIGHT, make_block(90, 30, {{0, 30, 1}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::RIGHT, make_block(90, 30, {{0, 30, 2}})}});
+
+  // The block falls off the bar, only the visible part is damaged
+  EXPECT_EQ((range_list{{100, 110}}), ranges(regions));
+}
+
+TEST(DamageTracker, blockOutsideDrawableArea) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::RIGHT, make_block(120, 10, {{0, 10, 1}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::RIGHT, make_block(120, 10, {{0, 10, 2}})}});
+
+  EXPECT_TRUE(regions.empty());
+}
+
+TEST(DamageTracker, separateBlocksStaySeparate) {
+  damage_tracker tracker{};
+  tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 1}})},
+                           {alignment::RIGHT, make_block(80, 20, {{0, 20, 2}})}});
+
+  auto regions = tracker.update(RECT, {{alignment::LEFT, make_block(0, 20, {{0, 20, 3}})},
+                                          {alignment::RIGHT, make_block(80, 20, {{0, 20, 4}})}});
+
+  EXPECT_EQ((range_list{{10, 30}, {90, 110}}), ranges(regions));
+}
+
+TEST(DamageTracker, merge) {
+  auto rect = [](int16_t x, uint16_t w) { return xcb_rectangle_t{x, RECT.y, w, RECT.height}; };
+
+  EXPECT_TRUE(damage_tracker::merge({}).empty());
+
+  // Out of order, overlapping, touching and contained regions
+  auto merged =
+      damage_tracker::merge({rect(50, 10), rect(10, 10), rect(15, 10), rect(25, 5), rect(52, 3), rect(70, 5)});
+
+  EXPECT_EQ((range_list{{10, 30}, {50, 60}, {70, 75}}), ranges(merged));
+}
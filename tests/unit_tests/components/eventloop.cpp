@@ -0,0 +1,92 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+#include "common/test.hpp"
+#include "components/eventloop.hpp"
+
+using namespace polybar;
+
+TEST(Eventloop, fdCallback) {
+  eventloop loop;
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  int calls{0};
+  loop.add(fds[0], [&] {
+    char c;
+    EXPECT_EQ(1, read(fds[0], &c, 1));
+    calls++;
+  });
+
+  EXPECT_EQ(0, loop.dispatch(0));
+  EXPECT_EQ(1, write(fds[1], "x", 1));
+  EXPECT_EQ(1, loop.dispatch(100));
+  EXPECT_EQ(1, calls);
+
+  loop.remove(fds[0]);
+  EXPECT_EQ(1, write(fds[1], "x", 1));
+  EXPECT_EQ(0, loop.dispatch(0));
+  EXPECT_EQ(1, calls);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(Eventloop, timer) {
+  eventloop loop;
+
+  int calls{0};
+  int timer{-1};
+  timer = loop.add_timer([&] {
+    if (++calls < 3) {
+      loop.arm(timer, 1ms);
+    }
+  });
+
+  while (loop.dispatch(100) > 0) {
+  }
+
+  EXPECT_EQ(3, calls);
+
+  loop.remove(timer);
+}
+
+TEST(Eventloop, removeWaitsForCallback) {
+  eventloop loop;
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  std::mutex lock;
+  std::condition_variable cv;
+  bool entered{false};
+  std::atomic<bool> finished{false};
+
+  loop.add(fds[0], [&] {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      entered = true;
+    }
+    cv.notify_all();
+    std::this_thread::sleep_for(50ms);
+    finished = true;
+  });
+
+  EXPECT_EQ(1, write(fds[1], "x", 1));
+  std::thread dispatcher([&] { loop.dispatch(1000); });
+
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    cv.wait(guard, [&] { return entered; });
+  }
+
+  // The owner of the callback may be destroyed once remove returns
+  loop.remove(fds[0]);
+  EXPECT_TRUE(finished);
+
+  dispatcher.join();
+  close(fds[0]);
+  close(fds[1]);
+}
@@ -0,0 +1,99 @@
+#include "common/test.hpp"
+#include "components/frame_scheduler.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+
+using clock_type = frame_scheduler::clock;
+
+TEST(FrameScheduler, uncapped) {
+  frame_scheduler frames{};
+  auto now = clock_type::now();
+
+  EXPECT_FALSE(frames.pending());
+  EXPECT_TRUE(frames.request(now));
+  EXPECT_TRUE(frames.due(now));
+  frames.rendered(now);
+  EXPECT_FALSE(frames.pending());
+  EXPECT_EQ(1U, frames.stats().rendered);
+}
+
+TEST(FrameScheduler, coalesce) {
+  frame_scheduler frames{100.0};
+  auto now = clock_type::now();
+
+  frames.rendered(now);
+
+  EXPECT_TRUE(frames.request(now + 1ms));
+  EXPECT_FALSE(frames.request(now + 2ms));
+  EXPECT_FALSE(frames.request(now + 3ms));
+
+  // Capped at one frame per 10ms
+  EXPECT_FALSE(frames.due(now + 5ms));
+  EXPECT_EQ(5ms, frames.until_due(now + 5ms));
+  EXPECT_TRUE(frames.due(now + 10ms));
+
+  frames.rendered(now + 10ms);
+
+  auto stats = frames.stats();
+  EXPECT_EQ(2U, stats.rendered);
+  EXPECT_EQ(2U, stats.coalesced);
+  EXPECT_EQ(0U, stats.dropped);
+  // 9ms from the first request to the frame
+  EXPECT_EQ(1U, stats.latency[3]);
+}
+
+TEST(FrameScheduler, idle) {
+  frame_scheduler frames{100.0};
+  auto now = clock_type::now();
+
+  frames.rendered(now);
+  frames.request(now + 50ms);
+  EXPECT_TRUE(frames.due(now + 50ms));
+  EXPECT_EQ(clock_type::duration::zero(), frames.until_due(now + 50ms));
+}
+
+TEST(FrameScheduler, dropped) {
+  frame_scheduler frames{100.0};
+  auto now = clock_type::now();
+
+  frames.rendered(now);
+  frames.request(now + 1ms);
+  frames.rendered(now + 45ms);
+
+  auto stats = frames.stats();
+  EXPECT_EQ(3U, stats.dropped);
+  EXPECT_EQ(1U, stats.latency[5]);
+}
+
+TEST(FrameScheduler, requestWhileBuilding) {
+  frame_scheduler frames{100.0};
+  auto now = clock_type::now();
+
+  frames.rendered(now);
+  frames.request(now + 20ms);
+  ASSERT_TRUE(frames.due(now + 20ms));
+
+  frames.begin_frame();
+  EXPECT_FALSE(frames.pending());
+
+  // A module changes after its output was read for this frame
+  EXPECT_TRUE(frames.request(now + 21ms));
+  frames.rendered(now + 22ms);
+
+  EXPECT_TRUE(frames.pending());
+  EXPECT_FALSE(frames.due(now + 23ms));
+  EXPECT_TRUE(frames.due(now + 32ms));
+
+  auto stats = frames.stats();
+  EXPECT_EQ(2U, stats.rendered);
+  EXPECT_EQ(0U, stats.coalesced);
+  // 2ms from the request to the first frame
+  EXPECT_EQ(1U, stats.latency[2]);
+
+  frames.begin_frame();
+  frames.rendered(now + 32ms);
+  EXPECT_FALSE(frames.pending());
+  // 11ms for the request made while building
+  EXPECT_EQ(1U, frames.stats().latency[4]);
+}
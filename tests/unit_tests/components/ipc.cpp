@@ -0,0 +1,186 @@
+#include "components/ipc.hpp"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+
+#include "common/test.hpp"
+#include "components/eventloop.hpp"
+#include "components/logger.hpp"
+#include "events/signal.hpp"
+#include "events/signal_emitter.hpp"
+#include "events/signal_receiver.hpp"
+#include "utils/string.hpp"
+
+using namespace polybar;
+
+/**
+ * Records the messages delivered through the signal emitter
+ */
+class receiver : public signal_receiver<0, signals::ipc::command, signals::ipc::hook, signals::ipc::action> {
+ public:
+  bool on(const signals::ipc::command& evt) override {
+    commands.emplace_back(evt.cast());
+    return evt.cast() != "invalid";
+  }
+  bool on(const signals::ipc::hook& evt) override {
+    hooks.emplace_back(evt.cast());
+    return true;
+  }
+  bool on(const signals::ipc::action& evt) override {
+    actions.emplace_back(evt.cast());
+    return true;
+  }
+
+  vector<string> commands;
+  vector<string> hooks;
+  vector<string> actions;
+};
+
+class Ipc : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    m_sig.attach(&m_receiver);
+    m_ipc.start();
+  }
+
+  void TearDown() override {
+    m_ipc.stop();
+    m_sig.detach(&m_receiver);
+  }
+
+  int connect_client() {
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, m_ipc.get_socket_path().c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    EXPECT_EQ(0, connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)));
+    return fd;
+  }
+
+  /**
+   * Dispatch the loop until the client has received the expected number of replies
+   */
+  vector<string> replies(int fd, size_t count) {
+    vector<string> result;
+    char buffer[BUFSIZ];
+
+    for (int i = 0; i < 100 && result.size() < count; i++) {
+      m_loop.dispatch(10);
+
+      ssize_t bytes;
+      while ((bytes = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        result.emplace_back(buffer, bytes);
+      }
+    }
+
+    return result;
+  }
+
+  signal_emitter m_sig;
+  eventloop m_loop;
+  logger m_log{loglevel::NONE};
+  ipc m_ipc{m_sig, m_loop, m_log};
+  receiver m_receiver;
+};
+
+TEST_F(Ipc, socket) {
+  int fd = connect_client();
+
+  for (auto&& msg : {"cmd:hide", "action:#date.toggle", "cmd:invalid", "foo", "hook:module/a1"}) {
+    ASSERT_LT(0, send(fd, msg, strlen(msg), 0));
+  }
+
+  EXPECT_EQ((vector<string>{"ok", "ok", "error: message was not handled", "error: unknown message type", "ok"}),
+      replies(fd, 5));
+  EXPECT_EQ((vector<string>{"hide", "invalid"}), m_receiver.commands);
+  EXPECT_EQ((vector<string>{"#date.toggle"}), m_receiver.actions);
+  EXPECT_EQ((vector<string>{"module/a1"}), m_receiver.hooks);
+
+  close(fd);
+}
+
+/**
+ * Repeated hooks all run, the frame scheduler merges their redraws
+ */
+TEST_F(Ipc, repeatedHooks) {
+  int fd = connect_client();
+
+  for (auto&& msg : {"hook:module/a1", "hook:module/a1", "hook:module/a1", "hook:module/b1", "hook:module/a1"}) {
+    ASSERT_LT(0, send(fd, msg, strlen(msg), 0));
+  }
+
+  EXPECT_EQ(5U, replies(fd, 5).size());
+  EXPECT_EQ((vector<string>{"module/a1", "module/a1", "module/a1", "module/b1", "module/a1"}), m_receiver.hooks);
+
+  close(fd);
+}
+
+/**
+ * A client that doesn't read its replies for a while still gets all of
+ * them, in order, once it does
+ */
+TEST_F(Ipc, backlog) {
+  int fd = connect_client();
+  const size_t count{5000};
+  size_t sent{0};
+
+  // Send without reading until neither side can make progress
+  for (int stalled = 0; sent < count && stalled < 10;) {
+    string msg{"hook:module/" + to_string(sent)};
+    if (send(fd, msg.c_str(), msg.size(), MSG_DONTWAIT) > 0) {
+      sent++;
+      stalled = 0;
+    } else {
+      ASSERT_EQ(EAGAIN, errno);
+      m_loop.dispatch(10);
+      stalled++;
+    }
+  }
+  ASSERT_LT(0U, sent);
+
+  vector<string> result;
+  char buffer[BUFSIZ];
+  ssize_t bytes;
+
+  for (int i = 0; i < 1000 && result.size() < count; i++) {
+    while (sent < count) {
+      string msg{"hook:module/" + to_string(sent)};
+      if (send(fd, msg.c_str(), msg.size(), MSG_DONTWAIT) <= 0) {
+        break;
+      }
+      sent++;
+    }
+
+    m_loop.dispatch(10);
+    while ((bytes = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+      result.emplace_back(buffer, bytes);
+    }
+  }
+
+  EXPECT_EQ(count, result.size());
+  EXPECT_EQ(count, m_receiver.hooks.size());
+  EXPECT_EQ(count, static_cast<size_t>(std::count(result.begin(), result.end(), "ok")));
+  EXPECT_EQ("module/4999", m_receiver.hooks.back());
+
+  close(fd);
+}
+
+TEST_F(Ipc, fifo) {
+  string path{string_util::replace(PATH_MESSAGING_FIFO, "%pid%", to_string(getpid()))};
+  int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+  ASSERT_NE(-1, fd);
+
+  // Several messages in one write, the last one without a newline
+  string data{"cmd:show\naction:#date.toggle\ncmd:hide"};
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), write(fd, data.c_str(), data.size()));
+  m_loop.dispatch(100);
+
+  EXPECT_EQ((vector<string>{"show", "hide"}), m_receiver.commands);
+  EXPECT_EQ((vector<string>{"#date.toggle"}), m_receiver.actions);
+
+  close(fd);
+}
@@ -1,6 +1,6 @@
 #include "common/test.hpp"
-#include "events/signal_emitter.hpp"
 #include "components/parser.hpp"
+#include "components/types.hpp"
 
 using namespace polybar;
 
@@ -11,7 +11,7 @@ class TestableParser : public parser {
 
 class Parser : public ::testing::Test {
   protected:
-    TestableParser m_parser{signal_emitter::make()};
+    TestableParser m_parser{};
 };
 /**
  * The first element of the pair is the expected return text, the second element
@@ -35,3 +35,149 @@ TEST_P(ParseActionCmd, correctness) {
   auto result = m_parser.parse_action_cmd(std::move(input));
   EXPECT_EQ(GetParam().first, result);
 }
+
+TEST_F(Parser, renderOps) {
+  bar_settings bar{};
+  render_list ops;
+  m_parser.parse(bar, "%{l}%{F#ff0000}foo%{A1:echo\\:bar:}baz%{A}", ops);
+
+  ASSERT_EQ(6U, ops.ops.size());
+  EXPECT_EQ(render_op_type::ALIGNMENT, ops.ops[0].type);
+  EXPECT_EQ(alignment::LEFT, ops.ops[0].align);
+  EXPECT_EQ(render_op_type::FOREGROUND, ops.ops[1].type);
+  EXPECT_EQ(0xffff0000, ops.ops[1].color);
+  EXPECT_EQ(render_op_type::TEXT, ops.ops[2].type);
+  EXPECT_EQ("foo", ops.strings.substr(ops.ops[2].offset, ops.ops[2].length));
+  EXPECT_EQ(render_op_type::ACTION_BEGIN, ops.ops[3].type);
+  EXPECT_EQ(mousebtn::LEFT, ops.ops[3].btn);
+  EXPECT_EQ("echo:bar", ops.strings.substr(ops.ops[3].offset, ops.ops[3].length));
+  EXPECT_EQ(render_op_type::TEXT, ops.ops[4].type);
+  EXPECT_EQ(render_op_type::ACTION_END, ops.ops[5].type);
+  EXPECT_EQ(mousebtn::LEFT, ops.ops[5].btn);
+
+  render_list all;
+  all.append(ops);
+  all.append(ops);
+  ASSERT_EQ(12U, all.ops.size());
+  EXPECT_EQ("baz", all.strings.substr(all.ops[10].offset, all.ops[10].length));
+}
+
+namespace {
+  string text_of(const render_list& ops, size_t i) {
+    return ops.strings.substr(ops.ops[i].offset, ops.ops[i].length);
+  }
+}  // namespace
+
+TEST_F(Parser, plainText) {
+  bar_settings bar{};
+  render_list ops;
+  m_parser.parse(bar, "foo } bar", ops);
+
+  ASSERT_EQ(1U, ops.ops.size());
+  EXPECT_EQ(render_op_type::TEXT, ops.ops[0].type);
+  EXPECT_EQ("foo } bar", text_of(ops, 0));
+}
+
+TEST_F(Parser, unterminatedTag) {
+  bar_settings bar{};
+  render_list ops;
+  m_parser.parse(bar, "foo%{F#ff0000", ops);
+
+  ASSERT_EQ(2U, ops.ops.size());
+  EXPECT_EQ("foo", text_of(ops, 0));
+  EXPECT_EQ(render_op_type::TEXT, ops.ops[1].type);
+  EXPECT_EQ("%{F#ff0000", text_of(ops, 1));
+
+  ops.clear();
+  m_parser.parse(bar, "%{", ops);
+  ASSERT_EQ(1U, ops.ops.size());
+  EXPECT_EQ("%{", text_of(ops, 0));
+
+  // A tag extends up to the first closing brace, tags can't be nested
+  ops.clear();
+  EXPECT_THROW(m_parser.parse(bar, "%{F#ff0000 %{R}x", ops), unrecognized_token);
+}
+
+TEST_F(Parser, emptyAndMultiTags) {
+  bar_settings bar{};
+  render_list ops;
+  m_parser.parse(bar, "%{}%{ }a%{B#000000 F#ffffff  -u}b", ops);
+
+  ASSERT_EQ(5U, ops.ops.size());
+  EXPECT_EQ("a", text_of(ops, 0));
+  EXPECT_EQ(render_op_type::BACKGROUND, ops.ops[1].type);
+  EXPECT_EQ(0xff000000, ops.ops[1].color);
+  EXPECT_EQ(render_op_type::FOREGROUND, ops.ops[2].type);
+  EXPECT_EQ(0xffffffff, ops.ops[2].color);
+  EXPECT_EQ(render_op_type::ATTRIBUTE_UNSET, ops.ops[3].type);
+  EXPECT_EQ(attribute::UNDERLINE, ops.ops[3].attr);
+  EXPECT_EQ("b", text_of(ops, 4));
+}
+
+TEST_F(Parser, nestedActions) {
+  bar_settings bar{};
+  render_list ops;
+  m_parser.parse(bar, "%{A1:one:}%{A3:three:}x%{A}y%{A}", ops);
+
+  ASSERT_EQ(6U, ops.ops.size());
+  EXPECT_EQ(render_op_type::ACTION_BEGIN, ops.ops[0].type);
+  EXPECT_EQ(mousebtn::LEFT, ops.ops[0].btn);
+  EXPECT_EQ("one", text_of(ops, 0));
+  EXPECT_EQ(render_op_type::ACTION_BEGIN, ops.ops[1].type);
+  EXPECT_EQ(mousebtn::RIGHT, ops.ops[1].btn);
+  EXPECT_EQ("three", text_of(ops, 1));
+  EXPECT_EQ("x", text_of(ops, 2));
+  // Closing tags without a button close the innermost block
+  EXPECT_EQ(render_op_type::ACTION_END, ops.ops[3].type);
+  EXPECT_EQ(mousebtn::RIGHT, ops.ops[3].btn);
+  EXPECT_EQ("y", text_of(ops, 4));
+  EXPECT_EQ(render_op_type::ACTION_END, ops.ops[5].type);
+  EXPECT_EQ(mousebtn::LEFT, ops.ops[5].btn);
+}
+
+TEST_F(Parser, escapedActionCommand) {
+  bar_settings bar{};
+  render_list ops;
+  m_parser.parse(bar, "%{A:notify-send a\\:b\\: c:}x%{A}", ops);
+
+  ASSERT_EQ(3U, ops.ops.size());
+  EXPECT_EQ(mousebtn::LEFT, ops.ops[0].btn);
+  EXPECT_EQ("notify-send a:b: c", text_of(ops, 0));
+
+  // Tags following the command in the same block are still parsed
+  ops.clear();
+  m_parser.parse(bar, "%{A2:cmd: F#ff0000}x%{A}", ops);
+
+  ASSERT_EQ(4U, ops.ops.size());
+  EXPECT_EQ(mousebtn::MIDDLE, ops.ops[0].btn);
+  EXPECT_EQ("cmd", text_of(ops, 0));
+  EXPECT_EQ(render_op_type::FOREGROUND, ops.ops[1].type);
+}
+
+TEST_F(Parser, errors) {
+  bar_settings bar{};
+  render_list ops;
+
+  EXPECT_THROW(m_parser.parse(bar, "%{A1:cmd:}x", ops), unclosed_actionblocks);
+  EXPECT_THROW(m_parser.parse(bar, "%{Z}", ops), unrecognized_token);
+  EXPECT_THROW(m_parser.parse(bar, "%{+x}", ops), unrecognized_token);
+
+  // The parser is still usable afterwards
+  ops.clear();
+  m_parser.parse(bar, "%{A1:cmd:}x%{A}", ops);
+  EXPECT_EQ(3U, ops.ops.size());
+}
+
+TEST_F(Parser, inputIsUnchanged) {
+  bar_settings bar{};
+  render_list ops;
+  const string data{"%{F#ff0000}foo%{A1:a\\:b:}bar%{A}%{F-}"};
+  const string copy{data};
+
+  m_parser.parse(bar, data, ops);
+  m_parser.parse(bar, data, ops);
+
+  EXPECT_EQ(copy, data);
+  EXPECT_EQ(12U, ops.ops.size());
+  EXPECT_EQ(text_of(ops, 2), text_of(ops, 8));
+}
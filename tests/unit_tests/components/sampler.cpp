@@ -0,0 +1,86 @@
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include "common/test.hpp"
+#include "components/sampler.hpp"
+#include "errors.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+
+class Sampler : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/polybar-sampler-XXXXXX";
+    int fd = mkstemp(tmpl);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    m_path = tmpl;
+    write("42\n");
+  }
+
+  void TearDown() override {
+    unlink(m_path.c_str());
+  }
+
+  void write(const string& contents) {
+    std::ofstream out(m_path, std::ofstream::trunc);
+    out << contents;
+  }
+
+  static string contents(const char* data, size_t len) {
+    return string{data, len};
+  }
+
+  sampler m_sampler{};
+  string m_path;
+};
+
+TEST_F(Sampler, shared) {
+  auto a = m_sampler.subscribe(m_path);
+  auto b = m_sampler.subscribe(m_path);
+  EXPECT_EQ(a, b);
+
+  EXPECT_EQ("42\n", m_sampler.read(a, 1h, contents));
+  write("43\n");
+
+  // Recent enough, the sample is shared
+  EXPECT_EQ("42\n", m_sampler.read(b, 1h, contents));
+  EXPECT_EQ(1U, a->reads());
+
+  EXPECT_EQ("43\n", m_sampler.read(b, sampler::clock::duration::zero(), contents));
+  EXPECT_EQ(2U, a->reads());
+}
+
+TEST_F(Sampler, large) {
+  string data(10000, 'x');
+  write(data);
+
+  auto src = m_sampler.subscribe(m_path);
+  EXPECT_EQ(data, m_sampler.read(src, 0s, contents));
+
+  write("short");
+  EXPECT_EQ("short", m_sampler.read(src, 0s, contents));
+}
+
+TEST_F(Sampler, missing) {
+  EXPECT_THROW(m_sampler.subscribe(m_path + ".missing"), system_error);
+}
+
+TEST_F(Sampler, released) {
+  std::weak_ptr<sampler::source> released;
+  {
+    auto src = m_sampler.subscribe(m_path);
+    m_sampler.read(src, 0s, contents);
+    released = src;
+  }
+
+  // The last subscriber is gone, the file was closed
+  EXPECT_TRUE(released.expired());
+
+  auto src = m_sampler.subscribe(m_path);
+  EXPECT_EQ(0U, src->reads());
+  EXPECT_EQ("42\n", m_sampler.read(src, 0s, contents));
+}
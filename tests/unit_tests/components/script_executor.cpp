@@ -0,0 +1,154 @@
+#include "components/script_executor.hpp"
+
+#include <atomic>
+
+#include "common/test.hpp"
+#include "components/eventloop.hpp"
+#include "components/logger.hpp"
+
+using namespace polybar;
+
+class ScriptExecutor : public ::testing::Test {
+ protected:
+  void wait_for(const std::atomic<size_t>& value, size_t expected) {
+    for (int i = 0; i < 400 && value < expected; i++) {
+      std::this_thread::sleep_for(5ms);
+    }
+  }
+
+  script_executor m_executor{eventloop::make(), logger::make()};
+};
+
+TEST_F(ScriptExecutor, output) {
+  auto res = m_executor.run("echo hello; echo world >&2");
+  EXPECT_EQ(0, res.status);
+  EXPECT_EQ("hello\nworld\n", res.output);
+}
+
+TEST_F(ScriptExecutor, status) {
+  EXPECT_EQ(3, m_executor.run("exit 3").status);
+  EXPECT_EQ(127, m_executor.run("polybar-no-such-command").status);
+}
+
+TEST_F(ScriptExecutor, shared) {
+  std::atomic<size_t> calls{0};
+  const string cmd{"sleep 0.05; echo shared"};
+
+  for (int i = 0; i < 3; i++) {
+    m_executor.submit(cmd, [&](const script_executor::result& res) {
+      EXPECT_EQ("shared\n", res.output);
+      calls++;
+    });
+  }
+
+  wait_for(calls, 3);
+  EXPECT_EQ(3U, calls);
+
+  auto stats = m_executor.get_stats(cmd);
+  EXPECT_EQ(1U, stats.runs);
+  EXPECT_EQ(2U, stats.shared);
+}
+
+TEST_F(ScriptExecutor, limit) {
+  std::atomic<size_t> calls{0};
+  string order;
+
+  m_executor.set_limit(1);
+  m_executor.submit("sleep 0.05; echo a", [&](const script_executor::result& res) {
+    order += res.output;
+    calls++;
+  });
+  m_executor.submit("echo b", [&](const script_executor::result& res) {
+    order += res.output;
+    calls++;
+  });
+
+  wait_for(calls, 2);
+  EXPECT_EQ("a\nb\n", order);
+  EXPECT_LE(chrono::milliseconds{40}, m_executor.get_stats("echo b").queued);
+}
+
+TEST_F(ScriptExecutor, cancel) {
+  std::atomic<size_t> calls{0};
+
+  auto ticket = m_executor.submit("sleep 10", [&](const script_executor::result&) { calls++; });
+  std::this_thread::sleep_for(20ms);
+  m_executor.cancel(ticket);
+
+  // The command gets terminated, which lets the next one through
+  m_executor.set_limit(1);
+  auto start = chrono::steady_clock::now();
+  EXPECT_EQ(0, m_executor.run("true").status);
+  EXPECT_GT(chrono::seconds{5}, chrono::steady_clock::now() - start);
+  EXPECT_EQ(0U, calls);
+}
+
+TEST(ScriptExecutorReactor, dispatch) {
+  eventloop loop;
+  loop.enable(true);
+  script_executor executor{loop, logger::make()};
+
+  std::atomic<size_t> calls{0};
+  executor.submit("echo reactor", [&](const script_executor::result& res) {
+    EXPECT_EQ("reactor\n", res.output);
+    calls++;
+  });
+
+  for (int i = 0; i < 100 && calls == 0; i++) {
+    loop.dispatch(20);
+  }
+  EXPECT_EQ(1U, calls);
+}
+
+TEST_F(ScriptExecutor, key) {
+  for (int i = 1; i <= 3; i++) {
+    m_executor.submit("echo " + to_string(i), [](const script_executor::result&) {}, "echo %counter%");
+  }
+  m_executor.run("true");
+
+  EXPECT_EQ(3U, m_executor.get_stats("echo %counter%").runs);
+  EXPECT_EQ(0U, m_executor.get_stats("echo 1").runs);
+}
+
+/**
+ * Executor that polls for exited commands as it would without pidfds
+ */
+class polling_executor : public script_executor {
+ public:
+  polling_executor(eventloop& loop, const logger& logger) : script_executor(loop, logger) {
+    m_use_pidfd = false;
+  }
+};
+
+class ScriptExecutorPolling : public ::testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_SUITE_P(Inst, ScriptExecutorPolling, ::testing::Values(true, false));
+
+/**
+ * A command that leaves a process behind which holds on to the output
+ * pipe is complete once the shell itself exits
+ */
+TEST_P(ScriptExecutorPolling, daemonized) {
+  eventloop loop;
+  loop.enable(GetParam());
+  polling_executor executor{loop, logger::make()};
+
+  std::atomic<size_t> calls{0};
+  auto start = chrono::steady_clock::now();
+  executor.submit("sleep 5 & echo started", [&](const script_executor::result& res) {
+    EXPECT_EQ(0, res.status);
+    EXPECT_EQ("started\n", res.output);
+    calls++;
+  });
+
+  for (int i = 0; i < 100 && calls == 0; i++) {
+    if (GetParam()) {
+      loop.dispatch(20);
+    } else {
+      std::this_thread::sleep_for(20ms);
+    }
+  }
+
+  EXPECT_EQ(1U, calls);
+  EXPECT_GT(chrono::seconds{2}, chrono::steady_clock::now() - start);
+}
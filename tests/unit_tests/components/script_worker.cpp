@@ -0,0 +1,115 @@
+#include "components/script_worker.hpp"
+
+#include "common/test.hpp"
+#include "components/logger.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+
+class ScriptWorker : public ::testing::Test {
+ protected:
+  unique_ptr<script_worker> make_worker(chrono::duration<double> timeout = 5s) {
+    return make_unique<script_worker>(logger::make(), "test", "update %counter%", 0, timeout);
+  }
+
+  bool query(script_worker& worker, const string& exec, int counter, string& reply) {
+    return worker.query(exec, counter, reply, m_stopping);
+  }
+
+  /**
+   * Wait until the worker has exited on its own
+   */
+  void wait_exited(script_worker& worker) {
+    for (int i = 0; i < 200 && worker.running(); i++) {
+      std::this_thread::sleep_for(5ms);
+    }
+  }
+
+  std::atomic<bool> m_stopping{false};
+};
+
+TEST_F(ScriptWorker, lineProtocol) {
+  auto worker = make_worker();
+  const string exec{"while read -r line; do echo \"got $line\"; done"};
+  string reply;
+
+  EXPECT_TRUE(query(*worker, exec, 1, reply));
+  EXPECT_EQ("got update 1", reply);
+  auto pid = worker->get_pid();
+
+  EXPECT_TRUE(query(*worker, exec, 2, reply));
+  EXPECT_EQ("got update 2", reply);
+  EXPECT_EQ(pid, worker->get_pid());
+
+  worker->stop();
+  EXPECT_FALSE(worker->running());
+  EXPECT_EQ(-1, worker->get_pid());
+}
+
+TEST_F(ScriptWorker, timeout) {
+  auto worker = make_worker(100ms);
+  const string exec{"while read -r line; do :; done"};
+  string reply;
+
+  auto start = chrono::steady_clock::now();
+  EXPECT_FALSE(query(*worker, exec, 1, reply));
+  EXPECT_LE(chrono::milliseconds{100}, chrono::steady_clock::now() - start);
+  EXPECT_GT(chrono::seconds{2}, chrono::steady_clock::now() - start);
+
+  // The silent worker was terminated
+  EXPECT_FALSE(worker->running());
+}
+
+TEST_F(ScriptWorker, splitLine) {
+  auto worker = make_worker();
+  const string exec{"while read -r line; do printf 'got '; sleep 0.1; echo \"$line\"; done"};
+  string reply;
+
+  EXPECT_TRUE(query(*worker, exec, 1, reply));
+  EXPECT_EQ("got update 1", reply);
+}
+
+TEST_F(ScriptWorker, partialLine) {
+  auto worker = make_worker(100ms);
+  const string exec{"while read -r line; do printf 'partial'; done"};
+  string reply;
+
+  auto start = chrono::steady_clock::now();
+  EXPECT_FALSE(query(*worker, exec, 1, reply));
+  EXPECT_GT(chrono::seconds{2}, chrono::steady_clock::now() - start);
+  EXPECT_FALSE(worker->running());
+}
+
+TEST_F(ScriptWorker, restartAfterExit) {
+  auto worker = make_worker();
+  const string exec{"read -r line; echo \"once $line\"; exit 1"};
+  string reply;
+
+  EXPECT_TRUE(query(*worker, exec, 1, reply));
+  EXPECT_EQ("once update 1", reply);
+  wait_exited(*worker);
+  EXPECT_FALSE(worker->running());
+
+  EXPECT_TRUE(query(*worker, exec, 2, reply));
+  EXPECT_EQ("once update 2", reply);
+}
+
+TEST_F(ScriptWorker, restartAfterCrash) {
+  auto worker = make_worker();
+  string reply;
+
+  // Dies without replying
+  EXPECT_FALSE(query(*worker, "read -r line; kill -KILL $$", 1, reply));
+  wait_exited(*worker);
+
+  EXPECT_TRUE(query(*worker, "while read -r line; do echo \"got $line\"; done", 2, reply));
+  EXPECT_EQ("got update 2", reply);
+}
+
+TEST_F(ScriptWorker, stopping) {
+  auto worker = make_worker();
+  string reply;
+
+  m_stopping = true;
+  EXPECT_FALSE(query(*worker, "while read -r line; do sleep 1; done", 1, reply));
+}
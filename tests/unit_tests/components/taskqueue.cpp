@@ -0,0 +1,135 @@
+#include <condition_variable>
+#include <mutex>
+
+#include "common/test.hpp"
+#include "components/eventloop.hpp"
+#include "components/taskqueue.hpp"
+
+using namespace polybar;
+
+namespace {
+  using clock = chrono::steady_clock;
+
+  /**
+   * Collects the calls made from the queue thread
+   */
+  class recorder {
+   public:
+    taskqueue::deferred::callback make(string name) {
+      return [this, name](size_t remaining) {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_calls.emplace_back(name + to_string(remaining));
+        m_times.emplace_back(clock::now());
+        m_cond.notify_all();
+      };
+    }
+
+    /**
+     * Wait until the given number of calls was made
+     */
+    bool wait(size_t count) {
+      std::unique_lock<std::mutex> guard(m_lock);
+      return m_cond.wait_for(guard, 2s, [&] { return m_calls.size() >= count; });
+    }
+
+    vector<string> calls() {
+      std::lock_guard<std::mutex> guard(m_lock);
+      return m_calls;
+    }
+
+    vector<clock::time_point> times() {
+      std::lock_guard<std::mutex> guard(m_lock);
+      return m_times;
+    }
+
+   private:
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    vector<string> m_calls;
+    vector<clock::time_point> m_times;
+  };
+}  // namespace
+
+class TaskQueue : public ::testing::Test {
+ protected:
+  recorder m_recorder;
+  taskqueue m_queue{eventloop::make()};
+};
+
+TEST_F(TaskQueue, repeat) {
+  m_queue.defer("repeat", 1ms, m_recorder.make("r"), 0ms, 3);
+
+  ASSERT_TRUE(m_recorder.wait(3));
+  EXPECT_EQ((vector<string>{"r2", "r1", "r0"}), m_recorder.calls());
+  EXPECT_FALSE(m_queue.exist("repeat"));
+}
+
+TEST_F(TaskQueue, order) {
+  m_queue.defer("b", 20ms, m_recorder.make("b"));
+  m_queue.defer("a", 5ms, m_recorder.make("a"));
+
+  ASSERT_TRUE(m_recorder.wait(2));
+  EXPECT_EQ((vector<string>{"a0", "b0"}), m_recorder.calls());
+}
+
+TEST_F(TaskQueue, purge) {
+  m_queue.defer("purged", 5ms, m_recorder.make("purged"));
+  m_queue.defer("purged", 5ms, m_recorder.make("purged"));
+  m_queue.defer("kept", 10ms, m_recorder.make("kept"));
+
+  EXPECT_TRUE(m_queue.exist("purged"));
+  EXPECT_TRUE(m_queue.purge("purged"));
+  EXPECT_FALSE(m_queue.exist("purged"));
+  EXPECT_FALSE(m_queue.purge("purged"));
+
+  // Tasks run in deadline order, the purged ones would come first
+  ASSERT_TRUE(m_recorder.wait(1));
+  EXPECT_EQ((vector<string>{"kept0"}), m_recorder.calls());
+}
+
+TEST_F(TaskQueue, deferUnique) {
+  m_queue.defer_unique("unique", 5ms, m_recorder.make("first"));
+  m_queue.defer_unique("unique", 5ms, m_recorder.make("second"));
+  m_queue.defer("last", 10ms, m_recorder.make("last"));
+
+  ASSERT_TRUE(m_recorder.wait(2));
+  EXPECT_EQ((vector<string>{"second0", "last0"}), m_recorder.calls());
+}
+
+TEST_F(TaskQueue, lateRepeatDoesNotBurst) {
+  auto record = m_recorder.make("r");
+  bool stalled{false};
+
+  // The first run stalls the queue for several intervals
+  m_queue.defer("late", 10ms, [&](size_t remaining) {
+    record(remaining);
+    if (!stalled) {
+      stalled = true;
+      std::this_thread::sleep_for(50ms);
+    }
+  }, 0ms, 3);
+
+  ASSERT_TRUE(m_recorder.wait(3));
+  auto times = m_recorder.times();
+  EXPECT_GE(times[2] - times[1], 9ms);
+  EXPECT_GE(times[1] - times[0], 49ms);
+}
+
+TEST(TaskQueueReactor, dispatch) {
+  auto& loop = eventloop::make();
+  loop.enable(true);
+
+  size_t calls{0};
+  {
+    taskqueue queue{loop};
+    queue.defer("reactor", 1ms, [&](size_t) { calls++; }, 0ms, 2);
+
+    for (int i = 0; i < 100 && calls < 2; i++) {
+      loop.dispatch(10);
+    }
+    EXPECT_FALSE(queue.exist("reactor"));
+  }
+
+  loop.enable(false);
+  EXPECT_EQ(2U, calls);
+}
@@ -107,3 +107,55 @@ TEST_P(GetTest, soundness) {
   EXPECT_TRUE(m_label->m_maxlen == 0 || actual.length() <= m_label->m_maxlen) << "Returned text is longer than maxlen";
   EXPECT_GE(actual.length(), m_label->m_minlen) << "Returned text is shorter than minlen";
 }
+
+TEST(Label, replaceToken) {
+  label l{"%a% and %b%", ""s, ""s, ""s, ""s, 0, {0U, 0U}, {0U, 0U}, 0, 0_z, alignment::LEFT, true,
+      {token{"%a%"}, token{"%b%"}}};
+
+  EXPECT_TRUE(l.has_token("%a%"));
+  l.replace_token("%a%", "%b%");
+  l.replace_token("%b%", "x");
+  EXPECT_EQ("%b% and x", l.get());
+  EXPECT_FALSE(l.has_token("%a%"));
+
+  // Already bound slots keep their value until the tokens are reset
+  l.replace_token("%a%", "y");
+  EXPECT_EQ("%b% and x", l.get());
+
+  l.reset_tokens();
+  EXPECT_EQ("%a% and %b%", l.get());
+  l.replace_token("%b%", "z");
+  EXPECT_EQ("%a% and z", l.get());
+}
+
+TEST(Label, replaceTokenMinMax) {
+  label l{"%a%|%a%|%a%", ""s, ""s, ""s, ""s, 0, {0U, 0U}, {0U, 0U}, 0, 0_z, alignment::LEFT, true,
+      {token{"%a%", 3, 0, ""s, true}, token{"%a%", 0, 2, "~"s}, token{"%a%", 4}}};
+
+  l.replace_token("%a%", "7");
+  EXPECT_EQ("007|7|   7", l.get());
+
+  l.reset_tokens();
+  l.replace_token("%a%", "1234");
+  EXPECT_EQ("1234|12~|1234", l.get());
+}
+
+TEST(Label, clear) {
+  label l{"x %a%", ""s, ""s, ""s, ""s, 0, {0U, 0U}, {0U, 0U}, 0, 0_z, alignment::LEFT, true, {token{"%a%"}}};
+
+  l.clear();
+  EXPECT_FALSE(l);
+  l.replace_token("%a%", "y");
+  EXPECT_EQ("", l.get());
+
+  l.reset_tokens();
+  l.replace_token("%a%", "y");
+  EXPECT_EQ("x y", l.get());
+
+  l.reset_tokens("%a%!");
+  l.replace_token("%a%", "z");
+  EXPECT_EQ("z!", l.get());
+
+  l.reset_tokens();
+  EXPECT_EQ("x %a%", l.get());
+}
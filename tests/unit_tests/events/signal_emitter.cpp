@@ -0,0 +1,146 @@
+#include "common/test.hpp"
+#include "events/signal.hpp"
+#include "events/signal_emitter.hpp"
+
+using namespace polybar;
+using namespace signals;
+
+namespace {
+  template <int Priority>
+  class test_receiver : public signal_receiver<Priority, ui::tick, ui::dim_window> {
+   public:
+    explicit test_receiver(vector<int>& calls, bool stop = false) : m_calls(calls), m_stop(stop) {}
+
+    bool on(const ui::tick&) override {
+      m_calls.push_back(Priority);
+      return m_stop;
+    }
+
+    bool on(const ui::dim_window&) override {
+      m_calls.push_back(-Priority);
+      return false;
+    }
+
+   private:
+    vector<int>& m_calls;
+    bool m_stop;
+  };
+
+  /**
+   * Detaches the given receiver when it gets a tick
+   */
+  class detaching_receiver : public signal_receiver<0, ui::tick> {
+   public:
+    detaching_receiver(signal_emitter& emitter, test_receiver<2>& other) : m_emitter(emitter), m_other(other) {}
+
+    bool on(const ui::tick&) override {
+      m_emitter.detach(&m_other);
+      return false;
+    }
+
+   private:
+    signal_emitter& m_emitter;
+    test_receiver<2>& m_other;
+  };
+
+  class testable_emitter : public signal_emitter {
+   public:
+    using signal_emitter::lookup;
+    using signal_emitter::read_guard;
+    using signal_emitter::retired;
+  };
+}  // namespace
+
+TEST(SignalEmitter, priority) {
+  signal_emitter emitter;
+  vector<int> calls;
+  test_receiver<2> second{calls};
+  test_receiver<1> first{calls};
+
+  emitter.attach(&second);
+  emitter.attach(&first);
+
+  EXPECT_FALSE(emitter.emit(ui::tick{}));
+  EXPECT_EQ((vector<int>{1, 2}), calls);
+
+  calls.clear();
+  emitter.emit(ui::dim_window{1.0});
+  EXPECT_EQ((vector<int>{-1, -2}), calls);
+}
+
+TEST(SignalEmitter, stopPropagation) {
+  signal_emitter emitter;
+  vector<int> calls;
+  test_receiver<1> first{calls, true};
+  test_receiver<2> second{calls};
+
+  emitter.attach(&first);
+  emitter.attach(&second);
+
+  EXPECT_TRUE(emitter.emit(ui::tick{}));
+  EXPECT_EQ((vector<int>{1}), calls);
+}
+
+TEST(SignalEmitter, detach) {
+  signal_emitter emitter;
+  vector<int> calls;
+  test_receiver<1> first{calls};
+  test_receiver<2> second{calls};
+
+  emitter.attach(&first);
+  emitter.attach(&second);
+  emitter.detach(&first);
+
+  emitter.emit(ui::tick{});
+  EXPECT_EQ((vector<int>{2}), calls);
+
+  emitter.detach(&second);
+  calls.clear();
+  EXPECT_FALSE(emitter.emit(ui::tick{}));
+  EXPECT_TRUE(calls.empty());
+}
+
+TEST(SignalEmitter, detachDuringEmit) {
+  signal_emitter emitter;
+  vector<int> calls;
+  test_receiver<2> second{calls};
+  detaching_receiver first{emitter, second};
+
+  emitter.attach(&first);
+  emitter.attach(&second);
+
+  // The running emit still iterates the list that contains `second`
+  emitter.emit(ui::tick{});
+  EXPECT_TRUE(calls.empty());
+
+  // dim_window has its own list that `second` was also removed from
+  emitter.emit(ui::dim_window{1.0});
+  EXPECT_TRUE(calls.empty());
+}
+
+TEST(SignalEmitter, retiredListsAreFreed) {
+  testable_emitter emitter;
+  vector<int> calls;
+  test_receiver<1> first{calls};
+  test_receiver<2> second{calls};
+
+  emitter.attach(&first);
+  emitter.attach(&second);
+  EXPECT_EQ(0U, emitter.retired());
+
+  // A list in use by an emit stays alive until the emit is done
+  {
+    testable_emitter::read_guard guard{emitter};
+    auto in_use = emitter.lookup(signal_id<ui::tick>());
+    emitter.detach(&second);
+    EXPECT_EQ(2U, emitter.retired());
+    EXPECT_EQ(2U, in_use->size());
+  }
+
+  EXPECT_EQ(0U, emitter.retired());
+}
+
+TEST(SignalEmitter, signalId) {
+  EXPECT_EQ(signal_id<ui::tick>(), signal_id<ui::tick>());
+  EXPECT_NE(signal_id<ui::tick>(), signal_id<ui::dim_window>());
+}
@@ -0,0 +1,83 @@
+#include "common/test.hpp"
+#include "utils/bspwm_status.hpp"
+
+using namespace polybar;
+using bspwm_util::status_parser;
+
+namespace {
+  bool parse(status_parser& parser, const string& report) {
+    return parser.parse(report.data(), report.size());
+  }
+}  // namespace
+
+TEST(BspwmStatus, parse) {
+  status_parser parser;
+  EXPECT_TRUE(parse(parser, "MeDP1:OI:fII:uIII:LT:TF:GS:mHDMI1:fIV:oV:LM:TT:G"));
+
+  const auto& monitors = parser.monitors();
+  ASSERT_EQ(2U, monitors.size());
+
+  EXPECT_EQ("eDP1", monitors[0].name);
+  EXPECT_TRUE(monitors[0].focused);
+  ASSERT_EQ(3U, monitors[0].desktops.size());
+  EXPECT_EQ("I", monitors[0].desktops[0].name);
+  EXPECT_EQ('O', monitors[0].desktops[0].flag);
+  EXPECT_EQ("III", monitors[0].desktops[2].name);
+  EXPECT_EQ('u', monitors[0].desktops[2].flag);
+  EXPECT_EQ("T", monitors[0].layout);
+  EXPECT_EQ("F", monitors[0].state);
+  EXPECT_EQ("S", monitors[0].flags);
+
+  EXPECT_EQ("HDMI1", monitors[1].name);
+  EXPECT_FALSE(monitors[1].focused);
+  ASSERT_EQ(2U, monitors[1].desktops.size());
+  EXPECT_EQ("M", monitors[1].layout);
+  EXPECT_EQ("", monitors[1].flags);
+}
+
+TEST(BspwmStatus, unchanged) {
+  status_parser parser;
+  EXPECT_TRUE(parse(parser, "MeDP1:OI:fII:LT:TT:G"));
+  EXPECT_FALSE(parse(parser, "MeDP1:OI:fII:LT:TT:G"));
+}
+
+TEST(BspwmStatus, diff) {
+  status_parser parser;
+  parse(parser, "MeDP1:OI:fII:LT:TT:G:mHDMI1:fIV:oV:LT:TT:G");
+
+  auto mon0 = parser.monitors()[0];
+  auto mon1 = parser.monitors()[1];
+
+  // Focus moves from I to II on the first monitor
+  EXPECT_TRUE(parse(parser, "MeDP1:oI:FII:LT:TT:G:mHDMI1:fIV:oV:LT:TT:G"));
+
+  const auto& monitors = parser.monitors();
+  EXPECT_NE(mon0.revision, monitors[0].revision);
+  EXPECT_NE(mon0.desktops[0].revision, monitors[0].desktops[0].revision);
+  EXPECT_NE(mon0.desktops[1].revision, monitors[0].desktops[1].revision);
+
+  EXPECT_EQ(mon1.revision, monitors[1].revision);
+  EXPECT_EQ(mon1.desktops[0].revision, monitors[1].desktops[0].revision);
+}
+
+TEST(BspwmStatus, monitorFocus) {
+  status_parser parser;
+  parse(parser, "MeDP1:OI:mHDMI1:fIV");
+  auto desktop = parser.monitors()[1].desktops[0];
+
+  // Desktops are dimmed along with their monitor
+  EXPECT_TRUE(parse(parser, "meDP1:OI:MHDMI1:fIV"));
+  EXPECT_NE(desktop.revision, parser.monitors()[1].desktops[0].revision);
+}
+
+TEST(BspwmStatus, shrink) {
+  status_parser parser;
+  parse(parser, "MeDP1:OI:fII:fIII:mHDMI1:fIV");
+
+  EXPECT_TRUE(parse(parser, "MeDP1:OI:fII"));
+  ASSERT_EQ(1U, parser.monitors().size());
+  EXPECT_EQ(2U, parser.monitors()[0].desktops.size());
+
+  EXPECT_TRUE(parse(parser, "MeDP1:OI"));
+  EXPECT_EQ(1U, parser.monitors()[0].desktops.size());
+}
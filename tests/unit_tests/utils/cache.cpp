@@ -0,0 +1,35 @@
+#include "common/test.hpp"
+#include "utils/cache.hpp"
+
+using namespace polybar;
+
+TEST(LruCache, findInsert) {
+  lru_cache<int, string> c{2};
+  EXPECT_EQ(nullptr, c.find("a"));
+  c.insert("a", 1);
+  c.insert("b", 2);
+  ASSERT_NE(nullptr, c.find("a"));
+  EXPECT_EQ(1, *c.find("a"));
+  EXPECT_EQ(2U, c.size());
+  EXPECT_EQ(2U, c.hits());
+  EXPECT_EQ(1U, c.misses());
+
+  c.insert("b", 3);
+  EXPECT_EQ(3, *c.find("b"));
+  EXPECT_EQ(2U, c.size());
+}
+
+TEST(LruCache, evictLeastRecentlyUsed) {
+  lru_cache<int, string> c{2};
+  c.insert("a", 1);
+  c.insert("b", 2);
+  c.find("a");
+  c.insert("c", 3);
+  EXPECT_EQ(nullptr, c.find("b"));
+  EXPECT_NE(nullptr, c.find("a"));
+  EXPECT_NE(nullptr, c.find("c"));
+
+  c.clear();
+  EXPECT_EQ(0U, c.size());
+  EXPECT_EQ(nullptr, c.find("a"));
+}
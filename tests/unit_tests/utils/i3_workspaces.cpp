@@ -0,0 +1,127 @@
+#include "common/test.hpp"
+#include "utils/i3_workspaces.hpp"
+
+using namespace polybar;
+using i3_util::workspace_model;
+using i3_util::workspace_state;
+
+namespace {
+  workspace_state make_ws(string name, string output, int num, bool focused = false, bool visible = false) {
+    workspace_state ws;
+    ws.name = move(name);
+    ws.output = move(output);
+    ws.num = num;
+    ws.focused = focused;
+    ws.visible = visible;
+    return ws;
+  }
+
+  const workspace_state& get(const workspace_model& model, const string& name) {
+    for (auto&& ws : model.workspaces()) {
+      if (ws.name == name) {
+        return ws;
+      }
+    }
+    throw std::out_of_range(name);
+  }
+}  // namespace
+
+class WorkspaceModel : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    m_model.reset({make_ws("1", "DP-1", 1, true, true), make_ws("2", "DP-1", 2), make_ws("3", "HDMI-1", 3, false, true)});
+  }
+
+  workspace_model m_model{};
+};
+
+TEST_F(WorkspaceModel, focusSameOutput) {
+  auto revision = get(m_model, "3").revision;
+
+  EXPECT_TRUE(m_model.focus("2"));
+  EXPECT_TRUE(get(m_model, "2").focused);
+  EXPECT_TRUE(get(m_model, "2").visible);
+  EXPECT_FALSE(get(m_model, "1").focused);
+  EXPECT_FALSE(get(m_model, "1").visible);
+
+  // Untouched workspaces keep their revision
+  EXPECT_TRUE(get(m_model, "3").visible);
+  EXPECT_EQ(revision, get(m_model, "3").revision);
+}
+
+TEST_F(WorkspaceModel, focusOtherOutput) {
+  EXPECT_TRUE(m_model.focus("3"));
+  EXPECT_TRUE(get(m_model, "3").focused);
+  EXPECT_FALSE(get(m_model, "1").focused);
+  EXPECT_TRUE(get(m_model, "1").visible);
+}
+
+TEST_F(WorkspaceModel, focusUnchanged) {
+  auto revision = m_model.revision();
+  EXPECT_TRUE(m_model.focus("1"));
+  EXPECT_EQ(revision, m_model.revision());
+}
+
+TEST_F(WorkspaceModel, urgent) {
+  EXPECT_TRUE(m_model.urgent("2", true));
+  EXPECT_TRUE(get(m_model, "2").urgent);
+  EXPECT_TRUE(m_model.urgent("2", false));
+  EXPECT_FALSE(get(m_model, "2").urgent);
+}
+
+TEST_F(WorkspaceModel, urgentClearing) {
+  EXPECT_TRUE(m_model.urgent("2", true));
+
+  // Focusing doesn't clear the flag, i3 sends an urgent event for that
+  EXPECT_TRUE(m_model.focus("2"));
+  EXPECT_TRUE(get(m_model, "2").urgent);
+
+  auto revision = get(m_model, "2").revision;
+  EXPECT_TRUE(m_model.urgent("2", false));
+  EXPECT_FALSE(get(m_model, "2").urgent);
+  EXPECT_NE(revision, get(m_model, "2").revision);
+
+  // Clearing it again is a no-op
+  revision = m_model.revision();
+  EXPECT_TRUE(m_model.urgent("2", false));
+  EXPECT_EQ(revision, m_model.revision());
+}
+
+TEST_F(WorkspaceModel, moveHidden) {
+  auto revision = get(m_model, "1").revision;
+
+  EXPECT_TRUE(m_model.move("2", "HDMI-1"));
+  EXPECT_EQ("HDMI-1", get(m_model, "2").output);
+  EXPECT_FALSE(get(m_model, "2").visible);
+  EXPECT_EQ(revision, get(m_model, "1").revision);
+
+  // Focus now follows the new output
+  EXPECT_TRUE(m_model.focus("2"));
+  EXPECT_TRUE(get(m_model, "2").visible);
+  EXPECT_FALSE(get(m_model, "3").visible);
+  EXPECT_FALSE(get(m_model, "1").focused);
+  EXPECT_TRUE(get(m_model, "1").visible);
+}
+
+TEST_F(WorkspaceModel, moveVisible) {
+  // Which workspace i3 shows on DP-1 instead is unknown
+  EXPECT_FALSE(m_model.move("1", "HDMI-1"));
+
+  auto revision = m_model.revision();
+  EXPECT_TRUE(m_model.move("1", "DP-1"));
+  EXPECT_EQ(revision, m_model.revision());
+  EXPECT_FALSE(m_model.move("4", "DP-1"));
+}
+
+TEST_F(WorkspaceModel, empty) {
+  EXPECT_TRUE(m_model.empty("2"));
+  EXPECT_EQ(2U, m_model.workspaces().size());
+  EXPECT_TRUE(m_model.empty("2"));
+}
+
+TEST_F(WorkspaceModel, unknown) {
+  auto revision = m_model.revision();
+  EXPECT_FALSE(m_model.focus("4"));
+  EXPECT_FALSE(m_model.urgent("4", true));
+  EXPECT_EQ(revision, m_model.revision());
+}
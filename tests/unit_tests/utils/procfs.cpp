@@ -0,0 +1,73 @@
+#include "common/test.hpp"
+#include "utils/procfs.hpp"
+
+using namespace polybar;
+
+namespace {
+  const string proc_stat{
+      "cpu  10132153 290696 3084719 46828483 16683 0 25195 0 175628 0\n"
+      "cpu0 1393280 32966 572056 13343292 6130 0 17875 5 0 0\n"
+      "cpu1 1335 12 43 2006 1 0 0 7\n"
+      "intr 1462898 0 0 0 0\n"
+      "ctxt 2102213\n"};
+
+  const string proc_meminfo{
+      "MemTotal:       16318760 kB\n"
+      "MemFree:         1287612 kB\n"
+      "MemAvailable:    9860980 kB\n"
+      "Buffers:          698476 kB\n"
+      "Cached:          7628384 kB\n"
+      "SwapTotal:       2097148 kB\n"
+      "SwapFree:        2097148 kB\n"};
+}  // namespace
+
+TEST(Procfs, parseStat) {
+  vector<procfs_util::cpu_time> cores;
+  EXPECT_EQ(2U, procfs_util::parse_stat(proc_stat.data(), proc_stat.size(), cores));
+  ASSERT_EQ(2U, cores.size());
+
+  EXPECT_EQ(1393280ULL, cores[0].user);
+  EXPECT_EQ(32966ULL, cores[0].nice);
+  EXPECT_EQ(572056ULL, cores[0].system);
+  EXPECT_EQ(13343292ULL, cores[0].idle);
+  EXPECT_EQ(5ULL, cores[0].steal);
+  EXPECT_EQ(1393280ULL + 32966 + 572056 + 13343292 + 5, cores[0].total);
+  EXPECT_EQ(7ULL, cores[1].steal);
+
+  // Reused between calls
+  EXPECT_EQ(1U, procfs_util::parse_stat(proc_stat.data(), proc_stat.find("cpu1"), cores));
+  EXPECT_EQ(1U, cores.size());
+  EXPECT_EQ(0U, procfs_util::parse_stat("", 0, cores));
+}
+
+TEST(Procfs, parseMeminfo) {
+  procfs_util::meminfo info{};
+  EXPECT_TRUE(procfs_util::parse_meminfo(proc_meminfo.data(), proc_meminfo.size(), info));
+  EXPECT_EQ(16318760ULL, info.total);
+  EXPECT_EQ(1287612ULL, info.free);
+  EXPECT_EQ(9860980ULL, info.available);
+  EXPECT_TRUE(info.has_available);
+  EXPECT_EQ(698476ULL, info.buffers);
+  EXPECT_EQ(7628384ULL, info.cached);
+  EXPECT_EQ(0ULL, info.shmem);
+  EXPECT_EQ(2097148ULL, info.swap_total);
+  EXPECT_EQ(2097148ULL, info.swap_free);
+
+  EXPECT_FALSE(procfs_util::parse_meminfo("", 0, info));
+  EXPECT_FALSE(info.has_available);
+}
+
+TEST(Procfs, parseInteger) {
+  EXPECT_EQ(45000, procfs_util::parse_integer("45000\n", 6));
+  EXPECT_EQ(-2500, procfs_util::parse_integer("-2500\n", 6));
+  EXPECT_EQ(12, procfs_util::parse_integer(" 12", 3));
+  EXPECT_EQ(0, procfs_util::parse_integer("Charging\n", 9));
+  EXPECT_EQ(0, procfs_util::parse_integer("", 0));
+}
+
+TEST(Procfs, startsWith) {
+  EXPECT_TRUE(procfs_util::starts_with("Charging\n", 9, "Charging"));
+  EXPECT_TRUE(procfs_util::starts_with("1\n", 2, "1"));
+  EXPECT_FALSE(procfs_util::starts_with("0\n", 2, "1"));
+  EXPECT_FALSE(procfs_util::starts_with("Char", 4, "Charging"));
+}